@@ -168,6 +168,18 @@ _EXTERN NSString* const kGDataCategoryScheme _INITIALIZE_AS(@"http://schemas.goo
 - (GDataBatchInterrupted *)batchInterrupted;
 - (void)setBatchInterrupted:(GDataBatchInterrupted *)obj;
 
+// partial updates
+//
+// patchEntryWithChangesFromEntry: returns an entry with just the top-level
+// elements and attributes whose XML differs from that of the original
+// version of this entry, and a field selection (gd:fields) naming them, so
+// updating with it sends a PATCH request.  Fields of the original missing
+// from this entry are named without elements, so the update deletes them.
+// Repeated elements, like links, are replaced together if any differ.  The
+// patch has the original's ETag, so the update fails if the entry has since
+// changed on the server.  Returns nil if no fields differ.
+- (id)patchEntryWithChangesFromEntry:(GDataEntryBase *)originalEntry;
+
 // convenience accessors
 
 - (NSArray *)categoriesWithScheme:(NSString *)scheme;
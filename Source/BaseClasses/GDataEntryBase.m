@@ -218,6 +218,120 @@
   return element;
 }
 
+#pragma mark Partial updates
+
+// GDataChildElementsByName returns the child elements of the element in
+// arrays keyed by qualified name, adding the names to the array in document
+// order
+static NSDictionary *GDataChildElementsByName(NSXMLElement *element,
+                                              NSMutableArray *names) {
+  NSMutableDictionary *dict = [NSMutableDictionary dictionary];
+
+  for (NSXMLNode *child in [element children]) {
+    if ([child kind] != NSXMLElementKind) continue;
+
+    NSString *name = [child name];
+    NSMutableArray *array = [dict objectForKey:name];
+    if (array == nil) {
+      array = [NSMutableArray array];
+      [dict setObject:array forKey:name];
+      [names addObject:name];
+    }
+    [array addObject:child];
+  }
+  return dict;
+}
+
+static NSString *GDataQualifiedNameForAttributeClass(Class attrClass) {
+  NSString *prefix = [attrClass extensionElementPrefix];
+  NSString *localName = [attrClass extensionElementLocalName];
+  if (prefix == nil) return localName;
+  return [NSString stringWithFormat:@"%@:%@", prefix, localName];
+}
+
+static BOOL GDataAreElementArraysEqual(NSArray *array1, NSArray *array2) {
+  NSUInteger count = [array1 count];
+  if (count != [array2 count]) return NO;
+
+  for (NSUInteger idx = 0; idx < count; idx++) {
+    NSString *str1 = [[array1 objectAtIndex:idx] XMLString];
+    NSString *str2 = [[array2 objectAtIndex:idx] XMLString];
+    if (!AreEqualOrBothNil(str1, str2)) return NO;
+  }
+  return YES;
+}
+
+- (id)patchEntryWithChangesFromEntry:(GDataEntryBase *)originalEntry {
+
+  // the fields are compared by their XML, which covers the extensions,
+  // the attributes, and the unknown children alike
+  NSXMLElement *element = [self XMLElement];
+  NSXMLElement *originalElement = [originalEntry XMLElement];
+
+  NSXMLElement *patchElement = [NSXMLNode elementWithName:[element name]];
+  for (NSXMLNode *ns in [element namespaces]) {
+    [patchElement addNamespace:[[ns copy] autorelease]];
+  }
+
+  NSMutableArray *fields = [NSMutableArray array];
+
+  // the ETag and the field selection are not fields of the entry
+  NSString *etagName = GDataQualifiedNameForAttributeClass([GDataETagAttribute class]);
+  NSString *fieldsName = GDataQualifiedNameForAttributeClass([GDataFieldsAttribute class]);
+
+  NSMutableSet *attrNames = [NSMutableSet set];
+  for (NSXMLNode *attr in [element attributes]) {
+    NSString *name = [attr name];
+    if ([name isEqual:etagName] || [name isEqual:fieldsName]) continue;
+
+    [attrNames addObject:name];
+    NSString *originalValue = [[originalElement attributeForName:name] stringValue];
+    if (!AreEqualOrBothNil([attr stringValue], originalValue)) {
+      [fields addObject:[@"@" stringByAppendingString:name]];
+      [patchElement addAttribute:[[attr copy] autorelease]];
+    }
+  }
+  for (NSXMLNode *attr in [originalElement attributes]) {
+    NSString *name = [attr name];
+    if ([name isEqual:etagName] || [name isEqual:fieldsName]) continue;
+
+    if (![attrNames containsObject:name]) {
+      [fields addObject:[@"@" stringByAppendingString:name]];
+    }
+  }
+
+  NSMutableArray *names = [NSMutableArray array];
+  NSMutableArray *originalNames = [NSMutableArray array];
+  NSDictionary *children = GDataChildElementsByName(element, names);
+  NSDictionary *originalChildren = GDataChildElementsByName(originalElement,
+                                                            originalNames);
+  for (NSString *name in names) {
+    NSArray *array = [children objectForKey:name];
+    if (!GDataAreElementArraysEqual(array, [originalChildren objectForKey:name])) {
+      [fields addObject:name];
+      for (NSXMLNode *child in array) {
+        [patchElement addChild:[[child copy] autorelease]];
+      }
+    }
+  }
+  for (NSString *name in originalNames) {
+    if ([children objectForKey:name] == nil) {
+      [fields addObject:name];
+    }
+  }
+
+  if ([fields count] == 0) return nil;
+
+  GDataEntryBase *patch = [[[[self class] alloc] initWithXMLElement:patchElement
+                                                             parent:nil
+                                                     serviceVersion:[self serviceVersion]
+                                                         surrogates:nil
+                                               shouldIgnoreUnknowns:NO] autorelease];
+  [patch setFieldSelection:[fields componentsJoinedByString:@","]];
+  [patch setETag:[originalEntry ETag]];
+  return patch;
+}
+
 #pragma mark -
 
 - (NSDictionary *)contentHeaders {
@@ -44,6 +44,15 @@
 // for an appropriate match
 _EXTERN Class const kUseRegisteredEntryClass _INITIALIZE_AS(nil);
 
+// feeds with at least this many entries are parsed on several threads when
+// parsing entries in parallel
+_EXTERN const NSUInteger kGDataMinEntriesForParallelParse _INITIALIZE_AS(256);
+
+#if NS_BLOCKS_AVAILABLE
+// handler for streamed entries; set *stop to YES to end the parse early
+typedef void (^GDataFeedBaseEntryHandler)(GDataEntryBase *entry, BOOL *stop);
+#endif
+
 @interface GDataFeedBase : GDataObject <NSFastEnumeration> {
 
   // generator is parsed manually to avoid comparison along with other
@@ -51,6 +60,18 @@ _EXTERN Class const kUseRegisteredEntryClass _INITIALIZE_AS(nil);
   GDataGenerator *generator_;
 
   NSMutableArray *entries_;
+
+  // when parsing lazily, entries_ holds NSNull placeholders until each
+  // entry is made from its element in lazyEntryElements_; an entry failing
+  // to parse is removed from both arrays
+  NSMutableArray *lazyEntryElements_;
+  BOOL shouldParseEntriesLazily_;
+
+  // counts changes to the entries, for detecting changes during fast
+  // enumeration
+  unsigned long entriesMutations_;
+
+  BOOL shouldParseEntriesInParallel_;
 }
 
 + (id)feedWithXMLData:(NSData *)data;
@@ -59,6 +80,95 @@ _EXTERN Class const kUseRegisteredEntryClass _INITIALIZE_AS(nil);
     serviceVersion:(NSString *)serviceVersion
 shouldIgnoreUnknowns:(BOOL)shouldIgnoreUnknowns;
 
+// feedWithContentsOfFile: parses a saved feed from a memory-mapped file
+// rather than from data read into memory; returns nil, with an error, if the
+// file cannot be read or parsed
++ (id)feedWithContentsOfFile:(NSString *)path
+              serviceVersion:(NSString *)serviceVersion
+        shouldIgnoreUnknowns:(BOOL)shouldIgnoreUnknowns
+                       error:(NSError **)error;
+- (id)initWithContentsOfFile:(NSString *)path
+              serviceVersion:(NSString *)serviceVersion
+        shouldIgnoreUnknowns:(BOOL)shouldIgnoreUnknowns
+                       error:(NSError **)error;
+
+#if NS_BLOCKS_AVAILABLE
+// Streaming parse
+//
+// feedWithStreamedData: parses without building a tree for the whole
+// response.  Each entry is created as soon as its end tag has been read and
+// is passed to the handler, so peak memory is roughly that of a single entry.
+// Entries passed to the handler have no parent and are not added to the
+// feed; the returned feed holds the feed-level elements.
+//
+// When called on a feed subclass, entries are created with the subclass's
+// classForEntries; when called on GDataFeedBase, the feed and entry classes
+// are found from the registered kinds.  Returns nil if the data cannot be
+// parsed, though entries preceding the error may already have been handled.
++ (id)feedWithStreamedData:(NSData *)data
+            serviceVersion:(NSString *)serviceVersion
+                surrogates:(NSDictionary *)surrogates
+      shouldIgnoreUnknowns:(BOOL)shouldIgnoreUnknowns
+              entryHandler:(GDataFeedBaseEntryHandler)handler
+                     error:(NSError **)error;
+#endif
+
+// Lazy entry parsing
+//
+// this initializer parses the feed-level elements but postpones creating
+// each entry until it is first needed by -entries, -entryAtIndex:,
+// -entryForIdentifier:, -entriesWithCategoryKind: or fast enumeration.
+// Lookups by identifier and kind examine the entry elements, so only
+// matching entries are created.  The feed's XML document must stay alive
+// until all entries are created, so lazy feeds are not detached from their
+// document.
+//
+// Entries which fail to parse are dropped when the full entries array
+// is made.
+//
+// Since the accessors above create entries, a lazily-parsed feed is not
+// safe to read from several threads at once, even when none of them changes
+// it.  Calling -entries creates all the entries, after which the feed may
+// be read from other threads as any feed may.
+- (id)initWithXMLElement:(NSXMLElement *)element
+                  parent:(GDataObject *)parent
+          serviceVersion:(NSString *)serviceVersion
+              surrogates:(NSDictionary *)surrogates
+    shouldIgnoreUnknowns:(BOOL)shouldIgnoreUnknowns
+shouldParseEntriesLazily:(BOOL)shouldParseLazily;
+
+- (BOOL)shouldParseEntriesLazily;
+
+// Parallel entry parsing
+//
+// this initializer creates the entries of a large feed on several threads
+// at once; the feed's document is only read while the entries are parsed,
+// and the entries are kept in document order.  Feeds with fewer than
+// kGDataMinEntriesForParallelParse entries are parsed serially.
+- (id)initWithXMLElement:(NSXMLElement *)element
+                  parent:(GDataObject *)parent
+          serviceVersion:(NSString *)serviceVersion
+              surrogates:(NSDictionary *)surrogates
+    shouldIgnoreUnknowns:(BOOL)shouldIgnoreUnknowns
+shouldDetachFromXMLDocument:(BOOL)shouldDetach
+shouldParseEntriesInParallel:(BOOL)shouldParseInParallel;
+
+- (BOOL)shouldParseEntriesInParallel;
+
+// this initializer takes all of the parsing options for a feed; see
+// GDataObject for the parse projection and detaching, and above for lazy and
+// parallel entry parsing.  Lazy parsing takes precedence over detaching and
+// over parallel parsing.
+- (id)initWithXMLElement:(NSXMLElement *)element
+                  parent:(GDataObject *)parent
+          serviceVersion:(NSString *)serviceVersion
+              surrogates:(NSDictionary *)surrogates
+         parseProjection:(NSSet *)projection
+    shouldIgnoreUnknowns:(BOOL)shouldIgnoreUnknowns
+shouldDetachFromXMLDocument:(BOOL)shouldDetach
+shouldParseEntriesLazily:(BOOL)shouldParseLazily
+shouldParseEntriesInParallel:(BOOL)shouldParseInParallel;
+
 // subclasses override initFeed to set up their ivars
 - (void)initFeedWithXMLElement:(NSXMLElement *)element;
 
@@ -133,6 +243,12 @@ shouldIgnoreUnknowns:(BOOL)shouldIgnoreUnknowns;
 
 - (NSArray *)entries;
 
+// numberOfEntries does not create entries of a lazily-parsed feed, so it
+// includes entries not yet created; entries failing to parse are dropped
+// when they are first needed, so the number and the indexes of later entries
+// then decrease
+- (NSUInteger)numberOfEntries;
+
 // setEntries: and addEntry: assert if the entries have other parents
 // already set; use setEntriesWithEntries: and addEntryWithEntry: to copy
 // entries that have other parents
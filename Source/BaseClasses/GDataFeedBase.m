@@ -21,12 +21,41 @@
 #import "GDataFeedBase.h"
 
 #import "GDataBaseElements.h"
+#import "GDataXMLNode.h"
 
 
 @interface GDataFeedBase (PrivateMethods)
 - (void)setupFromXMLElement:(NSXMLElement *)root;
+- (id)initWithData:(NSData *)data
+    serviceVersion:(NSString *)serviceVersion
+shouldIgnoreUnknowns:(BOOL)shouldIgnoreUnknowns
+             error:(NSError **)error;
+- (GDataEntryBase *)lazyEntryAtIndex:(NSUInteger)idx;
+- (void)createLazyEntries;
+- (void)releaseLazyEntryElements;
+- (NSXMLElement *)XMLElementOmittingEntries;
+#if NS_BLOCKS_AVAILABLE
+- (NSArray *)entriesForElementsInParallel:(NSArray *)entryElements
+                               entryClass:(Class)entryClass;
+#endif
+@end
+
+// GDataObject's declaration caches, which decide whether entries may be
+// parsed in parallel
+@interface GDataObject (GDataFeedBaseDeclarationCaches)
+- (NSMutableDictionary *)extensionDeclarationsCache;
+- (NSMutableDictionary *)attributeDeclarationsCache;
 @end
 
+// GDataObject's generation of cached XML, used without copying the cached
+// elements when writing entries to a stream
+@interface GDataObject (GDataFeedBaseCachedXML)
+- (NSXMLElement *)XMLElementUsingCacheInEpoch:(NSUInteger)epoch;
+@end
+
+// the smallest number of entries parsed together by a parallel parse
+static const NSUInteger kMinEntriesPerParseChunk = 16;
+
 @implementation GDataFeedBase
 
 + (NSString *)standardFeedKind {
@@ -145,6 +174,70 @@
   return self;
 }
 
+- (id)initWithXMLElement:(NSXMLElement *)element
+                  parent:(GDataObject *)parent
+          serviceVersion:(NSString *)serviceVersion
+              surrogates:(NSDictionary *)surrogates
+    shouldIgnoreUnknowns:(BOOL)shouldIgnoreUnknowns
+shouldParseEntriesLazily:(BOOL)shouldParseLazily {
+
+  return [self initWithXMLElement:element
+                           parent:parent
+                   serviceVersion:serviceVersion
+                       surrogates:surrogates
+                  parseProjection:nil
+             shouldIgnoreUnknowns:shouldIgnoreUnknowns
+      shouldDetachFromXMLDocument:NO
+         shouldParseEntriesLazily:shouldParseLazily
+     shouldParseEntriesInParallel:NO];
+}
+
+- (id)initWithXMLElement:(NSXMLElement *)element
+                  parent:(GDataObject *)parent
+          serviceVersion:(NSString *)serviceVersion
+              surrogates:(NSDictionary *)surrogates
+    shouldIgnoreUnknowns:(BOOL)shouldIgnoreUnknowns
+shouldDetachFromXMLDocument:(BOOL)shouldDetach
+shouldParseEntriesInParallel:(BOOL)shouldParseInParallel {
+
+  return [self initWithXMLElement:element
+                           parent:parent
+                   serviceVersion:serviceVersion
+                       surrogates:surrogates
+                  parseProjection:nil
+             shouldIgnoreUnknowns:shouldIgnoreUnknowns
+      shouldDetachFromXMLDocument:shouldDetach
+         shouldParseEntriesLazily:NO
+     shouldParseEntriesInParallel:shouldParseInParallel];
+}
+
+- (id)initWithXMLElement:(NSXMLElement *)element
+                  parent:(GDataObject *)parent
+          serviceVersion:(NSString *)serviceVersion
+              surrogates:(NSDictionary *)surrogates
+         parseProjection:(NSSet *)projection
+    shouldIgnoreUnknowns:(BOOL)shouldIgnoreUnknowns
+shouldDetachFromXMLDocument:(BOOL)shouldDetach
+shouldParseEntriesLazily:(BOOL)shouldParseLazily
+shouldParseEntriesInParallel:(BOOL)shouldParseInParallel {
+
+  // the flags must be set before the superclass calls through to
+  // setupFromXMLElement:
+  shouldParseEntriesLazily_ = shouldParseLazily;
+  shouldParseEntriesInParallel_ = shouldParseInParallel;
+
+  // lazily-made entries are parsed from the document after this returns
+  if (shouldParseLazily) shouldDetach = NO;
+
+  return [self initWithXMLElement:element
+                           parent:parent
+                   serviceVersion:serviceVersion
+                       surrogates:surrogates
+                  parseProjection:projection
+             shouldIgnoreUnknowns:shouldIgnoreUnknowns
+      shouldDetachFromXMLDocument:shouldDetach];
+}
+
 - (id)initWithData:(NSData *)data {
   return [self initWithData:data
              serviceVersion:nil
@@ -154,12 +247,51 @@
 - (id)initWithData:(NSData *)data
     serviceVersion:(NSString *)serviceVersion
 shouldIgnoreUnknowns:(BOOL)shouldIgnoreUnknowns {
+  return [self initWithData:data
+             serviceVersion:serviceVersion
+       shouldIgnoreUnknowns:shouldIgnoreUnknowns
+                      error:NULL];
+}
+
++ (id)feedWithContentsOfFile:(NSString *)path
+              serviceVersion:(NSString *)serviceVersion
+        shouldIgnoreUnknowns:(BOOL)shouldIgnoreUnknowns
+                       error:(NSError **)error {
+  return [[[self alloc] initWithContentsOfFile:path
+                                serviceVersion:serviceVersion
+                          shouldIgnoreUnknowns:shouldIgnoreUnknowns
+                                         error:error] autorelease];
+}
+
+- (id)initWithContentsOfFile:(NSString *)path
+              serviceVersion:(NSString *)serviceVersion
+        shouldIgnoreUnknowns:(BOOL)shouldIgnoreUnknowns
+                       error:(NSError **)error {
+  // the parsed document does not refer to the data, so the mapping lasts
+  // only for the parse
+  NSData *data = [NSData dataWithContentsOfFile:path
+                                        options:NSDataReadingMappedIfSafe
+                                          error:error];
+  if (data == nil) {
+    [self release];
+    return nil;
+  }
+
+  return [self initWithData:data
+             serviceVersion:serviceVersion
+       shouldIgnoreUnknowns:shouldIgnoreUnknowns
+                      error:error];
+}
+
+- (id)initWithData:(NSData *)data
+    serviceVersion:(NSString *)serviceVersion
+shouldIgnoreUnknowns:(BOOL)shouldIgnoreUnknowns
+             error:(NSError **)error {
 
   // entry point for creation of feeds from file or network data
-  NSError *error = nil;
   NSXMLDocument *xmlDocument = [[[NSXMLDocument alloc] initWithData:data
                                                             options:0
-                                                              error:&error] autorelease];
+                                                              error:error] autorelease];
   if (xmlDocument) {
 
     NSXMLElement* root = [xmlDocument rootElement];
@@ -186,6 +318,101 @@ shouldIgnoreUnknowns:(BOOL)shouldIgnoreUnknowns {
   }
 }
 
+#if NS_BLOCKS_AVAILABLE
+// return an NSXMLDocument for a document made by the streaming parser
+static NSXMLDocument *NSXMLDocumentForStreamedDocument(GDataXMLDocument *doc) {
+#if GDATA_USES_LIBXML
+  return doc;
+#else
+  NSXMLDocument *xmlDocument = [[[NSXMLDocument alloc] initWithData:[doc XMLData]
+                                                            options:0
+                                                              error:NULL] autorelease];
+  return xmlDocument;
+#endif
+}
+
++ (id)feedWithStreamedData:(NSData *)data
+            serviceVersion:(NSString *)serviceVersion
+                surrogates:(NSDictionary *)surrogates
+      shouldIgnoreUnknowns:(BOOL)shouldIgnoreUnknowns
+              entryHandler:(GDataFeedBaseEntryHandler)handler
+                     error:(NSError **)error {
+
+  // a subclass may specify its entry class; otherwise, each entry's class
+  // is found from its XML
+  Class feedEntryClass = kUseRegisteredEntryClass;
+  if (self != [GDataFeedBase class]) {
+    GDataFeedBase *prototypeFeed = [[[self alloc] init] autorelease];
+    feedEntryClass = [prototypeFeed classForEntries];
+  }
+
+  GDataXMLDocumentStreamHandler entryXMLHandler = ^(GDataXMLDocument *entryXMLDoc,
+                                                    BOOL *stop) {
+    // bound the autoreleased memory to a single entry
+    NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+
+    NSXMLDocument *entryDoc = NSXMLDocumentForStreamedDocument(entryXMLDoc);
+    NSXMLElement *entryElement = [entryDoc rootElement];
+    if (entryElement) {
+      Class entryClass = feedEntryClass;
+      if (entryClass == nil) {
+        entryClass = [self objectClassForXMLElement:entryElement];
+      }
+
+      Class surrogate = (Class)[surrogates objectForKey:entryClass];
+      if (surrogate) entryClass = surrogate;
+
+      GDataEntryBase *entry = [[entryClass alloc] initWithXMLElement:entryElement
+                                                              parent:nil
+                                                      serviceVersion:serviceVersion
+                                                          surrogates:surrogates
+                                                shouldIgnoreUnknowns:shouldIgnoreUnknowns];
+      [entry clearExtensionDeclarationsCache];
+#if GDATA_USES_LIBXML
+      // retain the entry's document so that pointers to internal nodes
+      // remain valid
+      [entry setProperty:entryDoc forKey:kGDataXMLDocumentPropertyKey];
+#endif
+      if (entry) {
+        handler(entry, stop);
+      }
+      [entry release];
+    }
+
+    [pool drain];
+  };
+
+  GDataXMLDocument *feedXMLDoc;
+  feedXMLDoc = [GDataXMLDocument documentWithStreamedData:data
+                                   streamingChildrenNamed:@"entry"
+                                                      URI:kGDataNamespaceAtom
+                                                  handler:entryXMLHandler
+                                                    error:error];
+  NSXMLDocument *feedDoc = NSXMLDocumentForStreamedDocument(feedXMLDoc);
+  NSXMLElement *root = [feedDoc rootElement];
+  if (root == nil) return nil;
+
+  Class feedClass = self;
+  if (feedClass == [GDataFeedBase class]) {
+    feedClass = [GDataObject objectClassForXMLElement:root];
+  }
+
+  Class surrogate = (Class)[surrogates objectForKey:feedClass];
+  if (surrogate) feedClass = surrogate;
+
+  GDataFeedBase *feed = [[[feedClass alloc] initWithXMLElement:root
+                                                        parent:nil
+                                                serviceVersion:serviceVersion
+                                                    surrogates:surrogates
+                                          shouldIgnoreUnknowns:shouldIgnoreUnknowns] autorelease];
+  [feed clearExtensionDeclarationsCache];
+#if GDATA_USES_LIBXML
+  [feed setProperty:feedDoc forKey:kGDataXMLDocumentPropertyKey];
+#endif
+  return feed;
+}
+#endif
+
 - (void)setupFromXMLElement:(NSXMLElement *)root {
 
   // we'll parse the generator manually rather than declare it to be an
@@ -204,6 +431,44 @@ shouldIgnoreUnknowns:(BOOL)shouldIgnoreUnknowns {
   GDATA_DEBUG_ASSERT([[root localName] isEqual:@"feed"],
             @"initing a feed from a non-feed element (%@)", [root name]);
 
+  if (shouldParseEntriesLazily_) {
+    // keep the entry elements, with a placeholder for each entry until it
+    // is created
+    NSArray *entryElements = [self childElementsOfElement:root
+                                            qualifiedName:@"entry"
+                                             namespaceURI:kGDataNamespaceAtom];
+    [self handleParsedElements:entryElements];
+
+    NSUInteger numberOfElements = [entryElements count];
+    if (numberOfElements > 0) {
+      lazyEntryElements_ = [entryElements mutableCopy];
+
+      entries_ = [[NSMutableArray alloc] initWithCapacity:numberOfElements];
+      NSNull *placeholder = [NSNull null];
+      for (NSUInteger idx = 0; idx < numberOfElements; idx++) {
+        [entries_ addObject:placeholder];
+      }
+    }
+    return;
+  }
+
+#if NS_BLOCKS_AVAILABLE
+  if (shouldParseEntriesInParallel_) {
+    NSArray *entryElements = [self childElementsOfElement:root
+                                            qualifiedName:@"entry"
+                                             namespaceURI:kGDataNamespaceAtom];
+    if ([entryElements count] >= kGDataMinEntriesForParallelParse) {
+      NSArray *entries = [self entriesForElementsInParallel:entryElements
+                                                 entryClass:entryClass];
+      if (entries != nil) {
+        [self handleParsedElements:entryElements];
+        [self setEntries:entries];
+        return;
+      }
+    }
+  }
+#endif
+
   // create entries of the proper class from each "entry" element
   id entryObj = [self objectOrArrayForChildrenOfElement:root
                                           qualifiedName:@"entry"
@@ -221,10 +486,150 @@ shouldIgnoreUnknowns:(BOOL)shouldIgnoreUnknowns {
   }
 }
 
+- (BOOL)shouldParseEntriesLazily {
+  return shouldParseEntriesLazily_;
+}
+
+- (BOOL)shouldParseEntriesInParallel {
+  return shouldParseEntriesInParallel_;
+}
+
+#if NS_BLOCKS_AVAILABLE
+// entriesForElementsInParallel:entryClass: creates the entries in contiguous
+// runs of elements on the global queue's threads, or returns nil if the feed
+// must be parsed serially.
+//
+// Entries only read the feed and the shared declarations while parsing.  The
+// first entry is made before the threads start, so the shared declarations
+// and parse plans of its class and its usual children already exist; those
+// made later by the threads are kept in locked maps.  A feed with declarations
+// of its own, not shared, has caches that entries might read or declare into,
+// so it is parsed serially.
+- (NSArray *)entriesForElementsInParallel:(NSArray *)entryElements
+                               entryClass:(Class)entryClass {
+
+  if ([self extensionDeclarationsCache] != nil
+      || [self attributeDeclarationsCache] != nil) {
+    return nil;
+  }
+
+  NSUInteger numberOfElements = [entryElements count];
+  if (numberOfElements == 0) return [NSArray array];
+
+  // each slot holds a retained entry, or nil if the element failed to parse
+  id *parsedEntries = (id *) calloc(numberOfElements, sizeof(id));
+  if (parsedEntries == NULL) return nil;
+
+  // parseEntryAtIndex returns a retained entry
+  GDataEntryBase *(^parseEntryAtIndex)(NSUInteger) = ^(NSUInteger idx) {
+    NSXMLElement *element = [entryElements objectAtIndex:idx];
+    Class elementClass = [self classForChildElement:element
+                                      qualifiedName:@"entry"
+                                       namespaceURI:kGDataNamespaceAtom
+                                        objectClass:entryClass];
+    GDataEntryBase *entry = [[elementClass alloc] initWithXMLElement:element
+                                                              parent:self];
+    [entry gatherUnknownChildren];
+    return entry;
+  };
+
+  NSAutoreleasePool *firstPool = [[NSAutoreleasePool alloc] init];
+  parsedEntries[0] = parseEntryAtIndex(0);
+  [firstPool drain];
+
+  // several runs per processor even out runs of slower entries
+  NSUInteger numberRemaining = numberOfElements - 1;
+  NSUInteger numberOfProcessors = [[NSProcessInfo processInfo] activeProcessorCount];
+  NSUInteger numberOfRuns = MIN(numberOfProcessors * 4,
+                                numberRemaining / kMinEntriesPerParseChunk);
+  numberOfRuns = MAX(numberOfRuns, 1U);
+  NSUInteger runLength = (numberRemaining + numberOfRuns - 1) / numberOfRuns;
+
+  dispatch_queue_t queue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+  dispatch_apply(numberOfRuns, queue, ^(size_t runIndex) {
+    NSUInteger firstIndex = 1 + runIndex * runLength;
+    NSUInteger endIndex = MIN(firstIndex + runLength, numberOfElements);
+
+    for (NSUInteger idx = firstIndex; idx < endIndex; idx++) {
+      NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+      parsedEntries[idx] = parseEntryAtIndex(idx);
+      [pool drain];
+    }
+  });
+
+  NSMutableArray *entries = [NSMutableArray arrayWithCapacity:numberOfElements];
+  for (NSUInteger idx = 0; idx < numberOfElements; idx++) {
+    id entry = parsedEntries[idx];
+    if (entry) {
+      [entries addObject:entry];
+      [entry release];
+    }
+  }
+  free(parsedEntries);
+
+  return entries;
+}
+#endif
+
+// lazyEntryAtIndex: returns the entry, creating it from its element if it
+// has not yet been made.  If the element cannot be parsed, it is dropped,
+// moving the following entries down an index, and this returns nil.
+//
+// Entries before the index of an enumeration have already been created, so
+// dropping an entry never moves those the enumeration has passed.
+- (GDataEntryBase *)lazyEntryAtIndex:(NSUInteger)idx {
+
+  id entry = [entries_ objectAtIndex:idx];
+  if (entry != [NSNull null]) return entry;
+
+  NSXMLElement *element = [lazyEntryElements_ objectAtIndex:idx];
+  Class entryClass = [self classForChildElement:element
+                                  qualifiedName:@"entry"
+                                   namespaceURI:kGDataNamespaceAtom
+                                    objectClass:[self classForEntries]];
+
+  NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+  entry = [[entryClass alloc] initWithXMLElement:element
+                                          parent:self];
+  [entry gatherUnknownChildren];
+  [pool drain];
+
+  if (entry == nil) {
+    [entries_ removeObjectAtIndex:idx];
+    [lazyEntryElements_ removeObjectAtIndex:idx];
+    return nil;
+  }
+
+  [entries_ replaceObjectAtIndex:idx withObject:entry];
+  [entry release];
+  return entry;
+}
+
+// createLazyEntries makes any entries not yet created, dropping those that
+// fail to parse, and ends lazy parsing for this feed
+- (void)createLazyEntries {
+
+  if (lazyEntryElements_ == nil) return;
+
+  NSUInteger idx = 0;
+  while (idx < [lazyEntryElements_ count]) {
+    // a dropped entry's successor moves to this index
+    if ([self lazyEntryAtIndex:idx]) idx++;
+  }
+
+  [self releaseLazyEntryElements];
+}
+
+- (void)releaseLazyEntryElements {
+  [lazyEntryElements_ release];
+  lazyEntryElements_ = nil;
+}
+
 
 - (void)dealloc {
   [generator_ release];
   [entries_ release];
+  [lazyEntryElements_ release];
 
   [super dealloc];
 }
@@ -285,7 +690,7 @@ shouldIgnoreUnknowns:(BOOL)shouldIgnoreUnknowns {
 }
 #endif
 
-- (NSXMLElement *)XMLElement {
+- (NSXMLElement *)XMLElementOmittingEntries {
 
   NSXMLElement *element = [self XMLElementWithExtensionsAndDefaultName:@"feed"];
 
@@ -293,11 +698,71 @@ shouldIgnoreUnknowns:(BOOL)shouldIgnoreUnknowns {
     [element addChild:[[self generator] XMLElement]];
   }
 
+  return element;
+}
+
+- (NSXMLElement *)XMLElement {
+
+  NSXMLElement *element = [self XMLElementOmittingEntries];
+
   [self addToElement:element XMLElementsForArray:[self entries]];
 
   return element;
 }
 
+- (void)releaseCachedXMLElements {
+  [super releaseCachedXMLElements];
+
+  // entries not yet created from lazily parsed elements have no cache
+  for (id entry in entries_) {
+    if (entry != [NSNull null]) {
+      [entry releaseCachedXMLElements];
+    }
+  }
+}
+
+#if GDATA_USES_LIBXML
+- (BOOL)writeXMLDocumentToStream:(NSOutputStream *)stream
+                      usingCache:(BOOL)shouldUseCache
+                           error:(NSError **)error {
+
+  // this may be called on another thread without using the caches, so it
+  // must not change the feed; callers there first create any lazily parsed
+  // entries by calling -entries on their own thread, and then this call
+  // leaves the entries unchanged
+  NSArray *entries = [self entries];
+
+  // generate the feed's element without the entries, since each entry's
+  // element will be generated and written after it
+  NSXMLElement *element = [self XMLElementOmittingEntries];
+
+  // declare at the root the namespaces of the entries too, so the entries'
+  // elements need not repeat them
+  NSMutableDictionary *namespaces = [NSMutableDictionary dictionary];
+  for (GDataEntryBase *entry in entries) {
+    [namespaces addEntriesFromDictionary:[entry namespaces]];
+  }
+  [namespaces addEntriesFromDictionary:[self completeNamespaces]];
+
+  GDataXMLWriter *writer = [[[GDataXMLWriter alloc] initWithOutputStream:stream] autorelease];
+  BOOL isOK = [writer writeStartOfElement:element
+                       hoistingNamespaces:namespaces];
+
+  for (GDataEntryBase *entry in entries) {
+    if (!isOK) break;
+
+    NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+    NSXMLElement *entryElement = (shouldUseCache ?
+                                  [entry XMLElementUsingCacheInEpoch:0] : [entry XMLElement]);
+    isOK = [writer writeElement:entryElement];
+    [pool drain];
+  }
+
+  [writer writeEndOfElement];
+  return [writer finishWritingWithError:error];
+}
+#endif
+
 
 #pragma mark -
 
@@ -618,17 +1083,26 @@ forCategoryWithScheme:scheme
 }
 
 - (NSArray *)entries {
+  [self createLazyEntries];
   return entries_;
 }
 
+- (NSUInteger)numberOfEntries {
+  // a lazily-parsed feed has a placeholder for each entry not yet created
+  return [entries_ count];
+}
+
 // setEntries: and addEntry: expect the entries to have parents that are
 // nil or this feed instance; setEntriesWithEntries: and addEntryWithEntry:
 // make copies of the supplied entries
 
 - (void)setEntries:(NSArray *)entries {
 
+  [self releaseLazyEntryElements];
+
   [entries_ autorelease];
   entries_ = [entries mutableCopy];
+  entriesMutations_++;
 
   // step through the entries, ensure that none have other parents,
   // make each have this feed as parent
@@ -644,6 +1118,8 @@ forCategoryWithScheme:scheme
 
 - (void)addEntry:(GDataEntryBase *)obj {
 
+  [self createLazyEntries];
+
   if (!entries_) {
     entries_ = [[NSMutableArray alloc] init];
   }
@@ -657,14 +1133,18 @@ forCategoryWithScheme:scheme
 
   [obj setParent:self];
   [entries_ addObject:obj];
+  entriesMutations_++;
 }
 
 - (void)setEntriesWithEntries:(NSArray *)entries {
 
   // make an array containing copies of the entries with this feed
   // as the parent of each entry copy
+  [self releaseLazyEntryElements];
+
   [entries_ autorelease];
   entries_ = nil;
+  entriesMutations_++;
 
   if (entries != nil) {
     entries_ = [[NSMutableArray alloc] initWithCapacity:[entries count]];
@@ -750,6 +1230,37 @@ forCategoryWithScheme:scheme
 
 - (id)entryForIdentifier:(NSString *)str {
 
+  if (lazyEntryElements_ != nil) {
+    // compare the atom:id of entries not yet created without creating them
+    NSUInteger idx = 0;
+    while (idx < [lazyEntryElements_ count]) {
+      NSString *identifier;
+
+      id entry = [entries_ objectAtIndex:idx];
+      if (entry != [NSNull null]) {
+        identifier = [entry identifier];
+      } else {
+        NSXMLElement *element = [lazyEntryElements_ objectAtIndex:idx];
+        NSArray *idElements = [self childElementsOfElement:element
+                                             qualifiedName:@"id"
+                                              namespaceURI:kGDataNamespaceAtom];
+        NSXMLElement *idElement = [idElements count] > 0 ?
+          [idElements objectAtIndex:0] : nil;
+        identifier = [self stringValueFromElement:idElement];
+      }
+
+      if (AreEqualOrBothNil(identifier, str)) {
+        entry = [self lazyEntryAtIndex:idx];
+        if (entry) return entry;
+
+        // the entry was dropped, and its successor moved to this index
+        continue;
+      }
+      idx++;
+    }
+    return nil;
+  }
+
   GDataEntryBase *desiredEntry;
   desiredEntry = [GDataUtilities firstObjectFromArray:[self entries]
                                             withValue:str
@@ -762,15 +1273,63 @@ forCategoryWithScheme:scheme
 }
 
 - (id)entryAtIndex:(NSUInteger)idx {
-  NSArray *entries = [self entries];
-  if ([entries count] > idx) {
-    return [entries objectAtIndex:idx];
+  if (lazyEntryElements_ != nil) {
+    // if the entry fails to parse, it is dropped and the next entry takes
+    // its index
+    while (idx < [lazyEntryElements_ count]) {
+      GDataEntryBase *entry = [self lazyEntryAtIndex:idx];
+      if (entry) return entry;
+    }
+    return nil;
+  }
+
+  if ([entries_ count] > idx) {
+    return [entries_ objectAtIndex:idx];
   }
   return nil;
 }
 
 - (NSArray *)entriesWithCategoryKind:(NSString *)term {
 
+  if (lazyEntryElements_ != nil) {
+    // compare the kind category of entries not yet created without creating
+    // them
+    NSMutableArray *kindEntries = [NSMutableArray array];
+
+    NSUInteger idx = 0;
+    while (idx < [lazyEntryElements_ count]) {
+      NSString *kindTerm = nil;
+
+      id entry = [entries_ objectAtIndex:idx];
+      if (entry != [NSNull null]) {
+        kindTerm = [[entry kindCategory] term];
+      } else {
+        NSXMLElement *element = [lazyEntryElements_ objectAtIndex:idx];
+        NSArray *categoryElements = [self childElementsOfElement:element
+                                                   qualifiedName:@"category"
+                                                    namespaceURI:kGDataNamespaceAtom];
+        for (NSXMLElement *categoryElement in categoryElements) {
+          NSString *scheme = [[categoryElement attributeForName:@"scheme"] stringValue];
+          if ([scheme isEqual:kGDataCategoryScheme]) {
+            kindTerm = [[categoryElement attributeForName:@"term"] stringValue];
+            break;
+          }
+        }
+      }
+
+      if (AreEqualOrBothNil(kindTerm, term)) {
+        entry = [self lazyEntryAtIndex:idx];
+        if (entry == nil) {
+          // the entry was dropped, and its successor moved to this index
+          continue;
+        }
+        [kindEntries addObject:entry];
+      }
+      idx++;
+    }
+    return kindEntries;
+  }
+
   NSArray *kindEntries = [GDataUtilities objectsFromArray:[self entries]
                                                 withValue:term
                                                forKeyPath:@"kindCategory.term"];
@@ -781,10 +1340,33 @@ forCategoryWithScheme:scheme
 - (NSUInteger)countByEnumeratingWithState:(NSFastEnumerationState *)state
                                   objects:(id *)stackbuf
                                     count:(NSUInteger)len {
-  NSUInteger result = [entries_ countByEnumeratingWithState:state
-                                                    objects:stackbuf
-                                                      count:len];
-  return result;
+
+  // state->state is the index of the next entry to enumerate; entries of a
+  // lazily-parsed feed are created a batch at a time.  Setting or adding
+  // entries is a mutation, but dropping an entry that fails to parse is not,
+  // since it moves only entries the enumeration has not yet reached.
+  if (state->state == 0) {
+    state->mutationsPtr = &entriesMutations_;
+  }
+  state->itemsPtr = stackbuf;
+
+  NSUInteger count = 0;
+  while (count < len && state->state < [entries_ count]) {
+    NSUInteger idx = (NSUInteger) state->state;
+
+    GDataEntryBase *entry;
+    if (lazyEntryElements_ != nil) {
+      entry = [self lazyEntryAtIndex:idx];
+
+      // a dropped entry's successor moves to this index
+      if (entry == nil) continue;
+    } else {
+      entry = [entries_ objectAtIndex:idx];
+    }
+    stackbuf[count++] = entry;
+    state->state++;
+  }
+  return count;
 }
 
 @end
@@ -0,0 +1,936 @@
+/* Copyright (c) 2026 Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//
+//  GDataObject+Snapshots.m
+//
+
+#import "GDataObject.h"
+#import "GDataFeedBase.h"
+#import "GDataEntryBase.h"
+
+// A snapshot is a header, a table of the offsets and lengths of its strings,
+// a flat array of records, and the UTF-8 bytes of the strings, all in the
+// native byte order.  Each record is a type and three arguments, which are
+// string indexes, counts, or flags.  An object or an XML element is a record
+// followed by the records of its contents and an end record.
+typedef struct {
+  uint32_t magic;
+  uint32_t formatVersion;
+  uint32_t stringCount;
+  uint32_t recordCount;
+  uint32_t stringBytesLength;
+  uint32_t reserved;
+} GDataSnapshotHeader;
+
+typedef struct {
+  uint32_t offset;
+  uint32_t length;
+} GDataSnapshotString;
+
+typedef struct {
+  uint32_t type;
+  uint32_t args[3];
+} GDataSnapshotRecord;
+
+static const uint32_t kGDataSnapshotMagic = 0x6E534447; // "GDSn" in little-endian order
+static const uint32_t kGDataSnapshotFormatVersion = 1;
+static const uint32_t kGDataSnapshotNoString = UINT32_MAX;
+
+// objects and XML elements nested more deeply than this are refused when
+// reading, so damaged data cannot exhaust the stack; libxml refuses documents
+// nested more deeply than 256 elements as well
+static const NSUInteger kGDataSnapshotMaxDepth = 256;
+
+// snapshot record types, with their arguments
+enum {
+  kSnapshotRecordEnd = 0,
+  kSnapshotRecordObject,             // class, element name, flags
+  kSnapshotRecordObjectXML,          // class, service version, flags; followed by an element
+  kSnapshotRecordServiceVersion,     // version
+  kSnapshotRecordNamespace,          // prefix, URI
+  kSnapshotRecordAttributeDeclaration, // local name or marker
+  kSnapshotRecordAttribute,          // name, value
+  kSnapshotRecordContentValue,       // value
+  kSnapshotRecordChildXMLElement,    // followed by a node
+  kSnapshotRecordUnknownChild,       // followed by a node
+  kSnapshotRecordUnknownAttribute,   // name, value
+  kSnapshotRecordExtension,          // class, number of values, is array; followed by the values
+  kSnapshotRecordAttributeExtension, // class, value
+  kSnapshotRecordGenerator,          // followed by an object
+  kSnapshotRecordEntry,              // followed by an object
+  kSnapshotRecordElement,            // name; followed by namespaces, attributes, and child nodes
+  kSnapshotRecordText,               // value
+  kSnapshotRecordXMLNode             // XML of other kinds of nodes
+};
+
+// flags of object records
+static const uint32_t kSnapshotObjectIgnoresUnknowns = 1U << 0;
+
+// A snapshot writer collects the strings and records of a snapshot.
+@interface GDataSnapshotWriter : NSObject {
+  NSMutableData *strings_;
+  NSMutableData *stringBytes_;
+  NSMutableData *records_;
+  NSMutableDictionary *stringIndexes_;
+}
+- (uint32_t)indexOfString:(NSString *)str;
+- (void)addRecordOfType:(uint32_t)type
+                   arg0:(uint32_t)arg0
+                   arg1:(uint32_t)arg1
+                   arg2:(uint32_t)arg2;
+- (void)addRecordsForXMLNode:(NSXMLNode *)node;
+
+// snapshotDataWithError: returns nil if the strings or records are too many
+// for the 32-bit offsets and counts of the format
+- (NSData *)snapshotDataWithError:(NSError **)error;
+@end
+
+// A snapshot reader steps through the records of a snapshot, making each
+// string and class of the string table only once.  The reader becomes
+// invalid at the first malformed record, and then returns no more records.
+@interface GDataSnapshotReader : NSObject {
+  NSData *data_;
+  const GDataSnapshotString *strings_;
+  const GDataSnapshotRecord *records_;
+  const char *stringBytes_;
+  uint32_t stringCount_;
+  uint32_t recordCount_;
+  uint32_t stringBytesLength_;
+  uint32_t nextRecordIndex_;
+  NSUInteger depth_;
+  id *stringObjects_;
+  Class *classObjects_;
+  NSInteger errorCode_;
+  NSString *unknownClassName_;
+}
+- (id)initWithData:(NSData *)data;
+- (const GDataSnapshotRecord *)nextRecord;
+- (NSString *)stringAtIndex:(uint32_t)idx;
+- (Class)classAtIndex:(uint32_t)idx kindOfClass:(Class)baseClass;
+- (NSXMLNode *)XMLNodeForRecord:(const GDataSnapshotRecord *)record;
+
+// enterNestedRecord marks the reader invalid and returns NO if the records
+// are nested too deeply; each successful call is balanced by a call to
+// leaveNestedRecord
+- (BOOL)enterNestedRecord;
+- (void)leaveNestedRecord;
+
+- (void)markInvalid;
+- (BOOL)isValid;
+- (NSError *)error;
+@end
+
+// GDataObject's methods for restoring objects, implemented in GDataObject.m
+@interface GDataObject (GDataSnapshotSupport)
++ (BOOL)hasStandardXML;
+- (void)restoreAttributeDeclarations:(NSArray *)attrDecls;
+- (void)setExtensions:(NSDictionary *)extensions;
+@end
+
+@interface GDataObject (GDataSnapshotPrivateMethods)
+- (void)addToSnapshotWriter:(GDataSnapshotWriter *)writer
+       parentServiceVersion:(NSString *)parentVersion;
+- (id)initWithSnapshotReader:(GDataSnapshotReader *)reader
+                      record:(const GDataSnapshotRecord *)objectRecord
+                      parent:(GDataObject *)parent;
++ (id)objectWithSnapshotReader:(GDataSnapshotReader *)reader
+                        record:(const GDataSnapshotRecord *)record
+                        parent:(GDataObject *)parent;
+@end
+
+@implementation GDataObject (GDataSnapshots)
+
+- (NSData *)snapshotData {
+  return [self snapshotDataWithError:NULL];
+}
+
+- (NSData *)snapshotDataWithError:(NSError **)error {
+  GDataSnapshotWriter *writer = [[[GDataSnapshotWriter alloc] init] autorelease];
+  [self addToSnapshotWriter:writer parentServiceVersion:nil];
+  return [writer snapshotDataWithError:error];
+}
+
++ (id)objectWithSnapshotData:(NSData *)data error:(NSError **)error {
+  GDataSnapshotReader *reader = [[[GDataSnapshotReader alloc] initWithData:data] autorelease];
+
+  GDataObject *obj = nil;
+  const GDataSnapshotRecord *record = [reader nextRecord];
+  if (record != NULL) {
+    obj = [GDataObject objectWithSnapshotReader:reader
+                                         record:record
+                                         parent:nil];
+  }
+
+  // the snapshot holds a single tree of the receiver's class
+  if (obj == nil
+      || [reader nextRecord] != NULL
+      || ![obj isKindOfClass:self]) {
+    [reader markInvalid];
+  }
+
+  if (![reader isValid]) {
+    if (error) *error = [reader error];
+    return nil;
+  }
+  return obj;
+}
+
++ (id)objectWithContentsOfSnapshotFile:(NSString *)path error:(NSError **)error {
+  NSData *data = [NSData dataWithContentsOfFile:path
+                                        options:NSDataReadingMappedIfSafe
+                                          error:error];
+  if (data == nil) return nil;
+
+  return [self objectWithSnapshotData:data error:error];
+}
+
+- (void)addToSnapshotWriter:(GDataSnapshotWriter *)writer
+       parentServiceVersion:(NSString *)parentVersion {
+
+  uint32_t classIndex = [writer indexOfString:NSStringFromClass([self class])];
+  uint32_t flags = (shouldIgnoreUnknowns_ ? kSnapshotObjectIgnoresUnknowns : 0);
+
+  if (![[self class] hasStandardXML]) {
+    // the object will be parsed from its XML when restored
+    [writer addRecordOfType:kSnapshotRecordObjectXML
+                       arg0:classIndex
+                       arg1:[writer indexOfString:serviceVersion_]
+                       arg2:flags];
+    [writer addRecordsForXMLNode:[self XMLElement]];
+    return;
+  }
+
+  [writer addRecordOfType:kSnapshotRecordObject
+                     arg0:classIndex
+                     arg1:[writer indexOfString:elementName_]
+                     arg2:flags];
+
+  if (!AreEqualOrBothNil(serviceVersion_, parentVersion)) {
+    [writer addRecordOfType:kSnapshotRecordServiceVersion
+                       arg0:[writer indexOfString:serviceVersion_]
+                       arg1:0
+                       arg2:0];
+  }
+
+  for (NSString *prefix in namespaces_) {
+    [writer addRecordOfType:kSnapshotRecordNamespace
+                       arg0:[writer indexOfString:prefix]
+                       arg1:[writer indexOfString:[namespaces_ objectForKey:prefix]]
+                       arg2:0];
+  }
+
+  for (NSString *decl in attributeDeclarations_) {
+    [writer addRecordOfType:kSnapshotRecordAttributeDeclaration
+                       arg0:[writer indexOfString:decl]
+                       arg1:0
+                       arg2:0];
+  }
+
+  for (NSString *name in attributes_) {
+    [writer addRecordOfType:kSnapshotRecordAttribute
+                       arg0:[writer indexOfString:name]
+                       arg1:[writer indexOfString:[attributes_ objectForKey:name]]
+                       arg2:0];
+  }
+
+  if (contentValue_ != nil) {
+    [writer addRecordOfType:kSnapshotRecordContentValue
+                       arg0:[writer indexOfString:contentValue_]
+                       arg1:0
+                       arg2:0];
+  }
+
+  for (NSXMLNode *node in childXMLElements_) {
+    [writer addRecordOfType:kSnapshotRecordChildXMLElement arg0:0 arg1:0 arg2:0];
+    [writer addRecordsForXMLNode:node];
+  }
+
+  for (NSXMLNode *node in [self unknownChildren]) {
+    [writer addRecordOfType:kSnapshotRecordUnknownChild arg0:0 arg1:0 arg2:0];
+    [writer addRecordsForXMLNode:node];
+  }
+
+  for (NSXMLNode *attr in unknownAttributes_) {
+    [writer addRecordOfType:kSnapshotRecordUnknownAttribute
+                       arg0:[writer indexOfString:[attr name]]
+                       arg1:[writer indexOfString:[attr stringValue]]
+                       arg2:0];
+  }
+
+  for (Class extensionClass in extensions_) {
+    id objectOrArray = [extensions_ objectForKey:extensionClass];
+
+    BOOL isArray = [objectOrArray isKindOfClass:[NSArray class]];
+    NSArray *values = (isArray ? objectOrArray : [NSArray arrayWithObject:objectOrArray]);
+
+    [writer addRecordOfType:kSnapshotRecordExtension
+                       arg0:[writer indexOfString:NSStringFromClass(extensionClass)]
+                       arg1:(uint32_t)[values count]
+                       arg2:(isArray ? 1 : 0)];
+
+    for (id value in values) {
+      if ([value isKindOfClass:[GDataAttribute class]]) {
+        [writer addRecordOfType:kSnapshotRecordAttributeExtension
+                           arg0:[writer indexOfString:NSStringFromClass([value class])]
+                           arg1:[writer indexOfString:[value stringValue]]
+                           arg2:0];
+      } else {
+        [value addToSnapshotWriter:writer parentServiceVersion:serviceVersion_];
+      }
+    }
+  }
+
+  if ([self isKindOfClass:[GDataFeedBase class]]) {
+    GDataFeedBase *feed = (GDataFeedBase *)self;
+
+    GDataGenerator *generator = [feed generator];
+    if (generator != nil) {
+      [writer addRecordOfType:kSnapshotRecordGenerator arg0:0 arg1:0 arg2:0];
+      [generator addToSnapshotWriter:writer parentServiceVersion:serviceVersion_];
+    }
+
+    for (GDataEntryBase *entry in [feed entries]) {
+      [writer addRecordOfType:kSnapshotRecordEntry arg0:0 arg1:0 arg2:0];
+      [entry addToSnapshotWriter:writer parentServiceVersion:serviceVersion_];
+    }
+  }
+
+  [writer addRecordOfType:kSnapshotRecordEnd arg0:0 arg1:0 arg2:0];
+}
+
+// objectWithSnapshotReader:record:parent: returns the object restored from
+// the records starting with the given one, or nil if the reader becomes
+// invalid
++ (id)objectWithSnapshotReader:(GDataSnapshotReader *)reader
+                        record:(const GDataSnapshotRecord *)record
+                        parent:(GDataObject *)parent {
+
+  if (record->type != kSnapshotRecordObject
+      && record->type != kSnapshotRecordObjectXML) {
+    [reader markInvalid];
+    return nil;
+  }
+
+  Class objClass = [reader classAtIndex:record->args[0]
+                            kindOfClass:[GDataObject class]];
+  if (objClass == Nil) return nil;
+
+  GDataObject *obj;
+
+  if (record->type == kSnapshotRecordObject) {
+    obj = [[[objClass alloc] initWithSnapshotReader:reader
+                                             record:record
+                                             parent:parent] autorelease];
+  } else {
+    NSString *serviceVersion = [reader stringAtIndex:record->args[1]];
+    BOOL shouldIgnoreUnknowns = ((record->args[2] & kSnapshotObjectIgnoresUnknowns) != 0);
+
+    const GDataSnapshotRecord *elementRecord = [reader nextRecord];
+    if (elementRecord == NULL || elementRecord->type != kSnapshotRecordElement) {
+      [reader markInvalid];
+      return nil;
+    }
+    NSXMLElement *element = (NSXMLElement *)[reader XMLNodeForRecord:elementRecord];
+    if (element == nil) return nil;
+
+    if (parent == nil) {
+      obj = [[[objClass alloc] initWithXMLElement:element
+                                           parent:nil
+                                   serviceVersion:serviceVersion
+                                       surrogates:nil
+                                  parseProjection:nil
+                             shouldIgnoreUnknowns:shouldIgnoreUnknowns
+                      shouldDetachFromXMLDocument:NO] autorelease];
+    } else {
+      obj = [[[objClass alloc] initWithXMLElement:element
+                                           parent:parent] autorelease];
+      [obj gatherUnknownChildren];
+    }
+  }
+
+  if (![reader isValid]) return nil;
+  return obj;
+}
+
+- (id)initWithSnapshotReader:(GDataSnapshotReader *)reader
+                      record:(const GDataSnapshotRecord *)objectRecord
+                      parent:(GDataObject *)parent {
+  if (![reader enterNestedRecord]) {
+    [self release];
+    return nil;
+  }
+
+  self = [super init];
+  if (self) {
+    [self setParent:parent];
+    if (parent != nil) {
+      [self setServiceVersion:parent->serviceVersion_];
+    }
+    [self setElementName:[reader stringAtIndex:objectRecord->args[1]]];
+    [self setShouldIgnoreUnknowns:((objectRecord->args[2] & kSnapshotObjectIgnoresUnknowns) != 0)];
+
+    NSMutableDictionary *namespaces = nil;
+    NSMutableArray *attrDecls = nil;
+    NSMutableDictionary *attributes = nil;
+    NSString *contentValue = nil;
+    NSMutableArray *childXMLElements = nil;
+    NSMutableArray *unknownChildren = nil;
+    NSMutableArray *unknownAttributes = nil;
+    NSMutableDictionary *extensions = nil;
+    GDataGenerator *generator = nil;
+    NSMutableArray *entries = nil;
+
+    const GDataSnapshotRecord *record;
+    while ((record = [reader nextRecord]) != NULL
+           && record->type != kSnapshotRecordEnd) {
+
+      switch (record->type) {
+        case kSnapshotRecordServiceVersion:
+          [self setServiceVersion:[reader stringAtIndex:record->args[0]]];
+          break;
+
+        case kSnapshotRecordNamespace: {
+          NSString *prefix = [reader stringAtIndex:record->args[0]];
+          NSString *uri = [reader stringAtIndex:record->args[1]];
+          if (prefix == nil || uri == nil) {
+            [reader markInvalid];
+            break;
+          }
+          if (namespaces == nil) namespaces = [NSMutableDictionary dictionary];
+          [namespaces setObject:uri forKey:prefix];
+          break;
+        }
+
+        case kSnapshotRecordAttributeDeclaration: {
+          NSString *decl = [reader stringAtIndex:record->args[0]];
+          if (decl == nil) {
+            [reader markInvalid];
+            break;
+          }
+          if (attrDecls == nil) attrDecls = [NSMutableArray array];
+          [attrDecls addObject:decl];
+          break;
+        }
+
+        case kSnapshotRecordAttribute: {
+          NSString *name = [reader stringAtIndex:record->args[0]];
+          NSString *value = [reader stringAtIndex:record->args[1]];
+          if (name == nil || value == nil) {
+            [reader markInvalid];
+            break;
+          }
+          if (attributes == nil) attributes = [NSMutableDictionary dictionary];
+          [attributes setObject:value forKey:name];
+          break;
+        }
+
+        case kSnapshotRecordContentValue:
+          contentValue = [reader stringAtIndex:record->args[0]];
+          break;
+
+        case kSnapshotRecordChildXMLElement:
+        case kSnapshotRecordUnknownChild: {
+          const GDataSnapshotRecord *nodeRecord = [reader nextRecord];
+          NSXMLNode *node = (nodeRecord ? [reader XMLNodeForRecord:nodeRecord] : nil);
+          if (node == nil) {
+            [reader markInvalid];
+            break;
+          }
+          if (record->type == kSnapshotRecordChildXMLElement) {
+            if (childXMLElements == nil) childXMLElements = [NSMutableArray array];
+            [childXMLElements addObject:node];
+          } else {
+            if (unknownChildren == nil) unknownChildren = [NSMutableArray array];
+            [unknownChildren addObject:node];
+          }
+          break;
+        }
+
+        case kSnapshotRecordUnknownAttribute: {
+          NSString *name = [reader stringAtIndex:record->args[0]];
+          NSString *value = [reader stringAtIndex:record->args[1]];
+          if (name == nil || value == nil) {
+            [reader markInvalid];
+            break;
+          }
+          if (unknownAttributes == nil) unknownAttributes = [NSMutableArray array];
+          [unknownAttributes addObject:[NSXMLNode attributeWithName:name
+                                                        stringValue:value]];
+          break;
+        }
+
+        case kSnapshotRecordExtension: {
+          Class extensionClass = [reader classAtIndex:record->args[0]
+                                          kindOfClass:Nil];
+          uint32_t numberOfValues = record->args[1];
+          BOOL isArray = (record->args[2] != 0);
+          if (extensionClass == Nil || (!isArray && numberOfValues != 1)) {
+            [reader markInvalid];
+            break;
+          }
+
+          NSMutableArray *values = [NSMutableArray array];
+          for (uint32_t idx = 0; idx < numberOfValues; idx++) {
+            const GDataSnapshotRecord *valueRecord = [reader nextRecord];
+            if (valueRecord == NULL) break;
+
+            id value;
+            if (valueRecord->type == kSnapshotRecordAttributeExtension) {
+              Class attrClass = [reader classAtIndex:valueRecord->args[0]
+                                         kindOfClass:[GDataAttribute class]];
+              NSString *str = [reader stringAtIndex:valueRecord->args[1]];
+              value = [attrClass attributeWithValue:str];
+            } else {
+              value = [GDataObject objectWithSnapshotReader:reader
+                                                     record:valueRecord
+                                                     parent:self];
+            }
+            if (value == nil) break;
+            [values addObject:value];
+          }
+
+          if ([values count] != numberOfValues) {
+            [reader markInvalid];
+            break;
+          }
+          if (extensions == nil) extensions = [NSMutableDictionary dictionary];
+          id objectOrArray = (isArray ? (id)values : [values objectAtIndex:0]);
+          [extensions setObject:objectOrArray forKey:(id<NSCopying>)extensionClass];
+          break;
+        }
+
+        case kSnapshotRecordGenerator:
+        case kSnapshotRecordEntry: {
+          const GDataSnapshotRecord *childRecord = [reader nextRecord];
+          GDataObject *child = nil;
+          if (childRecord != NULL && [self isKindOfClass:[GDataFeedBase class]]) {
+            child = [GDataObject objectWithSnapshotReader:reader
+                                                   record:childRecord
+                                                   parent:self];
+          }
+          if (child == nil) {
+            [reader markInvalid];
+            break;
+          }
+          if (record->type == kSnapshotRecordGenerator) {
+            generator = (GDataGenerator *)child;
+          } else {
+            if (entries == nil) entries = [NSMutableArray array];
+            [entries addObject:child];
+          }
+          break;
+        }
+
+        default:
+          [reader markInvalid];
+          break;
+      }
+
+      if (![reader isValid]) break;
+    }
+    [reader leaveNestedRecord];
+
+    if (record == NULL) {
+      // the object's records ended early
+      [reader markInvalid];
+    }
+    if (![reader isValid]) {
+      [self release];
+      return nil;
+    }
+
+    if (attrDecls != nil) {
+      [self restoreAttributeDeclarations:attrDecls];
+    }
+
+    // the content value and child XML elements are kept only if declared
+    if (contentValue != nil && [self hasDeclaredContentValue]) {
+      [self setContentStringValue:contentValue];
+    }
+    if (childXMLElements != nil && [self hasDeclaredChildXMLElements]) {
+      [self setChildXMLElements:childXMLElements];
+    }
+
+    [self setNamespaces:namespaces];
+    [self setAttributes:attributes];
+    [self setUnknownChildren:unknownChildren];
+    [self setUnknownAttributes:unknownAttributes];
+    [self setExtensions:extensions];
+
+    if (generator != nil) {
+      [(GDataFeedBase *)self setGenerator:generator];
+    }
+    if (entries != nil) {
+      [(GDataFeedBase *)self setEntries:entries];
+    }
+  }
+  return self;
+}
+
+@end
+
+@implementation GDataSnapshotWriter
+
+- (id)init {
+  self = [super init];
+  if (self) {
+    strings_ = [[NSMutableData alloc] init];
+    stringBytes_ = [[NSMutableData alloc] init];
+    records_ = [[NSMutableData alloc] init];
+    stringIndexes_ = [[NSMutableDictionary alloc] init];
+  }
+  return self;
+}
+
+- (void)dealloc {
+  [strings_ release];
+  [stringBytes_ release];
+  [records_ release];
+  [stringIndexes_ release];
+  [super dealloc];
+}
+
+- (uint32_t)indexOfString:(NSString *)str {
+  if (str == nil) return kGDataSnapshotNoString;
+
+  NSNumber *indexNum = [stringIndexes_ objectForKey:str];
+  if (indexNum != nil) return (uint32_t)[indexNum unsignedIntValue];
+
+  uint32_t idx = (uint32_t)[stringIndexes_ count];
+  [stringIndexes_ setObject:[NSNumber numberWithUnsignedInt:idx] forKey:str];
+
+  const char *utf8 = [str UTF8String];
+  GDataSnapshotString entry;
+  entry.offset = (uint32_t)[stringBytes_ length];
+  entry.length = (uint32_t)strlen(utf8);
+  [strings_ appendBytes:&entry length:sizeof(entry)];
+  [stringBytes_ appendBytes:utf8 length:entry.length];
+  return idx;
+}
+
+- (void)addRecordOfType:(uint32_t)type
+                   arg0:(uint32_t)arg0
+                   arg1:(uint32_t)arg1
+                   arg2:(uint32_t)arg2 {
+  GDataSnapshotRecord record = { type, { arg0, arg1, arg2 } };
+  [records_ appendBytes:&record length:sizeof(record)];
+}
+
+- (void)addRecordsForXMLNode:(NSXMLNode *)node {
+  NSXMLNodeKind kind = [node kind];
+
+  if (kind == NSXMLElementKind) {
+    NSXMLElement *element = (NSXMLElement *)node;
+
+    // qualified names are kept, as GDataObject generates them; their
+    // prefixes are resolved when the node is added to a tree
+    [self addRecordOfType:kSnapshotRecordElement
+                     arg0:[self indexOfString:[element name]]
+                     arg1:0
+                     arg2:0];
+
+    for (NSXMLNode *ns in [element namespaces]) {
+      [self addRecordOfType:kSnapshotRecordNamespace
+                       arg0:[self indexOfString:[ns name]]
+                       arg1:[self indexOfString:[ns stringValue]]
+                       arg2:0];
+    }
+    for (NSXMLNode *attr in [element attributes]) {
+      [self addRecordOfType:kSnapshotRecordAttribute
+                       arg0:[self indexOfString:[attr name]]
+                       arg1:[self indexOfString:[attr stringValue]]
+                       arg2:0];
+    }
+    for (NSXMLNode *child in [element children]) {
+      [self addRecordsForXMLNode:child];
+    }
+    [self addRecordOfType:kSnapshotRecordEnd arg0:0 arg1:0 arg2:0];
+
+  } else if (kind == NSXMLTextKind) {
+    [self addRecordOfType:kSnapshotRecordText
+                     arg0:[self indexOfString:[node stringValue]]
+                     arg1:0
+                     arg2:0];
+  } else {
+    // comments and processing instructions are rare enough to be kept as XML
+    [self addRecordOfType:kSnapshotRecordXMLNode
+                     arg0:[self indexOfString:[node XMLString]]
+                     arg1:0
+                     arg2:0];
+  }
+}
+
+- (NSData *)snapshotDataWithError:(NSError **)error {
+  // the offsets and lengths of strings were truncated to 32 bits if the
+  // string bytes exceed 4 GB, so such snapshots cannot be written
+  unsigned long long recordCount = [records_ length] / sizeof(GDataSnapshotRecord);
+  if ((unsigned long long)[stringBytes_ length] > UINT32_MAX
+      || (unsigned long long)[stringIndexes_ count] >= kGDataSnapshotNoString
+      || recordCount > UINT32_MAX) {
+    if (error) {
+      *error = [NSError errorWithDomain:kGDataSnapshotErrorDomain
+                                   code:kGDataSnapshotTooLargeError
+                               userInfo:nil];
+    }
+    return nil;
+  }
+
+  GDataSnapshotHeader header;
+  header.magic = kGDataSnapshotMagic;
+  header.formatVersion = kGDataSnapshotFormatVersion;
+  header.stringCount = (uint32_t)[stringIndexes_ count];
+  header.recordCount = (uint32_t)recordCount;
+  header.stringBytesLength = (uint32_t)[stringBytes_ length];
+  header.reserved = 0;
+
+  NSUInteger length = sizeof(header) + [strings_ length]
+    + [records_ length] + [stringBytes_ length];
+  NSMutableData *data = [NSMutableData dataWithCapacity:length];
+  [data appendBytes:&header length:sizeof(header)];
+  [data appendData:strings_];
+  [data appendData:records_];
+  [data appendData:stringBytes_];
+  return data;
+}
+
+@end
+
+@implementation GDataSnapshotReader
+
+- (id)initWithData:(NSData *)data {
+  self = [super init];
+  if (self) {
+    data_ = [data retain];
+
+    const GDataSnapshotHeader *header = [data_ bytes];
+    NSUInteger length = [data_ length];
+
+    if (length < sizeof(GDataSnapshotHeader)
+        || header->magic != kGDataSnapshotMagic
+        || header->formatVersion != kGDataSnapshotFormatVersion) {
+      [self markInvalid];
+      return self;
+    }
+
+    unsigned long long expectedLength = sizeof(GDataSnapshotHeader)
+      + (unsigned long long)header->stringCount * sizeof(GDataSnapshotString)
+      + (unsigned long long)header->recordCount * sizeof(GDataSnapshotRecord)
+      + header->stringBytesLength;
+    if (expectedLength != length) {
+      [self markInvalid];
+      return self;
+    }
+
+    stringCount_ = header->stringCount;
+    recordCount_ = header->recordCount;
+    stringBytesLength_ = header->stringBytesLength;
+
+    strings_ = (const GDataSnapshotString *)(header + 1);
+    records_ = (const GDataSnapshotRecord *)(strings_ + stringCount_);
+    stringBytes_ = (const char *)(records_ + recordCount_);
+
+    if (stringCount_ > 0) {
+      stringObjects_ = calloc(stringCount_, sizeof(id));
+      classObjects_ = calloc(stringCount_, sizeof(Class));
+    }
+  }
+  return self;
+}
+
+- (void)dealloc {
+  if (stringObjects_ != NULL) {
+    for (uint32_t idx = 0; idx < stringCount_; idx++) {
+      [stringObjects_[idx] release];
+    }
+    free(stringObjects_);
+  }
+  free(classObjects_);
+  [unknownClassName_ release];
+  [data_ release];
+  [super dealloc];
+}
+
+- (const GDataSnapshotRecord *)nextRecord {
+  if (errorCode_ != 0 || nextRecordIndex_ >= recordCount_) return NULL;
+
+  return &records_[nextRecordIndex_++];
+}
+
+- (NSString *)stringAtIndex:(uint32_t)idx {
+  if (idx == kGDataSnapshotNoString) return nil;
+
+  if (idx >= stringCount_) {
+    [self markInvalid];
+    return nil;
+  }
+
+  NSString *str = stringObjects_[idx];
+  if (str == nil) {
+    const GDataSnapshotString *entry = &strings_[idx];
+    if ((unsigned long long)entry->offset + entry->length > stringBytesLength_) {
+      [self markInvalid];
+      return nil;
+    }
+    str = [[NSString alloc] initWithBytes:(stringBytes_ + entry->offset)
+                                   length:entry->length
+                                 encoding:NSUTF8StringEncoding];
+    if (str == nil) {
+      [self markInvalid];
+      return nil;
+    }
+    stringObjects_[idx] = str;
+  }
+  return str;
+}
+
+// classAtIndex:kindOfClass: returns the class named by the string, which
+// must be a subclass of the base class if one is specified
+- (Class)classAtIndex:(uint32_t)idx kindOfClass:(Class)baseClass {
+  NSString *className = [self stringAtIndex:idx];
+  if (className == nil) {
+    [self markInvalid];
+    return Nil;
+  }
+
+  Class theClass = classObjects_[idx];
+  if (theClass == Nil) {
+    theClass = NSClassFromString(className);
+    if (theClass == Nil) {
+      if (errorCode_ == 0) {
+        errorCode_ = kGDataSnapshotUnknownClassError;
+        unknownClassName_ = [className copy];
+      }
+      return Nil;
+    }
+    classObjects_[idx] = theClass;
+  }
+
+  if (baseClass != Nil && ![theClass isSubclassOfClass:baseClass]) {
+    [self markInvalid];
+    return Nil;
+  }
+  return theClass;
+}
+
+- (NSXMLNode *)XMLNodeForRecord:(const GDataSnapshotRecord *)record {
+
+  switch (record->type) {
+    case kSnapshotRecordElement: {
+      NSString *name = [self stringAtIndex:record->args[0]];
+      if (name == nil || ![self enterNestedRecord]) break;
+
+      NSXMLElement *element = [NSXMLNode elementWithName:name];
+
+      const GDataSnapshotRecord *childRecord;
+      while ((childRecord = [self nextRecord]) != NULL
+             && childRecord->type != kSnapshotRecordEnd) {
+
+        if (childRecord->type == kSnapshotRecordNamespace) {
+          // the default namespace has no prefix
+          NSString *prefix = [self stringAtIndex:childRecord->args[0]];
+          NSString *uri = [self stringAtIndex:childRecord->args[1]];
+          if (uri == nil) {
+            [self markInvalid];
+            break;
+          }
+          [element addNamespace:[NSXMLNode namespaceWithName:prefix
+                                                 stringValue:uri]];
+        } else if (childRecord->type == kSnapshotRecordAttribute) {
+          NSString *attrName = [self stringAtIndex:childRecord->args[0]];
+          NSString *value = [self stringAtIndex:childRecord->args[1]];
+          if (attrName == nil || value == nil) {
+            [self markInvalid];
+            break;
+          }
+          [element addAttribute:[NSXMLNode attributeWithName:attrName
+                                                 stringValue:value]];
+        } else {
+          NSXMLNode *child = [self XMLNodeForRecord:childRecord];
+          if (child == nil) break;
+          [element addChild:child];
+        }
+        if (![self isValid]) break;
+      }
+      [self leaveNestedRecord];
+
+      if (childRecord == NULL || ![self isValid]) break;
+      return element;
+    }
+
+    case kSnapshotRecordText: {
+      NSString *str = [self stringAtIndex:record->args[0]];
+      if (str == nil) break;
+      return [NSXMLNode textWithStringValue:str];
+    }
+
+    case kSnapshotRecordXMLNode: {
+      NSString *str = [self stringAtIndex:record->args[0]];
+      if (str == nil) break;
+
+      NSString *wrapped = [NSString stringWithFormat:@"<snapshot>%@</snapshot>", str];
+      NSXMLElement *wrapper = [[[NSXMLElement alloc] initWithXMLString:wrapped
+                                                                 error:NULL] autorelease];
+      if ([wrapper childCount] != 1) break;
+
+      // copy the node so it does not belong to the wrapper
+      return [[[wrapper childAtIndex:0] copy] autorelease];
+    }
+
+    default:
+      break;
+  }
+
+  [self markInvalid];
+  return nil;
+}
+
+- (BOOL)enterNestedRecord {
+  if (depth_ >= kGDataSnapshotMaxDepth) {
+    [self markInvalid];
+    return NO;
+  }
+  ++depth_;
+  return YES;
+}
+
+- (void)leaveNestedRecord {
+  --depth_;
+}
+
+- (void)markInvalid {
+  if (errorCode_ == 0) {
+    errorCode_ = kGDataSnapshotInvalidDataError;
+  }
+}
+
+- (BOOL)isValid {
+  return (errorCode_ == 0);
+}
+
+- (NSError *)error {
+  if (errorCode_ == 0) return nil;
+
+  NSDictionary *userInfo = nil;
+  if (unknownClassName_ != nil) {
+    userInfo = [NSDictionary dictionaryWithObject:unknownClassName_
+                                           forKey:kGDataSnapshotClassNameKey];
+  }
+  return [NSError errorWithDomain:kGDataSnapshotErrorDomain
+                             code:errorCode_
+                         userInfo:userInfo];
+}
+
+@end
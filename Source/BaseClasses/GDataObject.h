@@ -130,6 +130,18 @@ _EXTERN NSString* const kGDataNamespaceGDataPrefix _INITIALIZE_AS(@"gd");
 _EXTERN NSString* const kGDataNamespaceBatch       _INITIALIZE_AS(@"http://schemas.google.com/gdata/batch");
 _EXTERN NSString* const kGDataNamespaceBatchPrefix _INITIALIZE_AS(@"batch");
 
+// errors from restoring objects from snapshots
+_EXTERN NSString* const kGDataSnapshotErrorDomain _INITIALIZE_AS(@"com.google.GDataSnapshotDomain");
+
+// for unknown class errors, the error's userInfo has the class name
+_EXTERN NSString* const kGDataSnapshotClassNameKey _INITIALIZE_AS(@"className");
+
+enum {
+  kGDataSnapshotInvalidDataError  = -1,
+  kGDataSnapshotUnknownClassError = -2,
+  kGDataSnapshotTooLargeError     = -3
+};
+
 #define GDATA_DEBUG_ASSERT_MIN_SERVICE_VERSION(versionString) \
   GDATA_DEBUG_ASSERT([self isServiceVersionAtLeast:versionString], \
     @"%@ requires newer version", NSStringFromSelector(_cmd))
@@ -162,6 +174,7 @@ _EXTERN NSString* const kGDataNamespaceBatchPrefix _INITIALIZE_AS(@"batch");
 @interface GDataAttribute : NSObject {
  @private
     NSString *value_;
+    NSUInteger changeStamp_;
 }
 + (GDataAttribute *)attributeWithValue:(NSString *)str;
 - (id)initWithValue:(NSString *)value;
@@ -191,6 +204,22 @@ typedef struct GDataDescriptionRecord {
   GDataDescRecTypes reportType;
 } GDataDescriptionRecord;
 
+// Local attributes may be declared with the type of their values.  The
+// values of typed attributes are parsed when the element is parsed, and
+// the parsed values are kept until the attributes change, so the typed
+// getters need not parse the attribute strings again.  The strings remain
+// the attribute values for XML generation and comparisons.
+
+typedef enum GDataAttributeType {
+  kGDataAttributeTypeString = 0,
+  kGDataAttributeTypeInt,
+  kGDataAttributeTypeLongLong,
+  kGDataAttributeTypeDouble,
+  kGDataAttributeTypeDecimal,
+  kGDataAttributeTypeBool,
+  kGDataAttributeTypeDateTime
+} GDataAttributeType;
+
 
 @interface GDataObject : NSObject <NSCopying> {
 
@@ -216,8 +245,14 @@ typedef struct GDataDescriptionRecord {
   NSMutableDictionary *attributeDeclarationsCache_;
 
   // list of attributes to be parsed for this class (points strongly into the
-  // attribute declarations cache)
+  // attribute declarations cache, or for parsed objects, into the shared
+  // declarations of the class, which are copied before being changed)
   NSMutableArray *attributeDeclarations_;
+  BOOL hasSharedAttributeDeclarations_;
+
+  // declared types of attributes, keyed by attribute name, shared along with
+  // the attribute declarations
+  NSMutableDictionary *attributeTypes_;
 
   // arrays of actual extension elements found for this element, keyed by extension class
   NSMutableDictionary *extensions_;
@@ -225,6 +260,10 @@ typedef struct GDataDescriptionRecord {
   // dictionary of attributes set for this element, keyed by attribute name
   NSMutableDictionary *attributes_;
 
+  // parsed values of attributes, kept until the attributes change
+  struct GDataAttributeValueSlot *attributeValueSlots_;
+  NSUInteger numberOfAttributeValueSlots_;
+
   // string for element body, if declared as parseable
   NSString *contentValue_;
 
@@ -236,10 +275,51 @@ typedef struct GDataDescriptionRecord {
   NSMutableArray *unknownAttributes_;
   BOOL shouldIgnoreUnknowns_;
 
+  // while parsing, the element's child nodes and a bit for each marking
+  // whether it has been parsed; the unknownChildren_ array is gathered from
+  // these once the object's parsing is done.  childPositions_ maps nodes to their positions
+  // for elements with many children
+  NSArray *childNodesBeingParsed_;
+  CFMutableBitVectorRef parsedChildFlags_;
+  CFMutableDictionaryRef childPositions_;
+
+  // objects being parsed from a tree that will be detached from it once
+  // parsing is done; held by the topmost parent only during parsing
+  NSMutableArray *objectsToDetach_;
+  BOOL shouldDetachFromXMLDocument_;
+
+  // memoized hash, valid while neither this object nor the objects beneath
+  // it have changed since cachedHashStamp_
+  NSUInteger cachedHash_;
+  NSUInteger cachedHashStamp_;
+
+  // XML element generated for this object when caching XML, valid while
+  // neither this object nor any object beneath it has a change stamp later
+  // than cachedXMLElementStamp_
+  NSXMLElement *cachedXMLElement_;
+  NSUInteger cachedXMLElementStamp_;
+  NSUInteger changeStamp_;
+  BOOL shouldCacheXMLElements_;
+
+  // nonzero while generating XML with the cache, the epoch of the outermost
+  // generation; the latest change stamp of this object and the objects
+  // beneath it is kept for the epoch in which it was found
+  NSUInteger xmlCacheEpoch_;
+  NSUInteger latestXMLChangeStamp_;
+  NSUInteger latestXMLChangeStampEpoch_;
+
   // mapping of standard classes to user's surrogate subclasses, used when
   // creating objects from XML
   NSDictionary *surrogates_;
 
+  // extension classes and element names to be parsed, set for the top of a
+  // parsed tree, or nil to parse all declared extensions
+  NSSet *parseProjection_;
+
+  // GDataParsePlan used to parse this object; the plans of parsed child
+  // objects are found from it
+  id parsePlan_;
+
   // service version, set for feeds and entries
   NSString *serviceVersion_;
 
@@ -272,6 +352,29 @@ typedef struct GDataDescriptionRecord {
 
 - (NSXMLDocument *)XMLDocument; // returns this XMLElement wrapped in an NSXMLDocument
 
+// writeXMLDocumentToStream:error: writes the text of the XMLDocument to an
+// open output stream.  With libxml, the text is written as the elements are
+// generated, without adding them to a document; feeds generate and write
+// each entry in turn, so the XML of all the entries is never held at once.
+- (BOOL)writeXMLDocumentToStream:(NSOutputStream *)stream
+                           error:(NSError **)error;
+
+// the cached elements are read and filled on the object's own thread, so
+// code writing an object's XML on another thread passes NO to leave the
+// caches alone; the object must not change while it is written
+- (BOOL)writeXMLDocumentToStream:(NSOutputStream *)stream
+                      usingCache:(BOOL)shouldUseCache
+                           error:(NSError **)error;
+
+// objects caching XML keep the elements generated for their child objects,
+// so XMLDocument and writeXMLDocumentToStream:error: regenerate only the
+// parts of the tree changed since the XML was last generated, as when
+// updating an entry after a few edits.  Elements of classes generating XML
+// from their own instance variables are not cached.  Clearing the setting
+// releases the cached elements.
+- (void)setShouldCacheXMLElements:(BOOL)flag;
+- (BOOL)shouldCacheXMLElements;
+
 // setters/getters
 
 // namespaces here are a dictionary mapping prefix to URI; they are not
@@ -300,6 +403,21 @@ typedef struct GDataDescriptionRecord {
 - (void)setSurrogates:(NSDictionary *)surrogates;
 - (NSDictionary *)surrogates;
 
+// A parse projection limits the element extensions created when parsing to
+// those whose classes or qualified element names (like @"title" or
+// @"gd:when") are in the set; it applies at every level of the tree below
+// the object for which it is set.  Elements not parsed are kept as unknown
+// children, so they are still written back in the object's XML, unless
+// unknowns are ignored.  Attribute extensions are always parsed.
+- (void)setParseProjection:(NSSet *)projection;
+- (NSSet *)parseProjection;
+
+// parseProjectionWithFieldSelection: makes a projection of the element names
+// in a field selection string like that of GDataQuery's setFieldSelection:,
+// such as @"id,updated,title,link[@rel='alternate'](@href)"; the element
+// nesting and conditions are ignored
++ (NSSet *)parseProjectionWithFieldSelection:(NSString *)fieldSelection;
+
 // service API version
 + (NSString *)defaultServiceVersion;
 
@@ -343,6 +461,12 @@ typedef struct GDataDescriptionRecord {
 - (void)setShouldIgnoreUnknowns:(BOOL)flag;
 - (BOOL)shouldIgnoreUnknowns;
 
+// objects parsed detached from their XML document keep standalone copies
+// of their unknown nodes rather than nodes of the document, so they do not
+// keep the document alive; see GDataServiceBase for more information
+- (void)setShouldDetachFromXMLDocument:(BOOL)flag;
+- (BOOL)shouldDetachFromXMLDocument;
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 //  Protected methods
@@ -361,12 +485,53 @@ typedef struct GDataDescriptionRecord {
               surrogates:(NSDictionary *)surrogates
     shouldIgnoreUnknowns:(BOOL)shouldIgnoreUnknowns;
 
+// as above; once the tree's objects are all parsed, they are detached from
+// the XML document if shouldDetach is set, so the caller need not retain the
+// document
+- (id)initWithXMLElement:(NSXMLElement *)element
+                  parent:(GDataObject *)parent
+          serviceVersion:(NSString *)serviceVersion
+              surrogates:(NSDictionary *)surrogates
+    shouldIgnoreUnknowns:(BOOL)shouldIgnoreUnknowns
+shouldDetachFromXMLDocument:(BOOL)shouldDetach;
+
+// as above, parsing only the extensions in the projection, if it is non-nil
+- (id)initWithXMLElement:(NSXMLElement *)element
+                  parent:(GDataObject *)parent
+          serviceVersion:(NSString *)serviceVersion
+              surrogates:(NSDictionary *)surrogates
+         parseProjection:(NSSet *)projection
+    shouldIgnoreUnknowns:(BOOL)shouldIgnoreUnknowns
+shouldDetachFromXMLDocument:(BOOL)shouldDetach;
+
 - (void)addExtensionDeclarations; // subclasses may override this to declare extensions
 
 - (void)addParseDeclarations; // subclasses may override this to declare local attributes and content value
 
 - (void)clearExtensionDeclarationsCache; // used by GDataServiceBase and by subclasses
 
+// XMLElementUsingCache returns the cached element for this object if neither
+// it nor the objects beneath it have changed since the element was generated;
+// otherwise it calls XMLElement, using the cached elements of unchanged child
+// objects.  The caller gets its own copy of the element, which it may modify.
+- (NSXMLElement *)XMLElementUsingCache;
+
+// classes may cache their elements if the XML is generated entirely from the
+// state kept by GDataObject; subclasses generating XML from their own
+// instance variables may override this to return YES if their setters call
+// noteXMLChange, and if they return any GDataObjects held in those instance
+// variables from childObjectsOutsideExtensions
++ (BOOL)canCacheXMLElement;
+- (void)noteXMLChange;
+- (NSArray *)childObjectsOutsideExtensions;
+
+// YES if the class uses theClass's XMLElement and addAttributesToElement:
+// methods, so overrides of canCacheXMLElement can exclude subclasses that
+// generate their XML differently
++ (BOOL)hasXMLElementOfClass:(Class)theClass;
+
+- (void)releaseCachedXMLElements; // releases the cache of this object and those beneath it
+
 // content stream and upload data: these always return NO/nil for objects
 // other than entries
 
@@ -425,6 +590,11 @@ typedef struct GDataDescriptionRecord {
 // automatically be parsed
 - (void)addLocalAttributeDeclarations:(NSArray *)attributeLocalNames;
 
+// typed attributes have their values parsed once, and kept until changed
+- (void)addLocalAttributeDeclarations:(NSArray *)attributeLocalNames
+                               ofType:(GDataAttributeType)type;
+- (GDataAttributeType)typeForAttribute:(NSString *)name;
+
 - (NSString *)stringValueForAttribute:(NSString *)name;
 - (NSNumber *)intNumberForAttribute:(NSString *)name;
 - (NSNumber *)doubleNumberForAttribute:(NSString *)name;
@@ -522,6 +692,24 @@ forCategoryWithScheme:(NSString *)scheme
                            namespaceURI:(NSString *)namespaceURI
                             objectClass:(Class)objectClass;
 
+// these are the steps of objectOrArrayForChildrenOfElement:..., for
+// subclasses making the objects themselves: finding the child elements,
+// choosing the class (or surrogate) for an element, removing the elements
+// from the unknown children once they are handled, and having each new
+// object gather its own unknown children once it has been initialized
+- (NSArray *)childElementsOfElement:(NSXMLElement *)parentElement
+                      qualifiedName:(NSString *)qualifiedName
+                       namespaceURI:(NSString *)namespaceURI;
+
+- (Class)classForChildElement:(NSXMLElement *)element
+                qualifiedName:(NSString *)qualifiedName
+                 namespaceURI:(NSString *)namespaceURI
+                  objectClass:(Class)objectClass;
+
+- (void)handleParsedElements:(NSArray *)array;
+
+- (void)gatherUnknownChildren;
+
 // childOfElement:withName returns the element with the name, or nil of there
 // are not exactly one of the element
 - (NSXMLElement *)childWithQualifiedName:(NSString *)localName
@@ -640,6 +828,33 @@ objectDescriptionIfNonNil:(id)obj
 
 @end
 
+// A snapshot is a compact binary archive of an object tree: a table of the
+// tree's distinct strings and a flat array of fixed-size records.  Restoring
+// a snapshot creates the objects directly, without parsing XML or making
+// the classes' declarations again, and keeps the unknown elements and
+// attributes and the service version, so the objects generate the same XML
+// as the originals.  Objects of classes generating XML from their own
+// instance variables are stored as XML and parsed when restored.
+//
+// Snapshots are meant for local caches; they can be read only on the same
+// byte order, and by builds having the classes of the archived objects.
+// Snapshots are limited to 4 GB of strings, and trees nested more than 256
+// objects or XML elements deep cannot be restored.
+@interface GDataObject (GDataSnapshots)
+
+// snapshotData returns nil if the tree is too large for a snapshot;
+// snapshotDataWithError: also sets the error
+- (NSData *)snapshotData;
+- (NSData *)snapshotDataWithError:(NSError **)error;
+
+// objectWithSnapshotData:error: returns nil and sets the error if the data is
+// not a valid snapshot or if its object is not of the receiving class.  The
+// data need not be kept once the object is restored, so it may be mapped
+// from a file, as objectWithContentsOfSnapshotFile:error: does.
++ (id)objectWithSnapshotData:(NSData *)data error:(NSError **)error;
++ (id)objectWithContentsOfSnapshotFile:(NSString *)path error:(NSError **)error;
+@end
+
 @interface NSXMLElement (GDataObjectExtensions)
 
 // XML generation helpers
@@ -48,6 +48,10 @@ static inline NSMutableDictionary *GDataCreateStaticDictionary(void) {
 static NSString* const kContentValueDeclarationMarker = @" __content";
 static NSString* const kChildXMLDeclarationMarker = @" __childXML";
 
+// elements with at least this many children map child nodes to their
+// positions rather than searching the list of children for each parsed node
+static const NSUInteger kMinChildCountForPositionMap = 8;
+
 // Elements may call -addExtensionDeclarationForParentClass:childClass: and
 // addAttributeExtensionDeclarationForParentClass: to declare extensions to be
 // parsed; the declaration applies in the element and all children of the element.
@@ -62,6 +66,57 @@ static NSString* const kChildXMLDeclarationMarker = @" __childXML";
 - (BOOL)isAttribute;
 @end
 
+// A parse plan lists the extensions that may be parsed for an object of one
+// class with one chain of parent classes, indexed by the local names of the
+// extensions' elements.  Plans are immutable once made, and are shared by
+// all parses.
+//
+// Kept plans form a tree: each plan holds the plans of the child classes
+// parsed beneath it, so a parse looks up only the plan of its topmost object
+// in the global map.  The child plans are read without locking; they are
+// replaced, never changed, when a plan is added.
+@interface GDataParsePlan : NSObject {
+  NSArray *declarations_;             // in order of precedence
+  NSDictionary *declIndexesByName_;   // local name -> NSIndexSet
+  NSIndexSet *alwaysParsedIndexes_;   // attribute and wildcard extensions
+
+  NSDictionary *sharedDeclarations_;  // of the class being parsed
+
+  // extension declarations by parent class of the class and its chain of
+  // parents, nearest first, or nil if the plan is not kept
+  NSArray *declarationsChain_;
+
+  NSDictionary * volatile childPlans_;  // child class -> GDataParsePlan
+  NSMutableArray *retiredChildPlans_;   // replaced dictionaries of child plans
+}
++ (GDataParsePlan *)planWithSharedDeclarations:(NSDictionary *)sharedDecls
+                                      forClass:(Class)theClass
+                                    parentPlan:(GDataParsePlan *)parentPlan;
+- (id)initWithDeclarations:(NSArray *)declarations
+        sharedDeclarations:(NSDictionary *)sharedDecls
+         declarationsChain:(NSArray *)chain;
+- (NSArray *)declarations;
+- (NSIndexSet *)declarationIndexesForLocalName:(NSString *)localName;
+- (NSIndexSet *)alwaysParsedDeclarationIndexes;
+- (NSDictionary *)sharedDeclarations;
+- (BOOL)canKeepChildPlans;
+- (GDataParsePlan *)childPlanForClass:(Class)theClass;
+- (GDataParsePlan *)addChildPlan:(GDataParsePlan *)plan forClass:(Class)theClass;
+@end
+
+@interface GDataAttribute (PrivateMethods)
+- (NSUInteger)changeStamp;
+@end
+
+// An attribute value slot holds the parsed value of a typed attribute's
+// string, or nil if the string has no value of the attribute's type.  An
+// object's slots are a small array, as elements have few attributes.
+typedef struct GDataAttributeValueSlot {
+  NSString *name;
+  GDataAttributeType type;
+  id value;
+} GDataAttributeValueSlot;
+
 @interface GDataObject (PrivateMethods)
 
 // array of local attribute names to be automatically parsed and
@@ -72,10 +127,29 @@ static NSString* const kChildXMLDeclarationMarker = @" __childXML";
 // array of attribute declarations for the current class, from the cache
 - (void)setAttributeDeclarations:(NSArray *)array;
 - (NSMutableArray *)attributeDeclarations;
+- (void)setAttributeTypes:(NSDictionary *)dict;
+- (NSDictionary *)attributeTypes;
+- (void)shareAttributeDeclarations:(NSDictionary *)sharedDecls;
+
+// parsed attribute values
+- (id)valueForAttribute:(NSString *)name ofType:(GDataAttributeType)type;
+- (GDataAttributeValueSlot *)valueSlotForAttribute:(NSString *)name;
+- (void)setParsedValue:(id)value
+          forAttribute:(NSString *)name
+                ofType:(GDataAttributeType)type;
+- (void)updateParsedValueForAttribute:(NSString *)name;
+- (void)removeParsedValueForAttribute:(NSString *)name;
+- (void)removeParsedAttributeValues;
 
 - (void)parseAttributesForElement:(NSXMLElement *)element;
 - (void)addAttributesToElement:(NSXMLElement *)element;
 
+// objects parsed from the tree, to be detached from the XML document
+// once parsing has finished
+- (NSMutableArray *)objectsToDetachFromXMLDocument;
+- (void)detachParsedObjectsFromXMLDocument;
+- (void)detachFromXMLDocument;
+
 // routines for comparing attributes
 - (BOOL)hasAttributesEqualToAttributesOf:(GDataObject *)other;
 - (NSArray *)attributesIgnoredForEquality;
@@ -101,6 +175,14 @@ static NSString* const kChildXMLDeclarationMarker = @" __childXML";
 - (void)setExtensionDeclarationsCache:(NSDictionary *)decls;
 - (NSMutableDictionary *)extensionDeclarationsCache;
 
+// declarations of the class shared by all parsed objects of the class and
+// service version, and the parse plan for this object's chain of parents
+- (NSDictionary *)sharedDeclarations;
+- (NSSet *)inheritedParseProjection;
+- (NSArray *)sharedExtensionDeclarationsForParentClass:(Class)parentClass;
+- (GDataParsePlan *)parsePlan;
+- (GDataParsePlan *)unkeptParsePlan;
+
 - (NSMutableArray *)extensionDeclarationsForParentClass:(Class)parentClass;
 
 - (void)addExtensionDeclarationForParentClass:(Class)parentClass
@@ -108,11 +190,13 @@ static NSString* const kChildXMLDeclarationMarker = @" __childXML";
                                   isAttribute:(BOOL)isAttribute;
 
 - (void)addUnknownChildNodesForElement:(NSXMLElement *)element;
+- (void)releaseParsedChildFlags;
 
 - (void)parseExtensionsForElement:(NSXMLElement *)element;
 
 - (void)handleParsedElement:(NSXMLNode *)element;
-- (void)handleParsedElements:(NSArray *)array;
+
+- (NSXMLElement *)XMLElementUsingCacheInEpoch:(NSUInteger)epoch;
 
 - (NSString *)qualifiedNameForExtensionClass:(Class)theClass;
 
@@ -127,10 +211,69 @@ static NSString* const kChildXMLDeclarationMarker = @" __childXML";
 // element names (foo:bar) repeatedly
 static NSMutableDictionary *gQualifiedNameMap = nil;
 
+// Parsed objects share the extension and attribute declarations of their
+// class, in dictionaries keyed by class and then by service version, and the
+// parse plans made from them; the map of plans holds the plans of topmost
+// objects, which hold the plans of their children.  Subclasses' declarations
+// should depend only on the class and the service version.
+static NSMutableDictionary *gSharedDeclarationsMap = nil;
+static NSMutableDictionary *gParsePlanMap = nil;
+
+// keys for the dictionaries of shared declarations
+static NSString* const kExtensionDeclarationsKey = @"extensions";
+static NSString* const kAttributeDeclarationsKey = @"attributes";
+static NSString* const kAttributeTypesKey = @"attributeTypes";
+
+// Cached XML elements and memoized hashes are valid until the object or an
+// object beneath it changes.  Setters stamp the object with a number later
+// than that of any element or hash already cached, and caching advances the
+// number, so the stamps need only be compared when the cache is next used.
+//
+// The latest stamp given to any object is kept too, so a memoized hash need
+// not look beneath its object while nothing anywhere has changed since it
+// was made.
+static volatile NSUInteger gXMLChangeStamp = 1;
+static volatile NSUInteger gLatestXMLChangeStamp = 0;
+
+static inline NSUInteger GDataNextXMLChangeStamp(void) {
+  NSUInteger stamp = __atomic_load_n(&gXMLChangeStamp, __ATOMIC_ACQUIRE) + 1;
+
+  // the latest stamp only grows; it is written just once after each advance
+  // of the number, so setters on several threads rarely contend for it
+  NSUInteger latest = __atomic_load_n(&gLatestXMLChangeStamp, __ATOMIC_ACQUIRE);
+  while (latest < stamp
+         && !__sync_bool_compare_and_swap(&gLatestXMLChangeStamp, latest, stamp)) {
+    latest = __atomic_load_n(&gLatestXMLChangeStamp, __ATOMIC_ACQUIRE);
+  }
+  return stamp;
+}
+
+static BOOL GDataObjectHasChangedSinceStamp(GDataObject *obj, NSUInteger stamp);
+
+static inline NSUInteger GDataHashCombine(NSUInteger hash, NSUInteger value) {
+  return hash * 31 + value;
+}
+
+// GDataHashForExtension returns the hash of an extension object or of an
+// array of extension objects; NSArray's own hash is just its count
+static NSUInteger GDataHashForExtension(id objectOrArray) {
+  if ([objectOrArray isKindOfClass:[NSArray class]]) {
+    NSUInteger hash = [(NSArray *)objectOrArray count];
+    for (id obj in (NSArray *)objectOrArray) {
+      hash = GDataHashCombine(hash, [obj hash]);
+    }
+    return hash;
+  }
+  return [objectOrArray hash];
+}
+
 + (void)load {
   // Initialize gQualifiedNameMap early so we can @synchronize on accesses
   // to it
   gQualifiedNameMap = GDataCreateStaticDictionary();
+
+  gSharedDeclarationsMap = GDataCreateStaticDictionary();
+  gParsePlanMap = GDataCreateStaticDictionary();
 }
 
 + (id)object {
@@ -167,14 +310,55 @@ static NSMutableDictionary *gQualifiedNameMap = nil;
               surrogates:(NSDictionary *)surrogates
     shouldIgnoreUnknowns:(BOOL)shouldIgnoreUnknowns {
 
+  return [self initWithXMLElement:element
+                           parent:parent
+                   serviceVersion:serviceVersion
+                       surrogates:surrogates
+             shouldIgnoreUnknowns:shouldIgnoreUnknowns
+      shouldDetachFromXMLDocument:NO];
+}
+
+- (id)initWithXMLElement:(NSXMLElement *)element
+                  parent:(GDataObject *)parent
+          serviceVersion:(NSString *)serviceVersion
+              surrogates:(NSDictionary *)surrogates
+    shouldIgnoreUnknowns:(BOOL)shouldIgnoreUnknowns
+shouldDetachFromXMLDocument:(BOOL)shouldDetach {
+
+  return [self initWithXMLElement:element
+                           parent:parent
+                   serviceVersion:serviceVersion
+                       surrogates:surrogates
+                  parseProjection:nil
+             shouldIgnoreUnknowns:shouldIgnoreUnknowns
+      shouldDetachFromXMLDocument:shouldDetach];
+}
+
+- (id)initWithXMLElement:(NSXMLElement *)element
+                  parent:(GDataObject *)parent
+          serviceVersion:(NSString *)serviceVersion
+              surrogates:(NSDictionary *)surrogates
+         parseProjection:(NSSet *)projection
+    shouldIgnoreUnknowns:(BOOL)shouldIgnoreUnknowns
+shouldDetachFromXMLDocument:(BOOL)shouldDetach {
+
   [self setServiceVersion:serviceVersion];
 
   [self setSurrogates:surrogates];
 
+  [self setParseProjection:projection];
+
   [self setShouldIgnoreUnknowns:shouldIgnoreUnknowns];
 
+  [self setShouldDetachFromXMLDocument:shouldDetach];
+
   id obj = [self initWithXMLElement:element
                              parent:parent];
+
+  // subclasses have finished parsing, so the unknown children are known, and
+  // the objects may now give up their nodes of the document
+  [obj gatherUnknownChildren];
+  [obj detachParsedObjectsFromXMLDocument];
   return obj;
 }
 
@@ -197,45 +381,18 @@ static NSMutableDictionary *gQualifiedNameMap = nil;
       // should ignore any unparsed XML
       [self setShouldIgnoreUnknowns:[parent shouldIgnoreUnknowns]];
 
-      // get the parent's declaration caches, and temporarily hang on to them
-      // in our ivar to avoid the need to get them recursively from the topmost
-      // parent
-      //
-      // We'll release these below, so that only the topmost parent retains
-      // them. The topmost parent retains them in case some subclass code still
-      // wants to do parsing after we return.
-      extensionDeclarationsCache_ = [[parent extensionDeclarationsCache] retain];
-      GDATA_DEBUG_ASSERT(extensionDeclarationsCache_ != nil, @"missing extn decl");
-
-      attributeDeclarationsCache_ = [[parent attributeDeclarationsCache] retain];
-      GDATA_DEBUG_ASSERT(extensionDeclarationsCache_ != nil, @"missing attr decl");
-
-    } else {
-      // parent is nil, so this is the topmost parent
-      extensionDeclarationsCache_ = [[NSMutableDictionary alloc] init];
-
-      attributeDeclarationsCache_ = [[NSMutableDictionary alloc] init];
+      [self setShouldDetachFromXMLDocument:[parent shouldDetachFromXMLDocument]];
     }
 
     [self setNamespaces:[[self class] dictionaryForElementNamespaces:element]];
     [self addUnknownChildNodesForElement:element];
 
-    // if we've not previously cached declarations for this class,
-    // add the declarations now
-    Class currClass = [self class];
-    NSDictionary *prevExtnDecls = [extensionDeclarationsCache_ objectForKey:currClass];
-    if (prevExtnDecls == nil) {
-      [self addExtensionDeclarations];
-    }
-
-    NSMutableArray *prevAttrDecls = [attributeDeclarationsCache_ objectForKey:currClass];
-    if (prevAttrDecls == nil) {
-      [self addParseDeclarations];
-      // if any parse declarations are added, attributeDeclarations_ will be set
-      // to the cached copy of this object's attribute decls
-    } else {
+    // parsed objects share the declarations of their class, which are made
+    // by the first object of the class and service version to be parsed
+    NSDictionary *sharedDecls = [[self parsePlan] sharedDeclarations];
+    if ([[sharedDecls objectForKey:kAttributeDeclarationsKey] count] > 0) {
       GDATA_DEBUG_ASSERT(attributeDeclarations_ == nil, @"attrDecls previously set");
-      attributeDeclarations_ = [prevAttrDecls retain];
+      [self shareAttributeDeclarations:sharedDecls];
     }
 
     [self parseExtensionsForElement:element];
@@ -244,29 +401,257 @@ static NSMutableDictionary *gQualifiedNameMap = nil;
     [self keepChildXMLElementsForElement:element];
     [self setElementName:[element name]];
 
-    if (parent != nil) {
-      // rather than keep a reference to the cache of declarations in the
-      // parent, set our pointer to nil; if a subclass continues to parse, the
-      // getter will obtain them by calling into the parent.  This lets callers
-      // free up the extensionDeclarations_ when parsing is done by just
-      // freeing them in the topmost parent with clearExtensionDeclarationsCache
-      [extensionDeclarationsCache_ release];
-      extensionDeclarationsCache_ = nil;
-
-      [attributeDeclarationsCache_ release];
-      attributeDeclarationsCache_ = nil;
-    }
-
 #if GDATA_USES_LIBXML
     if (!shouldIgnoreUnknowns_) {
-      // retain the element so that pointers to internal nodes remain valid
-      [self setProperty:element forKey:kGDataXMLElementPropertyKey];
+      if (shouldDetachFromXMLDocument_) {
+        // subclasses may still parse after this returns, so the detaching
+        // waits until the topmost parent has been parsed; the topmost parent
+        // is not added to its own list, to avoid a retain cycle
+        if (parent == nil) {
+          objectsToDetach_ = [[NSMutableArray alloc] init];
+        } else {
+          // a feed's entries may be parsed on several threads at once
+          NSMutableArray *objectsToDetach = [self objectsToDetachFromXMLDocument];
+          @synchronized(objectsToDetach) {
+            [objectsToDetach addObject:self];
+          }
+        }
+      } else {
+        // retain the element so that pointers to internal nodes remain valid
+        [self setProperty:element forKey:kGDataXMLElementPropertyKey];
+      }
     }
 #endif
   }
   return self;
 }
 
+// objectsToDetachFromXMLDocument returns the topmost parent's list of the
+// objects parsed from its tree
+- (NSMutableArray *)objectsToDetachFromXMLDocument {
+  if (objectsToDetach_ != nil) return objectsToDetach_;
+  return [parent_ objectsToDetachFromXMLDocument];
+}
+
+- (void)detachParsedObjectsFromXMLDocument {
+  if (objectsToDetach_ == nil) return;
+
+  [self detachFromXMLDocument];
+
+  for (GDataObject *obj in objectsToDetach_) {
+    [obj detachFromXMLDocument];
+  }
+  [objectsToDetach_ release];
+  objectsToDetach_ = nil;
+}
+
+// detachFromXMLDocument replaces the unknown nodes, which belong to the
+// parsed document, with copies that belong to this object
+- (void)detachFromXMLDocument {
+  [self gatherUnknownChildren];
+
+  if (unknownChildren_ != nil) {
+    NSMutableArray *childCopies =
+      [GDataUtilities mutableArrayWithCopiesOfObjectsInArray:unknownChildren_];
+    [unknownChildren_ release];
+    unknownChildren_ = [childCopies retain];
+  }
+
+  if (unknownAttributes_ != nil) {
+    NSMutableArray *attrCopies =
+      [GDataUtilities mutableArrayWithCopiesOfObjectsInArray:unknownAttributes_];
+    [unknownAttributes_ release];
+    unknownAttributes_ = [attrCopies retain];
+  }
+}
+
+#pragma mark Shared declarations
+
+// sharedDeclarations returns a dictionary with the extension declarations
+// and the attribute declarations of this object's class for its service
+// version, making them if this is the first object of the class to be parsed
+- (NSDictionary *)sharedDeclarations {
+  Class theClass = [self class];
+  NSString *serviceVersion = [self serviceVersion];
+  if (serviceVersion == nil) serviceVersion = @"";
+
+  NSDictionary *sharedDecls;
+  @synchronized(gSharedDeclarationsMap) {
+    NSDictionary *declsByVersion = [gSharedDeclarationsMap objectForKey:theClass];
+    sharedDecls = [[[declsByVersion objectForKey:serviceVersion] retain] autorelease];
+  }
+  if (sharedDecls) return sharedDecls;
+
+  // have this object declare into temporary caches, as objects made by -init
+  // do, and keep immutable copies of its declarations
+  GDATA_DEBUG_ASSERT(extensionDeclarationsCache_ == nil
+                     && attributeDeclarations_ == nil, @"declarations already made");
+  extensionDeclarationsCache_ = [[NSMutableDictionary alloc] init];
+  attributeDeclarationsCache_ = [[NSMutableDictionary alloc] init];
+
+  [self addExtensionDeclarations];
+  [self addParseDeclarations];
+
+  NSDictionary *extnDeclsByParent = [extensionDeclarationsCache_ objectForKey:[self class]];
+  NSMutableDictionary *extnDecls = [NSMutableDictionary dictionary];
+  for (Class parentClass in extnDeclsByParent) {
+    NSArray *array = [NSArray arrayWithArray:[extnDeclsByParent objectForKey:parentClass]];
+    [extnDecls setObject:array forKey:(id<NSCopying>)parentClass];
+  }
+
+  NSArray *attrDecls = [NSArray arrayWithArray:attributeDeclarations_];
+  NSDictionary *attrTypes = [NSDictionary dictionaryWithDictionary:attributeTypes_];
+
+  sharedDecls = [NSDictionary dictionaryWithObjectsAndKeys:
+                 extnDecls, kExtensionDeclarationsKey,
+                 attrDecls, kAttributeDeclarationsKey,
+                 attrTypes, kAttributeTypesKey, nil];
+
+  [extensionDeclarationsCache_ release];
+  extensionDeclarationsCache_ = nil;
+
+  [attributeDeclarationsCache_ release];
+  attributeDeclarationsCache_ = nil;
+
+  [attributeDeclarations_ release];
+  attributeDeclarations_ = nil;
+
+  [attributeTypes_ release];
+  attributeTypes_ = nil;
+
+  @synchronized(gSharedDeclarationsMap) {
+    NSMutableDictionary *declsByVersion = [gSharedDeclarationsMap objectForKey:theClass];
+    if (declsByVersion == nil) {
+      declsByVersion = [NSMutableDictionary dictionary];
+      [gSharedDeclarationsMap setObject:declsByVersion
+                                 forKey:(id<NSCopying>)theClass];
+    }
+
+    // another thread may have made them first
+    NSDictionary *prevDecls = [declsByVersion objectForKey:serviceVersion];
+    if (prevDecls) {
+      sharedDecls = [[prevDecls retain] autorelease];
+    } else {
+      [declsByVersion setObject:sharedDecls forKey:serviceVersion];
+    }
+  }
+  return sharedDecls;
+}
+
+// sharedExtensionDeclarationsForParentClass: returns the shared extensions
+// declared by this object's class for the parent class, or nil if this
+// object's class has no shared declarations yet
+- (NSArray *)sharedExtensionDeclarationsForParentClass:(Class)parentClass {
+  NSString *serviceVersion = [self serviceVersion];
+  if (serviceVersion == nil) serviceVersion = @"";
+
+  NSDictionary *sharedDecls;
+  @synchronized(gSharedDeclarationsMap) {
+    NSDictionary *declsByVersion = [gSharedDeclarationsMap objectForKey:[self class]];
+    sharedDecls = [[[declsByVersion objectForKey:serviceVersion] retain] autorelease];
+  }
+  if (sharedDecls == nil) return nil;
+
+  NSDictionary *extnDecls = [sharedDecls objectForKey:kExtensionDeclarationsKey];
+  NSArray *array = [extnDecls objectForKey:parentClass];
+  return (array ? array : [NSArray array]);
+}
+
+// parsePlan returns the plan for parsing extensions of this object's class
+// with its chain of parents, making it if needed.  A topmost object's plan
+// is looked up in the global map; a child's plan is looked up in the plan of
+// its parent, without locking.
+- (GDataParsePlan *)parsePlan {
+  if (parsePlan_ != nil) return parsePlan_;
+
+  Class theClass = [self class];
+  GDataParsePlan *plan = nil;
+  GDataParsePlan *parentPlan = nil;
+
+  if (parent_ == nil) {
+    NSString *serviceVersion = [self serviceVersion];
+    if (serviceVersion == nil) serviceVersion = @"";
+
+    @synchronized(gParsePlanMap) {
+      NSDictionary *plansByVersion = [gParsePlanMap objectForKey:theClass];
+      plan = [[[plansByVersion objectForKey:serviceVersion] retain] autorelease];
+    }
+
+    if (plan == nil) {
+      plan = [GDataParsePlan planWithSharedDeclarations:[self sharedDeclarations]
+                                               forClass:theClass
+                                             parentPlan:nil];
+      @synchronized(gParsePlanMap) {
+        NSMutableDictionary *plansByVersion = [gParsePlanMap objectForKey:theClass];
+        if (plansByVersion == nil) {
+          plansByVersion = [NSMutableDictionary dictionary];
+          [gParsePlanMap setObject:plansByVersion forKey:(id<NSCopying>)theClass];
+        }
+
+        // another thread may have made it first
+        GDataParsePlan *prevPlan = [plansByVersion objectForKey:serviceVersion];
+        if (prevPlan) {
+          plan = [[prevPlan retain] autorelease];
+        } else {
+          [plansByVersion setObject:plan forKey:serviceVersion];
+        }
+      }
+    }
+  } else {
+    parentPlan = parent_->parsePlan_;
+
+    if ([parentPlan canKeepChildPlans]) {
+      plan = [parentPlan childPlanForClass:theClass];
+      if (plan == nil) {
+        plan = [GDataParsePlan planWithSharedDeclarations:[self sharedDeclarations]
+                                                 forClass:theClass
+                                               parentPlan:parentPlan];
+        plan = [parentPlan addChildPlan:plan forClass:theClass];
+      }
+    } else {
+      plan = [self unkeptParsePlan];
+    }
+  }
+
+  parsePlan_ = [plan retain];
+  return plan;
+}
+
+// unkeptParsePlan makes a plan for an object whose parents were not all made
+// by parsing; such a parent may declare its extensions later, so the plan
+// cannot be kept
+- (GDataParsePlan *)unkeptParsePlan {
+  NSDictionary *sharedDecls = [self sharedDeclarations];
+
+  // gather the declarations for this class by this object and its parents,
+  // nearest first; the first declaration of an extension class takes
+  // precedence
+  Class classBeingParsed = [self class];
+  NSMutableArray *decls = [NSMutableArray array];
+  NSMutableSet *declaredClasses = [NSMutableSet set];
+
+  for (GDataObject *supplier = self; supplier != nil; supplier = [supplier parent]) {
+    NSArray *extnDecls = [supplier sharedExtensionDeclarationsForParentClass:classBeingParsed];
+    if (extnDecls == nil) {
+      extnDecls = [supplier extensionDeclarationsForParentClass:classBeingParsed];
+    }
+
+    for (GDataExtensionDeclaration *decl in extnDecls) {
+      Class extensionClass = [decl childClass];
+      if (![declaredClasses containsObject:extensionClass]) {
+        [declaredClasses addObject:extensionClass];
+        [decls addObject:decl];
+      }
+    }
+  }
+
+  GDataParsePlan *plan;
+  plan = [[[GDataParsePlan alloc] initWithDeclarations:decls
+                                    sharedDeclarations:sharedDecls
+                                     declarationsChain:nil] autorelease];
+  return plan;
+}
+
 - (BOOL)isEqual:(GDataObject *)other {
   if (self == other) return YES;
   if (![other isKindOfClass:[self class]]) return NO;
@@ -301,12 +686,65 @@ static NSMutableDictionary *gQualifiedNameMap = nil;
 }
 
 // By definition, for two objects to potentially be considered equal,
-// they must have the same hash value.  The hash is mostly ignored,
-// but removeObjectsInArray: in Leopard does seem to check the hash,
-// and NSObject's default hash method just returns the instance pointer.
-// We'll define hash here for all of our GDataObjects.
+// they must have the same hash value.  The hash covers the extensions,
+// attributes and content value compared by isEqual: above.  Subclasses'
+// isEqual: methods only add comparisons, so the hash holds for them too.
+// Kept child XML elements are left out, as they may be changed in place
+// without stamping the object.
+//
+// The hash is memoized until the object or an object beneath it changes.
+// While no object at all has changed since the hash was made, checking it
+// takes constant time; otherwise the objects beneath are checked once, and
+// the memo is restamped if none of them changed.
 - (NSUInteger)hash {
-  return (NSUInteger) (void *) [GDataObject class];
+  if (cachedHashStamp_ != 0) {
+    if (__atomic_load_n(&gLatestXMLChangeStamp, __ATOMIC_ACQUIRE) <= cachedHashStamp_) {
+      return cachedHash_;
+    }
+
+    NSUInteger newStamp = __sync_add_and_fetch(&gXMLChangeStamp, 1);
+    if (!GDataObjectHasChangedSinceStamp(self, cachedHashStamp_)) {
+      cachedHashStamp_ = newStamp;
+      return cachedHash_;
+    }
+  }
+
+  // changes made after this point get later stamps
+  NSUInteger stamp = __sync_add_and_fetch(&gXMLChangeStamp, 1);
+
+  // extensions, in any order, as the dictionaries are compared
+  NSUInteger extensionsHash = 0;
+  for (Class extensionClass in extensions_) {
+    id objectOrArray = [extensions_ objectForKey:extensionClass];
+    extensionsHash += GDataHashCombine((NSUInteger) (void *) extensionClass,
+                                       GDataHashForExtension(objectOrArray));
+  }
+
+  // attributes, in any order, skipping those ignored for equality
+  NSUInteger attributesHash = 0;
+  NSArray *attributesToIgnore = [self attributesIgnoredForEquality];
+  NSArray *attributeKeys;
+  if ([attributesToIgnore count] == 0) {
+    attributeKeys = [attributes_ allKeys];
+  } else {
+    attributeKeys = [self attributeDeclarations];
+  }
+  for (NSString *attrKey in attributeKeys) {
+    NSString *value = [attributes_ objectForKey:attrKey];
+    if (value != nil && ![attributesToIgnore containsObject:attrKey]) {
+      attributesHash += GDataHashCombine([attrKey hash], [value hash]);
+    }
+  }
+
+  NSUInteger hash = GDataHashCombine(extensionsHash, attributesHash);
+
+  if ([self hasDeclaredContentValue]) {
+    hash = GDataHashCombine(hash, [contentValue_ hash]);
+  }
+
+  cachedHash_ = hash;
+  cachedHashStamp_ = stamp;
+  return hash;
 }
 
 - (id)copyWithZone:(NSZone *)zone {
@@ -323,15 +761,17 @@ static NSMutableDictionary *gQualifiedNameMap = nil;
     [GDataUtilities mutableDictionaryWithCopiesOfArraysInDictionary:[self extensions]];
   [newObject setExtensions:extensions];
 
-  NSDictionary *attributes =
-    [GDataUtilities mutableDictionaryWithCopiesOfObjectsInDictionary:[self attributes]];
-  [newObject setAttributes:attributes];
-
   [newObject setAttributeDeclarations:[self attributeDeclarations]];
+  [newObject setAttributeTypes:[self attributeTypes]];
   // we copy the attribute declarations, which are retained by this object,
   // but we do not copy not the caches of extension or attribute declarations,
   // as those will be invalid once the top parent is released
 
+  // the copy parses the values of its typed attributes when they are set
+  NSDictionary *attributes =
+    [GDataUtilities mutableDictionaryWithCopiesOfObjectsInDictionary:[self attributes]];
+  [newObject setAttributes:attributes];
+
   // a marker in the attributes cache indicates the content value and
   // and child XML declaration settings
   if ([self hasDeclaredContentValue]) {
@@ -347,6 +787,9 @@ static NSMutableDictionary *gQualifiedNameMap = nil;
   BOOL shouldIgnoreUnknowns = [self shouldIgnoreUnknowns];
   [newObject setShouldIgnoreUnknowns:shouldIgnoreUnknowns];
 
+  // the copy caches its own XML
+  [newObject setShouldCacheXMLElements:[self shouldCacheXMLElements]];
+
   if (!shouldIgnoreUnknowns) {
     NSArray *unknownChildren =
       [GDataUtilities mutableArrayWithCopiesOfObjectsInArray:[self unknownChildren]];
@@ -372,13 +815,21 @@ static NSMutableDictionary *gQualifiedNameMap = nil;
   [extensionDeclarationsCache_ release];
   [attributeDeclarationsCache_ release];
   [attributeDeclarations_ release];
+  [attributeTypes_ release];
   [extensions_ release];
   [attributes_ release];
+  [self removeParsedAttributeValues];
+  free(attributeValueSlots_);
   [contentValue_ release];
   [childXMLElements_ release];
+  [cachedXMLElement_ release];
   [unknownChildren_ release];
   [unknownAttributes_ release];
+  [self releaseParsedChildFlags];
+  [objectsToDetach_ release];
   [surrogates_ release];
+  [parseProjection_ release];
+  [parsePlan_ release];
   [serviceVersion_ release];
   [coreProtocolVersion_ release];
   [userData_ release];
@@ -394,13 +845,55 @@ static NSMutableDictionary *gQualifiedNameMap = nil;
 }
 
 - (NSXMLDocument *)XMLDocument {
-  NSXMLElement *element = [self XMLElement];
+  // the document copies the element, so the cached one may be used directly
+  NSXMLElement *element = (shouldCacheXMLElements_ ?
+                           [self XMLElementUsingCacheInEpoch:0] : [self XMLElement]);
   NSXMLDocument *doc = [[[NSXMLDocument alloc] initWithRootElement:(id)element] autorelease];
   [doc setVersion:@"1.0"];
   [doc setCharacterEncoding:@"UTF-8"];
   return doc;
 }
 
+- (BOOL)writeXMLDocumentToStream:(NSOutputStream *)stream
+                           error:(NSError **)error {
+  return [self writeXMLDocumentToStream:stream
+                             usingCache:shouldCacheXMLElements_
+                                  error:error];
+}
+
+- (BOOL)writeXMLDocumentToStream:(NSOutputStream *)stream
+                      usingCache:(BOOL)shouldUseCache
+                           error:(NSError **)error {
+  NSXMLElement *element = (shouldUseCache ?
+                           [self XMLElementUsingCacheInEpoch:0] : [self XMLElement]);
+#if GDATA_USES_LIBXML
+  GDataXMLWriter *writer = [[[GDataXMLWriter alloc] initWithOutputStream:stream] autorelease];
+
+  [writer writeElement:element];
+  return [writer finishWritingWithError:error];
+#else
+  NSXMLDocument *doc = [[[NSXMLDocument alloc] initWithRootElement:element] autorelease];
+  [doc setVersion:@"1.0"];
+  [doc setCharacterEncoding:@"UTF-8"];
+  NSData *data = [doc XMLData];
+
+  const uint8_t *bytes = [data bytes];
+  NSUInteger length = [data length];
+  NSUInteger totalWritten = 0;
+
+  while (totalWritten < length) {
+    NSInteger result = [stream write:(bytes + totalWritten)
+                           maxLength:(length - totalWritten)];
+    if (result <= 0) {
+      if (error) *error = [stream streamError];
+      return NO;
+    }
+    totalWritten += (NSUInteger)result;
+  }
+  return YES;
+#endif
+}
+
 - (BOOL)generateContentInputStream:(NSInputStream **)outInputStream
                             length:(unsigned long long *)outLength
                            headers:(NSDictionary **)outHeaders {
@@ -437,6 +930,8 @@ static NSMutableDictionary *gQualifiedNameMap = nil;
 #pragma mark -
 
 - (void)setElementName:(NSString *)name {
+  changeStamp_ = GDataNextXMLChangeStamp();
+
   [elementName_ release];
   elementName_ = [name copy];
 }
@@ -446,11 +941,15 @@ static NSMutableDictionary *gQualifiedNameMap = nil;
 }
 
 - (void)setNamespaces:(NSDictionary *)dict {
+  changeStamp_ = GDataNextXMLChangeStamp();
+
   [namespaces_ release];
   namespaces_ = [dict mutableCopy];
 }
 
 - (void)addNamespaces:(NSDictionary *)dict {
+  changeStamp_ = GDataNextXMLChangeStamp();
+
   if (namespaces_ == nil) {
     namespaces_ = [[NSMutableDictionary alloc] init];
   }
@@ -525,17 +1024,69 @@ static NSMutableDictionary *gQualifiedNameMap = nil;
 }
 
 - (void)setAttributeDeclarations:(NSArray *)array {
+  changeStamp_ = GDataNextXMLChangeStamp();
+
   [attributeDeclarations_ autorelease];
   attributeDeclarations_ = [array mutableCopy];
+  hasSharedAttributeDeclarations_ = NO;
 }
 
 - (NSMutableArray *)attributeDeclarations {
   return attributeDeclarations_;
 }
 
+- (void)setAttributeTypes:(NSDictionary *)dict {
+  changeStamp_ = GDataNextXMLChangeStamp();
+
+  // like the attribute declarations, the types are not shared once set
+  [attributeTypes_ autorelease];
+  attributeTypes_ = ([dict count] > 0 ? [dict mutableCopy] : nil);
+}
+
+- (NSDictionary *)attributeTypes {
+  return attributeTypes_;
+}
+
+// shareAttributeDeclarations: has this object use the immutable attribute
+// declarations and types of its class, which are copied before being changed
+- (void)shareAttributeDeclarations:(NSDictionary *)sharedDecls {
+  NSArray *attrDecls = [sharedDecls objectForKey:kAttributeDeclarationsKey];
+  NSDictionary *attrTypes = [sharedDecls objectForKey:kAttributeTypesKey];
+
+  [attributeDeclarations_ release];
+  attributeDeclarations_ = (NSMutableArray *) [attrDecls retain];
+
+  [attributeTypes_ release];
+  attributeTypes_ = ([attrTypes count] > 0 ?
+                     (NSMutableDictionary *) [attrTypes retain] : nil);
+
+  hasSharedAttributeDeclarations_ = YES;
+}
+
+// restoreAttributeDeclarations: sets the attribute declarations of an object
+// restored from a snapshot, sharing those of the class when they match, as
+// parsed objects do
+- (void)restoreAttributeDeclarations:(NSArray *)attrDecls {
+  NSDictionary *sharedDecls = [self sharedDeclarations];
+  if ([[sharedDecls objectForKey:kAttributeDeclarationsKey] isEqual:attrDecls]) {
+    [self shareAttributeDeclarations:sharedDecls];
+  } else {
+    [self setAttributeDeclarations:attrDecls];
+    [self setAttributeTypes:[sharedDecls objectForKey:kAttributeTypesKey]];
+  }
+}
+
 - (void)setAttributes:(NSDictionary *)dict {
+  changeStamp_ = GDataNextXMLChangeStamp();
+
   [attributes_ autorelease];
   attributes_ = [dict mutableCopy];
+
+  [self removeParsedAttributeValues];
+
+  for (NSString *name in attributeTypes_) {
+    [self updateParsedValueForAttribute:name];
+  }
 }
 
 - (NSDictionary *)attributes {
@@ -543,6 +1094,8 @@ static NSMutableDictionary *gQualifiedNameMap = nil;
 }
 
 - (void)setExtensions:(NSDictionary *)extensions {
+  changeStamp_ = GDataNextXMLChangeStamp();
+
   [extensions_ autorelease];
   extensions_ = [extensions mutableCopy];
 }
@@ -572,15 +1125,27 @@ static NSMutableDictionary *gQualifiedNameMap = nil;
 }
 
 - (void)setUnknownChildren:(NSArray *)arr {
+  changeStamp_ = GDataNextXMLChangeStamp();
+
+  [self releaseParsedChildFlags];
+
   [unknownChildren_ autorelease];
   unknownChildren_ = [arr mutableCopy];
 }
 
 - (NSArray *)unknownChildren {
+  // objects made by their parents or by the top-level initializers gathered
+  // their unknown children when parsed; objects made otherwise gather them
+  // here, and may be read on several threads at once
+  @synchronized(self) {
+    [self gatherUnknownChildren];
+  }
   return unknownChildren_;
 }
 
 - (void)setUnknownAttributes:(NSArray *)arr {
+  changeStamp_ = GDataNextXMLChangeStamp();
+
   [unknownAttributes_ autorelease];
   unknownAttributes_ = [arr mutableCopy];
 }
@@ -590,6 +1155,8 @@ static NSMutableDictionary *gQualifiedNameMap = nil;
 }
 
 - (void)setShouldIgnoreUnknowns:(BOOL)flag {
+  changeStamp_ = GDataNextXMLChangeStamp();
+
   shouldIgnoreUnknowns_ = flag;
 }
 
@@ -597,6 +1164,25 @@ static NSMutableDictionary *gQualifiedNameMap = nil;
   return shouldIgnoreUnknowns_;
 }
 
+- (void)setShouldCacheXMLElements:(BOOL)flag {
+  shouldCacheXMLElements_ = flag;
+  if (!flag) {
+    [self releaseCachedXMLElements];
+  }
+}
+
+- (BOOL)shouldCacheXMLElements {
+  return shouldCacheXMLElements_;
+}
+
+- (void)setShouldDetachFromXMLDocument:(BOOL)flag {
+  shouldDetachFromXMLDocument_ = flag;
+}
+
+- (BOOL)shouldDetachFromXMLDocument {
+  return shouldDetachFromXMLDocument_;
+}
+
 - (void)setSurrogates:(NSDictionary *)surrogates {
   [surrogates_ autorelease];
   surrogates_ = [surrogates retain];
@@ -606,6 +1192,59 @@ static NSMutableDictionary *gQualifiedNameMap = nil;
   return surrogates_;
 }
 
+- (void)setParseProjection:(NSSet *)projection {
+  [parseProjection_ autorelease];
+  parseProjection_ = [projection copy];
+}
+
+- (NSSet *)parseProjection {
+  return parseProjection_;
+}
+
+// inheritedParseProjection returns the projection of this object or of its
+// nearest parent having one
+- (NSSet *)inheritedParseProjection {
+  for (GDataObject *currentObject = self;
+       currentObject != nil;
+       currentObject = [currentObject parent]) {
+
+    NSSet *projection = [currentObject parseProjection];
+    if (projection) return projection;
+  }
+  return nil;
+}
+
++ (NSSet *)parseProjectionWithFieldSelection:(NSString *)fieldSelection {
+
+  NSMutableSet *names = [NSMutableSet set];
+  NSMutableString *name = [NSMutableString string];
+  NSUInteger bracketDepth = 0;
+
+  NSUInteger numberOfChars = [fieldSelection length];
+  for (NSUInteger idx = 0; idx <= numberOfChars; idx++) {
+    unichar c = (idx < numberOfChars) ? [fieldSelection characterAtIndex:idx] : ',';
+
+    if (c == '[') {
+      ++bracketDepth;
+    } else if (c == ']') {
+      if (bracketDepth > 0) --bracketDepth;
+    } else if (bracketDepth > 0) {
+      // skip conditions like [@rel='alternate']
+    } else if (c == ',' || c == '(' || c == ')' || c == '/') {
+      // attribute extensions are always parsed, so @names are not needed
+      NSString *trimmed = [name stringByTrimmingCharactersInSet:
+                           [NSCharacterSet whitespaceCharacterSet]];
+      if ([trimmed length] > 0 && ![trimmed hasPrefix:@"@"]) {
+        [names addObject:trimmed];
+      }
+      [name setString:@""];
+    } else {
+      [name appendFormat:@"%C", c];
+    }
+  }
+  return names;
+}
+
 + (NSString *)defaultServiceVersion {
   return nil;
 }
@@ -721,6 +1360,207 @@ static NSMutableDictionary *gQualifiedNameMap = nil;
   return [[obj retain] autorelease];
 }
 
+#pragma mark XML caching
+
+// GDataHasStandardXML is YES if the XML of the class is made only from the
+// state kept by GDataObject and, for feeds, from their entries and generator;
+// the XML of subclasses overriding XMLElement or addAttributesToElement: may
+// depend on their own instance variables
+static BOOL GDataHasStandardXML(Class theClass) {
+  return [theClass hasXMLElementOfClass:[GDataObject class]]
+    || [theClass hasXMLElementOfClass:[GDataEntryBase class]]
+    || [theClass hasXMLElementOfClass:[GDataFeedBase class]];
+}
+
++ (BOOL)hasXMLElementOfClass:(Class)theClass {
+  SEL elementSel = @selector(XMLElement);
+  SEL attributesSel = @selector(addAttributesToElement:);
+
+  return ([self instanceMethodForSelector:elementSel]
+          == [theClass instanceMethodForSelector:elementSel])
+    && ([self instanceMethodForSelector:attributesSel]
+        == [theClass instanceMethodForSelector:attributesSel]);
+}
+
++ (BOOL)hasStandardXML {
+  return GDataHasStandardXML(self);
+}
+
++ (BOOL)canCacheXMLElement {
+  // changes to the entries and generator of feeds are not stamped
+  return GDataHasStandardXML(self)
+    && ![self isSubclassOfClass:[GDataFeedBase class]];
+}
+
+- (void)noteXMLChange {
+  changeStamp_ = GDataNextXMLChangeStamp();
+}
+
+- (NSArray *)childObjectsOutsideExtensions {
+  return nil;
+}
+
+- (NSXMLElement *)XMLElementUsingCache {
+  NSXMLElement *element = [self XMLElementUsingCacheInEpoch:0];
+#if GDATA_USES_LIBXML
+  // the element may be the cached one, which is kept for later generations,
+  // so callers get their own copy
+  return [[element copy] autorelease];
+#else
+  return element;
+#endif
+}
+
+// GDataLatestXMLChangeStamp returns the latest change stamp of the object
+// and of the objects beneath it, or NSUIntegerMax if any of them generates
+// XML from state its class does not stamp.  Nothing changes while XML is
+// generated, so the result is kept for the epoch of the generation, and the
+// cache check of each nested object doesn't walk its subtree again.
+static NSUInteger GDataLatestXMLChangeStamp(GDataObject *obj, NSUInteger epoch);
+
+static NSUInteger GDataLatestXMLChangeStampForExtension(id obj,
+                                                        NSUInteger epoch) {
+  if ([obj isKindOfClass:[GDataAttribute class]]) {
+    return [(GDataAttribute *)obj changeStamp];
+  }
+  return GDataLatestXMLChangeStamp(obj, epoch);
+}
+
+static NSUInteger GDataLatestXMLChangeStamp(GDataObject *obj, NSUInteger epoch) {
+  if (obj->latestXMLChangeStampEpoch_ == epoch) {
+    return obj->latestXMLChangeStamp_;
+  }
+
+  NSUInteger latest = NSUIntegerMax;
+
+  if ([[obj class] canCacheXMLElement]) {
+    latest = obj->changeStamp_;
+
+    NSDictionary *extensions = obj->extensions_;
+    for (Class oneClass in extensions) {
+      if (latest == NSUIntegerMax) break;
+
+      id objectOrArray = [extensions objectForKey:oneClass];
+      if ([objectOrArray isKindOfClass:[NSArray class]]) {
+        for (id extension in (NSArray *)objectOrArray) {
+          latest = MAX(latest,
+                       GDataLatestXMLChangeStampForExtension(extension, epoch));
+        }
+      } else {
+        latest = MAX(latest,
+                     GDataLatestXMLChangeStampForExtension(objectOrArray, epoch));
+      }
+    }
+
+    for (GDataObject *child in [obj childObjectsOutsideExtensions]) {
+      if (latest == NSUIntegerMax) break;
+
+      latest = MAX(latest, GDataLatestXMLChangeStamp(child, epoch));
+    }
+  }
+
+  obj->latestXMLChangeStamp_ = latest;
+  obj->latestXMLChangeStampEpoch_ = epoch;
+  return latest;
+}
+
+- (NSXMLElement *)XMLElementUsingCacheInEpoch:(NSUInteger)epoch {
+
+  if (epoch == 0) {
+    // start the outermost generation
+    epoch = __sync_add_and_fetch(&gXMLChangeStamp, 1);
+  }
+
+  BOOL canCache = [[self class] canCacheXMLElement];
+
+  if (canCache && cachedXMLElement_ != nil
+      && GDataLatestXMLChangeStamp(self, epoch) <= cachedXMLElementStamp_) {
+#if GDATA_USES_LIBXML
+    // adding the element to another element or to a document copies it
+    return cachedXMLElement_;
+#else
+    return [[cachedXMLElement_ copy] autorelease];
+#endif
+  }
+
+  // changes made after this point get later stamps
+  NSUInteger stamp = __sync_add_and_fetch(&gXMLChangeStamp, 1);
+
+  NSUInteger savedEpoch = xmlCacheEpoch_;
+  xmlCacheEpoch_ = epoch;
+
+  NSXMLElement *element = [self XMLElement];
+
+  xmlCacheEpoch_ = savedEpoch;
+
+  [cachedXMLElement_ release];
+  cachedXMLElement_ = nil;
+
+  if (canCache && element != nil) {
+#if GDATA_USES_LIBXML
+    cachedXMLElement_ = [element retain];
+#else
+    // the returned element will be added to a parent, so keep a copy
+    cachedXMLElement_ = [element copy];
+#endif
+    cachedXMLElementStamp_ = stamp;
+  }
+  return element;
+}
+
+// GDataExtensionHasChangedSinceStamp is YES if the extension object, or an
+// object beneath it, has changed since the stamp
+static BOOL GDataExtensionHasChangedSinceStamp(id obj, NSUInteger stamp) {
+  if ([obj isKindOfClass:[GDataAttribute class]]) {
+    return ([(GDataAttribute *)obj changeStamp] > stamp);
+  }
+
+  return GDataObjectHasChangedSinceStamp(obj, stamp);
+}
+
+static BOOL GDataObjectHasChangedSinceStamp(GDataObject *obj, NSUInteger stamp) {
+  if (obj->changeStamp_ > stamp) return YES;
+
+  NSDictionary *extensions = obj->extensions_;
+  for (Class oneClass in extensions) {
+    id objectOrArray = [extensions objectForKey:oneClass];
+
+    if ([objectOrArray isKindOfClass:[NSArray class]]) {
+      for (id extension in (NSArray *)objectOrArray) {
+        if (GDataExtensionHasChangedSinceStamp(extension, stamp)) return YES;
+      }
+    } else {
+      if (GDataExtensionHasChangedSinceStamp(objectOrArray, stamp)) return YES;
+    }
+  }
+
+  // as for cached XML, objects held outside the extensions are checked too
+  for (GDataObject *child in [obj childObjectsOutsideExtensions]) {
+    if (GDataObjectHasChangedSinceStamp(child, stamp)) return YES;
+  }
+  return NO;
+}
+
+- (void)releaseCachedXMLElements {
+  [cachedXMLElement_ release];
+  cachedXMLElement_ = nil;
+
+  for (Class oneClass in extensions_) {
+    id objectOrArray = [extensions_ objectForKey:oneClass];
+
+    NSArray *array = ([objectOrArray isKindOfClass:[NSArray class]] ?
+                      objectOrArray : [NSArray arrayWithObject:objectOrArray]);
+    for (id obj in array) {
+      if ([obj isKindOfClass:[GDataObject class]]) {
+        [(GDataObject *)obj releaseCachedXMLElements];
+      }
+    }
+  }
+
+  [[self childObjectsOutsideExtensions]
+    makeObjectsPerformSelector:@selector(releaseCachedXMLElements)];
+}
+
 #pragma mark XML generation helpers
 
 - (void)addNamespacesToElement:(NSXMLElement *)element {
@@ -772,7 +1612,7 @@ static NSMutableDictionary *gQualifiedNameMap = nil;
 
   // we have to copy the children so they don't point at the previous parent
   // nodes
-  for (NSXMLNode *child in unknownChildren_) {
+  for (NSXMLNode *child in [self unknownChildren]) {
     [element addChild:[[child copy] autorelease]];
   }
 
@@ -803,7 +1643,7 @@ static NSMutableDictionary *gQualifiedNameMap = nil;
   if ([unknownAttributes_ count]) {
     NSLog(@"%@ %p: unknown attributes %@\n%@\n", [self class], self, unknownAttributes_, self);
   }
-  if ([unknownChildren_ count]) {
+  if ([[self unknownChildren] count]) {
     NSLog(@"%@ %p: unknown children %@\n%@\n", [self class], self, unknownChildren_, self);
   }
 #endif
@@ -920,8 +1760,11 @@ attributeValueIfNonNil:str
                    URI:theURI];
 
   } else {
-    // element extension
-    NSXMLElement *child = [object XMLElement];
+    // element extension; while this object is generating XML with the cache,
+    // unchanged children supply their cached elements
+    NSXMLElement *child = (xmlCacheEpoch_ != 0 ?
+                           [object XMLElementUsingCacheInEpoch:xmlCacheEpoch_]
+                           : [object XMLElement]);
     if (child) {
       [element addChild:child];
     }
@@ -1174,10 +2017,11 @@ objectDescriptionIfNonNil:(id)obj
 
 #if !GDATA_SIMPLE_DESCRIPTIONS
   // add names of unknown children and attributes to the descriptions
-  if ([unknownChildren_ count] > 0) {
+  NSArray *unknownChildren = [self unknownChildren];
+  if ([unknownChildren count] > 0) {
     // remove repeats and put the element names in < > so they are more
     // readable
-    NSArray *names = [unknownChildren_ valueForKey:@"name"];
+    NSArray *names = [unknownChildren valueForKey:@"name"];
     NSSet *namesSet = [NSSet setWithArray:names];
     NSMutableArray *fmtNames = [NSMutableArray arrayWithCapacity:[namesSet count]];
 
@@ -1280,6 +2124,7 @@ objectDescriptionIfNonNil:(id)obj
 
     object = [[[objectClass alloc] initWithXMLElement:element
                                                parent:self] autorelease];
+    [object gatherUnknownChildren];
   }
   return object;
 }
@@ -1315,8 +2160,19 @@ objectDescriptionIfNonNil:(id)obj
 // prefix
 - (NSMutableArray *)childrenOfElement:(NSXMLElement *)parentElement
                            withPrefix:(NSString *)prefix {
-  NSArray *allChildren = [parentElement children];
   NSMutableArray *matchingChildren = [NSMutableArray array];
+#if GDATA_USES_LIBXML
+  // avoid making nodes for the text and other non-element children
+  [parentElement enumerateChildrenOfKind:NSXMLElementKind
+                                     URI:nil
+                               localName:nil
+                              usingBlock:^(NSXMLNode *childNode, BOOL *stop) {
+    if ([[childNode prefix] isEqual:prefix]) {
+      [matchingChildren addObject:childNode];
+    }
+  }];
+#else
+  NSArray *allChildren = [parentElement children];
   for (NSXMLNode *childNode in allChildren) {
     if ([childNode kind] == NSXMLElementKind
         && [[childNode prefix] isEqual:prefix]) {
@@ -1324,7 +2180,7 @@ objectDescriptionIfNonNil:(id)obj
       [matchingChildren addObject:childNode];
     }
   }
-
+#endif
   return matchingChildren;
 }
 
@@ -1341,30 +2197,9 @@ objectDescriptionIfNonNil:(id)obj
   id result = nil;
   BOOL isResultAnArray = NO;
 
-  NSArray *objElements = nil;
-
-  NSString *localName = [NSXMLNode localNameForName:qualifiedName];
-  if (![localName isEqual:@"*"]) {
-
-    // searching for an actual element name (not a wildcard)
-    objElements = [self elementsForName:qualifiedName
-                           namespaceURI:namespaceURI
-                          parentElement:parentElement];
-  }
-
-  else {
-    // we weren't given a local name, so get all objects for this namespace
-    // URI's prefix
-    NSString *prefixSought = [NSXMLNode prefixForName:qualifiedName];
-    if ([prefixSought length] == 0) {
-      prefixSought = [parentElement resolvePrefixForNamespaceURI:namespaceURI];
-    }
-
-    if (prefixSought) {
-      objElements = [self childrenOfElement:parentElement
-                                 withPrefix:prefixSought];
-    }
-  }
+  NSArray *objElements = [self childElementsOfElement:parentElement
+                                        qualifiedName:qualifiedName
+                                         namespaceURI:namespaceURI];
 
   // if we're creating entries, we'll use an autorelease pool around each
   // allocation, just to bound overall pool size.  We'll check the class
@@ -1376,24 +2211,10 @@ objectDescriptionIfNonNil:(id)obj
   // step through all child elements and create an appropriate GData object
   for (NSXMLElement *objElement in objElements) {
 
-    Class elementClass = objectClass;
-    if (elementClass == nil) {
-      // if the object is a feed or an entry, we might be able to determine the
-      // type for this element from the XML
-      elementClass = [[self class] objectClassForXMLElement:objElement];
-
-      // if a base feed class doesn't specify entry class, and the entry object
-      // class can't be determined by examining its XML, fall back on
-      // instantiating the base entry class
-      if (elementClass == nil
-        && [qualifiedName isEqual:@"entry"]
-        && [namespaceURI isEqual:kGDataNamespaceAtom]) {
-
-        elementClass = entryBaseClass;
-      }
-    }
-
-    elementClass = [self classOrSurrogateForClass:elementClass];
+    Class elementClass = [self classForChildElement:objElement
+                                      qualifiedName:qualifiedName
+                                       namespaceURI:namespaceURI
+                                        objectClass:objectClass];
 
     NSAutoreleasePool *pool = nil;
 
@@ -1408,31 +2229,94 @@ objectDescriptionIfNonNil:(id)obj
 
     id obj = [[elementClass alloc] initWithXMLElement:objElement
                                                parent:self];
+    [obj gatherUnknownChildren];
+
+    // We drain here to keep the clang static analyzer quiet.
+    [pool drain];
+
+    [obj autorelease];
+
+    if (obj) {
+      if (result == nil) {
+        // first result
+        result = obj;
+      } else if (!isResultAnArray) {
+        // second result; create an array with the previous and the new result
+        result = [NSMutableArray arrayWithObjects:result, obj, nil];
+        isResultAnArray = YES;
+      } else {
+        // third or later result
+        [result addObject:obj];
+      }
+    }
+  }
+
+  // remove these elements from the unknown list
+  [self handleParsedElements:objElements];
+
+  return result;
+}
+
+// childElementsOfElement:qualifiedName:namespaceURI: returns the child
+// elements with the name, or with the namespace's prefix if the local name
+// is "*"
+- (NSArray *)childElementsOfElement:(NSXMLElement *)parentElement
+                      qualifiedName:(NSString *)qualifiedName
+                       namespaceURI:(NSString *)namespaceURI {
+
+  NSArray *objElements = nil;
+
+  NSString *localName = [NSXMLNode localNameForName:qualifiedName];
+  if (![localName isEqual:@"*"]) {
+
+    // searching for an actual element name (not a wildcard)
+    objElements = [self elementsForName:qualifiedName
+                           namespaceURI:namespaceURI
+                          parentElement:parentElement];
+  }
+
+  else {
+    // we weren't given a local name, so get all objects for this namespace
+    // URI's prefix
+    NSString *prefixSought = [NSXMLNode prefixForName:qualifiedName];
+    if ([prefixSought length] == 0) {
+      prefixSought = [parentElement resolvePrefixForNamespaceURI:namespaceURI];
+    }
+
+    if (prefixSought) {
+      objElements = [self childrenOfElement:parentElement
+                                 withPrefix:prefixSought];
+    }
+  }
+  return objElements;
+}
+
+// classForChildElement:qualifiedName:namespaceURI:objectClass: returns the
+// class, or its surrogate, of the object to be made for a child element
+- (Class)classForChildElement:(NSXMLElement *)element
+                qualifiedName:(NSString *)qualifiedName
+                 namespaceURI:(NSString *)namespaceURI
+                  objectClass:(Class)objectClass {
 
-    // We drain here to keep the clang static analyzer quiet.
-    [pool drain];
+  Class elementClass = objectClass;
+  if (elementClass == nil) {
+    // if the object is a feed or an entry, we might be able to determine the
+    // type for this element from the XML
+    elementClass = [[self class] objectClassForXMLElement:element];
 
-    [obj autorelease];
+    // if a base feed class doesn't specify entry class, and the entry object
+    // class can't be determined by examining its XML, fall back on
+    // instantiating the base entry class
+    if (elementClass == nil
+      && [qualifiedName isEqual:@"entry"]
+      && [namespaceURI isEqual:kGDataNamespaceAtom]) {
 
-    if (obj) {
-      if (result == nil) {
-        // first result
-        result = obj;
-      } else if (!isResultAnArray) {
-        // second result; create an array with the previous and the new result
-        result = [NSMutableArray arrayWithObjects:result, obj, nil];
-        isResultAnArray = YES;
-      } else {
-        // third or later result
-        [result addObject:obj];
-      }
+      elementClass = [GDataEntryBase class];
     }
   }
 
-  // remove these elements from the unknown list
-  [self handleParsedElements:objElements];
-
-  return result;
+  elementClass = [self classOrSurrogateForClass:elementClass];
+  return elementClass;
 }
 
 // childOfElement:withName returns the element with the name, or nil if there
@@ -1476,7 +2360,31 @@ objectDescriptionIfNonNil:(id)obj
 
 #pragma mark element parsing
 
+// positionOfChildNode: returns the position of the node among the children
+// being parsed, or kCFNotFound
+- (CFIndex)positionOfChildNode:(NSXMLNode *)node {
+  if (childPositions_ != NULL) {
+    const void *position;
+    if (CFDictionaryGetValueIfPresent(childPositions_, node, &position)) {
+      return (CFIndex)(intptr_t)position;
+    }
+    return kCFNotFound;
+  }
+
+  NSUInteger idx = [childNodesBeingParsed_ indexOfObjectIdenticalTo:node];
+  return (idx == NSNotFound ? kCFNotFound : (CFIndex)idx);
+}
+
 - (void)handleParsedElement:(NSXMLNode *)element {
+  if (childNodesBeingParsed_ != nil && element != nil) {
+    // mark the child as parsed; the unknown children are gathered later
+    CFIndex position = [self positionOfChildNode:element];
+    if (position != kCFNotFound) {
+      CFBitVectorSetBitAtIndex(parsedChildFlags_, position, 1);
+    }
+    return;
+  }
+
   if (unknownChildren_ != nil && element != nil) {
     [unknownChildren_ removeObjectIdenticalTo:element];
 
@@ -1488,6 +2396,13 @@ objectDescriptionIfNonNil:(id)obj
 }
 
 - (void)handleParsedElements:(NSArray *)array {
+  if (childNodesBeingParsed_ != nil) {
+    for (NSXMLNode *element in array) {
+      [self handleParsedElement:element];
+    }
+    return;
+  }
+
   if (unknownChildren_ != nil) {
     // rather than use NSMutableArray's removeObjects:, it's faster to iterate and
     // and use removeObjectIdenticalTo: since it avoids comparing the underlying
@@ -1513,12 +2428,29 @@ objectDescriptionIfNonNil:(id)obj
     return nil;
   }
 
-  NSString *result = nil;
-
   // consider all text child nodes used to make this string value to now be
   // known
   //
   // in most cases, there is only one text node, so we'll optimize for that
+#if GDATA_USES_LIBXML
+  __block NSString *result = nil;
+
+  [element enumerateChildrenOfKind:NSXMLTextKind
+                               URI:nil
+                         localName:nil
+                        usingBlock:^(NSXMLNode *childNode, BOOL *stop) {
+    NSString *newNodeString = [childNode stringValue];
+
+    if (result == nil) {
+      result = newNodeString;
+    } else {
+      result = [result stringByAppendingString:newNodeString];
+    }
+    [self handleParsedElement:childNode];
+  }];
+#else
+  NSString *result = nil;
+
   NSArray *children = [element children];
 
   for (NSXMLNode *childNode in children) {
@@ -1534,6 +2466,7 @@ objectDescriptionIfNonNil:(id)obj
       [self handleParsedElement:childNode];
     }
   }
+#endif
 
   return (result != nil ? result : @"");
 }
@@ -1736,7 +2669,12 @@ objectDescriptionIfNonNil:(id)obj
   // this class
   Class currClass = [self class];
   NSMutableDictionary *extensionDeclarationsCache = [self extensionDeclarationsCache];
-  GDATA_DEBUG_ASSERT(extensionDeclarationsCache != nil, @"missing extnDecls");
+  if (extensionDeclarationsCache == nil) {
+    // parsed objects use shared declarations, so have no cache until
+    // declaring more extensions
+    extensionDeclarationsCache_ = [[NSMutableDictionary alloc] init];
+    extensionDeclarationsCache = extensionDeclarationsCache_;
+  }
 
   NSMutableDictionary *extensionDecls = [extensionDeclarationsCache objectForKey:currClass];
 
@@ -1803,6 +2741,7 @@ objectDescriptionIfNonNil:(id)obj
 // this is typically called by the getter methods of subclasses
 
 - (NSArray *)objectsForExtensionClass:(Class)theClass {
+
   id obj = [extensions_ objectForKey:theClass];
   if (obj == nil) return nil;
 
@@ -1819,6 +2758,7 @@ objectDescriptionIfNonNil:(id)obj
 // this is typically called by the getter methods of subclasses
 
 - (id)objectForExtensionClass:(Class)theClass {
+
   id obj = [extensions_ objectForKey:theClass];
 
   if ([obj isKindOfClass:[NSArray class]]) {
@@ -1890,6 +2830,9 @@ objectDescriptionIfNonNil:(id)obj
   GDATA_DEBUG_ASSERT(objects == nil || [objects isKindOfClass:[NSArray class]],
                      @"array expected");
 
+  changeStamp_ = GDataNextXMLChangeStamp();
+
+
   if (extensions_ == nil && objects != nil) {
     extensions_ = [[NSMutableDictionary alloc] init];
   }
@@ -1913,6 +2856,9 @@ objectDescriptionIfNonNil:(id)obj
 
   GDATA_DEBUG_ASSERT(![object isKindOfClass:[NSArray class]], @"array unexpected");
 
+  changeStamp_ = GDataNextXMLChangeStamp();
+
+
   if (extensions_ == nil && object != nil) {
     extensions_ = [[NSMutableDictionary alloc] init];
   }
@@ -1933,6 +2879,9 @@ objectDescriptionIfNonNil:(id)obj
 
   if (newObj == nil) return;
 
+  changeStamp_ = GDataNextXMLChangeStamp();
+
+
   id previousObjOrArray = [extensions_ objectForKey:theClass];
   if (previousObjOrArray) {
 
@@ -1961,6 +2910,9 @@ objectDescriptionIfNonNil:(id)obj
 // this is typically called by removeObject methods of subclasses
 
 - (void)removeObject:(id)object forExtensionClass:(Class)theClass {
+  changeStamp_ = GDataNextXMLChangeStamp();
+
+
   id previousObjOrArray = [extensions_ objectForKey:theClass];
   if ([previousObjOrArray isKindOfClass:[NSArray class]]) {
 
@@ -1974,19 +2926,44 @@ objectDescriptionIfNonNil:(id)obj
   }
 }
 
-// addUnknownChildNodesForElement: is called by initWithXMLElement.  It builds
-// the initial list of unknown child elements; this list is whittled down by
-// parseExtensionsForElement and objectForChildOfElement.
+// addUnknownChildNodesForElement: is called by initWithXMLElement.  It keeps
+// the child nodes with a flag for each to be set as the child is parsed by
+// parseExtensionsForElement and objectForChildOfElement; the children left
+// unflagged are gathered as the unknown children once parsing is done.
+//
+// Subclasses parse after initWithXMLElement returns, so the unknown children
+// cannot be gathered when it finishes; whoever made the object gathers them
+// after its initializer returns.
 - (void)addUnknownChildNodesForElement:(NSXMLElement *)element {
 
   GDATA_DEBUG_ASSERT(unknownChildren_ == nil, @"unknChildren added twice");
   GDATA_DEBUG_ASSERT(unknownAttributes_ == nil, @"unknAttr added twice");
+  GDATA_DEBUG_ASSERT(childNodesBeingParsed_ == nil, @"children added twice");
 
   if (!shouldIgnoreUnknowns_) {
 
     NSArray *children = [element children];
-    if ([children count] > 0) {
-      unknownChildren_ = [[NSMutableArray alloc] initWithArray:children];
+    NSUInteger numberOfChildren = [children count];
+    if (numberOfChildren > 0) {
+      childNodesBeingParsed_ = [children copy];
+
+      parsedChildFlags_ = CFBitVectorCreateMutable(kCFAllocatorDefault,
+                                                   (CFIndex)numberOfChildren);
+      CFBitVectorSetCount(parsedChildFlags_, (CFIndex)numberOfChildren);
+
+      if (numberOfChildren >= kMinChildCountForPositionMap) {
+        // nodes are compared by identity, as removeObjectIdenticalTo: did
+        childPositions_ = CFDictionaryCreateMutable(kCFAllocatorDefault,
+                                                    (CFIndex)numberOfChildren,
+                                                    NULL, NULL);
+        NSUInteger idx = 0;
+        for (NSXMLNode *child in childNodesBeingParsed_) {
+          // adding does not replace, so a node listed twice keeps its first
+          // position
+          CFDictionaryAddValue(childPositions_, child, (const void *)(intptr_t)idx);
+          idx++;
+        }
+      }
     }
 
     NSArray *attributes = [element attributes];
@@ -1996,87 +2973,131 @@ objectDescriptionIfNonNil:(id)obj
   }
 }
 
-// parseExtensionsForElement: is called by initWithXMLElement. It starts
-// from the current object and works up the chain of parents, grabbing
-// the declared extensions by each GDataObject in the ancestry and looking
-// at the current element to see if any of the declared extensions are present.
+// gatherUnknownChildren builds the unknown children array from the children
+// not flagged as parsed, and frees the flags
+- (void)gatherUnknownChildren {
+  if (childNodesBeingParsed_ == nil) return;
+
+  CFIndex numberOfChildren = CFBitVectorGetCount(parsedChildFlags_);
+  CFIndex numberOfParsed = CFBitVectorGetCountOfBit(parsedChildFlags_,
+                                                    CFRangeMake(0, numberOfChildren),
+                                                    1);
+  if (numberOfParsed < numberOfChildren) {
+    unknownChildren_ = [[NSMutableArray alloc] initWithCapacity:(NSUInteger)(numberOfChildren - numberOfParsed)];
+
+    CFIndex idx = 0;
+    for (NSXMLNode *child in childNodesBeingParsed_) {
+      if (!CFBitVectorGetBitAtIndex(parsedChildFlags_, idx)) {
+        [unknownChildren_ addObject:child];
+      }
+      idx++;
+    }
+  }
+
+  [self releaseParsedChildFlags];
+}
+
+- (void)releaseParsedChildFlags {
+  [childNodesBeingParsed_ release];
+  childNodesBeingParsed_ = nil;
+
+  if (parsedChildFlags_ != NULL) {
+    CFRelease(parsedChildFlags_);
+    parsedChildFlags_ = NULL;
+  }
+
+  if (childPositions_ != NULL) {
+    CFRelease(childPositions_);
+    childPositions_ = NULL;
+  }
+}
+
+// parseExtensionsForElement: is called by initWithXMLElement. It makes one
+// pass over the child elements, looking up their local names in the parse
+// plan for this object's class and parents, and then parses the declared
+// extensions that may be present.
 
 - (void)parseExtensionsForElement:(NSXMLElement *)element {
-  Class classBeingParsed = [self class];
 
-  // For performance, we'll avoid looking up extension elements whose
-  // local names aren't present in the element.  We don't bother doing
-  // this for attribute extensions since those are so rare (most attributes
-  // are parsed just by local declaration in parseAttributesForElement:.)
+  GDataParsePlan *plan = [self parsePlan];
+  NSArray *decls = [plan declarations];
+  if ([decls count] == 0) return;
+
+  // attribute extensions and wildcard element extensions are always parsed
+  NSMutableIndexSet *declIndexes = [[[plan alwaysParsedDeclarationIndexes] mutableCopy] autorelease];
 
-  NSArray *childLocalNames = [element valueForKeyPath:@"children.localName"];
+  // element extensions outside the projection are left unparsed
+  NSSet *projection = [self inheritedParseProjection];
 
-  // allow wildcard lookups
-  childLocalNames = [childLocalNames arrayByAddingObject:@"*"];
+#if GDATA_USES_LIBXML
+  // look at the names without making nodes for the non-element children
+  [element enumerateChildrenOfKind:NSXMLElementKind
+                               URI:nil
+                         localName:nil
+                        usingBlock:^(NSXMLNode *childNode, BOOL *stop) {
+    NSIndexSet *indexes = [plan declarationIndexesForLocalName:[childNode localName]];
+    if (indexes) [declIndexes addIndexes:indexes];
+  }];
+#else
+  for (NSXMLNode *childNode in [element children]) {
+    if ([childNode kind] == NSXMLElementKind) {
+      NSIndexSet *indexes = [plan declarationIndexesForLocalName:[childNode localName]];
+      if (indexes) [declIndexes addIndexes:indexes];
+    }
+  }
+#endif
 
   Class arrayClass = [NSArray class];
 
-  for (GDataObject * currentExtensionSupplier = self;
-       currentExtensionSupplier != nil;
-       currentExtensionSupplier = [currentExtensionSupplier parent]) {
-
-    // find all extensions in this supplier with the current class as the parent
-    NSArray *extnDecls = [currentExtensionSupplier extensionDeclarationsForParentClass:classBeingParsed];
-
-    if (extnDecls) {
-      for (GDataExtensionDeclaration *decl in extnDecls) {
-        // if we've not already found this class when parsing at an earlier supplier
-        Class extensionClass = [decl childClass];
-        if ([extensions_ objectForKey:extensionClass] == nil) {
-
-          // if this extension's local name really matches some child's local
-          // name (or this is an attribute extension)
-
-          NSString *declLocalName = [extensionClass extensionElementLocalName];
-          if ([childLocalNames containsObject:declLocalName]
-              || [decl isAttribute]) {
-
-            GDATA_DEBUG_ASSERT([extensionClass conformsToProtocol:@protocol(GDataExtension)],
-                      @"%@ does not conform to GDataExtension protocol",
-                      extensionClass);
-
-            NSString *namespaceURI = [extensionClass extensionElementURI];
-            NSString *qualifiedName = [self qualifiedNameForExtensionClass:extensionClass];
-
-            id objectOrArray = nil;
-
-            if ([decl isAttribute]) {
-              // parse for an attribute extension
-              NSString *str = [self stringForAttributeName:qualifiedName
-                                               fromElement:element];
-              if (str) {
-                id attr = [[[extensionClass alloc] init] autorelease];
-                [attr setStringValue:str];
-                objectOrArray = attr;
-              }
-
-            } else {
-              // parse for an element extension
-              objectOrArray = [self objectOrArrayForChildrenOfElement:element
-                                                        qualifiedName:qualifiedName
-                                                         namespaceURI:namespaceURI
-                                                          objectClass:extensionClass];
-            }
-
-            if ([objectOrArray isKindOfClass:arrayClass]) {
-              if ([(NSArray *)objectOrArray count] > 0) {
-
-                // save the non-empty array of extensions
-                [self setObjects:objectOrArray forExtensionClass:extensionClass];
-              }
-            } else if (objectOrArray != nil) {
-
-              // save the single extension
-              [self setObject:objectOrArray forExtensionClass:extensionClass];
-            }
-          }
-        }
+  NSUInteger idx = [declIndexes firstIndex];
+  for (; idx != NSNotFound; idx = [declIndexes indexGreaterThanIndex:idx]) {
+    GDataExtensionDeclaration *decl = [decls objectAtIndex:idx];
+    Class extensionClass = [decl childClass];
+
+    GDATA_DEBUG_ASSERT([extensionClass conformsToProtocol:@protocol(GDataExtension)],
+              @"%@ does not conform to GDataExtension protocol",
+              extensionClass);
+
+    NSString *namespaceURI = [extensionClass extensionElementURI];
+    NSString *qualifiedName = [self qualifiedNameForExtensionClass:extensionClass];
+
+    if (projection != nil
+        && ![decl isAttribute]
+        && ![projection containsObject:extensionClass]
+        && ![projection containsObject:qualifiedName]) {
+      continue;
+    }
+
+    id objectOrArray = nil;
+
+    if ([decl isAttribute]) {
+      // parse for an attribute extension
+      NSString *str = [self stringForAttributeName:qualifiedName
+                                       fromElement:element];
+      if (str) {
+        id attr = [[[extensionClass alloc] init] autorelease];
+        [attr setStringValue:str];
+        objectOrArray = attr;
+      }
+
+    } else {
+      // parse for an element extension
+      objectOrArray = [self objectOrArrayForChildrenOfElement:element
+                                                qualifiedName:qualifiedName
+                                                 namespaceURI:namespaceURI
+                                                  objectClass:extensionClass];
+    }
+
+    if ([objectOrArray isKindOfClass:arrayClass]) {
+      if ([(NSArray *)objectOrArray count] > 0) {
+
+        // save the non-empty array of extensions
+        [self setObjects:objectOrArray forExtensionClass:extensionClass];
       }
+    } else if (objectOrArray != nil) {
+
+      // save the single extension
+      [self setObject:objectOrArray forExtensionClass:extensionClass];
     }
   }
 }
@@ -2085,18 +3106,34 @@ objectDescriptionIfNonNil:(id)obj
 
 - (void)addLocalAttributeDeclarations:(NSArray *)attributeLocalNames {
 
+  changeStamp_ = GDataNextXMLChangeStamp();
+
+  if (hasSharedAttributeDeclarations_) {
+    // the shared declarations of the class are immutable, so this object
+    // needs its own copy to add to
+    NSMutableArray *attrDecls = [attributeDeclarations_ mutableCopy];
+    [attributeDeclarations_ release];
+    attributeDeclarations_ = attrDecls;
+
+    NSMutableDictionary *attrTypes = [attributeTypes_ mutableCopy];
+    [attributeTypes_ release];
+    attributeTypes_ = attrTypes;
+
+    hasSharedAttributeDeclarations_ = NO;
+  }
+
   // get or make the array which caches the attribute declarations for
   // this class
   if (attributeDeclarations_ == nil) {
 
     Class currClass = [self class];
     NSMutableDictionary *cache = [self attributeDeclarationsCache];
-    GDATA_DEBUG_ASSERT(cache != nil, @"missing attrDeclsCache");
 
     // we keep a strong pointer to the array in the cache since the cache
     // belongs to the feed or the topmost parent, and that may go away
     attributeDeclarations_ = [[cache objectForKey:currClass] retain];
     if (attributeDeclarations_ == nil) {
+      // parsed objects have no cache
       attributeDeclarations_ = [[NSMutableArray alloc] init];
       [cache setObject:attributeDeclarations_ forKey:(id<NSCopying>)currClass];
     }
@@ -2118,12 +3155,38 @@ objectDescriptionIfNonNil:(id)obj
   [attributeDeclarations_ addObjectsFromArray:attributeLocalNames];
 }
 
+- (void)addLocalAttributeDeclarations:(NSArray *)attributeLocalNames
+                               ofType:(GDataAttributeType)type {
+
+  [self addLocalAttributeDeclarations:attributeLocalNames];
+
+  if (type == kGDataAttributeTypeString) return;
+
+  if (attributeTypes_ == nil) {
+    attributeTypes_ = [[NSMutableDictionary alloc] init];
+  }
+
+  NSNumber *typeNum = [NSNumber numberWithInt:type];
+  for (NSString *name in attributeLocalNames) {
+    [attributeTypes_ setObject:typeNum forKey:name];
+  }
+}
+
+- (GDataAttributeType)typeForAttribute:(NSString *)name {
+  NSNumber *typeNum = [attributeTypes_ objectForKey:name];
+  if (typeNum == nil) return kGDataAttributeTypeString;
+
+  return (GDataAttributeType) [typeNum intValue];
+}
+
 - (void)addAttributeDeclarationMarker:(NSString *)marker {
 
+  changeStamp_ = GDataNextXMLChangeStamp();
+
   if (![attributeDeclarations_ containsObject:marker]) {
 
     // add the marker
-    if (attributeDeclarations_ != nil) {
+    if (attributeDeclarations_ != nil && !hasSharedAttributeDeclarations_) {
 
       // no need to create the cache
       [attributeDeclarations_ addObject:marker];
@@ -2146,68 +3209,40 @@ objectDescriptionIfNonNil:(id)obj
 }
 
 - (NSNumber *)intNumberForAttribute:(NSString *)name {
-
-  NSString *str = [self stringValueForAttribute:name];
-  if ([str length] > 0) {
-    NSNumber *number = [NSNumber numberWithInt:[str intValue]];
-    return number;
-  }
-  return nil;
+  return [self valueForAttribute:name ofType:kGDataAttributeTypeInt];
 }
 
 - (NSNumber *)doubleNumberForAttribute:(NSString *)name {
-
-  NSString *str = [self stringValueForAttribute:name];
-  return [GDataUtilities doubleNumberOrInfForString:str];
+  return [self valueForAttribute:name ofType:kGDataAttributeTypeDouble];
 }
 
 - (NSNumber *)longLongNumberForAttribute:(NSString *)name {
-
-  NSString *str = [self stringValueForAttribute:name];
-  if (str) {
-    long long val = [str longLongValue];
-    NSNumber *number = [NSNumber numberWithLongLong:val];
-    return number;
-  }
-  return nil;
+  return [self valueForAttribute:name ofType:kGDataAttributeTypeLongLong];
 }
 
 - (NSDecimalNumber *)decimalNumberForAttribute:(NSString *)name {
-
-  NSString *str = [self stringValueForAttribute:name];
-  if ([str length] > 0) {
-
-    // require periods as the separator
-    NSLocale *usLocale = [[[NSLocale alloc] initWithLocaleIdentifier:@"en_US"] autorelease];
-    NSDecimalNumber *number = [NSDecimalNumber decimalNumberWithString:str
-                                    locale:usLocale];
-    return number;
-  }
-  return nil;
+  return [self valueForAttribute:name ofType:kGDataAttributeTypeDecimal];
 }
 
 - (GDataDateTime *)dateTimeForAttribute:(NSString *)name  {
-
-  NSString *str = [self stringValueForAttribute:name];
-  if ([str length] > 0) {
-    GDataDateTime *dateTime = [GDataDateTime dateTimeWithRFC3339String:str];
-    return dateTime;
-  }
-  return nil;
+  // date times are mutable, so the caller gets a copy of the parsed value
+  GDataDateTime *dateTime = [self valueForAttribute:name
+                                             ofType:kGDataAttributeTypeDateTime];
+  return [[dateTime copy] autorelease];
 }
 
 - (BOOL)boolValueForAttribute:(NSString *)name defaultValue:(BOOL)defaultVal {
-  NSString *str = [self stringValueForAttribute:name];
+  // the parsed value is nil for a missing attribute or one that is neither
+  // true nor false
+  NSNumber *boolNum = [self valueForAttribute:name ofType:kGDataAttributeTypeBool];
   BOOL isTrue;
 
   if (defaultVal) {
     // default to true, so true if attribute is missing or is not "false"
-    isTrue = (str == nil
-              || [str caseInsensitiveCompare:@"false"] != NSOrderedSame);
+    isTrue = (boolNum == nil || [boolNum boolValue]);
   } else {
     // default to false, so true only if attribute is present and "true"
-    isTrue = (str != nil
-              && [str caseInsensitiveCompare:@"true"] == NSOrderedSame);
+    isTrue = (boolNum != nil && [boolNum boolValue]);
   }
   return isTrue;
 }
@@ -2218,11 +3253,15 @@ objectDescriptionIfNonNil:(id)obj
   GDATA_DEBUG_ASSERT([[self attributeDeclarations] containsObject:name],
             @"%@ setting undeclared attribute: %@", [self class], name);
 
+  changeStamp_ = GDataNextXMLChangeStamp();
+
   if (attributes_ == nil) {
     attributes_ = [[NSMutableDictionary alloc] init];
   }
 
   [attributes_ setValue:str forKey:name];
+
+  [self updateParsedValueForAttribute:name];
 }
 
 - (void)setBoolValue:(BOOL)flag defaultValue:(BOOL)defaultVal forAttribute:(NSString *)name {
@@ -2258,6 +3297,133 @@ objectDescriptionIfNonNil:(id)obj
 }
 
 
+// parsed attribute values
+//
+// the values of typed attributes are parsed into slots when the attributes
+// are parsed or set; the getters only read the slots, so objects may be read
+// from several threads at once, and values requested as another type are
+// parsed from the strings without being kept
+
+static id GDataParsedAttributeValue(NSString *str, GDataAttributeType type) {
+  switch (type) {
+    case kGDataAttributeTypeInt:
+      if ([str length] > 0) {
+        return [NSNumber numberWithInt:[str intValue]];
+      }
+      return nil;
+
+    case kGDataAttributeTypeLongLong:
+      if (str) {
+        return [NSNumber numberWithLongLong:[str longLongValue]];
+      }
+      return nil;
+
+    case kGDataAttributeTypeDouble:
+      return [GDataUtilities doubleNumberOrInfForString:str];
+
+    case kGDataAttributeTypeDecimal:
+      if ([str length] > 0) {
+        // require periods as the separator
+        NSLocale *usLocale = [[[NSLocale alloc] initWithLocaleIdentifier:@"en_US"] autorelease];
+        return [NSDecimalNumber decimalNumberWithString:str
+                                                 locale:usLocale];
+      }
+      return nil;
+
+    case kGDataAttributeTypeBool:
+      if ([str caseInsensitiveCompare:@"true"] == NSOrderedSame) {
+        return [NSNumber numberWithBool:YES];
+      }
+      if ([str caseInsensitiveCompare:@"false"] == NSOrderedSame) {
+        return [NSNumber numberWithBool:NO];
+      }
+      return nil;
+
+    case kGDataAttributeTypeDateTime:
+      if ([str length] > 0) {
+        return [GDataDateTime dateTimeWithRFC3339String:str];
+      }
+      return nil;
+
+    default:
+      return str;
+  }
+}
+
+- (id)valueForAttribute:(NSString *)name ofType:(GDataAttributeType)type {
+
+  GDataAttributeValueSlot *slot = [self valueSlotForAttribute:name];
+  if (slot != NULL && slot->type == type) {
+    return slot->value;
+  }
+
+  NSString *str = [self stringValueForAttribute:name];
+  return GDataParsedAttributeValue(str, type);
+}
+
+- (GDataAttributeValueSlot *)valueSlotForAttribute:(NSString *)name {
+  for (NSUInteger idx = 0; idx < numberOfAttributeValueSlots_; idx++) {
+    GDataAttributeValueSlot *slot = &attributeValueSlots_[idx];
+    if (slot->name == name || [slot->name isEqual:name]) {
+      return slot;
+    }
+  }
+  return NULL;
+}
+
+- (void)setParsedValue:(id)value
+          forAttribute:(NSString *)name
+                ofType:(GDataAttributeType)type {
+
+  GDataAttributeValueSlot *slot = [self valueSlotForAttribute:name];
+  if (slot == NULL) {
+    size_t newSize = (numberOfAttributeValueSlots_ + 1) * sizeof(GDataAttributeValueSlot);
+    GDataAttributeValueSlot *slots = realloc(attributeValueSlots_, newSize);
+    if (slots == NULL) return;
+
+    attributeValueSlots_ = slots;
+    slot = &attributeValueSlots_[numberOfAttributeValueSlots_++];
+    slot->name = [name copy];
+    slot->value = nil;
+  }
+
+  slot->type = type;
+  [slot->value autorelease];
+  slot->value = [value retain];
+}
+
+- (void)updateParsedValueForAttribute:(NSString *)name {
+  GDataAttributeType type = [self typeForAttribute:name];
+  NSString *str = [attributes_ objectForKey:name];
+
+  if (type == kGDataAttributeTypeString || str == nil) {
+    [self removeParsedValueForAttribute:name];
+  } else {
+    [self setParsedValue:GDataParsedAttributeValue(str, type)
+            forAttribute:name
+                  ofType:type];
+  }
+}
+
+- (void)removeParsedValueForAttribute:(NSString *)name {
+  GDataAttributeValueSlot *slot = [self valueSlotForAttribute:name];
+  if (slot == NULL) return;
+
+  [slot->name release];
+  [slot->value release];
+
+  // move the last slot into the removed one's place
+  *slot = attributeValueSlots_[--numberOfAttributeValueSlots_];
+}
+
+- (void)removeParsedAttributeValues {
+  for (NSUInteger idx = 0; idx < numberOfAttributeValueSlots_; idx++) {
+    [attributeValueSlots_[idx].name release];
+    [attributeValueSlots_[idx].value release];
+  }
+  numberOfAttributeValueSlots_ = 0;
+}
+
 // parseAttributesForElement: is called by initWithXMLElement.
 // It stores the value of all declared & present attributes in the dictionary
 - (void)parseAttributesForElement:(NSXMLElement *)element {
@@ -2272,6 +3438,7 @@ objectDescriptionIfNonNil:(id)obj
     NSString *attrName = [attribute name];
     if ([attributeDeclarations containsObject:attrName]) {
 
+      // typed attributes have their values parsed as they are set
       NSString *str = [attribute stringValue];
       if (str != nil) {
         [self setStringValue:str forAttribute:attrName];
@@ -2352,6 +3519,8 @@ objectDescriptionIfNonNil:(id)obj
   GDATA_ASSERT([self hasDeclaredContentValue], @"%@ setting undeclared content value",
                [self class]);
 
+  changeStamp_ = GDataNextXMLChangeStamp();
+
   [contentValue_ autorelease];
   contentValue_ = [str copy];
 }
@@ -2420,6 +3589,8 @@ objectDescriptionIfNonNil:(id)obj
   GDATA_DEBUG_ASSERT([self hasDeclaredChildXMLElements],
                      @"%@ setting undeclared XML values", [self class]);
 
+  changeStamp_ = GDataNextXMLChangeStamp();
+
   [childXMLElements_ release];
   childXMLElements_ = [array mutableCopy];
 }
@@ -2428,6 +3599,8 @@ objectDescriptionIfNonNil:(id)obj
   GDATA_DEBUG_ASSERT([self hasDeclaredChildXMLElements],
                      @"%@ adding undeclared XML values", [self class]);
 
+  changeStamp_ = GDataNextXMLChangeStamp();
+
   if (childXMLElements_ == nil) {
     childXMLElements_ = [[NSMutableArray alloc] init];
   }
@@ -2440,6 +3613,20 @@ objectDescriptionIfNonNil:(id)obj
 
   if ([self hasDeclaredChildXMLElements]) {
 
+#if GDATA_USES_LIBXML
+    [element enumerateChildrenOfKind:NSXMLElementKind
+                                 URI:nil
+                           localName:nil
+                          usingBlock:^(NSXMLNode *childNode, BOOL *stop) {
+      if (childXMLElements_ == nil) {
+        childXMLElements_ = [[NSMutableArray alloc] init];
+      }
+      NSXMLNode *childCopy = [[childNode copy] autorelease];
+      [childXMLElements_ addObject:childCopy];
+
+      [self handleParsedElement:childNode];
+    }];
+#else
     NSArray *children = [element children];
     if (children != nil) {
 
@@ -2456,6 +3643,7 @@ objectDescriptionIfNonNil:(id)obj
         }
       }
     }
+#endif
   }
 }
 
@@ -2754,6 +3942,151 @@ forCategoryWithScheme:(NSString *)scheme
 
 @end
 
+@implementation GDataParsePlan
+
++ (GDataParsePlan *)planWithSharedDeclarations:(NSDictionary *)sharedDecls
+                                      forClass:(Class)theClass
+                                    parentPlan:(GDataParsePlan *)parentPlan {
+  NSDictionary *extnDecls = [sharedDecls objectForKey:kExtensionDeclarationsKey];
+  NSMutableArray *chain = [NSMutableArray arrayWithObject:extnDecls];
+  if (parentPlan != nil) {
+    [chain addObjectsFromArray:parentPlan->declarationsChain_];
+  }
+
+  // the first declaration of an extension class, nearest first, takes
+  // precedence
+  NSMutableArray *decls = [NSMutableArray array];
+  NSMutableSet *declaredClasses = [NSMutableSet set];
+  for (NSDictionary *declsByParent in chain) {
+    for (GDataExtensionDeclaration *decl in [declsByParent objectForKey:theClass]) {
+      Class extensionClass = [decl childClass];
+      if (![declaredClasses containsObject:extensionClass]) {
+        [declaredClasses addObject:extensionClass];
+        [decls addObject:decl];
+      }
+    }
+  }
+
+  GDataParsePlan *plan = [[[self alloc] initWithDeclarations:decls
+                                          sharedDeclarations:sharedDecls
+                                           declarationsChain:chain] autorelease];
+  return plan;
+}
+
+- (id)initWithDeclarations:(NSArray *)declarations
+        sharedDeclarations:(NSDictionary *)sharedDecls
+         declarationsChain:(NSArray *)chain {
+  self = [super init];
+  if (self) {
+    declarations_ = [declarations copy];
+    sharedDeclarations_ = [sharedDecls retain];
+    declarationsChain_ = [chain copy];
+
+    NSMutableDictionary *indexesByName = [NSMutableDictionary dictionary];
+    NSMutableIndexSet *alwaysParsed = [NSMutableIndexSet indexSet];
+
+    NSUInteger idx = 0;
+    for (GDataExtensionDeclaration *decl in declarations_) {
+      NSString *localName = [[decl childClass] extensionElementLocalName];
+
+      if ([decl isAttribute] || [localName isEqual:@"*"] || localName == nil) {
+        [alwaysParsed addIndex:idx];
+      } else {
+        NSMutableIndexSet *indexes = [indexesByName objectForKey:localName];
+        if (indexes == nil) {
+          indexes = [NSMutableIndexSet indexSet];
+          [indexesByName setObject:indexes forKey:localName];
+        }
+        [indexes addIndex:idx];
+      }
+      idx++;
+    }
+
+    // keep immutable copies so the plan may be used from any thread
+    NSMutableDictionary *immutableIndexes = [NSMutableDictionary dictionary];
+    for (NSString *localName in indexesByName) {
+      NSIndexSet *indexes = [[[indexesByName objectForKey:localName] copy] autorelease];
+      [immutableIndexes setObject:indexes forKey:localName];
+    }
+    declIndexesByName_ = [immutableIndexes copy];
+    alwaysParsedIndexes_ = [alwaysParsed copy];
+  }
+  return self;
+}
+
+- (void)dealloc {
+  [declarations_ release];
+  [declIndexesByName_ release];
+  [alwaysParsedIndexes_ release];
+  [sharedDeclarations_ release];
+  [declarationsChain_ release];
+  [childPlans_ release];
+  [retiredChildPlans_ release];
+  [super dealloc];
+}
+
+- (NSString *)description {
+  return [NSString stringWithFormat:@"%@ %p: {%@}",
+          [self class], self, declarations_];
+}
+
+- (NSArray *)declarations {
+  return declarations_;
+}
+
+- (NSIndexSet *)declarationIndexesForLocalName:(NSString *)localName {
+  if (localName == nil) return nil;
+  return [declIndexesByName_ objectForKey:localName];
+}
+
+- (NSIndexSet *)alwaysParsedDeclarationIndexes {
+  return alwaysParsedIndexes_;
+}
+
+- (NSDictionary *)sharedDeclarations {
+  return sharedDeclarations_;
+}
+
+- (BOOL)canKeepChildPlans {
+  return (declarationsChain_ != nil);
+}
+
+- (GDataParsePlan *)childPlanForClass:(Class)theClass {
+  // the dictionary is never changed once published, and replaced ones are
+  // retained until this plan is released, so it may be read while another
+  // thread adds a plan
+  NSDictionary *childPlans = childPlans_;
+  return [childPlans objectForKey:theClass];
+}
+
+// addChildPlan:forClass: returns the plan kept for the class, which is the
+// one passed in unless another thread added one first
+- (GDataParsePlan *)addChildPlan:(GDataParsePlan *)plan forClass:(Class)theClass {
+  @synchronized(self) {
+    GDataParsePlan *prevPlan = [childPlans_ objectForKey:theClass];
+    if (prevPlan) return prevPlan;
+
+    NSMutableDictionary *childPlans = [NSMutableDictionary dictionaryWithDictionary:childPlans_];
+    [childPlans setObject:plan forKey:(id<NSCopying>)theClass];
+    NSDictionary *newChildPlans = [childPlans copy];
+
+    if (childPlans_ != nil) {
+      if (retiredChildPlans_ == nil) {
+        retiredChildPlans_ = [[NSMutableArray alloc] init];
+      }
+      [retiredChildPlans_ addObject:childPlans_];
+      [childPlans_ release];
+    }
+
+    // finish making the dictionary before other threads may see it
+    __sync_synchronize();
+    childPlans_ = newChildPlans;
+  }
+  return plan;
+}
+
+@end
+
 @implementation GDataAttribute
 
 // This is the base class for attribute extensions.
@@ -2807,10 +4140,12 @@ forCategoryWithScheme:(NSString *)scheme
 }
 
 - (NSUInteger)hash {
-  return (NSUInteger) (void *) [GDataAttribute class];
+  return [value_ hash];
 }
 
 - (void)setStringValue:(NSString *)str {
+  changeStamp_ = GDataNextXMLChangeStamp();
+
   [value_ autorelease];
   value_ = [str copy];
 }
@@ -2819,4 +4154,8 @@ forCategoryWithScheme:(NSString *)scheme
   return value_;
 }
 
+- (NSUInteger)changeStamp {
+  return changeStamp_;
+}
+
 @end
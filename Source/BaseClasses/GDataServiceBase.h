@@ -25,6 +25,7 @@
 
   #define kGDataFetcherStatusUnauthorized GTMSessionFetcherStatusUnauthorized
   #define kGDataFetcherStatusForbidden GTMSessionFetcherStatusForbidden
+  #define kGDataFetcherStatusNotModified GTMSessionFetcherStatusNotModified
   #define kGDataFetcherStatusDataKey kGTMSessionFetcherStatusDataKey
 
   #import "GTMSessionFetcherService.h"
@@ -34,6 +35,7 @@
 
   #define kGDataFetcherStatusUnauthorized kGTMHTTPFetcherStatusUnauthorized
   #define kGDataFetcherStatusForbidden kGTMHTTPFetcherStatusForbidden
+  #define kGDataFetcherStatusNotModified kGTMHTTPFetcherStatusNotModified
   #define kGDataFetcherStatusDataKey kGTMHTTPFetcherStatusDataKey
 
   #import "GTMHTTPFetcherService.h"
@@ -97,12 +99,16 @@ typedef void (^GDataServiceFeedBaseCompletionHandler)(GDataServiceTicketBase *ti
 typedef void (^GDataServiceEntryBaseCompletionHandler)(GDataServiceTicketBase *ticket, GDataEntryBase *entry, NSError *error);
 
 typedef void (^GDataServiceUploadProgressHandler)(GDataServiceTicketBase *ticket, unsigned long long numberOfBytesRead, unsigned long long dataLength);
+
+typedef void (^GDataServiceFeedPageHandler)(GDataServiceTicketBase *ticket, GDataFeedBase *page);
 #else
 typedef void *GDataServiceCompletionHandler;
 typedef void *GDataServiceFeedBaseCompletionHandler;
 typedef void *GDataServiceEntryBaseCompletionHandler;
 
 typedef void *GDataServiceUploadProgressHandler;
+
+typedef void *GDataServiceFeedPageHandler;
 #endif // NS_BLOCKS_AVAILABLE
 
 @class GDataServiceBase;
@@ -117,12 +123,18 @@ typedef void *GDataServiceUploadProgressHandler;
   id userData_;
   NSMutableDictionary *ticketProperties_;
   NSDictionary *surrogates_;
+  NSSet *parseProjection_;
 
   GTMBridgeFetcher *currentFetcher_; // object or auth fetcher if mid-fetch
   GTMBridgeFetcher *objectFetcher_;
   SEL uploadProgressSelector_;
   BOOL shouldFollowNextLinks_;
   BOOL shouldFeedsIgnoreUnknowns_;
+  BOOL shouldParseWhileDownloading_;
+  BOOL shouldStreamPostedXML_;
+  BOOL shouldDetachParsedObjects_;
+  BOOL shouldParseEntriesLazily_;
+  BOOL shouldParseEntriesInParallel_;
   BOOL isRetryEnabled_;
   SEL retrySEL_;
   NSTimeInterval maxRetryInterval_;
@@ -141,6 +153,19 @@ typedef void *GDataServiceUploadProgressHandler;
   NSError *fetchError_;
   BOOL hasCalledCallback_;
   NSUInteger nextLinksFollowedCounter_;
+  NSUInteger nextLinkFetchWindow_;
+  id feedPageFetch_; // pages of the feed being fetched at once
+
+  SEL feedPageSelector_;
+#if NS_BLOCKS_AVAILABLE
+  GDataServiceFeedPageHandler feedPageBlock_;
+#elif !__LP64__
+  id feedPagePlaceholder_;
+#endif
+  BOOL areFeedPagesPaused_;
+  NSDictionary *pausedFetcherProperties_; // for resuming, without the ticket
+
+  id coalescedFetch_; // fetch shared with other tickets for the same request
 
   NSOperation *parseOperation_;
 
@@ -155,6 +180,9 @@ typedef void *GDataServiceUploadProgressHandler;
 // if cancelTicket is called, the fetch is stopped if it is in progress,
 // the callbacks will not be called, and the ticket will no longer be useful
 // (though the client must still release the ticket if it retained the ticket)
+//
+// when the ticket's fetch is shared by other tickets coalesced with it, the
+// fetch continues for the others
 - (void)cancelTicket;
 
 // chunked upload tickets may be paused
@@ -179,6 +207,10 @@ typedef void *GDataServiceUploadProgressHandler;
 - (NSDictionary *)surrogates;
 - (void)setSurrogates:(NSDictionary *)dict;
 
+// see the service's setServiceParseProjection:
+- (NSSet *)parseProjection;
+- (void)setParseProjection:(NSSet *)projection;
+
 - (GTMBridgeFetcher *)currentFetcher; // object or auth fetcher, if active
 - (void)setCurrentFetcher:(GTMBridgeFetcher *)fetcher;
 
@@ -196,9 +228,59 @@ typedef void *GDataServiceUploadProgressHandler;
 - (BOOL)shouldFollowNextLinks;
 - (void)setShouldFollowNextLinks:(BOOL)flag;
 
+// see the service's setServiceNextLinkFetchWindow:
+- (NSUInteger)nextLinkFetchWindow;
+- (void)setNextLinkFetchWindow:(NSUInteger)val;
+
+// When a ticket following next links has a feed page selector or handler,
+// each page of the feed is passed to it once parsed, rather than being
+// accumulated, so only one page is held at a time.  The finished callback is
+// called after the last page has been passed, with the last page as the
+// fetched object.  There is no limit on the number of pages, and pages are
+// fetched one at a time regardless of the next link fetch window.
+//
+// The selector is sent to the fetch's delegate, and has a signature like
+//   - (void)ticket:(GDataServiceTicketBase *)ticket
+//   fetchedFeedPage:(GDataFeedBase *)page;
+//
+// Set the selector or handler on the ticket returned by the fetch method.
+- (void)setFeedPageSelector:(SEL)pageSelector;
+- (SEL)feedPageSelector;
+
+#if NS_BLOCKS_AVAILABLE
+- (void)setFeedPageHandler:(void (^)(GDataServiceTicketBase *ticket, GDataFeedBase *page))handler;
+- (GDataServiceFeedPageHandler)feedPageHandler;
+#endif
+
+// A paused ticket requests no further pages, so a client may pause the
+// ticket when passed a page and resume it once ready for the next one.
+- (void)pauseFeedPages;
+- (void)resumeFeedPages;
+- (BOOL)areFeedPagesPaused;
+
 - (BOOL)shouldFeedsIgnoreUnknowns;
 - (void)setShouldFeedsIgnoreUnknowns:(BOOL)flag;
 
+// see the service's setServiceShouldParseWhileDownloading:
+- (BOOL)shouldParseWhileDownloading;
+- (void)setShouldParseWhileDownloading:(BOOL)flag;
+
+// see the service's setServiceShouldStreamPostedXML:
+- (BOOL)shouldStreamPostedXML;
+- (void)setShouldStreamPostedXML:(BOOL)flag;
+
+// see the service's setServiceShouldDetachParsedObjects:
+- (BOOL)shouldDetachParsedObjects;
+- (void)setShouldDetachParsedObjects:(BOOL)flag;
+
+// see the service's setServiceShouldParseEntriesLazily:
+- (BOOL)shouldParseEntriesLazily;
+- (void)setShouldParseEntriesLazily:(BOOL)flag;
+
+// see the service's setServiceShouldParseEntriesInParallel:
+- (BOOL)shouldParseEntriesInParallel;
+- (void)setShouldParseEntriesInParallel:(BOOL)flag;
+
 - (BOOL)isRetryEnabled;
 - (void)setIsRetryEnabled:(BOOL)flag;
 
@@ -266,6 +348,7 @@ typedef void *GDataServiceUploadProgressHandler;
   NSMutableDictionary *serviceProperties_; // initial values for properties in future tickets
 
   NSDictionary *serviceSurrogates_; // initial value for surrogates in future tickets
+  NSSet *serviceParseProjection_;   // initial value for parse projection in future tickets
 
   BOOL shouldServiceFeedsIgnoreUnknowns_; // YES when feeds should ignore unknown XML
 
@@ -287,6 +370,17 @@ typedef void *GDataServiceUploadProgressHandler;
 
   NSInteger cookieStorageMethod_;   // constant from GTMHTTPFetcher.h
   BOOL serviceShouldFollowNextLinks_;
+  BOOL serviceShouldParseWhileDownloading_;
+  BOOL serviceShouldStreamPostedXML_;
+  BOOL serviceShouldDetachParsedObjects_;
+  BOOL serviceShouldParseEntriesLazily_;
+  BOOL serviceShouldParseEntriesInParallel_;
+  NSUInteger serviceNextLinkFetchWindow_;
+  BOOL serviceShouldCoalesceFetches_;
+  NSMutableDictionary *coalescedFetches_; // fetches in progress by fetch key
+  id parsedObjectCache_;
+  id responseDiskCache_;
+  NSUInteger responseDiskCacheCapacity_;
 }
 
 // Applications should call setUserAgent: with a string of the form
@@ -408,8 +502,8 @@ typedef void *GDataServiceUploadProgressHandler;
                                        completionHandler:(void (^)(GDataServiceTicketBase *ticket, GDataFeedBase *feed, NSError *error))handler;
 #endif
 
-// reset the response cache to avoid getting a Not Modified status
-// based on prior queries
+// reset the response cache and the parsed object cache to avoid getting a
+// Not Modified status based on prior queries
 - (void)clearResponseDataCache;
 
 // Turn on data caching to receive a copy of previously-retrieved objects.
@@ -423,6 +517,60 @@ typedef void *GDataServiceUploadProgressHandler;
 - (void)setResponseDataCacheCapacity:(NSUInteger)totalBytes;
 - (NSUInteger)responseDataCacheCapacity;
 
+// When the parsed object cache has a capacity, a copy of each object fetched
+// by a plain GET whose response has an ETag header is kept in memory.  Later
+// fetches of the URL for the same account with the same parse settings send
+// the ETag in an If-None-Match header, and if the server responds with status
+// 304 (Not Modified), the ticket completes with a copy of the cached object
+// without the response being parsed.
+//
+// The account is the authorizer's userEmail, if any, or the service's
+// username; objects fetched with authorizers that do not identify the user
+// are not cached.  Feeds fetched with lazily parsed entries are not cached
+// either, since copying a feed makes all of its entries.
+//
+// The capacity limits the total size of the responses of the cached objects,
+// and so the time spent copying them; the least recently used objects are
+// evicted first.  Default is 0, caching no objects.
+- (void)setParsedObjectCacheCapacity:(NSUInteger)totalBytes;
+- (NSUInteger)parsedObjectCacheCapacity;
+
+// Counts of fetches completed from the parsed object cache, of objects parsed
+// and added to the cache, and the total size of the responses that did not
+// need to be downloaded and parsed again
+- (NSUInteger)parsedObjectCacheHitCount;
+- (NSUInteger)parsedObjectCacheMissCount;
+- (unsigned long long)parsedObjectCacheHitByteCount;
+
+// When the response disk cache has a directory, the bodies of responses to
+// plain GETs that have ETag or Last-Modified headers are saved in files there,
+// along with those headers.  Later fetches of the URL with the same service
+// version and account send the headers' values in If-None-Match and
+// If-Modified-Since headers, and if the server responds with status 304
+// (Not Modified), the saved response is parsed as though it had been
+// downloaded.  The files persist, so fetches can be revalidated after the
+// application restarts.
+//
+// The account is the authorizer's userEmail, if any, or the service's
+// username.  Applications using authorizers that do not identify the user
+// should use a separate directory for each user.
+//
+// Files are written on a background queue, each response before the metadata
+// that makes it valid, so files left by an interrupted write are discarded.
+// Responses parsed while downloading are not saved.
+//
+// Default directory is nil, caching no responses on disk.
+- (void)setResponseDiskCacheDirectory:(NSString *)path;
+- (NSString *)responseDiskCacheDirectory;
+
+// The capacity limits the total size of the saved responses; the least
+// recently used responses are removed first.  Default is 10MB.
+- (void)setResponseDiskCacheCapacity:(NSUInteger)totalBytes;
+- (NSUInteger)responseDiskCacheCapacity;
+
+// remove all responses saved in the response disk cache's directory
+- (void)clearResponseDiskCache;
+
 // Fetcher service, if necessary for sharing cookies and dated data
 // cache with standalone http fetchers
 - (void)setFetcherService:(GTMBridgeFetcherService *)obj;
@@ -450,6 +598,99 @@ typedef void *GDataServiceUploadProgressHandler;
 - (BOOL)serviceShouldFollowNextLinks;
 - (void)setServiceShouldFollowNextLinks:(BOOL)flag;
 
+// When following next links, each page is normally fetched once the previous
+// page has been parsed.  With a fetch window greater than one, if the first
+// page's openSearch totalResults, startIndex and itemsPerPage elements give
+// the size of the feed, and its next link pages with a start-index parameter,
+// the URLs of the remaining pages are computed and up to that many pages are
+// fetched at once.  The pages are still accumulated into the feed in order.
+// Feeds that cannot be paged by start-index have their next links followed
+// one at a time.
+//
+// Default value is 0, following next links one at a time.
+- (NSUInteger)serviceNextLinkFetchWindow;
+- (void)setServiceNextLinkFetchWindow:(NSUInteger)val;
+
+// When coalescing fetches, a GET request made while an identical request
+// (same URL, account, service version, object class and parsing settings)
+// is in progress does not start a fetch of its own.  Its ticket instead waits
+// for the earlier fetch, and its callbacks receive a copy of the object
+// fetched, or the same error.  Each ticket may still be canceled separately.
+//
+// The account is the authorizer's userEmail, if any, or the service's
+// username.  Requests with an ETag, posted objects, uploads, tickets
+// following next links, and requests whose authorizer does not identify the
+// user are never coalesced.
+//
+// Default value is NO.
+- (BOOL)serviceShouldCoalesceFetches;
+- (void)setServiceShouldCoalesceFetches:(BOOL)flag;
+
+// When parsing while downloading, each chunk of a response body is passed to
+// a libxml push parser as it arrives, so parsing overlaps the download and the
+// complete response data is never held by the fetcher.  Chunked uploads are
+// always parsed after the download.
+//
+// This applies only to builds using libxml (GDATA_USES_LIBXML); NSXMLDocument
+// has no incremental parsing.
+//
+// Default value is NO.
+- (BOOL)serviceShouldParseWhileDownloading;
+- (void)setServiceShouldParseWhileDownloading:(BOOL)flag;
+
+// When streaming posted XML, the XML of an object being inserted or updated
+// is written by an operation on the operation queue into a stream that the
+// fetcher reads as the request body, so the XML is never held in memory all
+// at once; a feed being posted, such as for a batch request, writes each entry
+// in turn.  The length of the body is not known in advance, so the request
+// is sent with chunked transfer encoding.  Objects with upload data are
+// always posted as data.  The object posted should not be changed until the
+// fetch completes, since its XML is generated on the queue's thread.
+//
+// This applies only to builds using libxml (GDATA_USES_LIBXML) with an
+// operation queue.
+//
+// Default value is NO.
+- (BOOL)serviceShouldStreamPostedXML;
+- (void)setServiceShouldStreamPostedXML:(BOOL)flag;
+
+// Parsed objects normally keep the libxml document of the response alive,
+// since their unknown elements and attributes are nodes of that document;
+// a single unknown node in a small entry kept from a large feed pins the
+// entire feed's tree.  When detaching parsed objects, each object copies its
+// unknown nodes once parsing is done, and the document is freed.  Detaching
+// costs a copy of each unknown node, so it is most useful when only a few
+// parsed objects are kept for a long time.
+//
+// This applies only to builds using libxml (GDATA_USES_LIBXML); NSXMLNodes
+// already retain their own storage.
+//
+// Default value is NO.
+- (BOOL)serviceShouldDetachParsedObjects;
+- (void)setServiceShouldDetachParsedObjects:(BOOL)flag;
+
+// Fetched feeds normally create all of their entries as they are parsed.
+// When parsing entries lazily, each entry is created from its element when
+// first requested, so applications that use only a few entries of a large
+// feed, or look entries up by identifier or kind, do not pay to create the
+// rest.  Lazily-parsed feeds keep their XML document, so this setting
+// overrides serviceShouldDetachParsedObjects for feeds.
+//
+// Default value is NO.
+- (BOOL)serviceShouldParseEntriesLazily;
+- (void)setServiceShouldParseEntriesLazily:(BOOL)flag;
+
+// Fetched feeds with at least kGDataMinEntriesForParallelParse entries may
+// have their entries created on several threads at once.  Parsing is done
+// on the service's parse thread either way; this spreads the entries of a
+// large feed across the processors.  Surrogate classes must not change
+// state shared between entries while parsing.  Entries parsed lazily are
+// not parsed in parallel.
+//
+// Default value is NO.
+- (BOOL)serviceShouldParseEntriesInParallel;
+- (void)setServiceShouldParseEntriesInParallel:(BOOL)flag;
+
 // set a non-zero value to enable uploading via chunked fetches
 // (resumable uploads); typically this defaults to kGDataStandardUploadChunkSize
 // for service subclasses that support chunked uploads
@@ -498,6 +739,23 @@ typedef void *GDataServiceUploadProgressHandler;
 - (NSDictionary *)serviceSurrogates;
 - (void)setServiceSurrogates:(NSDictionary *)dict;
 
+// Set the parse projection to be used for future tickets.  Only the element
+// extensions whose classes or qualified names are in the projection are
+// created when parsing fetched objects; other elements are kept as unknown
+// children, or dropped if unknowns are ignored.  This helps when only a few
+// fields are needed and the server does not honor the query's field
+// selection.  For example:
+//
+//  NSSet *projection = [GDataObject parseProjectionWithFieldSelection:
+//    @"entry(id,updated,title,link)"];
+//  [service setServiceParseProjection:projection];
+//
+// Objects parsed with a projection lack the other extensions, so they
+// should not be used to update entries on the server unless unknowns are
+// kept.
+- (NSSet *)serviceParseProjection;
+- (void)setServiceParseProjection:(NSSet *)projection;
+
 // Set if feeds fetched (and the entries and elements contained in the feeds)
 // keep track of unparsed XML elements.  Setting this to YES offers a
 // performance and memory improvement, particularly for iPhone apps.  However,
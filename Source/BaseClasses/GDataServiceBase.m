@@ -26,6 +26,8 @@
 #import <UIKit/UIKit.h>
 #endif
 
+#import <CommonCrypto/CommonDigest.h>
+
 #define GDATASERVICEBASE_DEFINE_GLOBALS 1
 #import "GDataServiceBase.h"
 #import "GDataServerError.h"
@@ -39,19 +41,43 @@ static NSString* const kFetcherFinishedSelectorKey     = @"_finishedSelector";
 static NSString* const kFetcherCompletionHandlerKey    = @"_completionHandler";
 static NSString* const kFetcherTicketKey               = @"_ticket";
 static NSString* const kFetcherStreamDataKey           = @"_streamData";
+static NSString* const kFetcherStreamedXMLObjectKey    = @"_streamedXMLObject";
 static NSString* const kFetcherParsedObjectKey         = @"_parsedObject";
 static NSString* const kFetcherParseErrorKey           = @"_parseError";
 static NSString* const kFetcherCallbackThreadKey       = @"_callbackThread";
 static NSString* const kFetcherCallbackRunLoopModesKey = @"_runLoopModes";
+static NSString* const kFetcherPushParserKey           = @"_pushParser";
+static NSString* const kFetcherPushParseOperationKey   = @"_pushParseOperation";
+static NSString* const kFetcherErrorDataKey            = @"_errorData";
+static NSString* const kFetcherNextFeedURLKey          = @"_nextFeedURL";
+static NSString* const kFetcherObjectCacheKey          = @"_objectCacheKey";
+static NSString* const kFetcherResponseCacheKey        = @"_responseCacheKey";
+static NSString* const kFetcherCacheValidatorsKey      = @"_cacheValidators";
+static NSString* const kFetcherCachedResponseDataKey   = @"_cachedResponseData";
 
 NSString* const kFetcherRetryInvocationKey = @"_retryInvocation";
 
+static NSString* const kTicketFeedPageFetchKey = @"_feedPageFetch";
+static NSString* const kTicketFeedPageIndexKey = @"_feedPageIndex";
+
+// keys of the metadata files of the response disk cache
+static NSString* const kResponseCacheKeyKey          = @"key";
+static NSString* const kResponseCacheETagKey         = @"ETag";
+static NSString* const kResponseCacheLastModifiedKey = @"Last-Modified";
+static NSString* const kResponseCacheLengthKey       = @"length";
+static NSString* const kResponseCacheLastUseKey      = @"lastUse"; // only in memory
+
+static NSUInteger const kDefaultResponseDiskCacheCapacity = 10 * 1024 * 1024;
+
 static const NSUInteger kMaxNumberOfNextLinksFollowed = 25;
 
 // we'll enforce 50K chunks minimum just to avoid the server getting hit
 // with too many small upload chunks
 static const NSUInteger kMinimumUploadChunkSize = 50000;
 
+// size of the buffer between the writer of streamed XML and the fetcher
+static const CFIndex kStreamedXMLBufferSize = 64 * 1024;
+
 // XorPlainMutableData is a simple way to keep passwords held in heap objects
 // from being visible as plain-text
 static void XorPlainMutableData(NSMutableData *mutableData) {
@@ -126,17 +152,272 @@ static void XorPlainMutableData(NSMutableData *mutableData) {
 - (NSDictionary *)contentHeaders;
 @end
 
+// A feed page fetch holds the state of fetching the remaining pages of a
+// feed several at once.  Pages that arrive ahead of earlier pages are kept
+// until they can be accumulated into the ticket's feed in order.
+@interface GDataFeedPageFetch : NSObject {
+  GDataServiceTicketBase *ticket_;
+  id delegate_;
+  SEL finishedSelector_;
+  id completionHandler_;
+  NSArray *pageURLs_;
+  NSMutableArray *pageFeeds_;   // fetched pages not yet accumulated, or NSNull
+  NSMutableArray *pageTickets_; // tickets of the pages being fetched
+  NSUInteger numberOfPagesStarted_;
+  NSUInteger numberOfPagesAccumulated_;
+  NSURL *nextURLAfterLastPage_;
+}
+- (id)initWithTicket:(GDataServiceTicketBase *)ticket
+            delegate:(id)delegate
+    finishedSelector:(SEL)finishedSelector
+   completionHandler:(id)completionHandler
+            pageURLs:(NSArray *)pageURLs;
+- (GDataServiceTicketBase *)ticket;
+- (id)delegate;
+- (SEL)finishedSelector;
+- (GDataServiceCompletionHandler)completionHandler;
+
+// indexOfNextPageToStart returns NSNotFound once all pages have been started
+- (NSUInteger)indexOfNextPageToStart;
+- (NSURL *)URLOfPageAtIndex:(NSUInteger)idx;
+
+- (NSArray *)pageTickets;
+- (void)addPageTicket:(GDataServiceTicketBase *)pageTicket;
+- (void)removePageTicket:(GDataServiceTicketBase *)pageTicket;
+- (void)cancelPageTickets;
+
+// setFeed:forPageAtIndex: accumulates the pages fetched so far in order
+- (void)setFeed:(GDataFeedBase *)feed forPageAtIndex:(NSUInteger)idx;
+- (BOOL)hasAccumulatedAllPages;
+
+// the next link of the last page, if the feed grew while being fetched
+- (NSURL *)nextURLAfterLastPage;
+@end
+
+// A fetch key identifies the object fetched by a plain GET: the URL, the
+// account the request is authorized for, and how the response is parsed.
+// The hash is computed once, so keys are cheap to look up in dictionaries.
+@interface GDataFetchKey : NSObject <NSCopying> {
+  NSString *URLString_;
+  NSString *account_;
+  NSString *serviceVersion_;
+  NSString *className_;
+  NSDictionary *surrogates_;
+  NSSet *parseProjection_;
+  BOOL shouldIgnoreUnknowns_;
+  BOOL shouldParseEntriesLazily_;
+  BOOL shouldDetachParsedObjects_;
+  NSUInteger hash_;
+}
+- (id)initWithURLString:(NSString *)URLString
+                account:(NSString *)account
+         serviceVersion:(NSString *)serviceVersion
+              className:(NSString *)className
+             surrogates:(NSDictionary *)surrogates
+        parseProjection:(NSSet *)parseProjection
+   shouldIgnoreUnknowns:(BOOL)shouldIgnoreUnknowns
+shouldParseEntriesLazily:(BOOL)shouldParseEntriesLazily
+shouldDetachParsedObjects:(BOOL)shouldDetachParsedObjects;
+@end
+
+// an entry of the parsed object cache, linked into the list of entries in
+// order of use
+@interface GDataParsedObjectCacheEntry : NSObject {
+ @public
+  GDataFetchKey *key_;
+  GDataObject *object_;
+  NSString *ETag_;
+  NSUInteger byteCount_;
+  GDataParsedObjectCacheEntry *olderEntry_; // weak
+  GDataParsedObjectCacheEntry *newerEntry_; // weak
+}
+@end
+
+// The parsed object cache keeps copies of objects fetched along with ETags,
+// so that requests the server revalidates with a 304 (Not Modified) status
+// complete without parsing.  The least recently used objects are evicted once
+// the total size of their responses exceeds the capacity.
+//
+// Objects are copied when stored and again for each hit, so that no caller
+// sees another's changes; the copying takes time in proportion to the size
+// of the object, and so is bounded by the capacity.
+@interface GDataParsedObjectCache : NSObject {
+  NSUInteger capacity_;
+  NSUInteger totalByteCount_;
+
+  NSMutableDictionary *entries_; // entries by fetch key
+  GDataParsedObjectCacheEntry *oldestEntry_; // weak; entries_ retains these
+  GDataParsedObjectCacheEntry *newestEntry_; // weak
+
+  NSUInteger hitCount_;
+  NSUInteger missCount_;
+  unsigned long long hitByteCount_;
+}
+- (NSUInteger)capacity;
+- (void)setCapacity:(NSUInteger)totalBytes;
+
+- (NSString *)ETagForKey:(GDataFetchKey *)key;
+
+// cachedObjectForKey:ETag: returns a copy of the cached object if its ETag
+// matches, counting the cache hit
+- (GDataObject *)cachedObjectForKey:(GDataFetchKey *)key ETag:(NSString *)etag;
+
+// setObject:ETag:byteCount:forKey: caches a copy of a parsed object, counting
+// the cache miss
+- (void)setObject:(GDataObject *)object
+             ETag:(NSString *)etag
+        byteCount:(NSUInteger)byteCount
+           forKey:(GDataFetchKey *)key;
+
+- (void)removeAllObjects;
+
+- (NSUInteger)hitCount;
+- (NSUInteger)missCount;
+- (unsigned long long)hitByteCount;
+@end
+
+// The response disk cache keeps the bodies of responses having ETag or
+// Last-Modified headers in files, so requests can be revalidated rather than
+// downloaded again even after the application restarts.  Each response is
+// stored as a data file followed by a metadata file; an entry lacking either
+// file, as after a crash, is discarded when the directory is next read.
+// Files are written in the background, so responses are also kept in memory
+// until their files have been written.
+@interface GDataResponseDiskCache : NSObject {
+  NSString *directory_;
+  NSUInteger capacity_;
+  NSUInteger totalByteCount_;
+  NSMutableDictionary *entries_;  // metadata dictionaries by cache key
+  NSMutableArray *keysByLastUse_; // least recently used first
+  NSOperationQueue *fileQueue_;   // serial queue for writing and removing files
+  NSMutableDictionary *pendingData_; // responses not yet written, by cache key
+}
+- (id)initWithDirectory:(NSString *)directory
+               capacity:(NSUInteger)totalBytes;
+- (NSString *)directory;
+- (NSUInteger)capacity;
+- (void)setCapacity:(NSUInteger)totalBytes;
+
+// validatorsForKey: returns a dictionary with the ETag and Last-Modified
+// values of the cached response, if any
+- (NSDictionary *)validatorsForKey:(NSString *)key;
+
+// dataOfResponseForKey:... returns the cached response if the validators
+// sent match it, or nil if the response is no longer cached
+- (NSData *)dataOfResponseForKey:(NSString *)key
+                            ETag:(NSString *)etag
+                    lastModified:(NSString *)lastModified;
+
+- (void)storeResponseData:(NSData *)data
+                     ETag:(NSString *)etag
+             lastModified:(NSString *)lastModified
+                   forKey:(NSString *)key;
+
+- (void)removeAllResponses;
+@end
+
+// A coalesced fetch lets tickets making the same GET request as a ticket
+// already in progress wait for that leader ticket's fetch rather than
+// starting fetches of their own.
+@interface GDataCoalescedFetch : NSObject {
+  GDataServiceBase *service_; // weak; the service's table retains this
+  GDataFetchKey *key_;
+  GDataServiceTicketBase *leaderTicket_;
+  NSMutableArray *followers_; // dictionaries of the waiting tickets' callbacks
+  BOOL isLeaderCanceled_;
+}
+- (id)initWithService:(GDataServiceBase *)service
+                  key:(GDataFetchKey *)key
+         leaderTicket:(GDataServiceTicketBase *)leaderTicket;
+- (GDataServiceBase *)service;
+- (GDataFetchKey *)key;
+- (GDataServiceTicketBase *)leaderTicket;
+
+- (void)addFollowerTicket:(GDataServiceTicketBase *)ticket
+                 delegate:(id)delegate
+         finishedSelector:(SEL)finishedSelector
+        completionHandler:(id)completionHandler;
+- (void)removeFollowerTicket:(GDataServiceTicketBase *)ticket;
+- (NSUInteger)numberOfFollowers;
+
+// removeFirstFollower returns nil once no tickets are waiting
+- (NSDictionary *)removeFirstFollower;
+
+// the leader's fetch continues after its ticket is canceled while other
+// tickets are waiting
+- (BOOL)isLeaderCanceled;
+- (void)setIsLeaderCanceled:(BOOL)flag;
+@end
+
+@interface GDataServiceTicketBase (PrivateMethods)
+- (GDataFeedPageFetch *)feedPageFetch;
+- (void)setFeedPageFetch:(GDataFeedPageFetch *)pageFetch;
+- (BOOL)hasFeedPageCallback;
+- (void)setPausedFetcherProperties:(NSDictionary *)dict;
+
+- (GDataCoalescedFetch *)coalescedFetch;
+- (void)setCoalescedFetch:(GDataCoalescedFetch *)coalescedFetch;
+- (BOOL)isSharingFetch;
+@end
+
 @interface GDataServiceBase (PrivateMethods)
 - (BOOL)fetchNextFeedWithURL:(NSURL *)nextFeedURL
+                 objectClass:(Class)objectClass
                     delegate:(id)delegate
          didFinishedSelector:(SEL)finishedSelector
            completionHandler:(GDataServiceCompletionHandler)completionHandler
                       ticket:(GDataServiceTicketBase *)ticket;
 
+- (void)invokeFeedPageCallbackForTicket:(GDataServiceTicketBase *)ticket
+                               delegate:(id)delegate
+                                   page:(GDataFeedBase *)page;
+- (BOOL)fetchNextFeedPageForFetcher:(GTMBridgeFetcher *)fetcher;
+- (void)resumeFeedPagesForFetcher:(GTMBridgeFetcher *)fetcher;
+
+- (NSArray *)URLsOfRemainingPagesOfFeed:(GDataFeedBase *)feed
+                                nextURL:(NSURL *)nextURL;
+- (BOOL)fetchFeedPagesWithURLs:(NSArray *)pageURLs
+                      delegate:(id)delegate
+             didFinishSelector:(SEL)finishedSelector
+             completionHandler:(GDataServiceCompletionHandler)completionHandler
+                        ticket:(GDataServiceTicketBase *)ticket;
+- (BOOL)startFetchingFeedPagesForPageFetch:(GDataFeedPageFetch *)pageFetch;
+- (void)feedPageTicket:(GDataServiceTicketBase *)pageTicket
+      finishedWithFeed:(GDataFeedBase *)feed
+                 error:(NSError *)error;
+- (void)finishFeedPageFetch:(GDataFeedPageFetch *)pageFetch
+                      error:(NSError *)error;
+
+- (NSString *)accountForTicket:(GDataServiceTicketBase *)ticket;
+- (GDataFetchKey *)fetchKeyForURL:(NSURL *)feedURL
+                      objectClass:(Class)objectClass
+                     objectToPost:(GDataObject *)objectToPost
+                             ETag:(NSString *)etag
+                       httpMethod:(NSString *)httpMethod
+                           ticket:(GDataServiceTicketBase *)ticket;
+- (BOOL)finishCoalescedFetchForTicket:(GDataServiceTicketBase *)ticket
+                               object:(GDataObject *)object
+                                error:(NSError *)error;
+- (void)detachTicketFromCoalescedFetch:(GDataServiceTicketBase *)ticket;
+
+- (BOOL)completeFetcherWithCachedObject:(GTMBridgeFetcher *)fetcher;
+- (NSString *)responseDiskCacheKeyForURL:(NSURL *)feedURL
+                                  ticket:(GDataServiceTicketBase *)ticket;
+- (BOOL)useCachedResponseForFetcher:(GTMBridgeFetcher *)fetcher;
+- (BOOL)refetchWithoutCacheValidatorsForFetcher:(GTMBridgeFetcher *)fetcher;
+
 - (NSDictionary *)userInfoForErrorResponseData:(NSData *)data
                                    contentType:(NSString *)contentType
                               previousUserInfo:(NSDictionary *)previousUserInfo;
 
+#if GDATA_USES_LIBXML && NS_BLOCKS_AVAILABLE
+- (void)beginParsingWhileDownloadingForFetcher:(GTMBridgeFetcher *)fetcher;
+#endif
+
+#if GDATA_USES_LIBXML
+- (NSInputStream *)inputStreamWritingXMLOfObject:(GDataObject *)object;
+#endif
+
 - (void)objectFetcher:(GTMBridgeFetcher *)fetcher
      finishedWithData:(NSData *)data
                 error:(NSError *)error;
@@ -188,6 +469,8 @@ totalBytesExpectedToSend:(NSInteger)totalBytesExpected;
 
     cookieStorageMethod_ = -1;
 
+    responseDiskCacheCapacity_ = kDefaultResponseDiskCacheCapacity;
+
     NSUInteger chunkSize = [[self class] defaultServiceUploadChunkSize];
     [self setServiceUploadChunkSize:chunkSize];
   }
@@ -207,11 +490,21 @@ totalBytesExpectedToSend:(NSInteger)totalBytesExpected;
   [serviceUserData_ release];
   [serviceProperties_ release];
   [serviceSurrogates_ release];
+  [serviceParseProjection_ release];
 
 #if NS_BLOCKS_AVAILABLE
   [serviceUploadProgressBlock_ release];
 #endif
 
+  // break the retain cycles of leader tickets and their unfinished fetches
+  for (GDataCoalescedFetch *coalescedFetch in [coalescedFetches_ allValues]) {
+    [[coalescedFetch leaderTicket] setCoalescedFetch:nil];
+  }
+  [coalescedFetches_ release];
+
+  [parsedObjectCache_ release];
+  [responseDiskCache_ release];
+
   [super dealloc];
 }
 
@@ -412,6 +705,49 @@ totalBytesExpectedToSend:(NSInteger)totalBytesExpected;
   // authentication)
   if (!ticket) {
     ticket = [[[self class] ticketClass] ticketForService:self];
+  } else if ([ticket service] == nil && ![ticket isSharingFetch]) {
+    // the ticket was canceled while waiting, as for reauthentication
+    return nil;
+  }
+
+  GDataFetchKey *fetchKey = nil;
+  if ([self serviceShouldCoalesceFetches]
+      || [self parsedObjectCacheCapacity] > 0
+      || responseDiskCache_ != nil) {
+    fetchKey = [self fetchKeyForURL:feedURL
+                        objectClass:objectClass
+                       objectToPost:objectToPost
+                               ETag:etag
+                         httpMethod:httpMethod
+                             ticket:ticket];
+  }
+
+  GDataFetchKey *coalescingKey = nil;
+  GDataCoalescedFetch *coalescedFetch = [ticket coalescedFetch];
+  if (coalescedFetch != nil) {
+    // the leader of a shared fetch is being retried; if the leader was
+    // canceled, the fetch continues only for the tickets waiting on it
+    if ([coalescedFetch isLeaderCanceled]) {
+      delegate = nil;
+      finishedSelector = NULL;
+      completionHandler = nil;
+    }
+  } else if ([self serviceShouldCoalesceFetches]
+             && ![ticket shouldFollowNextLinks]) {
+    coalescingKey = fetchKey;
+    if (coalescingKey) {
+      coalescedFetch = [coalescedFetches_ objectForKey:coalescingKey];
+      if (coalescedFetch) {
+        // wait for the identical fetch already in progress
+        [coalescedFetch addFollowerTicket:ticket
+                                 delegate:delegate
+                         finishedSelector:finishedSelector
+                        completionHandler:completionHandler];
+        [ticket setCoalescedFetch:coalescedFetch];
+        [ticket setCurrentFetcher:[[coalescedFetch leaderTicket] currentFetcher]];
+        return ticket;
+      }
+    }
   }
 
   NSMutableURLRequest *request = nil;
@@ -423,6 +759,48 @@ totalBytesExpectedToSend:(NSInteger)totalBytesExpected;
                                  ticket:ticket];
   }
 
+  // ask the server to revalidate a cached copy of the object being fetched;
+  // feeds with lazily parsed entries are not cached, since copying them would
+  // make all of their entries
+  GDataFetchKey *objectCacheKey = nil;
+  BOOL hasCacheValidators = NO;
+  if (fetchKey != nil
+      && [self parsedObjectCacheCapacity] > 0
+      && ![ticket shouldParseEntriesLazily]) {
+    objectCacheKey = fetchKey;
+
+    NSString *cachedETag = [parsedObjectCache_ ETagForKey:objectCacheKey];
+    if (cachedETag != nil
+        && [request valueForHTTPHeaderField:@"If-None-Match"] == nil) {
+      [request setValue:cachedETag forHTTPHeaderField:@"If-None-Match"];
+      hasCacheValidators = YES;
+    }
+  }
+
+  // or of a response kept on disk, perhaps from before a restart
+  NSString *responseCacheKey = nil;
+  if (fetchKey != nil && responseDiskCache_ != nil) {
+    responseCacheKey = [self responseDiskCacheKeyForURL:feedURL
+                                                 ticket:ticket];
+
+    NSDictionary *validators = [responseDiskCache_ validatorsForKey:responseCacheKey];
+    if (validators != nil
+        && [request valueForHTTPHeaderField:@"If-None-Match"] == nil
+        && [request valueForHTTPHeaderField:@"If-Modified-Since"] == nil) {
+
+      NSString *cachedETag = [validators objectForKey:kResponseCacheETagKey];
+      if (cachedETag) {
+        [request setValue:cachedETag forHTTPHeaderField:@"If-None-Match"];
+      }
+
+      NSString *lastModified = [validators objectForKey:kResponseCacheLastModifiedKey];
+      if (lastModified) {
+        [request setValue:lastModified forHTTPHeaderField:@"If-Modified-Since"];
+      }
+      hasCacheValidators = YES;
+    }
+  }
+
   GTMBridgeAssertValidSelector(delegate, [ticket uploadProgressSelector],
       @encode(GDataServiceTicketBase *), @encode(unsigned long long),
       @encode(unsigned long long), 0);
@@ -440,6 +818,7 @@ totalBytesExpectedToSend:(NSInteger)totalBytesExpected;
   NSFileHandle *uploadFileHandle = nil;
   BOOL shouldUploadDataChunked = ([self serviceUploadChunkSize] > 0);
   BOOL isUploadingDataChunked = NO;
+  BOOL isStreamingXML = NO;
 
   NSMutableDictionary *uploadProperties = nil;
   if (objectToPost) {
@@ -490,6 +869,23 @@ totalBytesExpectedToSend:(NSInteger)totalBytesExpected;
       contentHeaders = [objectToPost performSelector:@selector(contentHeaders)];
       contentLength = 0;
 
+#if GDATA_USES_LIBXML
+    } else if ([ticket shouldStreamPostedXML]
+               && !isUploadingDataChunked
+               && operationQueue_ != nil) {
+      // the XML will be written into the request body as it is generated, so
+      // its length is unknown
+      isStreamingXML = YES;
+
+      // the XML is written on the operation queue, so create any lazily
+      // parsed entries of a feed here rather than on that thread
+      if ([objectToPost isKindOfClass:[GDataFeedBase class]]) {
+        [(GDataFeedBase *)objectToPost entries];
+      }
+#if !GTM_USE_SESSION_FETCHER
+      contentInputStream = [self inputStreamWritingXMLOfObject:objectToPost];
+#endif
+#endif
     } else {
       // we're sending either just XML, or XML now with chunked upload data
       // later
@@ -540,8 +936,10 @@ totalBytesExpectedToSend:(NSInteger)totalBytesExpected;
 
     streamToPost = contentInputStream;
 
-    NSNumber* num = [NSNumber numberWithUnsignedLongLong:contentLength];
-    [request setValue:[num stringValue] forHTTPHeaderField:@"Content-Length"];
+    if (!isStreamingXML) {
+      NSNumber* num = [NSNumber numberWithUnsignedLongLong:contentLength];
+      [request setValue:[num stringValue] forHTTPHeaderField:@"Content-Length"];
+    }
 
     if (shouldReportUploadProgress) {
       if (doesSupportSentData || isUploadingDataChunked) {
@@ -635,8 +1033,8 @@ totalBytesExpectedToSend:(NSInteger)totalBytesExpected;
   [fetcher setRetryEnabled:[ticket isRetryEnabled]];
   [fetcher setMaxRetryInterval:[ticket maxRetryInterval]];
 
-  if ([ticket retrySelector]) {
 #if GTM_USE_SESSION_FETCHER
+  if ([ticket retrySelector]) {
     __block GTMBridgeFetcher *fetcherRef = fetcher;
     fetcher.retryBlock = ^(BOOL suggestedWillRetry, NSError *error,
                            GTMSessionFetcherRetryResponse response) {
@@ -645,10 +1043,19 @@ totalBytesExpectedToSend:(NSInteger)totalBytesExpected;
                                     forError:error];
       response(shouldRetry);
     };
+  }
 #else
+  // the retry callback also gives a retried fetch of streamed XML new streams
+  if ([ticket retrySelector] || isStreamingXML) {
     [fetcher setRetrySelector:@selector(objectFetcher:willRetry:forError:)];
+  }
 #endif
+
+#if GDATA_USES_LIBXML && NS_BLOCKS_AVAILABLE
+  if ([ticket shouldParseWhileDownloading] && !isUploadingDataChunked) {
+    [self beginParsingWhileDownloadingForFetcher:fetcher];
   }
+#endif
 
   // remember the object fetcher in the ticket
   [ticket setObjectFetcher:fetcher];
@@ -666,6 +1073,17 @@ totalBytesExpectedToSend:(NSInteger)totalBytesExpected;
   [fetcher setProperty:ticket
                 forKey:kFetcherTicketKey];
 
+  [fetcher setProperty:objectCacheKey
+                forKey:kFetcherObjectCacheKey];
+
+  [fetcher setProperty:responseCacheKey
+                forKey:kFetcherResponseCacheKey];
+
+  if (hasCacheValidators) {
+    [fetcher setProperty:[NSNumber numberWithBool:YES]
+                  forKey:kFetcherCacheValidatorsKey];
+  }
+
 #if NS_BLOCKS_AVAILABLE
   // copy the completion handler block to the heap; this does nothing if the
   // block is already on the heap
@@ -686,13 +1104,25 @@ totalBytesExpectedToSend:(NSInteger)totalBytesExpected;
 
   if (dataToPost) {
     [fetcher setBodyData:dataToPost];
-  } else if (streamToPost) {
+  } else if (streamToPost || isStreamingXML) {
 #if GTM_USE_SESSION_FETCHER
     [fetcher setBodyStreamProvider:^(GTMSessionFetcherBodyStreamProviderResponse response) {
+#if GDATA_USES_LIBXML
+      if (isStreamingXML) {
+        // each attempt of the fetch needs the XML written anew
+        response([self inputStreamWritingXMLOfObject:objectToPost]);
+        return;
+      }
+#endif
       response(streamToPost);
     }];
 #else
     [fetcher setPostStream:streamToPost];
+#if GDATA_USES_LIBXML
+    if (isStreamingXML) {
+      [fetcher setProperty:objectToPost forKey:kFetcherStreamedXMLObjectKey];
+    }
+#endif
 #endif
   }
 
@@ -747,9 +1177,130 @@ totalBytesExpectedToSend:(NSInteger)totalBytesExpected;
     return nil;
   }
 
+  if (coalescingKey) {
+    // identical requests made before this fetch finishes will wait for it
+    coalescedFetch = [[[GDataCoalescedFetch alloc] initWithService:self
+                                                               key:coalescingKey
+                                                      leaderTicket:ticket] autorelease];
+    if (coalescedFetches_ == nil) {
+      coalescedFetches_ = [[NSMutableDictionary alloc] init];
+    }
+    [coalescedFetches_ setObject:coalescedFetch forKey:coalescingKey];
+    [ticket setCoalescedFetch:coalescedFetch];
+  }
+
   return ticket;
 }
 
+#if GDATA_USES_LIBXML
+// When streaming posted XML, the object's XML is written by an operation on
+// the operation queue into one end of a bound pair of streams, and the fetcher
+// reads the other end as the request body.  Writes block while the buffer
+// between them is full.
+- (NSInputStream *)inputStreamWritingXMLOfObject:(GDataObject *)object {
+
+  CFReadStreamRef readStream = NULL;
+  CFWriteStreamRef writeStream = NULL;
+  CFStreamCreateBoundPair(kCFAllocatorDefault, &readStream, &writeStream,
+                          kStreamedXMLBufferSize);
+  if (readStream == NULL || writeStream == NULL) {
+    if (readStream) CFRelease(readStream);
+    if (writeStream) CFRelease(writeStream);
+    return nil;
+  }
+
+  NSInputStream *inputStream = [(NSInputStream *)readStream autorelease];
+  NSOutputStream *outputStream = [(NSOutputStream *)writeStream autorelease];
+
+  NSArray *args = [NSArray arrayWithObjects:object, outputStream, nil];
+  NSInvocationOperation *op;
+  op = [[[NSInvocationOperation alloc] initWithTarget:self
+                                             selector:@selector(writeXMLWithArguments:)
+                                               object:args] autorelease];
+  [operationQueue_ addOperation:op];
+
+  return inputStream;
+}
+
+- (void)writeXMLWithArguments:(NSArray *)args {
+  NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+
+  GDataObject *object = [args objectAtIndex:0];
+  NSOutputStream *outputStream = [args objectAtIndex:1];
+
+  [outputStream open];
+
+  // the object's cached elements belong to the thread that posted it, so
+  // the XML is generated here without them
+  NSError *error = nil;
+  if (![object writeXMLDocumentToStream:outputStream
+                             usingCache:NO
+                                  error:&error]) {
+    // the fetcher reports the failure, since the body ends early
+    GDATA_DEBUG_LOG(@"GDataServiceBase streaming XML failed: %@", error);
+  }
+
+  // closing the stream ends the request body
+  [outputStream close];
+
+  [pool drain];
+}
+#endif
+
+#if GDATA_USES_LIBXML && NS_BLOCKS_AVAILABLE
+// When parsing while downloading, the fetcher hands each received chunk to
+// us rather than accumulating the response, and we pass the chunk to a push
+// parser.  With an operation queue, each chunk is parsed by an operation
+// dependent on the previous chunk's, so parsing stays off the callback thread
+// and in order.
+- (void)beginParsingWhileDownloadingForFetcher:(GTMBridgeFetcher *)fetcher {
+
+  // the fetcher retains the block, so the block must not retain the fetcher
+  __block GTMBridgeFetcher *fetcherRef = fetcher;
+  __block NSURLResponse *parsedResponse = nil; // weak; only compared
+
+  [fetcher setAccumulateDataBlock:^(NSData *buffer) {
+
+    if ([fetcherRef statusCode] >= 300) {
+      // keep error response bodies for the failure callback
+      NSMutableData *errorData = [fetcherRef propertyForKey:kFetcherErrorDataKey];
+      if (errorData == nil) {
+        errorData = [NSMutableData data];
+        [fetcherRef setProperty:errorData forKey:kFetcherErrorDataKey];
+      }
+      [errorData appendData:buffer];
+      return;
+    }
+
+    // each retry of the fetch has a new response, and needs a fresh parser
+    GDataXMLPushParser *parser = [fetcherRef propertyForKey:kFetcherPushParserKey];
+    NSURLResponse *response = [fetcherRef response];
+    if (parser == nil || response != parsedResponse) {
+      parser = [[[GDataXMLPushParser alloc] init] autorelease];
+      [fetcherRef setProperty:parser forKey:kFetcherPushParserKey];
+      parsedResponse = response;
+    }
+
+    if (operationQueue_ == nil) {
+      [parser appendData:buffer];
+      return;
+    }
+
+    NSOperation *previousOp = [fetcherRef propertyForKey:kFetcherPushParseOperationKey];
+
+    NSInvocationOperation *op;
+    op = [[[NSInvocationOperation alloc] initWithTarget:parser
+                                               selector:@selector(appendData:)
+                                                 object:buffer] autorelease];
+    if (previousOp) {
+      [op addDependency:previousOp];
+    }
+    [fetcherRef setProperty:op forKey:kFetcherPushParseOperationKey];
+    [operationQueue_ addOperation:op];
+  }];
+}
+#endif
+
 - (void)invokeProgressCallbackForTicket:(GDataServiceTicketBase *)ticket
                          deliveredBytes:(unsigned long long)numReadSoFar
                              totalBytes:(unsigned long long)total {
@@ -793,13 +1344,50 @@ totalBytesExpectedToSend:(NSInteger)totalBytesExpected {
 }
 
 - (void)objectFetcher:(GTMBridgeFetcher *)fetcher finishedWithData:(NSData *)data error:(NSError *)error {
+  if ([error code] == kGDataFetcherStatusNotModified) {
+    if ([self completeFetcherWithCachedObject:fetcher]) {
+      // the server revalidated the object in the parsed object cache
+      return;
+    }
+
+    if ([self useCachedResponseForFetcher:fetcher]) {
+      // the server revalidated the response in the disk cache, which will
+      // be parsed below
+      error = nil;
+    } else if ([self refetchWithoutCacheValidatorsForFetcher:fetcher]) {
+      // the revalidated object or response was removed from the caches
+      // after the request was made
+      return;
+    }
+  }
+
   if (error) {
+    if ([data length] == 0) {
+      // when parsing while downloading, the fetcher did not accumulate the
+      // error response
+      NSData *errorData = [fetcher propertyForKey:kFetcherErrorDataKey];
+      if (errorData) data = errorData;
+    }
     [self objectFetcher:fetcher failedWithData:data error:error];
     return;
   }
 
   // we now have the XML data for a feed or entry
 
+  // keep the response for revalidating it later, even after a restart
+  NSString *responseCacheKey = [fetcher propertyForKey:kFetcherResponseCacheKey];
+  if (responseCacheKey != nil && [data length] > 0) {
+    NSDictionary *responseHeaders = [fetcher responseHeaders];
+    NSString *responseETag = [responseHeaders objectForKey:@"ETag"];
+    NSString *lastModified = [responseHeaders objectForKey:@"Last-Modified"];
+    if (responseETag != nil || lastModified != nil) {
+      [responseDiskCache_ storeResponseData:data
+                                       ETag:responseETag
+                               lastModified:lastModified
+                                     forKey:responseCacheKey];
+    }
+  }
+
   // save the current thread into the fetcher, since we'll handle additional
   // fetches and callbacks on this thread
   [fetcher setProperty:[NSThread currentThread]
@@ -826,6 +1414,15 @@ totalBytesExpectedToSend:(NSInteger)totalBytesExpected {
     op = [[[NSInvocationOperation alloc] initWithTarget:self
                                                selector:parseSel
                                                  object:fetcher] autorelease];
+
+    // when parsing while downloading, finish only after the last chunk
+    // has been parsed
+    NSOperation *pushParseOp = [fetcher propertyForKey:kFetcherPushParseOperationKey];
+    if (pushParseOp) {
+      [op addDependency:pushParseOp];
+      [fetcher setProperty:nil forKey:kFetcherPushParseOperationKey];
+    }
+
     [ticket setParseOperation:op];
     [operationQueue_ addOperation:op];
     // the fetcher now belongs to the parsing thread
@@ -872,10 +1469,32 @@ totalBytesExpectedToSend:(NSInteger)totalBytesExpected {
 
   Class objectClass = (Class)[fetcher propertyForKey:kFetcherObjectClassKey];
 
-  NSData *data = [fetcher downloadedData];
-  NSXMLDocument *xmlDocument = [[[NSXMLDocument alloc] initWithData:data
-                                                            options:0
-                                                              error:&error] autorelease];
+  NSXMLDocument *xmlDocument;
+#if GDATA_USES_LIBXML
+  // if the response was parsed while downloading, we just need the document
+  // from the push parser.  Data not from the network, like cached data
+  // for a 304 status, was not pushed and is parsed here.
+  GDataXMLPushParser *pushParser = [fetcher propertyForKey:kFetcherPushParserKey];
+  if (pushParser != nil
+      && [[fetcher downloadedData] length] == 0
+      && [fetcher propertyForKey:kFetcherCachedResponseDataKey] == nil) {
+    xmlDocument = [pushParser finishParsingWithError:&error];
+  } else
+#endif
+  {
+    NSData *data = [fetcher downloadedData];
+
+    // a 304 status revalidating a response in the disk cache is parsed from
+    // the cached response
+    NSData *cachedResponseData = [fetcher propertyForKey:kFetcherCachedResponseDataKey];
+    if (cachedResponseData) {
+      data = cachedResponseData;
+    }
+
+    xmlDocument = [[[NSXMLDocument alloc] initWithData:data
+                                               options:0
+                                                 error:&error] autorelease];
+  }
   if ([parseOperation isCancelled]) return;
 
   if (xmlDocument) {
@@ -904,19 +1523,47 @@ totalBytesExpectedToSend:(NSInteger)totalBytesExpected {
     BOOL shouldIgnoreUnknowns = ([ticket shouldFeedsIgnoreUnknowns]
                                  && [objectClass isSubclassOfClass:[GDataFeedBase class]]);
 
-    object = [[objectClass alloc] initWithXMLElement:root
-                                              parent:nil
-                                      serviceVersion:serviceVersion
-                                          surrogates:surrogates
-                                shouldIgnoreUnknowns:shouldIgnoreUnknowns];
+    // detached objects keep copies of their unknown nodes, so the document
+    // can be freed once parsing is done
+    BOOL shouldDetach = [ticket shouldDetachParsedObjects];
+
+    // the projection limits the extensions created for the whole tree
+    NSSet *projection = [ticket parseProjection];
+
+    if ([objectClass isSubclassOfClass:[GDataFeedBase class]]) {
+      // feeds parsing entries lazily make the entries from the document
+      // later, so they cannot be detached from it
+      BOOL shouldParseLazily = [ticket shouldParseEntriesLazily];
+      if (shouldParseLazily) shouldDetach = NO;
+
+      object = [[objectClass alloc] initWithXMLElement:root
+                                                parent:nil
+                                        serviceVersion:serviceVersion
+                                            surrogates:surrogates
+                                       parseProjection:projection
+                                  shouldIgnoreUnknowns:shouldIgnoreUnknowns
+                           shouldDetachFromXMLDocument:shouldDetach
+                              shouldParseEntriesLazily:shouldParseLazily
+                          shouldParseEntriesInParallel:[ticket shouldParseEntriesInParallel]];
+    } else {
+      object = [[objectClass alloc] initWithXMLElement:root
+                                                parent:nil
+                                        serviceVersion:serviceVersion
+                                            surrogates:surrogates
+                                       parseProjection:projection
+                                  shouldIgnoreUnknowns:shouldIgnoreUnknowns
+                           shouldDetachFromXMLDocument:shouldDetach];
+    }
 
     // we're done parsing; the extension declarations won't be needed again
     [object clearExtensionDeclarationsCache];
 
 
 #if GDATA_USES_LIBXML
-    // retain the document so that pointers to internal nodes remain valid
-    [object setProperty:xmlDocument forKey:kGDataXMLDocumentPropertyKey];
+    if (!shouldDetach) {
+      // retain the document so that pointers to internal nodes remain valid
+      [object setProperty:xmlDocument forKey:kGDataXMLDocumentPropertyKey];
+    }
 #endif
 
     [fetcher setProperty:object forKey:kFetcherParsedObjectKey];
@@ -985,17 +1632,84 @@ totalBytesExpectedToSend:(NSInteger)totalBytesExpected {
                            object:ticket];
 
   NSData *data = [fetcher downloadedData];
-  NSUInteger dataLength = [data length];
+  unsigned long long dataLength = [data length];
+#if GDATA_USES_LIBXML
+  if (dataLength == 0) {
+    GDataXMLPushParser *pushParser = [fetcher propertyForKey:kFetcherPushParserKey];
+    dataLength = [pushParser numberOfBytesAppended];
+  }
+#endif
+  if (dataLength == 0) {
+    NSData *cachedResponseData = [fetcher propertyForKey:kFetcherCachedResponseDataKey];
+    dataLength = [cachedResponseData length];
+  }
 
   // if we created the object (or we got empty data back, as from a GData
   // delete resource request) then we succeeded
   if (object != nil || dataLength == 0) {
 
+    // keep a copy of the object for later requests revalidating it
+    GDataFetchKey *objectCacheKey = [fetcher propertyForKey:kFetcherObjectCacheKey];
+    if (objectCacheKey != nil && object != nil) {
+      NSString *responseETag = [[fetcher responseHeaders] objectForKey:@"ETag"];
+      if (responseETag == nil
+          && [fetcher statusCode] == kGDataFetcherStatusNotModified) {
+        // the server revalidated the ETag sent
+        responseETag = [[fetcher request] valueForHTTPHeaderField:@"If-None-Match"];
+      }
+      if (responseETag != nil) {
+        [parsedObjectCache_ setObject:object
+                                 ETag:responseETag
+                            byteCount:(NSUInteger)dataLength
+                               forKey:objectCacheKey];
+      }
+    }
+
     // if the user is fetching a feed and the ticket specifies that "next" links
-    // should be followed, then do that now
+    // should be followed, then do that now, passing each page to the client
+    // or accumulating the pages
     if ([ticket shouldFollowNextLinks]
+        && [ticket hasFeedPageCallback]
         && [object isKindOfClass:[GDataFeedBase class]]) {
 
+      GDataFeedBase *latestFeed = [[(GDataFeedBase *)object retain] autorelease];
+
+      [self invokeFeedPageCallbackForTicket:ticket
+                                   delegate:delegate
+                                       page:latestFeed];
+
+      if ([ticket service] == nil) {
+        // the client canceled the ticket
+        return;
+      }
+
+      NSURL *nextURL = [[latestFeed nextLink] URL];
+      if (nextURL) {
+
+        // the fetcher keeps just the next page's URL, so the page may be
+        // released while the ticket is paused
+        [fetcher setProperty:nil forKey:kFetcherParsedObjectKey];
+        [fetcher setProperty:nextURL forKey:kFetcherNextFeedURLKey];
+
+        if ([ticket areFeedPagesPaused]) {
+          // the ticket keeps the fetcher's properties for resuming, and the
+          // finished fetcher releases the ticket, so a paused ticket that is
+          // never resumed is not kept alive by its fetcher
+          [ticket setPausedFetcherProperties:[fetcher properties]];
+          [fetcher setProperties:nil];
+          return;
+        }
+
+        if ([self fetchNextFeedPageForFetcher:fetcher]) {
+          // skip calling the callbacks since the ticket is still in progress
+          return;
+        }
+      }
+
+      // the last page is the object that was fetched
+    } else if ([ticket shouldFollowNextLinks]
+               && [object isKindOfClass:[GDataFeedBase class]]) {
+
       GDataFeedBase *latestFeed = (GDataFeedBase *)object;
 
       // append the latest feed
@@ -1004,7 +1718,28 @@ totalBytesExpectedToSend:(NSInteger)totalBytesExpected {
       NSURL *nextURL = [[latestFeed nextLink] URL];
       if (nextURL) {
 
+        // when the URLs of the remaining pages can be computed from the first
+        // page, fetch several of them at once
+        if ([ticket nextLinkFetchWindow] > 1
+            && [ticket nextLinksFollowedCounter] == 0) {
+
+          NSArray *pageURLs = [self URLsOfRemainingPagesOfFeed:latestFeed
+                                                       nextURL:nextURL];
+          if (pageURLs != nil
+              && [self fetchFeedPagesWithURLs:pageURLs
+                                     delegate:delegate
+                            didFinishSelector:finishedSelector
+                            completionHandler:completionHandler
+                                       ticket:ticket]) {
+
+            // the callbacks are called once all pages have been fetched
+            [fetcher setProperties:nil];
+            return;
+          }
+        }
+
         BOOL isFetchingNextFeed = [self fetchNextFeedWithURL:nextURL
+                                                 objectClass:[latestFeed class]
                                                     delegate:delegate
                                          didFinishedSelector:finishedSelector
                                            completionHandler:completionHandler
@@ -1053,6 +1788,13 @@ totalBytesExpectedToSend:(NSInteger)totalBytesExpected {
       }
     }
 
+    if (![self finishCoalescedFetchForTicket:ticket
+                                      object:object
+                                       error:nil]) {
+      [fetcher setProperties:nil];
+      return;
+    }
+
     if (finishedSelector) {
       [[self class] invokeCallback:finishedSelector
                             target:delegate
@@ -1075,6 +1817,14 @@ totalBytesExpectedToSend:(NSInteger)totalBytesExpected {
                                   code:kGDataCouldNotConstructObjectError
                               userInfo:nil];
     }
+
+    if (![self finishCoalescedFetchForTicket:ticket
+                                      object:nil
+                                       error:error]) {
+      [fetcher setProperties:nil];
+      return;
+    }
+
     if (finishedSelector) {
       [[self class] invokeCallback:finishedSelector
                             target:delegate
@@ -1128,6 +1878,13 @@ totalBytesExpectedToSend:(NSInteger)totalBytesExpected {
                             userInfo:newUserInfo];
   }
 
+  if (![self finishCoalescedFetchForTicket:ticket
+                                    object:nil
+                                     error:error]) {
+    [fetcher setProperties:nil];
+    return;
+  }
+
   if (finishedSelector) {
     [[self class] invokeCallback:finishedSelector
                           target:delegate
@@ -1248,6 +2005,20 @@ totalBytesExpectedToSend:(NSInteger)totalBytesExpected {
                                 willRetry:willRetry
                                     error:error];
   }
+
+#if GDATA_USES_LIBXML && !GTM_USE_SESSION_FETCHER
+  // the previous attempt read the streamed XML, so write it anew into a new
+  // pair of streams
+  GDataObject *streamedObject = [fetcher propertyForKey:kFetcherStreamedXMLObjectKey];
+  if (willRetry && streamedObject != nil) {
+    NSInputStream *inputStream = [self inputStreamWritingXMLOfObject:streamedObject];
+    if (inputStream == nil) {
+      willRetry = NO;
+    } else {
+      [fetcher setPostStream:inputStream];
+    }
+  }
+#endif
   return willRetry;
 }
 
@@ -1295,15 +2066,18 @@ totalBytesExpectedToSend:(NSInteger)totalBytesExpected {
 // when a ticket is set to follow "next" links for feeds, this routine
 // initiates the fetch for each additional feed
 - (BOOL)fetchNextFeedWithURL:(NSURL *)nextFeedURL
+                 objectClass:(Class)objectClass
                     delegate:(id)delegate
          didFinishedSelector:(SEL)finishedSelector
            completionHandler:(GDataServiceCompletionHandler)completionHandler
                       ticket:(GDataServiceTicketBase *)ticket {
 
-  // sanity check the number of pages fetched already
+  // sanity check the number of pages fetched already; pages passed to the
+  // client one at a time are not held, so they have no limit
   NSUInteger followedCounter = [ticket nextLinksFollowedCounter];
 
-  if (followedCounter > kMaxNumberOfNextLinksFollowed) {
+  if (followedCounter > kMaxNumberOfNextLinksFollowed
+      && ![ticket hasFeedPageCallback]) {
 
     // the client should be querying with a higher max results per page
     // to avoid this
@@ -1318,7 +2092,7 @@ totalBytesExpectedToSend:(NSInteger)totalBytesExpected {
   // should be nil
   GDataServiceTicketBase *startedTicket;
   startedTicket = [self fetchObjectWithURL:nextFeedURL
-                               objectClass:[[ticket accumulatedFeed] class]
+                               objectClass:objectClass
                               objectToPost:nil
                                       ETag:nil
                                 httpMethod:nil
@@ -1334,66 +2108,633 @@ totalBytesExpectedToSend:(NSInteger)totalBytesExpected {
   return (ticket == startedTicket);
 }
 
+- (void)invokeFeedPageCallbackForTicket:(GDataServiceTicketBase *)ticket
+                               delegate:(id)delegate
+                                   page:(GDataFeedBase *)page {
 
-- (BOOL)waitForTicket:(GDataServiceTicketBase *)ticket
-              timeout:(NSTimeInterval)timeoutInSeconds
-        fetchedObject:(GDataObject **)outObjectOrNil
-                error:(NSError **)outErrorOrNil {
+  SEL pageSelector = [ticket feedPageSelector];
+  if (pageSelector) {
+    [delegate performSelector:pageSelector
+                   withObject:ticket
+                   withObject:page];
+  }
 
-  NSDate* giveUpDate = [NSDate dateWithTimeIntervalSinceNow:timeoutInSeconds];
+#if NS_BLOCKS_AVAILABLE
+  GDataServiceFeedPageHandler block = [ticket feedPageHandler];
+  if (block) {
+    block(ticket, page);
+  }
+#endif
+}
 
-  // loop until the fetch completes with an object or an error,
-  // or until the timeout has expired
-  while (![ticket hasCalledCallback]
-         && [giveUpDate timeIntervalSinceNow] > 0) {
+// fetchNextFeedPageForFetcher: fetches the page following the one the
+// fetcher fetched for a ticket passing pages to the client
+- (BOOL)fetchNextFeedPageForFetcher:(GTMBridgeFetcher *)fetcher {
 
-    // run the current run loop 1/1000 of a second to give the networking
-    // code a chance to work
-    NSDate *stopDate = [NSDate dateWithTimeIntervalSinceNow:0.001];
-    [[NSRunLoop currentRunLoop] runUntilDate:stopDate];
+  // the URL is removed so the page is fetched just once
+  NSURL *nextURL = [[[fetcher propertyForKey:kFetcherNextFeedURLKey] retain] autorelease];
+  [fetcher setProperty:nil forKey:kFetcherNextFeedURLKey];
+  if (nextURL == nil) return NO;
+
+  GDataServiceTicketBase *ticket = [fetcher propertyForKey:kFetcherTicketKey];
+  id delegate = [fetcher propertyForKey:kFetcherDelegateKey];
+  SEL finishedSelector = NSSelectorFromString([fetcher propertyForKey:kFetcherFinishedSelectorKey]);
+  Class objectClass = (Class)[fetcher propertyForKey:kFetcherObjectClassKey];
+
+  GDataServiceCompletionHandler completionHandler;
+#if NS_BLOCKS_AVAILABLE
+  completionHandler = [fetcher propertyForKey:kFetcherCompletionHandlerKey];
+#else
+  completionHandler = NULL;
+#endif
+
+  return [self fetchNextFeedWithURL:nextURL
+                        objectClass:objectClass
+                           delegate:delegate
+                didFinishedSelector:finishedSelector
+                  completionHandler:completionHandler
+                             ticket:ticket];
+}
+
+- (void)resumeFeedPagesForFetcher:(GTMBridgeFetcher *)fetcher {
+  if (![self fetchNextFeedPageForFetcher:fetcher]) {
+    // the fetch of the next page didn't start, so the ticket fails
+    NSError *error = [NSError errorWithDomain:kGDataServiceErrorDomain
+                                         code:kGDataCouldNotConstructObjectError
+                                     userInfo:nil];
+    [self objectFetcher:fetcher failedWithData:nil error:error];
   }
+}
 
-  NSError *fetchError = [ticket fetchError];
+// URLsOfRemainingPagesOfFeed:nextURL: returns the URLs of the pages following
+// the first page of a feed, or nil if the feed's size is not known or its
+// next link does not page by start-index
+- (NSArray *)URLsOfRemainingPagesOfFeed:(GDataFeedBase *)feed
+                                nextURL:(NSURL *)nextURL {
 
-  if (![ticket hasCalledCallback] && fetchError == nil) {
-    fetchError = [NSError errorWithDomain:kGDataServiceErrorDomain
-                                     code:kGDataWaitTimedOutError
-                                 userInfo:nil];
+  NSInteger totalResults = [[feed totalResults] integerValue];
+  NSInteger startIndex = [[feed startIndex] integerValue];
+  NSInteger itemsPerPage = [[feed itemsPerPage] integerValue];
+
+  if (totalResults <= 0 || startIndex <= 0 || itemsPerPage <= 0) {
+    return nil;
   }
 
-  if (outObjectOrNil) *outObjectOrNil = [ticket fetchedObject];
-  if (outErrorOrNil)  *outErrorOrNil = fetchError;
+  // find the start-index parameter of the next link
+  NSString *urlString = [nextURL absoluteString];
+  NSRange paramRange = [urlString rangeOfString:@"start-index="];
+  if (paramRange.location == NSNotFound || paramRange.location == 0) {
+    return nil;
+  }
 
-  return (fetchError == nil);
-}
+  unichar prevChar = [urlString characterAtIndex:(paramRange.location - 1)];
+  if (prevChar != '?' && prevChar != '&') {
+    return nil;
+  }
 
-#pragma mark -
+  NSUInteger valueStart = NSMaxRange(paramRange);
+  NSScanner *scanner = [NSScanner scannerWithString:urlString];
+  [scanner setCharactersToBeSkipped:nil];
+  [scanner setScanLocation:valueStart];
 
-// These external entry points all call into fetchObjectWithURL: defined above
+  NSInteger nextStartIndex;
+  if (![scanner scanInteger:&nextStartIndex]
+      || nextStartIndex != startIndex + itemsPerPage) {
+    // the next link is not simply the following page
+    return nil;
+  }
 
-- (GDataServiceTicketBase *)fetchPublicFeedWithURL:(NSURL *)feedURL
-                                         feedClass:(Class)feedClass
-                                          delegate:(id)delegate
-                                 didFinishSelector:(SEL)finishedSelector {
+  NSString *prefix = [urlString substringToIndex:valueStart];
+  NSString *suffix = [urlString substringFromIndex:[scanner scanLocation]];
 
-  return [self fetchObjectWithURL:feedURL
-                      objectClass:feedClass
-                     objectToPost:nil
-                             ETag:nil
-                       httpMethod:nil
-                         delegate:delegate
-                didFinishSelector:finishedSelector
-                completionHandler:nil
-             retryInvocationValue:nil
-                           ticket:nil];
+  NSMutableArray *pageURLs = [NSMutableArray array];
+  for (NSInteger pageStart = nextStartIndex;
+       pageStart <= totalResults;
+       pageStart += itemsPerPage) {
+
+    if ([pageURLs count] > kMaxNumberOfNextLinksFollowed) {
+      // following next links one at a time will stop at the same limit
+      return nil;
+    }
+
+    NSString *pageURLString = [NSString stringWithFormat:@"%@%ld%@",
+                               prefix, (long) pageStart, suffix];
+    NSURL *pageURL = [NSURL URLWithString:pageURLString];
+    if (pageURL == nil) return nil;
+
+    [pageURLs addObject:pageURL];
+  }
+
+  // a single remaining page is no faster to fetch this way
+  if ([pageURLs count] < 2) return nil;
+
+  return pageURLs;
 }
 
-- (GDataServiceTicketBase *)fetchPublicEntryWithURL:(NSURL *)entryURL
-                                         entryClass:(Class)entryClass
-                                           delegate:(id)delegate
-                                  didFinishSelector:(SEL)finishedSelector {
+- (BOOL)fetchFeedPagesWithURLs:(NSArray *)pageURLs
+                      delegate:(id)delegate
+             didFinishSelector:(SEL)finishedSelector
+             completionHandler:(GDataServiceCompletionHandler)completionHandler
+                        ticket:(GDataServiceTicketBase *)ticket {
 
-  return [self fetchObjectWithURL:entryURL
+  GDataFeedPageFetch *pageFetch;
+  pageFetch = [[[GDataFeedPageFetch alloc] initWithTicket:ticket
+                                                 delegate:delegate
+                                         finishedSelector:finishedSelector
+                                        completionHandler:completionHandler
+                                                 pageURLs:pageURLs] autorelease];
+  [ticket setFeedPageFetch:pageFetch];
+
+  if (![self startFetchingFeedPagesForPageFetch:pageFetch]) {
+    // the fetches didn't start; follow the next links instead
+    [pageFetch cancelPageTickets];
+    [ticket setFeedPageFetch:nil];
+    return NO;
+  }
+
+  [ticket setNextLinksFollowedCounter:[pageURLs count]];
+  return YES;
+}
+
+// startFetchingFeedPagesForPageFetch: starts fetching pages until the ticket's
+// window is full, returning NO if a fetch did not start
+- (BOOL)startFetchingFeedPagesForPageFetch:(GDataFeedPageFetch *)pageFetch {
+
+  GDataServiceTicketBase *ticket = [pageFetch ticket];
+  NSUInteger window = [ticket nextLinkFetchWindow];
+  Class feedClass = [[ticket accumulatedFeed] class];
+
+  while ([[pageFetch pageTickets] count] < window) {
+
+    NSUInteger pageIndex = [pageFetch indexOfNextPageToStart];
+    if (pageIndex == NSNotFound) break;
+
+    // each page is fetched with its own ticket, parsed as the ticket's feeds
+    // are, and without following next links
+    GDataServiceTicketBase *pageTicket = [[[self class] ticketClass] ticketForService:self];
+    [pageTicket setSurrogates:[ticket surrogates]];
+    [pageTicket setParseProjection:[ticket parseProjection]];
+    [pageTicket setShouldFeedsIgnoreUnknowns:[ticket shouldFeedsIgnoreUnknowns]];
+    [pageTicket setShouldParseWhileDownloading:[ticket shouldParseWhileDownloading]];
+    [pageTicket setShouldDetachParsedObjects:[ticket shouldDetachParsedObjects]];
+    [pageTicket setShouldParseEntriesLazily:[ticket shouldParseEntriesLazily]];
+    [pageTicket setShouldParseEntriesInParallel:[ticket shouldParseEntriesInParallel]];
+    [pageTicket setIsRetryEnabled:[ticket isRetryEnabled]];
+    [pageTicket setMaxRetryInterval:[ticket maxRetryInterval]];
+    [pageTicket setRetrySelector:NULL];
+    [pageTicket setAuthorizer:[ticket authorizer]];
+    [pageTicket setShouldFollowNextLinks:NO];
+
+    [pageTicket setProperty:pageFetch forKey:kTicketFeedPageFetchKey];
+    [pageTicket setProperty:[NSNumber numberWithUnsignedInteger:pageIndex]
+                     forKey:kTicketFeedPageIndexKey];
+    [pageFetch addPageTicket:pageTicket];
+
+    SEL finishedSel = @selector(feedPageTicket:finishedWithFeed:error:);
+    GDataServiceTicketBase *startedTicket;
+    startedTicket = [self fetchObjectWithURL:[pageFetch URLOfPageAtIndex:pageIndex]
+                                 objectClass:feedClass
+                                objectToPost:nil
+                                        ETag:nil
+                                  httpMethod:nil
+                                    delegate:self
+                           didFinishSelector:finishedSel
+                           completionHandler:nil
+                        retryInvocationValue:nil
+                                      ticket:pageTicket];
+    if (startedTicket != pageTicket) {
+      [pageTicket setProperty:nil forKey:kTicketFeedPageFetchKey];
+      [pageFetch removePageTicket:pageTicket];
+      return NO;
+    }
+  }
+  return YES;
+}
+
+- (void)feedPageTicket:(GDataServiceTicketBase *)pageTicket
+      finishedWithFeed:(GDataFeedBase *)feed
+                 error:(NSError *)error {
+
+  GDataFeedPageFetch *pageFetch = [pageTicket propertyForKey:kTicketFeedPageFetchKey];
+  if (pageFetch == nil) return;
+
+  NSUInteger pageIndex = [[pageTicket propertyForKey:kTicketFeedPageIndexKey] unsignedIntegerValue];
+
+  [pageTicket setProperty:nil forKey:kTicketFeedPageFetchKey];
+  [pageFetch removePageTicket:pageTicket];
+
+  if (error == nil && ![feed isKindOfClass:[GDataFeedBase class]]) {
+    error = [NSError errorWithDomain:kGDataServiceErrorDomain
+                                code:kGDataCouldNotConstructObjectError
+                            userInfo:nil];
+  }
+
+  if (error != nil) {
+    [self finishFeedPageFetch:pageFetch error:error];
+    return;
+  }
+
+  [pageFetch setFeed:feed forPageAtIndex:pageIndex];
+
+  if ([pageFetch hasAccumulatedAllPages]) {
+    [self finishFeedPageFetch:pageFetch error:nil];
+  } else if (![self startFetchingFeedPagesForPageFetch:pageFetch]) {
+    error = [NSError errorWithDomain:kGDataServiceErrorDomain
+                                code:kGDataCouldNotConstructObjectError
+                            userInfo:nil];
+    [self finishFeedPageFetch:pageFetch error:error];
+  }
+}
+
+// finishFeedPageFetch:error: calls the callbacks of the ticket whose pages
+// were being fetched, with the accumulated feed or the first error
+- (void)finishFeedPageFetch:(GDataFeedPageFetch *)pageFetch
+                      error:(NSError *)error {
+
+  // the ticket releases the page fetch with autorelease, so the callback
+  // parameters remain valid here
+  GDataServiceTicketBase *ticket = [pageFetch ticket];
+  id delegate = [pageFetch delegate];
+  SEL finishedSelector = [pageFetch finishedSelector];
+  GDataServiceCompletionHandler completionHandler = [pageFetch completionHandler];
+
+  [pageFetch cancelPageTickets];
+  [ticket setFeedPageFetch:nil];
+
+  GDataFeedBase *accumulatedFeed = nil;
+  if (error == nil) {
+    // the feed may have grown since its first page was fetched
+    NSURL *nextURL = [pageFetch nextURLAfterLastPage];
+    if (nextURL != nil
+        && [self fetchNextFeedWithURL:nextURL
+                          objectClass:[[ticket accumulatedFeed] class]
+                             delegate:delegate
+                  didFinishedSelector:finishedSelector
+                    completionHandler:completionHandler
+                               ticket:ticket]) {
+      return;
+    }
+
+    // remove the misleading "next" link from the accumulated feed
+    accumulatedFeed = [ticket accumulatedFeed];
+    GDataLink *accumulatedFeedNextLink = [accumulatedFeed nextLink];
+    if (accumulatedFeedNextLink) {
+      [accumulatedFeed removeLink:accumulatedFeedNextLink];
+    }
+  }
+
+  if (finishedSelector) {
+    [[self class] invokeCallback:finishedSelector
+                          target:delegate
+                          ticket:ticket
+                          object:accumulatedFeed
+                           error:error];
+  }
+
+#if NS_BLOCKS_AVAILABLE
+  if (completionHandler) {
+    completionHandler(ticket, accumulatedFeed, error);
+  }
+#endif
+
+  if (error == nil) {
+    [ticket setFetchedObject:accumulatedFeed];
+  } else {
+    [ticket setFetchError:error];
+  }
+
+  [ticket setHasCalledCallback:YES];
+  [ticket setCurrentFetcher:nil];
+}
+
+#pragma mark -
+
+// returns the stable identity of the account a ticket's requests are made
+// for: the authorizer's userEmail, if any, or the service's username
+- (NSString *)accountForTicket:(GDataServiceTicketBase *)ticket {
+  NSString *account = nil;
+  id authorizer = [ticket authorizer];
+  if ([authorizer respondsToSelector:@selector(userEmail)]) {
+    account = [authorizer performSelector:@selector(userEmail)];
+  }
+  if (account == nil) {
+    account = [self username];
+  }
+  return account;
+}
+
+// returns the key identifying the object fetched by a plain GET, for
+// coalescing identical requests and for caching the parsed object, or nil
+// if the request posts an object or is conditional on a client's ETag
+//
+// requests are keyed by account rather than by authorizer, since a new
+// authorizer may be allocated at the address of a released one, so requests
+// whose authorizer does not identify the account are not keyed at all
+- (GDataFetchKey *)fetchKeyForURL:(NSURL *)feedURL
+                      objectClass:(Class)objectClass
+                     objectToPost:(GDataObject *)objectToPost
+                             ETag:(NSString *)etag
+                       httpMethod:(NSString *)httpMethod
+                           ticket:(GDataServiceTicketBase *)ticket {
+
+  BOOL isGET = (httpMethod == nil
+                || [httpMethod caseInsensitiveCompare:@"GET"] == NSOrderedSame);
+
+  if (feedURL == nil || objectToPost != nil || etag != nil || !isGET) {
+    return nil;
+  }
+
+  NSString *account = [self accountForTicket:ticket];
+  if (account == nil && [ticket authorizer] != nil) {
+    return nil;
+  }
+
+  // the tickets must also agree on how the response is parsed
+  GDataFetchKey *key;
+  key = [[[GDataFetchKey alloc] initWithURLString:[feedURL absoluteString]
+                                          account:account
+                                   serviceVersion:[self serviceVersion]
+                                        className:NSStringFromClass(objectClass)
+                                       surrogates:[ticket surrogates]
+                                  parseProjection:[ticket parseProjection]
+                             shouldIgnoreUnknowns:[ticket shouldFeedsIgnoreUnknowns]
+                         shouldParseEntriesLazily:[ticket shouldParseEntriesLazily]
+                        shouldDetachParsedObjects:[ticket shouldDetachParsedObjects]] autorelease];
+  return key;
+}
+
+// the tickets waiting for a leader ticket's fetch are called back before the
+// leader, each with its own copy of the fetched object, so that no callback
+// sees changes another made to its object.
+//
+// Returns NO if the leader ticket has been canceled, perhaps by a follower's
+// callback, and so must not be called back.
+- (BOOL)finishCoalescedFetchForTicket:(GDataServiceTicketBase *)ticket
+                               object:(GDataObject *)object
+                                error:(NSError *)error {
+
+  // a follower's callback may cancel the leader, releasing it from its fetcher
+  [[ticket retain] autorelease];
+
+  GDataCoalescedFetch *coalescedFetch = [[[ticket coalescedFetch] retain] autorelease];
+  if (coalescedFetch == nil) return YES;
+
+  // requests made from now on start a fetch of their own
+  [coalescedFetches_ removeObjectForKey:[coalescedFetch key]];
+  [ticket setCoalescedFetch:nil];
+
+  // a follower canceled by an earlier callback is no longer in the list
+  NSDictionary *follower;
+  while ((follower = [coalescedFetch removeFirstFollower]) != nil) {
+
+    GDataServiceTicketBase *followerTicket = [follower objectForKey:kFetcherTicketKey];
+    id delegate = [follower objectForKey:kFetcherDelegateKey];
+
+    NSString *finishedSelectorStr = [follower objectForKey:kFetcherFinishedSelectorKey];
+    SEL finishedSelector = finishedSelectorStr ? NSSelectorFromString(finishedSelectorStr) : NULL;
+
+    GDataObject *followerObject = [[object copy] autorelease];
+
+    [followerTicket setCoalescedFetch:nil];
+
+    if (finishedSelector) {
+      [[self class] invokeCallback:finishedSelector
+                            target:delegate
+                            ticket:followerTicket
+                            object:followerObject
+                             error:error];
+    }
+
+#if NS_BLOCKS_AVAILABLE
+    GDataServiceCompletionHandler completionHandler;
+
+    completionHandler = [follower objectForKey:kFetcherCompletionHandlerKey];
+    if (completionHandler) {
+      completionHandler(followerTicket, followerObject, error);
+    }
+#endif
+
+    if (error == nil) {
+      [followerTicket setFetchedObject:followerObject];
+    } else {
+      [followerTicket setFetchError:error];
+    }
+    [followerTicket setHasCalledCallback:YES];
+    [followerTicket setCurrentFetcher:nil];
+  }
+
+  return ([ticket service] != nil);
+}
+
+// called when a ticket is canceled and is not the leader of a fetch that other
+// tickets are still waiting on
+- (void)detachTicketFromCoalescedFetch:(GDataServiceTicketBase *)ticket {
+
+  GDataCoalescedFetch *coalescedFetch = [[[ticket coalescedFetch] retain] autorelease];
+  if (coalescedFetch == nil) return;
+
+  [ticket setCoalescedFetch:nil];
+
+  GDataServiceTicketBase *leaderTicket = [coalescedFetch leaderTicket];
+  if (ticket == leaderTicket) {
+    // the leader's fetch is being stopped
+    [coalescedFetches_ removeObjectForKey:[coalescedFetch key]];
+    return;
+  }
+
+  [coalescedFetch removeFollowerTicket:ticket];
+
+  if ([coalescedFetch numberOfFollowers] == 0
+      && [coalescedFetch isLeaderCanceled]) {
+    // no ticket wants the fetch any longer, so stop it
+    [leaderTicket cancelTicket];
+  }
+}
+
+// when the server revalidates the ETag sent for an object in the parsed object
+// cache, the fetch completes with a copy of the cached object
+- (BOOL)completeFetcherWithCachedObject:(GTMBridgeFetcher *)fetcher {
+
+  GDataFetchKey *objectCacheKey = [fetcher propertyForKey:kFetcherObjectCacheKey];
+  if (objectCacheKey == nil) return NO;
+
+  // the fetcher may have replaced the ETag added to the request with one it
+  // remembered, so check the one actually sent
+  NSString *sentETag = [[fetcher request] valueForHTTPHeaderField:@"If-None-Match"];
+  GDataObject *object = [parsedObjectCache_ cachedObjectForKey:objectCacheKey
+                                                          ETag:sentETag];
+  if (object == nil) return NO;
+
+  [fetcher setProperty:nil forKey:kFetcherObjectCacheKey];
+  [fetcher setProperty:object forKey:kFetcherParsedObjectKey];
+
+  // post the parsing notifications in pairs, as for a parsed response
+  GDataServiceTicketBase *ticket = [fetcher propertyForKey:kFetcherTicketKey];
+  NSNotificationCenter *defaultNC = [NSNotificationCenter defaultCenter];
+  [defaultNC postNotificationName:kGDataServiceTicketParsingStartedNotification
+                           object:ticket];
+
+  [self handleParsedObjectForFetcher:fetcher];
+  return YES;
+}
+
+// responses are cached on disk by URL, service version and account, since
+// authorizer objects do not persist across restarts
+- (NSString *)responseDiskCacheKeyForURL:(NSURL *)feedURL
+                                  ticket:(GDataServiceTicketBase *)ticket {
+  NSString *account = [self accountForTicket:ticket];
+
+  NSString *serviceVersion = [self serviceVersion];
+  NSString *key = [NSString stringWithFormat:@"%@ %@ %@",
+                   [feedURL absoluteString],
+                   (serviceVersion ? serviceVersion : @""),
+                   (account ? account : @"")];
+  return key;
+}
+
+// when the server revalidates a response in the disk cache, the fetcher is
+// given the cached response to parse
+- (BOOL)useCachedResponseForFetcher:(GTMBridgeFetcher *)fetcher {
+
+  NSString *responseCacheKey = [fetcher propertyForKey:kFetcherResponseCacheKey];
+  if (responseCacheKey == nil) return NO;
+
+  NSURLRequest *request = [fetcher request];
+  NSData *data = [responseDiskCache_ dataOfResponseForKey:responseCacheKey
+                                                     ETag:[request valueForHTTPHeaderField:@"If-None-Match"]
+                                             lastModified:[request valueForHTTPHeaderField:@"If-Modified-Since"]];
+  if (data == nil) return NO;
+
+  [fetcher setProperty:nil forKey:kFetcherResponseCacheKey];
+  [fetcher setProperty:data forKey:kFetcherCachedResponseDataKey];
+  return YES;
+}
+
+// when the server revalidates validators taken from the caches, but the
+// cached object and response have since been evicted or cleared, the
+// request is fetched again without the validators rather than failing
+- (BOOL)refetchWithoutCacheValidatorsForFetcher:(GTMBridgeFetcher *)fetcher {
+
+  if ([fetcher propertyForKey:kFetcherCacheValidatorsKey] == nil) return NO;
+
+  GDataServiceTicketBase *ticket = [fetcher propertyForKey:kFetcherTicketKey];
+
+  NSMutableURLRequest *request = [[[fetcher request] mutableCopy] autorelease];
+  [request setValue:nil forHTTPHeaderField:@"If-None-Match"];
+  [request setValue:nil forHTTPHeaderField:@"If-Modified-Since"];
+
+  GTMBridgeFetcher *newFetcher = [fetcherService_ fetcherWithRequest:request];
+
+  // the new fetcher has the callback parameters of the old one, but not its
+  // parsing state, and it will not be refetched again
+  [newFetcher addPropertiesFromDictionary:[fetcher properties]];
+  [newFetcher setProperty:nil forKey:kFetcherCacheValidatorsKey];
+  [newFetcher setProperty:nil forKey:kFetcherPushParserKey];
+  [newFetcher setProperty:nil forKey:kFetcherPushParseOperationKey];
+  [newFetcher setProperty:nil forKey:kFetcherErrorDataKey];
+  [fetcher setProperties:nil];
+
+  NSInteger cookieStorageMethod = [self cookieStorageMethod];
+  if (cookieStorageMethod >= 0) {
+    [newFetcher setCookieStorageMethod:cookieStorageMethod];
+  }
+
+  [newFetcher setRetryEnabled:[ticket isRetryEnabled]];
+  [newFetcher setMaxRetryInterval:[ticket maxRetryInterval]];
+
+  if ([ticket retrySelector]) {
+#if GTM_USE_SESSION_FETCHER
+    __block GTMBridgeFetcher *fetcherRef = newFetcher;
+    newFetcher.retryBlock = ^(BOOL suggestedWillRetry, NSError *error,
+                              GTMSessionFetcherRetryResponse response) {
+      BOOL shouldRetry = [self objectFetcher:fetcherRef
+                                   willRetry:suggestedWillRetry
+                                    forError:error];
+      response(shouldRetry);
+    };
+#else
+    [newFetcher setRetrySelector:@selector(objectFetcher:willRetry:forError:)];
+#endif
+  }
+
+#if GDATA_USES_LIBXML && NS_BLOCKS_AVAILABLE
+  if ([ticket shouldParseWhileDownloading]) {
+    [self beginParsingWhileDownloadingForFetcher:newFetcher];
+  }
+#endif
+
+  [ticket setObjectFetcher:newFetcher];
+  [ticket setCurrentFetcher:newFetcher];
+
+  [newFetcher setAuthorizer:[ticket authorizer]];
+  [self addAuthenticationToFetcher:newFetcher];
+  [newFetcher setComment:[fetcher comment]];
+
+  // a fetch that fails to start calls the failure callback
+  [newFetcher beginFetchWithDelegate:self
+                   didFinishSelector:@selector(objectFetcher:finishedWithData:error:)];
+  return YES;
+}
+
+- (BOOL)waitForTicket:(GDataServiceTicketBase *)ticket
+              timeout:(NSTimeInterval)timeoutInSeconds
+        fetchedObject:(GDataObject **)outObjectOrNil
+                error:(NSError **)outErrorOrNil {
+
+  NSDate* giveUpDate = [NSDate dateWithTimeIntervalSinceNow:timeoutInSeconds];
+
+  // loop until the fetch completes with an object or an error,
+  // or until the timeout has expired
+  while (![ticket hasCalledCallback]
+         && [giveUpDate timeIntervalSinceNow] > 0) {
+
+    // run the current run loop 1/1000 of a second to give the networking
+    // code a chance to work
+    NSDate *stopDate = [NSDate dateWithTimeIntervalSinceNow:0.001];
+    [[NSRunLoop currentRunLoop] runUntilDate:stopDate];
+  }
+
+  NSError *fetchError = [ticket fetchError];
+
+  if (![ticket hasCalledCallback] && fetchError == nil) {
+    fetchError = [NSError errorWithDomain:kGDataServiceErrorDomain
+                                     code:kGDataWaitTimedOutError
+                                 userInfo:nil];
+  }
+
+  if (outObjectOrNil) *outObjectOrNil = [ticket fetchedObject];
+  if (outErrorOrNil)  *outErrorOrNil = fetchError;
+
+  return (fetchError == nil);
+}
+
+#pragma mark -
+
+// These external entry points all call into fetchObjectWithURL: defined above
+
+- (GDataServiceTicketBase *)fetchPublicFeedWithURL:(NSURL *)feedURL
+                                         feedClass:(Class)feedClass
+                                          delegate:(id)delegate
+                                 didFinishSelector:(SEL)finishedSelector {
+
+  return [self fetchObjectWithURL:feedURL
+                      objectClass:feedClass
+                     objectToPost:nil
+                             ETag:nil
+                       httpMethod:nil
+                         delegate:delegate
+                didFinishSelector:finishedSelector
+                completionHandler:nil
+             retryInvocationValue:nil
+                           ticket:nil];
+}
+
+- (GDataServiceTicketBase *)fetchPublicEntryWithURL:(NSURL *)entryURL
+                                         entryClass:(Class)entryClass
+                                           delegate:(id)delegate
+                                  didFinishSelector:(SEL)finishedSelector {
+
+  return [self fetchObjectWithURL:entryURL
                       objectClass:entryClass
                      objectToPost:nil
                              ETag:nil
@@ -1685,6 +3026,60 @@ return [self fetchPublicFeedWithBatchFeed:batchFeed
 #if !GTM_USE_SESSION_FETCHER
   [fetcherService_ clearETaggedDataCache];
 #endif
+  [parsedObjectCache_ removeAllObjects];
+}
+
+- (void)setParsedObjectCacheCapacity:(NSUInteger)totalBytes {
+  if (parsedObjectCache_ == nil) {
+    parsedObjectCache_ = [[GDataParsedObjectCache alloc] init];
+  }
+  [parsedObjectCache_ setCapacity:totalBytes];
+}
+
+- (NSUInteger)parsedObjectCacheCapacity {
+  return [parsedObjectCache_ capacity];
+}
+
+- (NSUInteger)parsedObjectCacheHitCount {
+  return [parsedObjectCache_ hitCount];
+}
+
+- (NSUInteger)parsedObjectCacheMissCount {
+  return [parsedObjectCache_ missCount];
+}
+
+- (unsigned long long)parsedObjectCacheHitByteCount {
+  return [parsedObjectCache_ hitByteCount];
+}
+
+- (void)setResponseDiskCacheDirectory:(NSString *)path {
+  if (path == [self responseDiskCacheDirectory]
+      || [path isEqual:[self responseDiskCacheDirectory]]) return;
+
+  [responseDiskCache_ release];
+  responseDiskCache_ = nil;
+
+  if (path) {
+    responseDiskCache_ = [[GDataResponseDiskCache alloc] initWithDirectory:path
+                                                                  capacity:responseDiskCacheCapacity_];
+  }
+}
+
+- (NSString *)responseDiskCacheDirectory {
+  return [responseDiskCache_ directory];
+}
+
+- (void)setResponseDiskCacheCapacity:(NSUInteger)totalBytes {
+  responseDiskCacheCapacity_ = totalBytes;
+  [responseDiskCache_ setCapacity:totalBytes];
+}
+
+- (NSUInteger)responseDiskCacheCapacity {
+  return responseDiskCacheCapacity_;
+}
+
+- (void)clearResponseDiskCache {
+  [responseDiskCache_ removeAllResponses];
 }
 
 - (void)setFetcherService:(GTMBridgeFetcherService *)obj {
@@ -1712,20 +3107,76 @@ return [self fetchPublicFeedWithBatchFeed:batchFeed
   return serviceShouldFollowNextLinks_;
 }
 
-// The service userData becomes the initial value for each future ticket's
-// userData.
-//
-// Since the network transactions may begin before the client has been
-// returned the ticket by the fetch call, it's preferable to call
-// setServiceUserData before the ticket is created rather than call the
-// ticket's setUserData:.  Either way, the ticket's userData:
-// method will return the value.
-- (void)setServiceUserData:(id)userData {
-  [serviceUserData_ autorelease];
-  serviceUserData_ = [userData retain];
+- (void)setServiceNextLinkFetchWindow:(NSUInteger)val {
+  serviceNextLinkFetchWindow_ = val;
 }
 
-- (id)serviceUserData {
+- (NSUInteger)serviceNextLinkFetchWindow {
+  return serviceNextLinkFetchWindow_;
+}
+
+- (void)setServiceShouldCoalesceFetches:(BOOL)flag {
+  serviceShouldCoalesceFetches_ = flag;
+}
+
+- (BOOL)serviceShouldCoalesceFetches {
+  return serviceShouldCoalesceFetches_;
+}
+
+- (void)setServiceShouldParseWhileDownloading:(BOOL)flag {
+  serviceShouldParseWhileDownloading_ = flag;
+}
+
+- (BOOL)serviceShouldParseWhileDownloading {
+  return serviceShouldParseWhileDownloading_;
+}
+
+- (void)setServiceShouldStreamPostedXML:(BOOL)flag {
+  serviceShouldStreamPostedXML_ = flag;
+}
+
+- (BOOL)serviceShouldStreamPostedXML {
+  return serviceShouldStreamPostedXML_;
+}
+
+- (void)setServiceShouldDetachParsedObjects:(BOOL)flag {
+  serviceShouldDetachParsedObjects_ = flag;
+}
+
+- (BOOL)serviceShouldDetachParsedObjects {
+  return serviceShouldDetachParsedObjects_;
+}
+
+- (void)setServiceShouldParseEntriesLazily:(BOOL)flag {
+  serviceShouldParseEntriesLazily_ = flag;
+}
+
+- (BOOL)serviceShouldParseEntriesLazily {
+  return serviceShouldParseEntriesLazily_;
+}
+
+- (void)setServiceShouldParseEntriesInParallel:(BOOL)flag {
+  serviceShouldParseEntriesInParallel_ = flag;
+}
+
+- (BOOL)serviceShouldParseEntriesInParallel {
+  return serviceShouldParseEntriesInParallel_;
+}
+
+// The service userData becomes the initial value for each future ticket's
+// userData.
+//
+// Since the network transactions may begin before the client has been
+// returned the ticket by the fetch call, it's preferable to call
+// setServiceUserData before the ticket is created rather than call the
+// ticket's setUserData:.  Either way, the ticket's userData:
+// method will return the value.
+- (void)setServiceUserData:(id)userData {
+  [serviceUserData_ autorelease];
+  serviceUserData_ = [userData retain];
+}
+
+- (id)serviceUserData {
   return serviceUserData_;
 }
 
@@ -1774,6 +3225,15 @@ return [self fetchPublicFeedWithBatchFeed:batchFeed
   serviceSurrogates_ = [dict retain];
 }
 
+- (NSSet *)serviceParseProjection {
+  return serviceParseProjection_;
+}
+
+- (void)setServiceParseProjection:(NSSet *)projection {
+  [serviceParseProjection_ autorelease];
+  serviceParseProjection_ = [projection copy];
+}
+
 - (BOOL)shouldServiceFeedsIgnoreUnknowns {
   return shouldServiceFeedsIgnoreUnknowns_;
 }
@@ -1920,12 +3380,19 @@ return [self fetchPublicFeedWithBatchFeed:batchFeed
     [self setUserData:[service serviceUserData]];
     [self setProperties:[service serviceProperties]];
     [self setSurrogates:[service serviceSurrogates]];
+    [self setParseProjection:[service serviceParseProjection]];
     [self setUploadProgressSelector:[service serviceUploadProgressSelector]];
     [self setIsRetryEnabled:[service isServiceRetryEnabled]];
     [self setRetrySelector:[service serviceRetrySelector]];
     [self setMaxRetryInterval:[service serviceMaxRetryInterval]];
     [self setShouldFollowNextLinks:[service serviceShouldFollowNextLinks]];
+    [self setNextLinkFetchWindow:[service serviceNextLinkFetchWindow]];
     [self setShouldFeedsIgnoreUnknowns:[service shouldServiceFeedsIgnoreUnknowns]];
+    [self setShouldParseWhileDownloading:[service serviceShouldParseWhileDownloading]];
+    [self setShouldStreamPostedXML:[service serviceShouldStreamPostedXML]];
+    [self setShouldDetachParsedObjects:[service serviceShouldDetachParsedObjects]];
+    [self setShouldParseEntriesLazily:[service serviceShouldParseEntriesLazily]];
+    [self setShouldParseEntriesInParallel:[service serviceShouldParseEntriesInParallel]];
 #if NS_BLOCKS_AVAILABLE
     [self setUploadProgressHandler:[service serviceUploadProgressHandler]];
 #endif
@@ -1940,6 +3407,7 @@ return [self fetchPublicFeedWithBatchFeed:batchFeed
   [userData_ release];
   [ticketProperties_ release];
   [surrogates_ release];
+  [parseProjection_ release];
 
   [currentFetcher_ release];
   [objectFetcher_ release];
@@ -1950,6 +3418,12 @@ return [self fetchPublicFeedWithBatchFeed:batchFeed
   [postedObject_ release];
   [fetchedObject_ release];
   [accumulatedFeed_ release];
+  [feedPageFetch_ release];
+#if NS_BLOCKS_AVAILABLE
+  [feedPageBlock_ release];
+#endif
+  [pausedFetcherProperties_ release];
+  [coalescedFetch_ release];
   [fetchError_ release];
 
   [parseOperation_ release];
@@ -1994,14 +3468,30 @@ return [self fetchPublicFeedWithBatchFeed:batchFeed
 }
 
 - (void)cancelTicket {
-  NSOperation *op = [self parseOperation];
-  [op cancel];
-  [self setParseOperation:nil];
+  if ([self isSharingFetch]) {
+    // other tickets are waiting for this ticket's fetch, so let it finish
+    // without calling back this ticket
+    [[self coalescedFetch] setIsLeaderCanceled:YES];
+
+    [objectFetcher_ setProperty:nil forKey:kFetcherDelegateKey];
+    [objectFetcher_ setProperty:nil forKey:kFetcherFinishedSelectorKey];
+    [objectFetcher_ setProperty:nil forKey:kFetcherCompletionHandlerKey];
+  } else {
+    [[[self coalescedFetch] service] detachTicketFromCoalescedFetch:self];
 
-  [objectFetcher_ stopFetching];
-  [objectFetcher_ setProperties:nil];
+    NSOperation *op = [self parseOperation];
+    [op cancel];
+    [self setParseOperation:nil];
+
+    [objectFetcher_ stopFetching];
+    [objectFetcher_ setProperties:nil];
+
+    [self setObjectFetcher:nil];
+  }
+
+  [[self feedPageFetch] cancelPageTickets];
+  [self setFeedPageFetch:nil];
 
-  [self setObjectFetcher:nil];
   [self setCurrentFetcher:nil];
   [self setUserData:nil];
   [self setProperties:nil];
@@ -2011,6 +3501,12 @@ return [self fetchPublicFeedWithBatchFeed:batchFeed
   [self setUploadProgressHandler:nil];
 #endif
 
+  [self setFeedPageSelector:NULL];
+#if NS_BLOCKS_AVAILABLE
+  [self setFeedPageHandler:nil];
+#endif
+  [self setPausedFetcherProperties:nil];
+
   [service_ autorelease];
   service_ = nil;
 }
@@ -2070,6 +3566,15 @@ return [self fetchPublicFeedWithBatchFeed:batchFeed
   surrogates_ = [dict retain];
 }
 
+- (NSSet *)parseProjection {
+  return parseProjection_;
+}
+
+- (void)setParseProjection:(NSSet *)projection {
+  [parseProjection_ autorelease];
+  parseProjection_ = [projection copy];
+}
+
 - (SEL)uploadProgressSelector {
   return uploadProgressSelector_;
 }
@@ -2135,6 +3640,72 @@ return [self fetchPublicFeedWithBatchFeed:batchFeed
   shouldFollowNextLinks_ = flag;
 }
 
+- (NSUInteger)nextLinkFetchWindow {
+  return nextLinkFetchWindow_;
+}
+
+- (void)setNextLinkFetchWindow:(NSUInteger)val {
+  nextLinkFetchWindow_ = val;
+}
+
+- (SEL)feedPageSelector {
+  return feedPageSelector_;
+}
+
+- (void)setFeedPageSelector:(SEL)pageSelector {
+  feedPageSelector_ = pageSelector;
+}
+
+#if NS_BLOCKS_AVAILABLE
+- (void)setFeedPageHandler:(GDataServiceFeedPageHandler)block {
+  [feedPageBlock_ autorelease];
+  feedPageBlock_ = [block copy];
+}
+
+- (GDataServiceFeedPageHandler)feedPageHandler {
+  return feedPageBlock_;
+}
+#endif
+
+- (BOOL)hasFeedPageCallback {
+#if NS_BLOCKS_AVAILABLE
+  if (feedPageBlock_ != nil) return YES;
+#endif
+  return (feedPageSelector_ != NULL);
+}
+
+- (void)pauseFeedPages {
+  areFeedPagesPaused_ = YES;
+}
+
+- (void)resumeFeedPages {
+  areFeedPagesPaused_ = NO;
+
+  // if the ticket stopped after a page, give the finished fetcher back its
+  // properties and fetch the next page
+  if (pausedFetcherProperties_ != nil) {
+    GTMBridgeFetcher *fetcher = [self currentFetcher];
+    [fetcher addPropertiesFromDictionary:pausedFetcherProperties_];
+    [fetcher setProperty:self forKey:kFetcherTicketKey];
+    [self setPausedFetcherProperties:nil];
+
+    [service_ resumeFeedPagesForFetcher:fetcher];
+  }
+}
+
+- (void)setPausedFetcherProperties:(NSDictionary *)dict {
+  // the properties are kept without the ticket, which would retain itself
+  NSMutableDictionary *props = [[dict mutableCopy] autorelease];
+  [props removeObjectForKey:kFetcherTicketKey];
+
+  [pausedFetcherProperties_ autorelease];
+  pausedFetcherProperties_ = [props copy];
+}
+
+- (BOOL)areFeedPagesPaused {
+  return areFeedPagesPaused_;
+}
+
 - (BOOL)shouldFeedsIgnoreUnknowns {
   return shouldFeedsIgnoreUnknowns_;
 }
@@ -2143,6 +3714,46 @@ return [self fetchPublicFeedWithBatchFeed:batchFeed
   shouldFeedsIgnoreUnknowns_ = flag;
 }
 
+- (BOOL)shouldParseWhileDownloading {
+  return shouldParseWhileDownloading_;
+}
+
+- (void)setShouldParseWhileDownloading:(BOOL)flag {
+  shouldParseWhileDownloading_ = flag;
+}
+
+- (BOOL)shouldStreamPostedXML {
+  return shouldStreamPostedXML_;
+}
+
+- (void)setShouldStreamPostedXML:(BOOL)flag {
+  shouldStreamPostedXML_ = flag;
+}
+
+- (BOOL)shouldDetachParsedObjects {
+  return shouldDetachParsedObjects_;
+}
+
+- (void)setShouldDetachParsedObjects:(BOOL)flag {
+  shouldDetachParsedObjects_ = flag;
+}
+
+- (BOOL)shouldParseEntriesLazily {
+  return shouldParseEntriesLazily_;
+}
+
+- (void)setShouldParseEntriesLazily:(BOOL)flag {
+  shouldParseEntriesLazily_ = flag;
+}
+
+- (BOOL)shouldParseEntriesInParallel {
+  return shouldParseEntriesInParallel_;
+}
+
+- (void)setShouldParseEntriesInParallel:(BOOL)flag {
+  shouldParseEntriesInParallel_ = flag;
+}
+
 - (BOOL)isRetryEnabled {
   return isRetryEnabled_;
 }
@@ -2268,6 +3879,31 @@ return [self fetchPublicFeedWithBatchFeed:batchFeed
   return nextLinksFollowedCounter_;
 }
 
+- (GDataFeedPageFetch *)feedPageFetch {
+  return feedPageFetch_;
+}
+
+- (void)setFeedPageFetch:(GDataFeedPageFetch *)pageFetch {
+  [feedPageFetch_ autorelease];
+  feedPageFetch_ = [pageFetch retain];
+}
+
+- (GDataCoalescedFetch *)coalescedFetch {
+  return coalescedFetch_;
+}
+
+- (void)setCoalescedFetch:(GDataCoalescedFetch *)coalescedFetch {
+  [coalescedFetch_ autorelease];
+  coalescedFetch_ = [coalescedFetch retain];
+}
+
+// YES when this ticket's fetch has other tickets waiting for it
+- (BOOL)isSharingFetch {
+  GDataCoalescedFetch *coalescedFetch = [self coalescedFetch];
+  return ([coalescedFetch leaderTicket] == self
+          && [coalescedFetch numberOfFollowers] > 0);
+}
+
 - (NSOperation *)parseOperation {
   return parseOperation_;
 }
@@ -2291,3 +3927,778 @@ return [self fetchPublicFeedWithBatchFeed:batchFeed
 }
 
 @end
+
+@implementation GDataFeedPageFetch
+
+- (id)initWithTicket:(GDataServiceTicketBase *)ticket
+            delegate:(id)delegate
+    finishedSelector:(SEL)finishedSelector
+   completionHandler:(id)completionHandler
+            pageURLs:(NSArray *)pageURLs {
+  self = [super init];
+  if (self) {
+    // the ticket is retained until the pages have been fetched or the
+    // ticket is canceled, as the ticket's fetcher is done with it
+    ticket_ = [ticket retain];
+    delegate_ = [delegate retain];
+    finishedSelector_ = finishedSelector;
+    completionHandler_ = [completionHandler copy];
+    pageURLs_ = [pageURLs copy];
+    pageTickets_ = [[NSMutableArray alloc] init];
+
+    NSUInteger numberOfPages = [pageURLs count];
+    pageFeeds_ = [[NSMutableArray alloc] initWithCapacity:numberOfPages];
+    for (NSUInteger idx = 0; idx < numberOfPages; idx++) {
+      [pageFeeds_ addObject:[NSNull null]];
+    }
+  }
+  return self;
+}
+
+- (void)dealloc {
+  [ticket_ release];
+  [delegate_ release];
+  [completionHandler_ release];
+  [pageURLs_ release];
+  [pageFeeds_ release];
+  [pageTickets_ release];
+  [nextURLAfterLastPage_ release];
+  [super dealloc];
+}
+
+- (GDataServiceTicketBase *)ticket {
+  return ticket_;
+}
+
+- (id)delegate {
+  return delegate_;
+}
+
+- (SEL)finishedSelector {
+  return finishedSelector_;
+}
+
+- (GDataServiceCompletionHandler)completionHandler {
+  return completionHandler_;
+}
+
+- (NSUInteger)indexOfNextPageToStart {
+  if (numberOfPagesStarted_ >= [pageURLs_ count]) return NSNotFound;
+
+  return numberOfPagesStarted_++;
+}
+
+- (NSURL *)URLOfPageAtIndex:(NSUInteger)idx {
+  return [pageURLs_ objectAtIndex:idx];
+}
+
+- (NSArray *)pageTickets {
+  return pageTickets_;
+}
+
+- (void)addPageTicket:(GDataServiceTicketBase *)pageTicket {
+  [pageTickets_ addObject:pageTicket];
+}
+
+- (void)removePageTicket:(GDataServiceTicketBase *)pageTicket {
+  [pageTickets_ removeObjectIdenticalTo:pageTicket];
+}
+
+- (void)cancelPageTickets {
+  NSArray *pageTickets = [[pageTickets_ copy] autorelease];
+  [pageTickets_ removeAllObjects];
+
+  for (GDataServiceTicketBase *pageTicket in pageTickets) {
+    [pageTicket cancelTicket];
+  }
+}
+
+- (void)setFeed:(GDataFeedBase *)feed forPageAtIndex:(NSUInteger)idx {
+  [pageFeeds_ replaceObjectAtIndex:idx withObject:feed];
+
+  // accumulate the pages that have arrived after all pages before them
+  NSUInteger numberOfPages = [pageFeeds_ count];
+  while (numberOfPagesAccumulated_ < numberOfPages) {
+    id pageFeed = [pageFeeds_ objectAtIndex:numberOfPagesAccumulated_];
+    if (pageFeed == [NSNull null]) break;
+
+    [ticket_ accumulateFeed:pageFeed];
+
+    if (numberOfPagesAccumulated_ + 1 == numberOfPages) {
+      nextURLAfterLastPage_ = [[[pageFeed nextLink] URL] retain];
+    }
+
+    [pageFeeds_ replaceObjectAtIndex:numberOfPagesAccumulated_
+                          withObject:[NSNull null]];
+    ++numberOfPagesAccumulated_;
+  }
+}
+
+- (BOOL)hasAccumulatedAllPages {
+  return (numberOfPagesAccumulated_ == [pageFeeds_ count]);
+}
+
+- (NSURL *)nextURLAfterLastPage {
+  return nextURLAfterLastPage_;
+}
+
+@end
+
+@implementation GDataCoalescedFetch
+
+- (id)initWithService:(GDataServiceBase *)service
+                  key:(GDataFetchKey *)key
+         leaderTicket:(GDataServiceTicketBase *)leaderTicket {
+  self = [super init];
+  if (self) {
+    service_ = service;
+    key_ = [key copy];
+    leaderTicket_ = [leaderTicket retain];
+    followers_ = [[NSMutableArray alloc] init];
+  }
+  return self;
+}
+
+- (void)dealloc {
+  [key_ release];
+  [leaderTicket_ release];
+  [followers_ release];
+  [super dealloc];
+}
+
+- (GDataServiceBase *)service {
+  return service_;
+}
+
+- (GDataFetchKey *)key {
+  return key_;
+}
+
+- (GDataServiceTicketBase *)leaderTicket {
+  return leaderTicket_;
+}
+
+- (void)addFollowerTicket:(GDataServiceTicketBase *)ticket
+                 delegate:(id)delegate
+         finishedSelector:(SEL)finishedSelector
+        completionHandler:(id)completionHandler {
+
+  NSMutableDictionary *follower = [NSMutableDictionary dictionary];
+  [follower setObject:ticket forKey:kFetcherTicketKey];
+
+  if (delegate) {
+    [follower setObject:delegate forKey:kFetcherDelegateKey];
+  }
+
+  if (finishedSelector) {
+    [follower setObject:NSStringFromSelector(finishedSelector)
+                 forKey:kFetcherFinishedSelectorKey];
+  }
+
+#if NS_BLOCKS_AVAILABLE
+  // copy the completion handler block to the heap
+  if (completionHandler) {
+    [follower setObject:[[completionHandler copy] autorelease]
+                 forKey:kFetcherCompletionHandlerKey];
+  }
+#endif
+
+  [followers_ addObject:follower];
+}
+
+- (void)removeFollowerTicket:(GDataServiceTicketBase *)ticket {
+  NSUInteger numberOfFollowers = [followers_ count];
+  for (NSUInteger idx = 0; idx < numberOfFollowers; idx++) {
+    NSDictionary *follower = [followers_ objectAtIndex:idx];
+    if ([follower objectForKey:kFetcherTicketKey] == ticket) {
+      [followers_ removeObjectAtIndex:idx];
+      return;
+    }
+  }
+}
+
+- (NSUInteger)numberOfFollowers {
+  return [followers_ count];
+}
+
+- (NSDictionary *)removeFirstFollower {
+  if ([followers_ count] == 0) return nil;
+
+  NSDictionary *follower = [[[followers_ objectAtIndex:0] retain] autorelease];
+  [followers_ removeObjectAtIndex:0];
+  return follower;
+}
+
+- (BOOL)isLeaderCanceled {
+  return isLeaderCanceled_;
+}
+
+- (void)setIsLeaderCanceled:(BOOL)flag {
+  isLeaderCanceled_ = flag;
+}
+
+@end
+
+@implementation GDataFetchKey
+
+- (id)initWithURLString:(NSString *)URLString
+                account:(NSString *)account
+         serviceVersion:(NSString *)serviceVersion
+              className:(NSString *)className
+             surrogates:(NSDictionary *)surrogates
+        parseProjection:(NSSet *)parseProjection
+   shouldIgnoreUnknowns:(BOOL)shouldIgnoreUnknowns
+shouldParseEntriesLazily:(BOOL)shouldParseEntriesLazily
+shouldDetachParsedObjects:(BOOL)shouldDetachParsedObjects {
+  self = [super init];
+  if (self) {
+    URLString_ = [URLString copy];
+    account_ = [account copy];
+    serviceVersion_ = [serviceVersion copy];
+    className_ = [className copy];
+    surrogates_ = [surrogates copy];
+    parseProjection_ = [parseProjection copy];
+    shouldIgnoreUnknowns_ = shouldIgnoreUnknowns;
+    shouldParseEntriesLazily_ = shouldParseEntriesLazily;
+    shouldDetachParsedObjects_ = shouldDetachParsedObjects;
+
+    // keys differing only in their parse settings are rare, so the hash
+    // needn't include them
+    hash_ = [URLString_ hash] ^ ([account_ hash] << 1) ^ [className_ hash];
+  }
+  return self;
+}
+
+- (void)dealloc {
+  [URLString_ release];
+  [account_ release];
+  [serviceVersion_ release];
+  [className_ release];
+  [surrogates_ release];
+  [parseProjection_ release];
+  [super dealloc];
+}
+
+- (id)copyWithZone:(NSZone *)zone {
+  // keys are immutable
+  return [self retain];
+}
+
+- (NSUInteger)hash {
+  return hash_;
+}
+
+- (BOOL)isEqual:(id)other {
+  if (self == other) return YES;
+  if (![other isKindOfClass:[GDataFetchKey class]]) return NO;
+
+  GDataFetchKey *key = other;
+  return hash_ == key->hash_
+    && shouldIgnoreUnknowns_ == key->shouldIgnoreUnknowns_
+    && shouldParseEntriesLazily_ == key->shouldParseEntriesLazily_
+    && shouldDetachParsedObjects_ == key->shouldDetachParsedObjects_
+    && AreEqualOrBothNil(URLString_, key->URLString_)
+    && AreEqualOrBothNil(account_, key->account_)
+    && AreEqualOrBothNil(serviceVersion_, key->serviceVersion_)
+    && AreEqualOrBothNil(className_, key->className_)
+    && AreEqualOrBothNil(surrogates_, key->surrogates_)
+    && AreEqualOrBothNil(parseProjection_, key->parseProjection_);
+}
+
+- (NSString *)description {
+  return [NSString stringWithFormat:@"%@ %p: {URL:%@ account:%@ class:%@}",
+          [self class], self, URLString_, account_, className_];
+}
+
+@end
+
+@implementation GDataParsedObjectCacheEntry
+
+- (void)dealloc {
+  [key_ release];
+  [object_ release];
+  [ETag_ release];
+  [super dealloc];
+}
+
+@end
+
+@implementation GDataParsedObjectCache
+
+- (id)init {
+  self = [super init];
+  if (self) {
+    entries_ = [[NSMutableDictionary alloc] init];
+  }
+  return self;
+}
+
+- (void)dealloc {
+  [entries_ release];
+  [super dealloc];
+}
+
+- (void)unlinkEntry:(GDataParsedObjectCacheEntry *)entry {
+  GDataParsedObjectCacheEntry *older = entry->olderEntry_;
+  GDataParsedObjectCacheEntry *newer = entry->newerEntry_;
+
+  if (older) older->newerEntry_ = newer;
+  else oldestEntry_ = newer;
+
+  if (newer) newer->olderEntry_ = older;
+  else newestEntry_ = older;
+
+  entry->olderEntry_ = nil;
+  entry->newerEntry_ = nil;
+}
+
+- (void)linkNewestEntry:(GDataParsedObjectCacheEntry *)entry {
+  entry->olderEntry_ = newestEntry_;
+  entry->newerEntry_ = nil;
+
+  if (newestEntry_) newestEntry_->newerEntry_ = entry;
+  else oldestEntry_ = entry;
+
+  newestEntry_ = entry;
+}
+
+- (void)removeObjectForKey:(GDataFetchKey *)key {
+  GDataParsedObjectCacheEntry *entry = [entries_ objectForKey:key];
+  if (entry == nil) return;
+
+  // the key may be the entry's own
+  [[entry retain] autorelease];
+
+  totalByteCount_ -= entry->byteCount_;
+
+  [self unlinkEntry:entry];
+  [entries_ removeObjectForKey:key];
+}
+
+- (void)evictObjectsToFitByteCount:(NSUInteger)byteCount {
+  while (totalByteCount_ + byteCount > capacity_
+         && oldestEntry_ != nil) {
+    [self removeObjectForKey:oldestEntry_->key_];
+  }
+}
+
+- (NSUInteger)capacity {
+  @synchronized(self) {
+    return capacity_;
+  }
+}
+
+- (void)setCapacity:(NSUInteger)totalBytes {
+  @synchronized(self) {
+    capacity_ = totalBytes;
+    [self evictObjectsToFitByteCount:0];
+  }
+}
+
+- (NSString *)ETagForKey:(GDataFetchKey *)key {
+  @synchronized(self) {
+    GDataParsedObjectCacheEntry *entry = [entries_ objectForKey:key];
+    if (entry == nil) return nil;
+
+    return [[entry->ETag_ retain] autorelease];
+  }
+}
+
+- (GDataObject *)cachedObjectForKey:(GDataFetchKey *)key ETag:(NSString *)etag {
+  @synchronized(self) {
+    GDataParsedObjectCacheEntry *entry = [entries_ objectForKey:key];
+    if (entry == nil || ![entry->ETag_ isEqual:etag]) {
+      return nil;
+    }
+
+    // move the entry to the most recently used end
+    [self unlinkEntry:entry];
+    [self linkNewestEntry:entry];
+
+    ++hitCount_;
+    hitByteCount_ += entry->byteCount_;
+
+    // the cached object is never handed out, so callers may modify copies
+    return [[entry->object_ copy] autorelease];
+  }
+}
+
+- (void)setObject:(GDataObject *)object
+             ETag:(NSString *)etag
+        byteCount:(NSUInteger)byteCount
+           forKey:(GDataFetchKey *)key {
+  @synchronized(self) {
+    ++missCount_;
+
+    [self removeObjectForKey:key];
+
+    if (byteCount > capacity_) return;
+
+    [self evictObjectsToFitByteCount:byteCount];
+
+    GDataParsedObjectCacheEntry *entry;
+    entry = [[[GDataParsedObjectCacheEntry alloc] init] autorelease];
+    entry->key_ = [key copy];
+    entry->object_ = [object copy];
+    entry->ETag_ = [etag copy];
+    entry->byteCount_ = byteCount;
+
+    [entries_ setObject:entry forKey:key];
+    [self linkNewestEntry:entry];
+
+    totalByteCount_ += byteCount;
+  }
+}
+
+- (void)removeAllObjects {
+  @synchronized(self) {
+    [entries_ removeAllObjects];
+    oldestEntry_ = nil;
+    newestEntry_ = nil;
+    totalByteCount_ = 0;
+  }
+}
+
+- (NSUInteger)hitCount {
+  @synchronized(self) {
+    return hitCount_;
+  }
+}
+
+- (NSUInteger)missCount {
+  @synchronized(self) {
+    return missCount_;
+  }
+}
+
+- (unsigned long long)hitByteCount {
+  @synchronized(self) {
+    return hitByteCount_;
+  }
+}
+
+@end
+
+@interface GDataResponseDiskCache (PrivateMethods)
+- (NSString *)baseNameForKey:(NSString *)key;
+- (NSString *)dataPathForBaseName:(NSString *)baseName;
+- (NSString *)metadataPathForBaseName:(NSString *)baseName;
+- (void)readDirectory;
+- (void)addFileOperationWithSelector:(SEL)sel object:(id)obj;
+- (void)removeResponseForKey:(NSString *)key;
+- (void)evictResponsesToFitByteCount:(NSUInteger)byteCount;
+@end
+
+@implementation GDataResponseDiskCache
+
+- (id)initWithDirectory:(NSString *)directory
+               capacity:(NSUInteger)totalBytes {
+  self = [super init];
+  if (self) {
+    directory_ = [directory copy];
+    capacity_ = totalBytes;
+    entries_ = [[NSMutableDictionary alloc] init];
+    keysByLastUse_ = [[NSMutableArray alloc] init];
+
+    fileQueue_ = [[NSOperationQueue alloc] init];
+    [fileQueue_ setMaxConcurrentOperationCount:1];
+
+    pendingData_ = [[NSMutableDictionary alloc] init];
+
+    [self readDirectory];
+  }
+  return self;
+}
+
+- (void)dealloc {
+  // pending writes retain this object, so there are none left
+  [directory_ release];
+  [entries_ release];
+  [keysByLastUse_ release];
+  [fileQueue_ release];
+  [pendingData_ release];
+  [super dealloc];
+}
+
+// file names are the SHA-1 digests of the cache keys
+- (NSString *)baseNameForKey:(NSString *)key {
+  NSData *keyData = [key dataUsingEncoding:NSUTF8StringEncoding];
+
+  unsigned char digest[CC_SHA1_DIGEST_LENGTH];
+  CC_SHA1([keyData bytes], (CC_LONG)[keyData length], digest);
+
+  NSMutableString *baseName = [NSMutableString stringWithCapacity:2 * CC_SHA1_DIGEST_LENGTH];
+  for (int idx = 0; idx < CC_SHA1_DIGEST_LENGTH; idx++) {
+    [baseName appendFormat:@"%02x", digest[idx]];
+  }
+  return baseName;
+}
+
+- (NSString *)dataPathForBaseName:(NSString *)baseName {
+  NSString *fileName = [baseName stringByAppendingPathExtension:@"data"];
+  return [directory_ stringByAppendingPathComponent:fileName];
+}
+
+- (NSString *)metadataPathForBaseName:(NSString *)baseName {
+  NSString *fileName = [baseName stringByAppendingPathExtension:@"plist"];
+  return [directory_ stringByAppendingPathComponent:fileName];
+}
+
+static NSInteger CompareLastUse(id key1, id key2, void *context) {
+  NSDictionary *entries = (NSDictionary *)context;
+  NSDate *date1 = [[entries objectForKey:key1] objectForKey:kResponseCacheLastUseKey];
+  NSDate *date2 = [[entries objectForKey:key2] objectForKey:kResponseCacheLastUseKey];
+  return [date1 compare:date2];
+}
+
+// build the index of complete entries, removing the files of incomplete ones
+- (void)readDirectory {
+  NSFileManager *fileMgr = [NSFileManager defaultManager];
+  [fileMgr createDirectoryAtPath:directory_
+     withIntermediateDirectories:YES
+                      attributes:nil
+                           error:NULL];
+
+  NSArray *fileNames = [fileMgr contentsOfDirectoryAtPath:directory_
+                                                    error:NULL];
+  NSMutableSet *validBaseNames = [NSMutableSet set];
+
+  for (NSString *fileName in fileNames) {
+    if (![[fileName pathExtension] isEqual:@"plist"]) continue;
+
+    NSString *baseName = [fileName stringByDeletingPathExtension];
+    NSString *metadataPath = [self metadataPathForBaseName:baseName];
+    NSString *dataPath = [self dataPathForBaseName:baseName];
+
+    NSDictionary *metadata = [NSDictionary dictionaryWithContentsOfFile:metadataPath];
+    NSString *key = [metadata objectForKey:kResponseCacheKeyKey];
+    NSNumber *length = [metadata objectForKey:kResponseCacheLengthKey];
+
+    NSDictionary *attributes = [fileMgr attributesOfItemAtPath:dataPath
+                                                         error:NULL];
+    BOOL isComplete = (key != nil
+                       && attributes != nil
+                       && [attributes fileSize] == [length unsignedLongLongValue]
+                       && [baseName isEqual:[self baseNameForKey:key]]);
+    if (!isComplete) continue;
+
+    NSMutableDictionary *entry = [NSMutableDictionary dictionaryWithDictionary:metadata];
+    [entry setObject:[attributes fileModificationDate]
+              forKey:kResponseCacheLastUseKey];
+    [entries_ setObject:entry forKey:key];
+    [keysByLastUse_ addObject:key];
+    totalByteCount_ += [length unsignedIntegerValue];
+
+    [validBaseNames addObject:baseName];
+  }
+
+  for (NSString *fileName in fileNames) {
+    NSString *baseName = [fileName stringByDeletingPathExtension];
+    if (![validBaseNames containsObject:baseName]) {
+      NSString *path = [directory_ stringByAppendingPathComponent:fileName];
+      [fileMgr removeItemAtPath:path error:NULL];
+    }
+  }
+
+  [keysByLastUse_ sortUsingFunction:CompareLastUse context:entries_];
+
+  [self evictResponsesToFitByteCount:0];
+}
+
+#pragma mark File operations
+
+// these run on the file queue, in the order they were added
+
+- (void)writeResponse:(NSDictionary *)response {
+  NSString *baseName = [response objectForKey:@"baseName"];
+  NSData *data = [response objectForKey:@"data"];
+  NSDictionary *metadata = [response objectForKey:@"metadata"];
+
+  NSString *metadataPath = [self metadataPathForBaseName:baseName];
+  NSString *dataPath = [self dataPathForBaseName:baseName];
+
+  // the old metadata goes first and the new metadata is written last, so an
+  // interrupted write leaves only files that will be discarded
+  NSFileManager *fileMgr = [NSFileManager defaultManager];
+  [fileMgr removeItemAtPath:metadataPath error:NULL];
+
+  BOOL didWrite = ([data writeToFile:dataPath atomically:YES]
+                   && [metadata writeToFile:metadataPath atomically:YES]);
+
+  // the response is read from the files once written, unless it was
+  // replaced or removed meanwhile
+  NSString *key = [metadata objectForKey:kResponseCacheKeyKey];
+  @synchronized(self) {
+    if ([pendingData_ objectForKey:key] == data) {
+      [pendingData_ removeObjectForKey:key];
+      if (!didWrite) {
+        [self removeResponseForKey:key];
+      }
+    }
+  }
+}
+
+- (void)removeFilesWithBaseName:(NSString *)baseName {
+  NSFileManager *fileMgr = [NSFileManager defaultManager];
+  [fileMgr removeItemAtPath:[self metadataPathForBaseName:baseName] error:NULL];
+  [fileMgr removeItemAtPath:[self dataPathForBaseName:baseName] error:NULL];
+}
+
+// the data file's modification date records the last use across restarts
+- (void)touchFileWithBaseName:(NSString *)baseName {
+  NSDictionary *attributes = [NSDictionary dictionaryWithObject:[NSDate date]
+                                                         forKey:NSFileModificationDate];
+  [[NSFileManager defaultManager] setAttributes:attributes
+                                   ofItemAtPath:[self dataPathForBaseName:baseName]
+                                          error:NULL];
+}
+
+- (void)addFileOperationWithSelector:(SEL)sel object:(id)obj {
+  NSInvocationOperation *op;
+  op = [[[NSInvocationOperation alloc] initWithTarget:self
+                                             selector:sel
+                                               object:obj] autorelease];
+  [fileQueue_ addOperation:op];
+}
+
+#pragma mark -
+
+- (void)removeResponseForKey:(NSString *)key {
+  NSDictionary *entry = [entries_ objectForKey:key];
+  if (entry == nil) return;
+
+  totalByteCount_ -= [[entry objectForKey:kResponseCacheLengthKey] unsignedIntegerValue];
+
+  [[key retain] autorelease];
+  [entries_ removeObjectForKey:key];
+  [keysByLastUse_ removeObject:key];
+  [pendingData_ removeObjectForKey:key];
+
+  [self addFileOperationWithSelector:@selector(removeFilesWithBaseName:)
+                              object:[self baseNameForKey:key]];
+}
+
+- (void)evictResponsesToFitByteCount:(NSUInteger)byteCount {
+  while (totalByteCount_ + byteCount > capacity_
+         && [keysByLastUse_ count] > 0) {
+    [self removeResponseForKey:[keysByLastUse_ objectAtIndex:0]];
+  }
+}
+
+- (NSString *)directory {
+  return directory_;
+}
+
+- (NSUInteger)capacity {
+  @synchronized(self) {
+    return capacity_;
+  }
+}
+
+- (void)setCapacity:(NSUInteger)totalBytes {
+  @synchronized(self) {
+    capacity_ = totalBytes;
+    [self evictResponsesToFitByteCount:0];
+  }
+}
+
+- (NSDictionary *)validatorsForKey:(NSString *)key {
+  @synchronized(self) {
+    return [[[entries_ objectForKey:key] retain] autorelease];
+  }
+}
+
+- (NSData *)dataOfResponseForKey:(NSString *)key
+                            ETag:(NSString *)etag
+                    lastModified:(NSString *)lastModified {
+  @synchronized(self) {
+    NSMutableDictionary *entry = [entries_ objectForKey:key];
+    if (entry == nil) return nil;
+
+    // the response is valid only if the validators sent were its own
+    NSString *cachedETag = [entry objectForKey:kResponseCacheETagKey];
+    NSString *cachedLastModified = [entry objectForKey:kResponseCacheLastModifiedKey];
+    BOOL isRevalidated;
+    if (cachedETag != nil) {
+      isRevalidated = [etag isEqual:cachedETag];
+    } else {
+      isRevalidated = (etag == nil && [lastModified isEqual:cachedLastModified]);
+    }
+    if (!isRevalidated) return nil;
+
+    [entry setObject:[NSDate date] forKey:kResponseCacheLastUseKey];
+    [keysByLastUse_ removeObject:key];
+    [keysByLastUse_ addObject:key];
+
+    // a response still being written is kept in memory
+    NSData *data = [pendingData_ objectForKey:key];
+    if (data != nil) {
+      return [[data retain] autorelease];
+    }
+
+    // the file is read now, before a later removal of the response is queued;
+    // a mapped file stays readable after it is removed
+    NSString *baseName = [self baseNameForKey:key];
+    data = [NSData dataWithContentsOfFile:[self dataPathForBaseName:baseName]
+                                  options:NSDataReadingMappedIfSafe
+                                    error:NULL];
+    if (data == nil) {
+      [self removeResponseForKey:key];
+      return nil;
+    }
+
+    [self addFileOperationWithSelector:@selector(touchFileWithBaseName:)
+                                object:baseName];
+    return data;
+  }
+}
+
+- (void)storeResponseData:(NSData *)data
+                     ETag:(NSString *)etag
+             lastModified:(NSString *)lastModified
+                   forKey:(NSString *)key {
+  @synchronized(self) {
+    [self removeResponseForKey:key];
+
+    NSUInteger byteCount = [data length];
+    if (byteCount > capacity_) return;
+
+    [self evictResponsesToFitByteCount:byteCount];
+
+    NSMutableDictionary *metadata = [NSMutableDictionary dictionary];
+    [metadata setObject:key forKey:kResponseCacheKeyKey];
+    [metadata setObject:[NSNumber numberWithUnsignedInteger:byteCount]
+                 forKey:kResponseCacheLengthKey];
+    if (etag) {
+      [metadata setObject:etag forKey:kResponseCacheETagKey];
+    }
+    if (lastModified) {
+      [metadata setObject:lastModified forKey:kResponseCacheLastModifiedKey];
+    }
+
+    NSMutableDictionary *entry = [NSMutableDictionary dictionaryWithDictionary:metadata];
+    [entry setObject:[NSDate date] forKey:kResponseCacheLastUseKey];
+    [entries_ setObject:entry forKey:key];
+    [keysByLastUse_ addObject:key];
+    [pendingData_ setObject:data forKey:key];
+    totalByteCount_ += byteCount;
+
+    NSDictionary *response = [NSDictionary dictionaryWithObjectsAndKeys:
+                              [self baseNameForKey:key], @"baseName",
+                              data, @"data",
+                              metadata, @"metadata",
+                              nil];
+    [self addFileOperationWithSelector:@selector(writeResponse:)
+                                object:response];
+  }
+}
+
+- (void)removeAllResponses {
+  @synchronized(self) {
+    while ([keysByLastUse_ count] > 0) {
+      [self removeResponseForKey:[keysByLastUse_ objectAtIndex:0]];
+    }
+  }
+}
+
+@end
@@ -190,6 +190,15 @@ typedef void *GDataServiceGoogleEntryBaseCompletionHandler;
                                          delegate:(id)delegate
                                 didFinishSelector:(SEL)finishedSelector;
 
+// update only the fields of an entry that differ from its original version,
+// with a PATCH request conditional on the original's ETag; see
+// -[GDataEntryBase patchEntryWithChangesFromEntry:].  If no fields differ,
+// this returns nil and does not call back.
+- (GDataServiceTicket *)fetchEntryByPatchingEntry:(GDataEntryBase *)changedEntry
+                                    originalEntry:(GDataEntryBase *)originalEntry
+                                         delegate:(id)delegate
+                                didFinishSelector:(SEL)finishedSelector;
+
 // delete an entry, authenticated
 // (on success, callback will have nil object and error pointers)
 - (GDataServiceTicket *)deleteEntry:(GDataEntryBase *)entryToDelete
@@ -244,6 +253,12 @@ typedef void *GDataServiceGoogleEntryBaseCompletionHandler;
                                       forEntryURL:(NSURL *)entryURL
                                 completionHandler:(void (^)(GDataServiceTicket *ticket, GDataEntryBase *entry, NSError *error))handler;
 
+// update only the fields of an entry that differ from its original version;
+// if no fields differ, this returns nil and does not call back
+- (GDataServiceTicket *)fetchEntryByPatchingEntry:(GDataEntryBase *)changedEntry
+                                    originalEntry:(GDataEntryBase *)originalEntry
+                                completionHandler:(void (^)(GDataServiceTicket *ticket, GDataEntryBase *entry, NSError *error))handler;
+
 // delete an entry, authenticated
 // (on success, callback will have receive nil pointers for both object and error)
 - (GDataServiceTicket *)deleteEntry:(GDataEntryBase *)entryToDelete
@@ -62,6 +62,10 @@ enum {
                                         ticket:(GDataServiceTicketBase *)ticket;
 @end
 
+@interface GDataServiceTicketBase (ProtectedMethods)
+- (BOOL)isSharingFetch;
+@end
+
 @interface GDataServiceGoogle (PrivateMethods)
 - (GTMBridgeFetcher *)authenticationFetcher;
 - (NSError *)cannotCreateAuthFetcherError;
@@ -876,6 +880,23 @@ enum {
                              completionHandler:NULL];
 }
 
+- (GDataServiceTicket *)fetchEntryByPatchingEntry:(GDataEntryBase *)changedEntry
+                                    originalEntry:(GDataEntryBase *)originalEntry
+                                         delegate:(id)delegate
+                                didFinishSelector:(SEL)finishedSelector {
+
+  GDataEntryBase *patch = [changedEntry patchEntryWithChangesFromEntry:originalEntry];
+  if (patch == nil) return nil;
+
+  // the patch has only the changed fields, so the URL is from the original
+  NSURL *editURL = [[originalEntry editLink] URL];
+
+  return [self fetchEntryByUpdatingEntry:patch
+                             forEntryURL:editURL
+                                delegate:delegate
+                       didFinishSelector:finishedSelector];
+}
+
 - (GDataServiceTicket *)deleteEntry:(GDataEntryBase *)entryToDelete
                            delegate:(id)delegate
                   didFinishSelector:(SEL)finishedSelector {
@@ -1043,6 +1064,21 @@ enum {
                              completionHandler:(GDataServiceGoogleCompletionHandler)handler];
 }
 
+- (GDataServiceTicket *)fetchEntryByPatchingEntry:(GDataEntryBase *)changedEntry
+                                    originalEntry:(GDataEntryBase *)originalEntry
+                                completionHandler:(GDataServiceGoogleEntryBaseCompletionHandler)handler {
+
+  GDataEntryBase *patch = [changedEntry patchEntryWithChangesFromEntry:originalEntry];
+  if (patch == nil) return nil;
+
+  // the patch has only the changed fields, so the URL is from the original
+  NSURL *editURL = [[originalEntry editLink] URL];
+
+  return [self fetchEntryByUpdatingEntry:patch
+                             forEntryURL:editURL
+                       completionHandler:handler];
+}
+
 - (GDataServiceTicket *)deleteEntry:(GDataEntryBase *)entryToDelete
                   completionHandler:(void (^)(GDataServiceTicket *ticket, id nilObject, NSError *error))handler {
   NSString *etag = [entryToDelete ETag];
@@ -1382,8 +1418,11 @@ enum {
 }
 
 - (void)cancelTicket {
-  GDataServiceGoogle *service = [self service];
-  [service stopAuthenticationForTicket:self];
+  // a fetch shared with coalesced tickets is reauthenticated for their sake
+  if (![self isSharingFetch]) {
+    GDataServiceGoogle *service = [self service];
+    [service stopAuthenticationForTicket:self];
+  }
 
   [super cancelTicket];
 }
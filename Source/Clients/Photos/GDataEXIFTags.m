@@ -114,6 +114,11 @@
 }
 #endif
 
++ (BOOL)canCacheXMLElement {
+  // the XML is made only from the state kept by GDataObject
+  return [self hasXMLElementOfClass:[GDataEXIFTags class]];
+}
+
 - (NSXMLElement *)XMLElement {
 
   NSXMLElement *element = [self XMLElementWithExtensionsAndDefaultName:@"exif:tags"];
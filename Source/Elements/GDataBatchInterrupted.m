@@ -42,11 +42,14 @@ static NSString* const kContentTypeAttr = @"content-type";
 - (void)addParseDeclarations {
 
   NSArray *attrs = [NSArray arrayWithObjects:
-                    kReasonAttr, kSuccessAttr, kFailuresAttr, kParsedAttr,
-                    kContentTypeAttr, nil];
-
+                    kReasonAttr, kContentTypeAttr, nil];
   [self addLocalAttributeDeclarations:attrs];
 
+  NSArray *intAttrs = [NSArray arrayWithObjects:
+                       kSuccessAttr, kFailuresAttr, kParsedAttr, nil];
+  [self addLocalAttributeDeclarations:intAttrs
+                               ofType:kGDataAttributeTypeInt];
+
   [self addContentValueDeclaration];
 }
 
@@ -42,10 +42,12 @@ static NSString *const kContentTypeAttr = @"content-type";
 - (void)addParseDeclarations {
 
   NSArray *attrs = [NSArray arrayWithObjects:
-                    kCodeAttr, kReasonAttr, kContentTypeAttr, nil];
-
+                    kReasonAttr, kContentTypeAttr, nil];
   [self addLocalAttributeDeclarations:attrs];
 
+  [self addLocalAttributeDeclarations:[NSArray arrayWithObject:kCodeAttr]
+                               ofType:kGDataAttributeTypeInt];
+
   [self addContentValueDeclaration];
 }
 
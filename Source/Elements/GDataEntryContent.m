@@ -134,14 +134,23 @@ static BOOL IsTypeEqualToText(NSString *str) {
   [super dealloc];
 }
 
++ (BOOL)canCacheXMLElement {
+  // setChildObject: notes the change to the XML
+  return [self hasXMLElementOfClass:[GDataEntryContent class]];
+}
+
+- (NSArray *)childObjectsOutsideExtensions {
+  GDataObject *obj = [self childObject];
+  return (obj ? [NSArray arrayWithObject:obj] : nil);
+}
+
 - (NSXMLElement *)XMLElement {
 
   NSXMLElement *element = [self XMLElementWithExtensionsAndDefaultName:nil];
 
   GDataObject *obj = [self childObject];
   if (obj) {
-    NSXMLElement *elem = [obj XMLElement];
-    [element addChild:elem];
+    [self addToElement:element XMLElementForObject:obj];
   }
 
   return element;
@@ -249,6 +258,7 @@ static BOOL IsTypeEqualToText(NSString *str) {
 - (void)setChildObject:(GDataObject *)obj {
   [childObject_ autorelease];
   childObject_ = [obj retain];
+  [self noteXMLChange];
 }
 
 - (NSArray *)XMLValues {
@@ -93,12 +93,21 @@ static NSString* const kRelAttr = @"rel";
 }
 #endif
 
++ (BOOL)canCacheXMLElement {
+  // setEntry: notes the change to the XML
+  return [self hasXMLElementOfClass:[GDataEntryLink class]];
+}
+
+- (NSArray *)childObjectsOutsideExtensions {
+  return (entry_ ? [NSArray arrayWithObject:entry_] : nil);
+}
+
 - (NSXMLElement *)XMLElement {
 
   NSXMLElement *element = [self XMLElementWithExtensionsAndDefaultName:nil];
 
   if ([self entry]) {
-    [element addChild:[entry_ XMLElement]];
+    [self addToElement:element XMLElementForObject:entry_];
   }
   return element;
 }
@@ -136,6 +145,7 @@ static NSString* const kRelAttr = @"rel";
 - (void)setEntry:(GDataEntryBase *)entry {
   [entry_ autorelease];
   entry_ = [entry retain];
+  [self noteXMLChange];
 }
 
 @end
@@ -38,10 +38,14 @@ static NSString *const kCountHintAttr = @"countHint";
 
 - (void)addParseDeclarations {
 
-  NSArray *attrs = [NSArray arrayWithObjects:
-                    kHrefAttr, kRelAttr, KReadOnlyAttr, kCountHintAttr, nil];
-
+  NSArray *attrs = [NSArray arrayWithObjects:kHrefAttr, kRelAttr, nil];
   [self addLocalAttributeDeclarations:attrs];
+
+  [self addLocalAttributeDeclarations:[NSArray arrayWithObject:KReadOnlyAttr]
+                               ofType:kGDataAttributeTypeBool];
+
+  [self addLocalAttributeDeclarations:[NSArray arrayWithObject:kCountHintAttr]
+                               ofType:kGDataAttributeTypeInt];
 }
 
 + (id)feedLinkWithHref:(NSString *)href
@@ -103,12 +107,23 @@ static NSString *const kCountHintAttr = @"countHint";
 }
 #endif
 
++ (BOOL)canCacheXMLElement {
+  // setFeed: notes the change to the XML, though a link containing a feed
+  // is not cached since feeds aren't
+  return [self hasXMLElementOfClass:[GDataFeedLink class]];
+}
+
+- (NSArray *)childObjectsOutsideExtensions {
+  GDataFeedBase *feed = [self feed];
+  return (feed ? [NSArray arrayWithObject:feed] : nil);
+}
+
 - (NSXMLElement *)XMLElement {
 
   NSXMLElement *element = [self XMLElementWithExtensionsAndDefaultName:nil];
 
   if ([self feed]) {
-    [element addChild:[[self feed] XMLElement]];
+    [self addToElement:element XMLElementForObject:[self feed]];
   }
   return element;
 }
@@ -152,6 +167,7 @@ static NSString *const kCountHintAttr = @"countHint";
 - (void)setFeed:(GDataFeedBase *)feed {
   [feed_ autorelease];
   feed_ = [feed retain];
+  [self noteXMLChange];
 }
 
 // convenience method
@@ -117,6 +117,12 @@
 }
 #endif
 
++ (BOOL)canCacheXMLElement {
+  // the setters note changes to the XML; the time is treated as a value,
+  // so changing it requires calling setTime:
+  return [self hasXMLElementOfClass:[GDataGeoPt class]];
+}
+
 - (NSXMLElement *)XMLElement {
 
   NSXMLElement *element = [self XMLElementWithExtensionsAndDefaultName:@"gd:geoPt"];
@@ -137,6 +143,7 @@
 - (void)setLabel:(NSString *)str {
   [label_ autorelease];
   label_ = [str copy];
+  [self noteXMLChange];
 }
 
 - (NSNumber *)lat {
@@ -146,6 +153,7 @@
 - (void)setLat:(NSNumber *)num {
   [lat_ autorelease];
   lat_ = [num copy];
+  [self noteXMLChange];
 }
 
 - (NSNumber *)lon {
@@ -155,6 +163,7 @@
 - (void)setLon:(NSNumber *)num {
   [lon_ autorelease];
   lon_ = [num copy];
+  [self noteXMLChange];
 }
 
 - (NSNumber *)elev {
@@ -164,6 +173,7 @@
 - (void)setElev:(NSNumber *)num {
   [elev_ autorelease];
   elev_ = [num copy];
+  [self noteXMLChange];
 }
 
 - (GDataDateTime *)time {
@@ -173,6 +183,7 @@
 - (void)setTime:(GDataDateTime *)cdate {
   [time_ autorelease];
   time_ = [cdate retain];
+  [self noteXMLChange];
 }
 
 @end
@@ -51,11 +51,15 @@ static NSString* const kNumRatersAttr = @"numRaters";
 }
 
 - (void)addParseDeclarations {
-  NSArray *attrs = [NSArray arrayWithObjects:
-                    kRelAttr, kValueAttr, kMaxAttr, kMinAttr,
-                    kAverageAttr, kNumRatersAttr, nil];
+  [self addLocalAttributeDeclarations:[NSArray arrayWithObject:kRelAttr]];
 
-  [self addLocalAttributeDeclarations:attrs];
+  NSArray *intAttrs = [NSArray arrayWithObjects:
+                       kValueAttr, kMaxAttr, kMinAttr, kNumRatersAttr, nil];
+  [self addLocalAttributeDeclarations:intAttrs
+                               ofType:kGDataAttributeTypeInt];
+
+  [self addLocalAttributeDeclarations:[NSArray arrayWithObject:kAverageAttr]
+                               ofType:kGDataAttributeTypeDouble];
 }
 
 #pragma mark -
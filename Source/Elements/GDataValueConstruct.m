@@ -124,8 +124,16 @@
 }
 
 // subclass value utilities
+//
+// values kept in attributes use the attribute's parsed value, which is
+// kept until the attribute changes
 
 - (int)intValue {
+  NSString *attrName = [self attributeName];
+  if (attrName != nil) {
+    return [[self intNumberForAttribute:attrName] intValue];
+  }
+
   NSString *str = [self stringValue];
   if (str) {
     int result;
@@ -147,6 +155,11 @@
 }
 
 - (long long)longLongValue {
+  NSString *attrName = [self attributeName];
+  if (attrName != nil) {
+    return [[self longLongNumberForAttribute:attrName] longLongValue];
+  }
+
   NSString *str = [self stringValue];
   if (str) {
     long long result;
@@ -174,8 +187,14 @@
 }
 
 - (NSNumber *)doubleNumberValue {
-  NSString *str = [self stringValue];
-  NSNumber *num = [GDataUtilities doubleNumberOrInfForString:str];
+  NSNumber *num;
+  NSString *attrName = [self attributeName];
+  if (attrName != nil) {
+    num = [self doubleNumberForAttribute:attrName];
+  } else {
+    NSString *str = [self stringValue];
+    num = [GDataUtilities doubleNumberOrInfForString:str];
+  }
   if (num != nil) return num;
 
   return [NSNumber numberWithDouble:0];
@@ -203,6 +222,11 @@
 }
 
 - (GDataDateTime *)dateTimeValue {
+  NSString *attrName = [self attributeName];
+  if (attrName != nil) {
+    return [self dateTimeForAttribute:attrName];
+  }
+
   NSString *str = [self stringValue];
   if ([str length] > 0) {
     GDataDateTime *dateTime = [GDataDateTime dateTimeWithRFC3339String:str];
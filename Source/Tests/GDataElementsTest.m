@@ -396,6 +396,16 @@ shouldWrapWithNamespaceAndEntry:(BOOL)shouldWrap {
     { @"unknownChildren.@count", @"2" },
     { @"", @"" },
 
+    // enough children that parsed children are found by position
+    { @"GDataComment", @"<gd:comments rel=\"http://schemas.google.com/g/2005#reviews\"> "
+      "<unk1/> <unk2/> <unk3/> <unk4/> <gd:feedLink href=\"http://example.com/\" /> "
+      "<unk5/> <unk6/> <unk7/> <unk8/> </gd:comments>" },
+    { @"feedLink.href", @"http://example.com/" },
+    { @"unknownChildren.0.XMLString", @"<unk1></unk1>" },
+    { @"unknownChildren.4.XMLString", @"<unk5></unk5>" },
+    { @"unknownChildren.@count", @"8" },
+    { @"", @"" },
+
     { @"GDataCustomProperty", @"<gd:customProperty name='milk' type='integer' "
       "unit='gallons' >5</gd:customProperty>" },
     { @"name", @"milk" },
@@ -24,7 +24,63 @@
 
 #import "GDataEntryCalendarEvent.h"
 #import "GDataEntryYouTubeVideo.h"
+#import "GDataXMLNode.h"
 
+// the cached elements themselves, which XMLElementUsingCache copies for
+// callers, show which generations were cache hits
+@interface GDataObject (CachedXMLTestMethods)
+- (NSXMLElement *)XMLElementUsingCacheInEpoch:(NSUInteger)epoch;
+@end
+
+// GDataEntryUnparseableTest fails to parse the entry with the identifier
+// set by the test, as if it were malformed
+@interface GDataEntryUnparseableTest : GDataEntryCalendarEvent
+@end
+
+static NSString *gUnparseableEntryIdentifier = nil;
+
+@implementation GDataEntryUnparseableTest
+- (id)initWithXMLElement:(NSXMLElement *)element
+                  parent:(GDataObject *)parent {
+  self = [super initWithXMLElement:element
+                            parent:parent];
+  if ([[self identifier] isEqual:gUnparseableEntryIdentifier]) {
+    [self release];
+    return nil;
+  }
+  return self;
+}
+@end
+
+
+// GDataEntryCountingTest counts the entries made of it, for tests of when
+// lazy feeds make their entries
+@interface GDataEntryCountingTest : GDataEntryCalendarEvent
++ (void)resetNumberOfEntriesMade;
++ (NSUInteger)numberOfEntriesMade;
+@end
+
+static NSUInteger gNumberOfCountingEntriesMade = 0;
+
+@implementation GDataEntryCountingTest
++ (void)resetNumberOfEntriesMade {
+  gNumberOfCountingEntriesMade = 0;
+}
+
++ (NSUInteger)numberOfEntriesMade {
+  return gNumberOfCountingEntriesMade;
+}
+
+- (id)initWithXMLElement:(NSXMLElement *)element
+                  parent:(GDataObject *)parent {
+  self = [super initWithXMLElement:element
+                            parent:parent];
+  if (self) {
+    ++gNumberOfCountingEntriesMade;
+  }
+  return self;
+}
+@end
 
 @implementation GDataFeedTest
 
@@ -1702,6 +1758,739 @@
   XCTAssertEqualObjects(titleType, @"text", @"testing an attribute in a detached entry");
 }
 
+- (void)testStreamedFeed {
+
+  // parse a feed with the streaming parser, and compare the entries and the
+  // feed-level elements to those from a conventional parse
+
+  NSData *data = [self calendarEventTestData];
+  GDataFeedBase *feed = [self calendarEventTestFeed];
+
+  NSMutableArray *streamedEntries = [NSMutableArray array];
+  NSError *error = nil;
+  GDataFeedBase *streamedFeed;
+  streamedFeed = [GDataFeedCalendarEvent feedWithStreamedData:data
+                                               serviceVersion:@"2.1"
+                                                   surrogates:nil
+                                         shouldIgnoreUnknowns:NO
+                                                 entryHandler:^(GDataEntryBase *entry, BOOL *stop) {
+    XCTAssertNil([entry parent], @"streamed entry has a parent");
+    [streamedEntries addObject:entry];
+  }
+                                                        error:&error];
+  XCTAssertNotNil(streamedFeed, @"streaming parse failed: %@", error);
+  XCTAssertEqualObjects([streamedFeed class], [feed class]);
+  XCTAssertEqual([[streamedFeed entries] count], (NSUInteger)0);
+  XCTAssertEqualObjects([streamedFeed title], [feed title]);
+  XCTAssertEqualObjects([streamedFeed links], [feed links]);
+
+  // the streamed entries declare their own namespaces, so compare their
+  // contents rather than the entry objects
+  XCTAssertEqualObjects([streamedEntries valueForKey:@"identifier"],
+                        [[feed entries] valueForKey:@"identifier"]);
+  XCTAssertEqualObjects([streamedEntries valueForKey:@"title"],
+                        [[feed entries] valueForKey:@"title"]);
+  XCTAssertEqualObjects([streamedEntries valueForKey:@"times"],
+                        [[feed entries] valueForKey:@"times"]);
+
+  // stopping from the handler ends the parse after the first entry
+  __block NSUInteger numberOfEntries = 0;
+  streamedFeed = [GDataFeedBase feedWithStreamedData:data
+                                      serviceVersion:@"2.1"
+                                          surrogates:nil
+                                shouldIgnoreUnknowns:NO
+                                        entryHandler:^(GDataEntryBase *entry, BOOL *stop) {
+    XCTAssertEqualObjects([entry class], [GDataEntryCalendarEvent class]);
+    ++numberOfEntries;
+    *stop = YES;
+  }
+                                               error:&error];
+  XCTAssertNotNil(streamedFeed, @"streaming parse failed: %@", error);
+  XCTAssertEqual(numberOfEntries, (NSUInteger)1);
+
+  // invalid XML fails
+  NSData *badData = [@"<feed><entry>" dataUsingEncoding:NSUTF8StringEncoding];
+  streamedFeed = [GDataFeedBase feedWithStreamedData:badData
+                                      serviceVersion:nil
+                                          surrogates:nil
+                                shouldIgnoreUnknowns:NO
+                                        entryHandler:^(GDataEntryBase *entry, BOOL *stop) {}
+                                               error:&error];
+  XCTAssertNil(streamedFeed);
+  XCTAssertNotNil(error);
+}
+
+- (void)testWriteXMLDocumentToStream {
+
+  // write a feed to a stream, and compare the feed parsed from that
+  // to the original
+  GDataFeedBase *feed = [self calendarEventTestFeed];
+
+  NSOutputStream *stream = [NSOutputStream outputStreamToMemory];
+  [stream open];
+  NSError *error = nil;
+  BOOL didWrite = [feed writeXMLDocumentToStream:stream error:&error];
+  XCTAssertTrue(didWrite, @"writing failed: %@", error);
+  NSData *writtenData = [stream propertyForKey:NSStreamDataWrittenToMemoryStreamKey];
+  [stream close];
+
+  GDataFeedBase *writtenFeed = [[[GDataFeedCalendarEvent alloc] initWithData:writtenData
+                                                              serviceVersion:@"2.1"
+                                                        shouldIgnoreUnknowns:NO] autorelease];
+  XCTAssertNotNil(writtenFeed);
+  XCTAssertEqualObjects([writtenFeed title], [feed title]);
+  XCTAssertEqualObjects([[writtenFeed entries] valueForKey:@"identifier"],
+                        [[feed entries] valueForKey:@"identifier"]);
+  XCTAssertEqualObjects([[writtenFeed entries] valueForKey:@"times"],
+                        [[feed entries] valueForKey:@"times"]);
+
+  // the written text is the same as the text of the feed's document
+  NSData *documentData = [[feed XMLDocument] XMLData];
+  GDataFeedBase *documentFeed = [[[GDataFeedCalendarEvent alloc] initWithData:documentData
+                                                               serviceVersion:@"2.1"
+                                                         shouldIgnoreUnknowns:NO] autorelease];
+  XCTAssertEqualObjects([[writtenFeed entries] valueForKey:@"title"],
+                        [[documentFeed entries] valueForKey:@"title"]);
+
+  // writing without the caches, as on another thread, writes the same text
+  [feed setShouldCacheXMLElements:YES];
+  NSOutputStream *cachedStream = [NSOutputStream outputStreamToMemory];
+  [cachedStream open];
+  XCTAssertTrue([feed writeXMLDocumentToStream:cachedStream
+                                    usingCache:YES
+                                         error:&error]);
+  NSOutputStream *uncachedStream = [NSOutputStream outputStreamToMemory];
+  [uncachedStream open];
+  XCTAssertTrue([feed writeXMLDocumentToStream:uncachedStream
+                                    usingCache:NO
+                                         error:&error]);
+  XCTAssertEqualObjects([uncachedStream propertyForKey:NSStreamDataWrittenToMemoryStreamKey],
+                        [cachedStream propertyForKey:NSStreamDataWrittenToMemoryStreamKey]);
+  [cachedStream close];
+  [uncachedStream close];
+}
+
+- (void)testFeedFromFile {
+
+  NSBundle *testBundle = [NSBundle bundleForClass:[self class]];
+  NSString *path = [[testBundle resourcePath]
+                    stringByAppendingPathComponent:@"FeedCalendarEventTest1.xml"];
+
+  NSError *error = nil;
+  GDataFeedBase *fileFeed = [GDataFeedCalendarEvent feedWithContentsOfFile:path
+                                                            serviceVersion:@"2.1"
+                                                      shouldIgnoreUnknowns:NO
+                                                                     error:&error];
+  XCTAssertNotNil(fileFeed, @"file parse failed: %@", error);
+
+  GDataFeedBase *dataFeed = [self calendarEventTestFeed];
+  XCTAssertEqualObjects(fileFeed, dataFeed);
+
+  GDataXMLDocument *doc = [[[GDataXMLDocument alloc] initWithContentsOfFile:path
+                                                                    options:0
+                                                                      error:&error] autorelease];
+  XCTAssertEqualObjects([[doc rootElement] localName], @"feed", @"%@", error);
+
+  // missing files fail with an error
+  error = nil;
+  fileFeed = [GDataFeedCalendarEvent feedWithContentsOfFile:@"/no/such/feed.xml"
+                                             serviceVersion:@"2.1"
+                                       shouldIgnoreUnknowns:NO
+                                                      error:&error];
+  XCTAssertNil(fileFeed);
+  XCTAssertNotNil(error);
+}
+
+- (void)testDetachedFeed {
+
+  GDataFeedBase *attachedFeed = [self calendarEventTestFeed];
+
+  // parse detached, and let the document be freed before using the feed
+  GDataFeedBase *detachedFeed;
+  @autoreleasepool {
+    NSXMLDocument *doc = [self calendarEventTestDocument];
+    detachedFeed = [[GDataFeedCalendarEvent alloc] initWithXMLElement:[doc rootElement]
+                                                               parent:nil
+                                                       serviceVersion:@"2.1"
+                                                           surrogates:nil
+                                                 shouldIgnoreUnknowns:NO
+                                          shouldDetachFromXMLDocument:YES];
+    [detachedFeed clearExtensionDeclarationsCache];
+  }
+  [detachedFeed autorelease];
+
+  XCTAssertTrue([detachedFeed shouldDetachFromXMLDocument]);
+
+  // the XML nodes the detached objects keep are still readable with their
+  // document gone
+  GDataEntryBase *detachedEntry = [detachedFeed firstEntry];
+  GDataEntryBase *attachedEntry = [attachedFeed firstEntry];
+  XCTAssertEqualObjects([[detachedEntry unknownChildren] valueForKey:@"XMLString"],
+                        [[attachedEntry unknownChildren] valueForKey:@"XMLString"]);
+  XCTAssertEqualObjects([[detachedEntry unknownAttributes] valueForKey:@"XMLString"],
+                        [[attachedEntry unknownAttributes] valueForKey:@"XMLString"]);
+  XCTAssertEqualObjects([[detachedFeed XMLElement] XMLString],
+                        [[attachedFeed XMLElement] XMLString]);
+}
+
+- (void)testLazyFeed {
+
+  GDataFeedBase *eagerFeed = [self calendarEventTestFeed];
+  NSUInteger numberOfEntries = [[eagerFeed entries] count];
+
+  // the surrogate entry class counts the entries made
+  NSXMLDocument *doc = [self calendarEventTestDocument];
+  NSDictionary *surrogates = [NSDictionary dictionaryWithObject:[GDataEntryCountingTest class]
+                                                         forKey:[GDataEntryCalendarEvent class]];
+  [GDataEntryCountingTest resetNumberOfEntriesMade];
+
+  GDataFeedBase *lazyFeed;
+  lazyFeed = [[[GDataFeedCalendarEvent alloc] initWithXMLElement:[doc rootElement]
+                                                          parent:nil
+                                                  serviceVersion:@"2.1"
+                                                      surrogates:surrogates
+                                            shouldIgnoreUnknowns:NO
+                                        shouldParseEntriesLazily:YES] autorelease];
+  XCTAssertTrue([lazyFeed shouldParseEntriesLazily]);
+  XCTAssertEqual([lazyFeed numberOfEntries], numberOfEntries);
+  XCTAssertEqual([GDataEntryCountingTest numberOfEntriesMade], (NSUInteger)0);
+
+  // lookups create only the entries they return, once
+  NSString *identifier = [[eagerFeed entryAtIndex:2] identifier];
+  GDataEntryBase *lazyEntry = [lazyFeed entryForIdentifier:identifier];
+  XCTAssertEqualObjects([lazyEntry identifier], identifier);
+  XCTAssertEqual([GDataEntryCountingTest numberOfEntriesMade], (NSUInteger)1);
+
+  XCTAssertTrue([lazyFeed entryAtIndex:2] == lazyEntry);
+  XCTAssertNil([lazyFeed entryForIdentifier:@"no such entry"]);
+  XCTAssertEqual([GDataEntryCountingTest numberOfEntriesMade], (NSUInteger)1);
+
+  XCTAssertEqualObjects([[lazyFeed firstEntry] identifier],
+                        [[eagerFeed firstEntry] identifier]);
+  XCTAssertEqual([GDataEntryCountingTest numberOfEntriesMade], (NSUInteger)2);
+
+  // a kind lookup creates just the entries of that kind, and enumeration
+  // creates the rest in order
+  NSString *kind = @"http://schemas.google.com/g/2005#event";
+  NSArray *kindEntries = [lazyFeed entriesWithCategoryKind:kind];
+  XCTAssertEqual([kindEntries count],
+                 [[eagerFeed entriesWithCategoryKind:kind] count]);
+  XCTAssertEqual([GDataEntryCountingTest numberOfEntriesMade], [kindEntries count]);
+
+  NSUInteger numberEnumerated = 0;
+  for (GDataEntryBase *entry in lazyFeed) {
+    XCTAssertEqualObjects([entry identifier],
+                          [[eagerFeed entryAtIndex:numberEnumerated] identifier]);
+    numberEnumerated++;
+  }
+  XCTAssertEqual(numberEnumerated, numberOfEntries);
+  XCTAssertEqual([GDataEntryCountingTest numberOfEntriesMade], numberOfEntries);
+
+  // once made, the entries are not made again
+  XCTAssertEqual([[lazyFeed entries] count], numberOfEntries);
+  XCTAssertEqual([GDataEntryCountingTest numberOfEntriesMade], numberOfEntries);
+}
+
+- (void)testLazyFeedDroppingEntries {
+
+  GDataFeedBase *eagerFeed = [self calendarEventTestFeed];
+  NSArray *eagerEntries = [eagerFeed entries];
+  NSUInteger numberOfEntries = [eagerEntries count];
+
+  NSXMLDocument *doc = [self calendarEventTestDocument];
+  NSDictionary *surrogates = [NSDictionary dictionaryWithObject:[GDataEntryUnparseableTest class]
+                                                         forKey:[GDataEntryCalendarEvent class]];
+  GDataFeedBase *lazyFeed;
+  lazyFeed = [[[GDataFeedCalendarEvent alloc] initWithXMLElement:[doc rootElement]
+                                                          parent:nil
+                                                  serviceVersion:@"2.1"
+                                                      surrogates:surrogates
+                                            shouldIgnoreUnknowns:NO
+                                        shouldParseEntriesLazily:YES] autorelease];
+  XCTAssertEqual([lazyFeed numberOfEntries], numberOfEntries);
+
+  // the second entry fails to parse, so the third takes its index and the
+  // count drops
+  gUnparseableEntryIdentifier = [[eagerEntries objectAtIndex:1] identifier];
+  GDataEntryBase *secondEntry = [lazyFeed entryAtIndex:1];
+  gUnparseableEntryIdentifier = nil;
+
+  XCTAssertEqualObjects([secondEntry identifier],
+                        [[eagerEntries objectAtIndex:2] identifier]);
+  XCTAssertEqual([lazyFeed numberOfEntries], numberOfEntries - 1);
+
+  NSUInteger numberEnumerated = 0;
+  for (GDataEntryBase *entry in lazyFeed) {
+    XCTAssertTrue([lazyFeed entryAtIndex:numberEnumerated] == entry);
+    numberEnumerated++;
+  }
+  XCTAssertEqual(numberEnumerated, [lazyFeed numberOfEntries]);
+  XCTAssertEqual([[lazyFeed entries] count], numberOfEntries - 1);
+
+  // adding entries while enumerating is detected as a mutation
+  BOOL didDetectMutation = NO;
+  @try {
+    for (GDataEntryBase *entry in lazyFeed) {
+      [lazyFeed addEntryWithEntry:entry];
+    }
+  }
+  @catch (NSException *exc) {
+    didDetectMutation = YES;
+  }
+  XCTAssertTrue(didDetectMutation);
+}
+
+- (void)testParallelFeed {
+
+  // make a feed large enough to be parsed in parallel by repeating the
+  // test feed's entries
+  GDataFeedBase *smallFeed = [self calendarEventTestFeed];
+  NSArray *smallEntries = [smallFeed entries];
+
+  NSMutableArray *manyEntries = [NSMutableArray array];
+  while ([manyEntries count] < kGDataMinEntriesForParallelParse) {
+    [manyEntries addObjectsFromArray:smallEntries];
+  }
+  [smallFeed setEntriesWithEntries:manyEntries];
+
+  NSXMLDocument *doc = [[[NSXMLDocument alloc] initWithRootElement:[smallFeed XMLElement]] autorelease];
+  NSData *largeData = [doc XMLData];
+
+  GDataFeedBase *serialFeed = [[[GDataFeedCalendarEvent alloc] initWithData:largeData
+                                                             serviceVersion:@"2.1"
+                                                       shouldIgnoreUnknowns:NO] autorelease];
+
+  NSXMLDocument *largeDoc = [[[NSXMLDocument alloc] initWithData:largeData
+                                                         options:0
+                                                           error:NULL] autorelease];
+  GDataFeedBase *parallelFeed;
+  parallelFeed = [[[GDataFeedCalendarEvent alloc] initWithXMLElement:[largeDoc rootElement]
+                                                              parent:nil
+                                                      serviceVersion:@"2.1"
+                                                          surrogates:nil
+                                                shouldIgnoreUnknowns:NO
+                                         shouldDetachFromXMLDocument:NO
+                                        shouldParseEntriesInParallel:YES] autorelease];
+  XCTAssertTrue([parallelFeed shouldParseEntriesInParallel]);
+
+  // the entries parsed in parallel keep the document's order, and belong
+  // to the feed
+  NSArray *parallelEntries = [parallelFeed entries];
+  XCTAssertEqual([parallelEntries count], [manyEntries count]);
+  XCTAssertEqualObjects([parallelEntries valueForKey:@"identifier"],
+                        [manyEntries valueForKey:@"identifier"]);
+  XCTAssertEqualObjects(parallelEntries, [serialFeed entries]);
+
+  for (GDataEntryBase *entry in parallelFeed) {
+    XCTAssertTrue([entry parent] == parallelFeed);
+  }
+
+  // parse several feeds at once with a service version not yet used, so
+  // their entries make the shared declarations and parse plans while other
+  // threads are parsing
+  static const size_t kNumberOfFeeds = 4;
+  GDataFeedBase **coldFeeds = (GDataFeedBase **) calloc(kNumberOfFeeds,
+                                                        sizeof(GDataFeedBase *));
+  dispatch_queue_t queue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+  dispatch_apply(kNumberOfFeeds, queue, ^(size_t feedIndex) {
+    NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+    NSXMLDocument *feedDoc = [[[NSXMLDocument alloc] initWithData:largeData
+                                                          options:0
+                                                            error:NULL] autorelease];
+    coldFeeds[feedIndex] = [[GDataFeedCalendarEvent alloc] initWithXMLElement:[feedDoc rootElement]
+                                                                        parent:nil
+                                                                serviceVersion:@"2.1.0"
+                                                                    surrogates:nil
+                                                          shouldIgnoreUnknowns:NO
+                                                   shouldDetachFromXMLDocument:YES
+                                                  shouldParseEntriesInParallel:YES];
+    [pool drain];
+  });
+
+  NSString *serialXML = [[serialFeed XMLElement] XMLString];
+  for (size_t feedIndex = 0; feedIndex < kNumberOfFeeds; feedIndex++) {
+    GDataFeedBase *coldFeed = [coldFeeds[feedIndex] autorelease];
+    XCTAssertEqual([[coldFeed entries] count], [manyEntries count]);
+    XCTAssertEqualObjects([[coldFeed XMLElement] XMLString], serialXML);
+  }
+  free(coldFeeds);
+}
+
+- (void)testParseProjection {
+
+  NSSet *projection = [GDataObject parseProjectionWithFieldSelection:
+                       @"@gd:etag,id,entry(id, title ,link[@rel='alternate'](@href))"];
+  NSSet *expected = [NSSet setWithObjects:@"id", @"entry", @"title", @"link", nil];
+  XCTAssertEqualObjects(projection, expected);
+
+  GDataFeedBase *fullFeed = [self calendarEventTestFeed];
+
+  NSXMLDocument *doc = [self calendarEventTestDocument];
+  GDataFeedBase *projectedFeed;
+  projectedFeed = [[[GDataFeedCalendarEvent alloc] initWithXMLElement:[doc rootElement]
+                                                               parent:nil
+                                                       serviceVersion:@"2.1"
+                                                           surrogates:nil
+                                                      parseProjection:projection
+                                                 shouldIgnoreUnknowns:NO
+                                          shouldDetachFromXMLDocument:NO] autorelease];
+  XCTAssertEqualObjects([projectedFeed parseProjection], projection);
+  XCTAssertEqual([[projectedFeed entries] count], [[fullFeed entries] count]);
+
+  GDataEntryBase *fullEntry = [fullFeed firstEntry];
+  GDataEntryBase *projectedEntry = [projectedFeed firstEntry];
+  XCTAssertEqualObjects([projectedEntry identifier], [fullEntry identifier]);
+  XCTAssertEqualObjects([projectedEntry title], [fullEntry title]);
+  XCTAssertEqualObjects([projectedEntry links], [fullEntry links]);
+  XCTAssertNotNil([fullEntry updatedDate]);
+  XCTAssertNil([projectedEntry updatedDate]);
+  XCTAssertNotNil([fullEntry content]);
+  XCTAssertNil([projectedEntry content]);
+  XCTAssertNotNil([(GDataEntryCalendarEvent *)fullEntry times]);
+  XCTAssertNil([(GDataEntryCalendarEvent *)projectedEntry times]);
+
+  // the skipped elements are kept as unknowns, and the projected ones are not
+  NSSet *unknownNames = [NSSet setWithArray:[[projectedEntry unknownChildren] valueForKey:@"localName"]];
+  XCTAssertTrue([unknownNames containsObject:@"updated"]);
+  XCTAssertTrue([unknownNames containsObject:@"content"]);
+  XCTAssertTrue([unknownNames containsObject:@"when"]);
+  XCTAssertFalse([unknownNames containsObject:@"id"]);
+  XCTAssertFalse([unknownNames containsObject:@"title"]);
+  XCTAssertFalse([unknownNames containsObject:@"link"]);
+}
+
+- (void)testConcurrentParsesShareParsePlans {
+
+  // parses on several threads at once use the same shared declarations and
+  // parse plans, and must produce the same objects as a serial parse
+  NSData *data = [self calendarEventTestData];
+  GDataFeedBase *serialFeed = [self calendarEventTestFeed];
+
+  const size_t kNumberOfParses = 8;
+  __block volatile int32_t numberOfMismatches = 0;
+  dispatch_queue_t queue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+  dispatch_apply(kNumberOfParses, queue, ^(size_t idx) {
+    @autoreleasepool {
+      GDataFeedBase *feed = [[[GDataFeedCalendarEvent alloc] initWithData:data
+                                                           serviceVersion:@"2.1"
+                                                     shouldIgnoreUnknowns:NO] autorelease];
+      if (![feed isEqual:serialFeed]) {
+        __sync_fetch_and_add(&numberOfMismatches, 1);
+      }
+    }
+  });
+  XCTAssertEqual(numberOfMismatches, 0);
+}
+
+- (void)testEntryHashes {
+
+  GDataFeedBase *feed = [self calendarEventTestFeed];
+  NSArray *entries = [feed entries];
+  XCTAssertTrue([entries count] > 1);
+
+  // equal objects have equal hashes, so sets of copies remove the duplicates
+  NSArray *copies = [GDataUtilities arrayWithCopiesOfObjectsInArray:entries];
+  for (NSUInteger idx = 0; idx < [entries count]; idx++) {
+    GDataEntryBase *entry = [entries objectAtIndex:idx];
+    GDataEntryBase *entryCopy = [copies objectAtIndex:idx];
+    XCTAssertEqualObjects(entry, entryCopy);
+    XCTAssertEqual([entry hash], [entryCopy hash]);
+  }
+
+  NSMutableSet *set = [NSMutableSet setWithArray:entries];
+  [set addObjectsFromArray:copies];
+  XCTAssertEqual([set count], [[NSSet setWithArray:entries] count]);
+
+  // changing an extension of a copy changes the memoized hash of the copy
+  GDataEntryBase *firstEntry = [entries objectAtIndex:0];
+  GDataEntryBase *firstCopy = [copies objectAtIndex:0];
+  NSUInteger previousHash = [firstCopy hash];
+  [[firstCopy title] setStringValue:@"a different title"];
+  XCTAssertNotEqual([firstCopy hash], previousHash);
+  XCTAssertFalse([firstCopy isEqual:firstEntry]);
+
+  // the unchanged objects keep their memoized hashes after the change
+  GDataEntryBase *lastEntry = [entries lastObject];
+  GDataEntryBase *lastCopy = [copies lastObject];
+  XCTAssertEqual([lastEntry hash], [lastCopy hash]);
+
+  // kept child XML elements changed in place leave equal objects with equal
+  // hashes
+  NSXMLElement *childElement = [NSXMLNode elementWithName:@"child"];
+  GDataExtendedProperty *property = [GDataExtendedProperty propertyWithName:@"name"
+                                                                      value:nil];
+  [property addXMLValue:childElement];
+  GDataExtendedProperty *propertyCopy = [[property copy] autorelease];
+  (void) [property hash];
+
+  NSXMLElement *keptElement = [[property XMLValues] lastObject];
+  [keptElement addChild:[NSXMLNode elementWithName:@"grandchild"]];
+  [[[propertyCopy XMLValues] lastObject] addChild:[NSXMLNode elementWithName:@"grandchild"]];
+  XCTAssertEqualObjects(property, propertyCopy);
+  XCTAssertEqual([property hash], [propertyCopy hash]);
+}
+
+- (void)testCachedXMLElements {
+
+  GDataFeedBase *feed = [self calendarEventTestFeed];
+  GDataEntryBase *entry = [feed firstEntry];
+  [entry setShouldCacheXMLElements:YES];
+
+  // an unchanged entry generates its XML once
+  NSXMLElement *cachedElement = [[[entry XMLElementUsingCacheInEpoch:0] retain] autorelease];
+#if GDATA_USES_LIBXML
+  XCTAssertTrue([entry XMLElementUsingCacheInEpoch:0] == cachedElement);
+#endif
+  [[entry title] setStringValue:[[entry title] stringValue]];
+  XCTAssertTrue([entry XMLElementUsingCacheInEpoch:0] != cachedElement);
+
+  // callers get their own copies of the cached element, so changing one
+  // leaves the cache unchanged
+  NSXMLElement *callersElement = [entry XMLElementUsingCache];
+  NSString *callersXML = [callersElement XMLString];
+  [callersElement addChild:[NSXMLNode elementWithName:@"callersChild"]];
+  XCTAssertEqualObjects([[entry XMLElementUsingCache] XMLString], callersXML);
+
+  // the cached XML matches freshly generated XML before and after changes to
+  // the entry and to its child objects
+  NSString *cachedXML = [[[entry XMLDocument] rootElement] XMLString];
+  XCTAssertEqualObjects(cachedXML, [[entry XMLElement] XMLString]);
+
+  [[entry title] setStringValue:@"changed title"];
+  cachedXML = [[[entry XMLDocument] rootElement] XMLString];
+  XCTAssertEqualObjects(cachedXML, [[entry XMLElement] XMLString]);
+  XCTAssertTrue([cachedXML rangeOfString:@"changed title"].location != NSNotFound);
+
+  [entry addLink:[GDataLink linkWithRel:@"related"
+                                   type:nil
+                                   href:@"http://example.com/"]];
+  cachedXML = [[[entry XMLDocument] rootElement] XMLString];
+  XCTAssertEqualObjects(cachedXML, [[entry XMLElement] XMLString]);
+  XCTAssertTrue([cachedXML rangeOfString:@"http://example.com/"].location != NSNotFound);
+
+  [[[entry links] lastObject] setHref:@"http://example.com/changed"];
+  cachedXML = [[[entry XMLDocument] rootElement] XMLString];
+  XCTAssertEqualObjects(cachedXML, [[entry XMLElement] XMLString]);
+  XCTAssertTrue([cachedXML rangeOfString:@"http://example.com/changed"].location != NSNotFound);
+
+  [entry setShouldCacheXMLElements:NO];
+  XCTAssertEqualObjects([[[entry XMLDocument] rootElement] XMLString], cachedXML);
+}
+
+- (void)testCachedXMLElementHits {
+
+  GDataFeedBase *feed = [self calendarEventTestFeed];
+  GDataEntryCalendarEvent *entry = (GDataEntryCalendarEvent *)[feed firstEntry];
+
+  // the content and the comments' feed link generate XML from their own
+  // instance variables, but stamp their changes, so the entry can be cached
+  GDataEntryContent *content = [entry content];
+  GDataFeedLink *feedLink = [[entry comment] feedLink];
+  XCTAssertNotNil(content);
+  XCTAssertNotNil(feedLink);
+
+  XCTAssertTrue([GDataEntryContent canCacheXMLElement]);
+  XCTAssertTrue([GDataFeedLink canCacheXMLElement]);
+  XCTAssertTrue([GDataEntryLink canCacheXMLElement]);
+  XCTAssertTrue([GDataGeoPt canCacheXMLElement]);
+  XCTAssertTrue([GDataEXIFTags canCacheXMLElement]);
+  XCTAssertTrue([[entry class] canCacheXMLElement]);
+  XCTAssertFalse([[feed class] canCacheXMLElement]);
+
+  NSXMLElement *element = [[[entry XMLElementUsingCacheInEpoch:0] retain] autorelease];
+  NSString *xml = [element XMLString];
+  XCTAssertEqualObjects([[entry XMLElement] XMLString], xml);
+#if GDATA_USES_LIBXML
+  // with libxml, a cache hit returns the cached element itself to the
+  // objects generating XML
+  XCTAssertTrue([entry XMLElementUsingCacheInEpoch:0] == element);
+  XCTAssertTrue([content XMLElementUsingCacheInEpoch:0] == [content XMLElementUsingCacheInEpoch:0]);
+#endif
+
+  // a change to the content replaces the entry's element
+  [content setStringValue:@"changed content"];
+  NSXMLElement *changedElement = [[[entry XMLElementUsingCacheInEpoch:0] retain] autorelease];
+  XCTAssertTrue(changedElement != element);
+  XCTAssertTrue([[changedElement XMLString] rangeOfString:@"changed content"].location != NSNotFound);
+#if GDATA_USES_LIBXML
+  XCTAssertTrue([entry XMLElementUsingCacheInEpoch:0] == changedElement);
+#endif
+
+  // as does a change to the feed link
+  [feedLink setHref:@"http://example.com/comments"];
+  NSXMLElement *linkChangedElement = [entry XMLElementUsingCacheInEpoch:0];
+  XCTAssertTrue(linkChangedElement != changedElement);
+  XCTAssertTrue([[linkChangedElement XMLString] rangeOfString:@"http://example.com/comments"].location != NSNotFound);
+
+  // geoPt setters note their changes too
+  GDataGeoPt *geoPt = [GDataGeoPt geoPtWithLabel:@"Everest"
+                                             lat:[NSNumber numberWithDouble:27.98778]
+                                             lon:[NSNumber numberWithDouble:86.94444]
+                                            elev:nil
+                                            time:nil];
+  NSXMLElement *geoElement = [[[geoPt XMLElementUsingCacheInEpoch:0] retain] autorelease];
+#if GDATA_USES_LIBXML
+  XCTAssertTrue([geoPt XMLElementUsingCacheInEpoch:0] == geoElement);
+#endif
+  [geoPt setElev:[NSNumber numberWithDouble:8850.0]];
+  NSXMLElement *changedGeoElement = [geoPt XMLElementUsingCacheInEpoch:0];
+  XCTAssertTrue(changedGeoElement != geoElement);
+  XCTAssertEqualObjects([[changedGeoElement attributeForName:@"elev"] stringValue], @"8850");
+}
+
+- (void)testSnapshots {
+
+  GDataFeedBase *feed = [self calendarEventTestFeed];
+  NSXMLElement *unknownElement = [NSXMLNode elementWithName:@"unknownElement"
+                                                stringValue:@"unknown value"];
+  [[feed firstEntry] setUnknownChildren:[NSArray arrayWithObject:unknownElement]];
+
+  NSData *snapshot = [feed snapshotData];
+  XCTAssertTrue([snapshot length] > 0);
+
+  NSError *error = nil;
+  GDataFeedBase *restored = [GDataFeedBase objectWithSnapshotData:snapshot
+                                                             error:&error];
+  XCTAssertNil(error);
+  XCTAssertEqualObjects([restored class], [feed class]);
+  XCTAssertEqualObjects(restored, feed);
+  XCTAssertEqualObjects([restored serviceVersion], @"2.1");
+  XCTAssertEqual([[restored entries] count], [[feed entries] count]);
+  XCTAssertEqualObjects([[restored firstEntry] parent], restored);
+
+  NSArray *unknownChildren = [[restored firstEntry] unknownChildren];
+  XCTAssertEqual([unknownChildren count], (NSUInteger)1);
+  XCTAssertEqualObjects([[unknownChildren lastObject] XMLString],
+                        [unknownElement XMLString]);
+
+  // restoring requires the receiving class and valid data
+  XCTAssertNil([GDataEntryBase objectWithSnapshotData:snapshot error:&error]);
+  XCTAssertEqual([error code], (NSInteger)kGDataSnapshotInvalidDataError);
+
+  NSData *truncated = [snapshot subdataWithRange:NSMakeRange(0, [snapshot length] - 1)];
+  error = nil;
+  XCTAssertNil([GDataFeedBase objectWithSnapshotData:truncated error:&error]);
+  XCTAssertEqualObjects([error domain], kGDataSnapshotErrorDomain);
+
+  // trees nested too deeply are refused when restored
+  NSXMLElement *deepElement = [NSXMLNode elementWithName:@"deepElement"];
+  NSXMLElement *innermostElement = deepElement;
+  for (int idx = 0; idx < 300; idx++) {
+    NSXMLElement *child = [NSXMLNode elementWithName:@"deepElement"];
+    [innermostElement addChild:child];
+    innermostElement = child;
+  }
+  [[feed firstEntry] setUnknownChildren:[NSArray arrayWithObject:deepElement]];
+
+  NSData *deepSnapshot = [feed snapshotDataWithError:&error];
+  XCTAssertNotNil(deepSnapshot, @"%@", error);
+
+  error = nil;
+  XCTAssertNil([GDataFeedBase objectWithSnapshotData:deepSnapshot error:&error]);
+  XCTAssertEqual([error code], (NSInteger)kGDataSnapshotInvalidDataError);
+}
+
+- (void)testPatchEntries {
+
+  GDataFeedBase *feed = [self calendarEventTestFeed];
+  GDataEntryBase *originalEntry = [feed firstEntry];
+  [originalEntry setETag:@"\"original ETag\""];
+
+  GDataEntryBase *changedEntry = [[originalEntry copy] autorelease];
+  XCTAssertNil([changedEntry patchEntryWithChangesFromEntry:originalEntry]);
+
+  // only the changed field is in the patch, with the original's ETag
+  [changedEntry setTitleWithString:@"changed title"];
+  GDataEntryBase *patch = [changedEntry patchEntryWithChangesFromEntry:originalEntry];
+  XCTAssertEqualObjects([patch class], [changedEntry class]);
+  XCTAssertEqualObjects([patch fieldSelection], @"title");
+  XCTAssertEqualObjects([patch ETag], [originalEntry ETag]);
+  XCTAssertEqualObjects([[patch title] stringValue], @"changed title");
+  XCTAssertEqual([[patch links] count], (NSUInteger)0);
+
+  // removed fields are selected without elements
+  [changedEntry setTitle:nil];
+  patch = [changedEntry patchEntryWithChangesFromEntry:originalEntry];
+  XCTAssertEqualObjects([patch fieldSelection], @"title");
+  XCTAssertNil([patch title]);
+}
+
+- (void)testTypedAttributes {
+
+  NSString *xml = @"<gd:rating xmlns:gd='http://schemas.google.com/g/2005'"
+    " rel='http://schemas.google.com/g/2005#price' value='5' min='1'"
+    " max='5' average='2.30' numRaters='not a number' />";
+  NSError *error = nil;
+  NSXMLElement *element = [[[NSXMLElement alloc] initWithXMLString:xml
+                                                             error:&error] autorelease];
+  XCTAssertNil(error);
+
+  GDataRating *rating = [[[GDataRating alloc] initWithXMLElement:element
+                                                          parent:nil] autorelease];
+  XCTAssertEqual([rating typeForAttribute:@"value"], kGDataAttributeTypeInt);
+  XCTAssertEqual([rating typeForAttribute:@"average"], kGDataAttributeTypeDouble);
+  XCTAssertEqual([rating typeForAttribute:@"rel"], kGDataAttributeTypeString);
+
+  XCTAssertEqualObjects([rating value], [NSNumber numberWithInt:5]);
+  XCTAssertEqualObjects([rating average], [NSNumber numberWithDouble:2.3]);
+  XCTAssertEqualObjects([rating numberOfRaters], [NSNumber numberWithInt:0]);
+
+  // the strings are kept for the XML, even when unparsable
+  NSXMLElement *ratingXML = [rating XMLElement];
+  XCTAssertEqualObjects([[ratingXML attributeForName:@"average"] stringValue], @"2.30");
+  XCTAssertEqualObjects([[ratingXML attributeForName:@"numRaters"] stringValue],
+                        @"not a number");
+
+  // setting an attribute replaces its parsed value
+  [rating setNumberOfRaters:[NSNumber numberWithInt:132]];
+  XCTAssertEqualObjects([rating numberOfRaters], [NSNumber numberWithInt:132]);
+  [rating setStringValue:@"4" forAttribute:@"value"];
+  XCTAssertEqualObjects([rating value], [NSNumber numberWithInt:4]);
+
+  // reading a typed attribute as another type leaves the parsed value
+  XCTAssertEqualObjects([rating doubleNumberForAttribute:@"value"],
+                        [NSNumber numberWithDouble:4.0]);
+  XCTAssertEqualObjects([rating intNumberForAttribute:@"average"],
+                        [NSNumber numberWithInt:2]);
+  XCTAssertEqualObjects([rating value], [NSNumber numberWithInt:4]);
+  XCTAssertEqualObjects([rating average], [NSNumber numberWithDouble:2.3]);
+
+  // the getters don't change the object, so it may be read from several
+  // threads at once
+  NSUInteger hash = [rating hash];
+  dispatch_apply(64, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0),
+                 ^(size_t idx) {
+    [rating value];
+    [rating doubleNumberForAttribute:@"value"];
+    [rating numberOfRaters];
+    [rating longLongNumberForAttribute:@"min"];
+  });
+  XCTAssertEqual([rating hash], hash);
+
+  // copies keep the declared types and parsed values, including types
+  // declared by the object itself
+  [rating addLocalAttributeDeclarations:[NSArray arrayWithObject:@"extra"]
+                                 ofType:kGDataAttributeTypeInt];
+  [rating setStringValue:@"17" forAttribute:@"extra"];
+  GDataRating *ratingCopy = [[rating copy] autorelease];
+  XCTAssertEqualObjects(ratingCopy, rating);
+  XCTAssertEqualObjects([ratingCopy value], [NSNumber numberWithInt:4]);
+  XCTAssertEqual([ratingCopy typeForAttribute:@"extra"], kGDataAttributeTypeInt);
+  XCTAssertEqualObjects([ratingCopy intNumberForAttribute:@"extra"],
+                        [NSNumber numberWithInt:17]);
+  [ratingCopy setValue:[NSNumber numberWithInt:3]];
+  XCTAssertEqualObjects([rating value], [NSNumber numberWithInt:4]);
+
+  // values of attributes set after parsing are parsed as they are set,
+  // and parsed booleans respect the defaults
+  GDataFeedLink *feedLink = [GDataFeedLink feedLinkWithHref:@"http://example.com/"
+                                                 isReadOnly:YES];
+  XCTAssertTrue([feedLink isReadOnly]);
+  [feedLink setStringValue:@"maybe" forAttribute:@"readOnly"];
+  XCTAssertFalse([feedLink isReadOnly]);
+  XCTAssertTrue([feedLink boolValueForAttribute:@"readOnly" defaultValue:YES]);
+}
+
 - (NSData *)dataWithTestFilePath:(NSString *)localPath {
   NSBundle *testBundle = [NSBundle bundleForClass:[self class]];
   NSString *resourcesPath = [testBundle resourcePath];
@@ -1710,6 +2499,32 @@
   return data;
 }
 
+// the tests of parsing and generating feeds start from the calendar event
+// test feed, parsed eagerly, or from its document
+- (NSData *)calendarEventTestData {
+  NSData *data = [self dataWithTestFilePath:@"FeedCalendarEventTest1.xml"];
+  XCTAssertNotNil(data, @"Cannot read calendar event test feed");
+  return data;
+}
+
+- (GDataFeedBase *)calendarEventTestFeed {
+  NSData *data = [self calendarEventTestData];
+  GDataFeedBase *feed = [[[GDataFeedCalendarEvent alloc] initWithData:data
+                                                       serviceVersion:@"2.1"
+                                                 shouldIgnoreUnknowns:NO] autorelease];
+  XCTAssertTrue([[feed entries] count] > 2, @"Cannot parse calendar event test feed");
+  return feed;
+}
+
+- (NSXMLDocument *)calendarEventTestDocument {
+  NSData *data = [self calendarEventTestData];
+  NSXMLDocument *doc = [[[NSXMLDocument alloc] initWithData:data
+                                                    options:0
+                                                      error:NULL] autorelease];
+  XCTAssertNotNil(doc);
+  return doc;
+}
+
 @end
 
 ///////////////////////////////////////////////////////////////////////////
@@ -37,6 +37,7 @@
   NSError *fetcherError_;
   int fetchStartedNotificationCount_;
   int fetchStoppedNotificationCount_;
+  int maxFetchesInProgressCount_;
   unsigned long long lastProgressDeliveredCount_;
   unsigned long long lastProgressTotalCount_;
   int parseStartedCount_;
@@ -80,6 +81,28 @@
 - (NSString *)mySurrogateLinkName;
 @end
 
+@interface GDataServiceBase (NextLinkTestMethods)
+- (NSArray *)URLsOfRemainingPagesOfFeed:(GDataFeedBase *)feed
+                                nextURL:(NSURL *)nextURL;
+@end
+
+@interface GDataServiceBase (FetchKeyTestMethods)
+- (id)fetchKeyForURL:(NSURL *)feedURL
+         objectClass:(Class)objectClass
+        objectToPost:(GDataObject *)objectToPost
+                ETag:(NSString *)etag
+          httpMethod:(NSString *)httpMethod
+              ticket:(GDataServiceTicketBase *)ticket;
+@end
+
+// an authorizer identifying its user, for testing fetch keys
+@interface MyGDataUserAuthorizer : NSObject {
+  NSString *userEmail_;
+}
+- (id)initWithUserEmail:(NSString *)userEmail;
+- (NSString *)userEmail;
+@end
+
 NSTask *StartHTTPServerTask(int portNumber, NSBundle *testBundle) NS_RETURNS_RETAINED;
 
 // StartHTTPServerTask is used below and in GTMHTTPFetcherTest
@@ -177,6 +200,11 @@ static int kServerPortNumber = 54579;
     ++fetchStoppedNotificationCount_;
   }
 
+  int fetchesInProgressCount = fetchStartedNotificationCount_ - fetchStoppedNotificationCount_;
+  if (fetchesInProgressCount > maxFetchesInProgressCount_) {
+    maxFetchesInProgressCount_ = fetchesInProgressCount;
+  }
+
   XCTAssertTrue(retryDelayStartedNotificationCount_ <= fetchStartedNotificationCount_,
                @"fetch notification imbalance: starts=%d stops=%d",
                fetchStartedNotificationCount_, retryDelayStartedNotificationCount_);
@@ -250,6 +278,7 @@ static int kServerPortNumber = 54579;
 
   fetchStartedNotificationCount_ = 0;
   fetchStoppedNotificationCount_ = 0;
+  maxFetchesInProgressCount_ = 0;
   parseStartedCount_ = 0;
   parseStoppedCount_ = 0;
   retryDelayStartedNotificationCount_ = 0;
@@ -478,6 +507,32 @@ static int gFetchCounter = 0;
   XCTAssertEqual([[ticket_ objectFetcher] statusCode], (NSInteger)200,
                  @"fetching uncached copy of %@", feedURL);
 
+#if GDATA_USES_LIBXML
+  //
+  // test: download feed, parsing while downloading
+  //
+
+  [self resetFetchResponse];
+
+  [service_ setServiceShouldParseWhileDownloading:YES];
+
+  ticket_ = (GDataServiceTicket *)
+    [service_ fetchPublicFeedWithURL:feedURL
+                           feedClass:kGDataUseRegisteredClass
+                            delegate:self
+                   didFinishSelector:@selector(ticket:finishedWithObject:error:)];
+  [ticket_ retain];
+
+  [self waitForFetch];
+
+  XCTAssertTrue([ticket_ shouldParseWhileDownloading]);
+  XCTAssertEqualObjects(fetchedObject_, objectCopy,
+                        @"parsing while downloading %@", feedURL);
+  XCTAssertNil(fetcherError_, @"fetcherError_=%@", fetcherError_);
+
+  [service_ setServiceShouldParseWhileDownloading:NO];
+#endif
+
   //
   // test: download feed only, no auth, forcing a structured xml error
   //
@@ -1555,6 +1610,606 @@ authenticatedWithError:(NSError *)error {
   authError_ = [error retain];
 }
 
+- (void)testNextLinkPageURLs {
+
+  GDataFeedBase *feed = [GDataFeedSpreadsheet object];
+  [feed setTotalResults:[NSNumber numberWithInt:95]];
+  [feed setStartIndex:[NSNumber numberWithInt:1]];
+  [feed setItemsPerPage:[NSNumber numberWithInt:25]];
+
+  NSURL *nextURL = [NSURL URLWithString:@"http://example.com/feed?start-index=26&max-results=25"];
+  NSArray *pageURLs = [service_ URLsOfRemainingPagesOfFeed:feed
+                                                   nextURL:nextURL];
+  NSArray *expectedURLs = [NSArray arrayWithObjects:
+    [NSURL URLWithString:@"http://example.com/feed?start-index=26&max-results=25"],
+    [NSURL URLWithString:@"http://example.com/feed?start-index=51&max-results=25"],
+    [NSURL URLWithString:@"http://example.com/feed?start-index=76&max-results=25"],
+    nil];
+  XCTAssertEqualObjects(pageURLs, expectedURLs);
+
+  // next links that do not page by start-index are followed one at a time
+  nextURL = [NSURL URLWithString:@"http://example.com/feed?xstart-index=26"];
+  XCTAssertNil([service_ URLsOfRemainingPagesOfFeed:feed nextURL:nextURL]);
+
+  nextURL = [NSURL URLWithString:@"http://example.com/feed?continuation=abc"];
+  XCTAssertNil([service_ URLsOfRemainingPagesOfFeed:feed nextURL:nextURL]);
+
+  nextURL = [NSURL URLWithString:@"http://example.com/feed?start-index=30"];
+  XCTAssertNil([service_ URLsOfRemainingPagesOfFeed:feed nextURL:nextURL]);
+
+  // as are feeds of unknown size
+  [feed setTotalResults:nil];
+  nextURL = [NSURL URLWithString:@"http://example.com/feed?start-index=26"];
+  XCTAssertNil([service_ URLsOfRemainingPagesOfFeed:feed nextURL:nextURL]);
+}
+
+- (NSURL *)pagedFeedURLWithTotal:(int)total failingIndex:(int)failIndex {
+  // the test server generates the paged feed, so there is no file to check
+  // for; pages have two entries each, and the page starting at failIndex, if
+  // any, fails with status 500
+  NSString *urlString = [NSString stringWithFormat:
+    @"http://localhost:%d/pagedfeed.xml?start-index=1&max-results=2&total=%d",
+    kServerPortNumber, total];
+  if (failIndex > 0) {
+    urlString = [urlString stringByAppendingFormat:@"&fail=%d", failIndex];
+  }
+  return [NSURL URLWithString:urlString];
+}
+
+- (NSArray *)titlesOfEntriesOfFeed:(GDataFeedBase *)feed {
+  NSMutableArray *titles = [NSMutableArray array];
+  for (GDataEntryBase *entry in [feed entries]) {
+    [titles addObject:[[entry title] stringValue]];
+  }
+  return titles;
+}
+
+- (void)waitForArray:(NSMutableArray *)array
+        toReachCount:(NSUInteger)count {
+  // wait for the array to fill, then a moment more so that fetches which
+  // should not happen have a chance to
+  NSDate *giveUpDate = [NSDate dateWithTimeIntervalSinceNow:10.0];
+  while ([array count] < count && [giveUpDate timeIntervalSinceNow] > 0) {
+    NSDate *stopDate = [NSDate dateWithTimeIntervalSinceNow:0.001];
+    [[NSRunLoop currentRunLoop] runUntilDate:stopDate];
+  }
+  [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.5]];
+}
+
+- (void)testFeedPages {
+
+  if (!isServerRunning_) return;
+
+  [service_ setServiceShouldFollowNextLinks:YES];
+
+  NSURL *feedURL = [self pagedFeedURLWithTotal:5 failingIndex:0];
+  NSArray *expectedTitles = [NSArray arrayWithObjects:@"Entry 1", @"Entry 2",
+                             @"Entry 3", @"Entry 4", @"Entry 5", nil];
+  NSMutableArray *titles = [NSMutableArray array];
+
+  __block int callbackCounter = 0;
+  void (^handler)(GDataServiceTicketBase *, GDataFeedBase *, NSError *) =
+    ^(GDataServiceTicketBase *ticket, GDataFeedBase *feed, NSError *error) {
+      XCTAssertNotNil(feed, @"fetch error %@", error);
+      ++callbackCounter;
+    };
+
+  // each page is passed to the page handler in order, and the last page is
+  // the fetched object
+  GDataServiceTicketBase *ticket;
+  ticket = [service_ fetchPublicFeedWithURL:feedURL
+                                  feedClass:[GDataFeedSpreadsheet class]
+                          completionHandler:handler];
+  [ticket setFeedPageHandler:^(GDataServiceTicketBase *pageTicket,
+                               GDataFeedBase *page) {
+    XCTAssertFalse([pageTicket hasCalledCallback]);
+    [titles addObjectsFromArray:[self titlesOfEntriesOfFeed:page]];
+  }];
+
+  XCTAssertTrue([service_ waitForTicket:ticket
+                                timeout:10
+                          fetchedObject:NULL
+                                  error:NULL]);
+  XCTAssertEqualObjects(titles, expectedTitles);
+  XCTAssertEqual(callbackCounter, 1);
+  XCTAssertEqual(fetchStartedNotificationCount_, 3);
+  XCTAssertEqualObjects([self titlesOfEntriesOfFeed:(GDataFeedBase *)[ticket fetchedObject]],
+                        [NSArray arrayWithObject:@"Entry 5"]);
+
+  // a ticket paused when passed a page fetches no more pages, and its
+  // finished fetcher lets go of the ticket until it is resumed
+  [titles removeAllObjects];
+  callbackCounter = 0;
+  fetchStartedNotificationCount_ = 0;
+
+  ticket = [service_ fetchPublicFeedWithURL:feedURL
+                                  feedClass:[GDataFeedSpreadsheet class]
+                          completionHandler:handler];
+  [ticket setFeedPageHandler:^(GDataServiceTicketBase *pageTicket,
+                               GDataFeedBase *page) {
+    [titles addObjectsFromArray:[self titlesOfEntriesOfFeed:page]];
+    if ([titles count] == 2) {
+      [pageTicket pauseFeedPages];
+    }
+  }];
+
+  [self waitForArray:titles toReachCount:2];
+  XCTAssertEqual([titles count], (NSUInteger)2);
+  XCTAssertFalse([ticket hasCalledCallback]);
+  XCTAssertEqual(fetchStartedNotificationCount_, 1);
+  XCTAssertNil([[ticket objectFetcher] GDataTicket]);
+
+  [ticket resumeFeedPages];
+  XCTAssertTrue([service_ waitForTicket:ticket
+                                timeout:10
+                          fetchedObject:NULL
+                                  error:NULL]);
+  XCTAssertEqualObjects(titles, expectedTitles);
+  XCTAssertEqual(callbackCounter, 1);
+  XCTAssertEqual(fetchStartedNotificationCount_, 3);
+
+  // canceling the ticket when passed a page stops the fetch without
+  // calling back
+  [titles removeAllObjects];
+  callbackCounter = 0;
+  fetchStartedNotificationCount_ = 0;
+
+  ticket = [service_ fetchPublicFeedWithURL:feedURL
+                                  feedClass:[GDataFeedSpreadsheet class]
+                          completionHandler:handler];
+  [ticket setFeedPageHandler:^(GDataServiceTicketBase *pageTicket,
+                               GDataFeedBase *page) {
+    [titles addObjectsFromArray:[self titlesOfEntriesOfFeed:page]];
+    [pageTicket cancelTicket];
+  }];
+
+  [self waitForArray:titles toReachCount:2];
+  XCTAssertEqual([titles count], (NSUInteger)2);
+  XCTAssertFalse([ticket hasCalledCallback]);
+  XCTAssertEqual(callbackCounter, 0);
+  XCTAssertEqual(fetchStartedNotificationCount_, 1);
+
+  // canceling a paused ticket drops the pages it was waiting to fetch, so
+  // resuming it does nothing
+  [titles removeAllObjects];
+  fetchStartedNotificationCount_ = 0;
+
+  ticket = [service_ fetchPublicFeedWithURL:feedURL
+                                  feedClass:[GDataFeedSpreadsheet class]
+                          completionHandler:handler];
+  [ticket setFeedPageHandler:^(GDataServiceTicketBase *pageTicket,
+                               GDataFeedBase *page) {
+    [titles addObjectsFromArray:[self titlesOfEntriesOfFeed:page]];
+    [pageTicket pauseFeedPages];
+  }];
+
+  [self waitForArray:titles toReachCount:2];
+  [ticket cancelTicket];
+  [ticket resumeFeedPages];
+  [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.5]];
+
+  XCTAssertEqual([titles count], (NSUInteger)2);
+  XCTAssertFalse([ticket hasCalledCallback]);
+  XCTAssertEqual(callbackCounter, 0);
+  XCTAssertEqual(fetchStartedNotificationCount_, 1);
+
+  [service_ setServiceShouldFollowNextLinks:NO];
+}
+
+- (void)testFeedPageWindow {
+
+  if (!isServerRunning_) return;
+
+  NSUInteger savedWindow = [service_ serviceNextLinkFetchWindow];
+  [service_ setServiceShouldFollowNextLinks:YES];
+  [service_ setServiceNextLinkFetchWindow:2];
+
+  __block int callbackCounter = 0;
+  __block GDataFeedBase *fetchedFeed = nil;
+  __block NSError *fetchError = nil;
+  void (^handler)(GDataServiceTicketBase *, GDataFeedBase *, NSError *) =
+    ^(GDataServiceTicketBase *ticket, GDataFeedBase *feed, NSError *error) {
+      ++callbackCounter;
+      fetchedFeed = feed;
+      fetchError = error;
+    };
+
+  // the first page gives the URLs of the remaining four, which are fetched
+  // two at a time and merged in page order, even though the test server
+  // answers them one at a time
+  NSURL *feedURL = [self pagedFeedURLWithTotal:9 failingIndex:0];
+  GDataServiceTicketBase *ticket;
+  ticket = [service_ fetchPublicFeedWithURL:feedURL
+                                  feedClass:[GDataFeedSpreadsheet class]
+                          completionHandler:handler];
+  XCTAssertTrue([service_ waitForTicket:ticket
+                                timeout:10
+                          fetchedObject:NULL
+                                  error:NULL]);
+  XCTAssertNil(fetchError);
+  XCTAssertEqual(callbackCounter, 1);
+  XCTAssertEqual(fetchStartedNotificationCount_, 5);
+  XCTAssertEqual(maxFetchesInProgressCount_, 2);
+
+  NSArray *expectedTitles = [NSArray arrayWithObjects:@"Entry 1", @"Entry 2",
+                             @"Entry 3", @"Entry 4", @"Entry 5", @"Entry 6",
+                             @"Entry 7", @"Entry 8", @"Entry 9", nil];
+  XCTAssertEqualObjects([self titlesOfEntriesOfFeed:fetchedFeed], expectedTitles);
+  XCTAssertTrue(fetchedFeed == [ticket fetchedObject]);
+  XCTAssertNil([fetchedFeed nextLink]);
+
+  // canceling the ticket while pages are being fetched stops them all
+  // without calling back
+  [self resetFetchResponse];
+  callbackCounter = 0;
+
+  ticket = [service_ fetchPublicFeedWithURL:feedURL
+                                  feedClass:[GDataFeedSpreadsheet class]
+                          completionHandler:handler];
+
+  NSDate *giveUpDate = [NSDate dateWithTimeIntervalSinceNow:10.0];
+  while (fetchStartedNotificationCount_ < 3
+         && [giveUpDate timeIntervalSinceNow] > 0) {
+    NSDate *stopDate = [NSDate dateWithTimeIntervalSinceNow:0.001];
+    [[NSRunLoop currentRunLoop] runUntilDate:stopDate];
+  }
+  XCTAssertEqual(fetchStartedNotificationCount_, 3);
+
+  [ticket cancelTicket];
+  [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.5]];
+
+  XCTAssertFalse([ticket hasCalledCallback]);
+  XCTAssertEqual(callbackCounter, 0);
+  XCTAssertEqual(fetchStartedNotificationCount_, 3);
+  XCTAssertEqual(fetchStoppedNotificationCount_, 3);
+
+  // a page that fails ends the fetch with its error, once, and stops the
+  // other pages
+  [self resetFetchResponse];
+  callbackCounter = 0;
+
+  feedURL = [self pagedFeedURLWithTotal:9 failingIndex:5];
+  ticket = [service_ fetchPublicFeedWithURL:feedURL
+                                  feedClass:[GDataFeedSpreadsheet class]
+                          completionHandler:handler];
+  XCTAssertFalse([service_ waitForTicket:ticket
+                                 timeout:10
+                           fetchedObject:NULL
+                                   error:NULL]);
+  XCTAssertTrue([ticket hasCalledCallback]);
+  XCTAssertNil(fetchedFeed);
+  XCTAssertEqual([fetchError code], (NSInteger)500,
+                 @"fetchError should be 500, was %@", fetchError);
+  XCTAssertEqualObjects([ticket fetchError], fetchError);
+
+  int startedCount = fetchStartedNotificationCount_;
+  [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.5]];
+  XCTAssertEqual(callbackCounter, 1);
+  XCTAssertEqual(fetchStartedNotificationCount_, startedCount);
+  XCTAssertEqual(fetchStoppedNotificationCount_, startedCount);
+
+  [service_ setServiceShouldFollowNextLinks:NO];
+  [service_ setServiceNextLinkFetchWindow:savedWindow];
+}
+
+- (void)testCoalescedFetches {
+
+  if (!isServerRunning_) return;
+
+  [service_ setServiceShouldCoalesceFetches:YES];
+
+  NSURL *feedURL = [self fileURLToTestFileName:@"FeedSpreadsheetTest1.xml"];
+
+  __block int callbackCounter = 0;
+  void (^handler)(GDataServiceTicketBase *, GDataFeedBase *, NSError *) =
+    ^(GDataServiceTicketBase *ticket, GDataFeedBase *feed, NSError *error) {
+      XCTAssertNotNil(feed, @"fetch error %@", error);
+      ++callbackCounter;
+    };
+
+  // identical requests share the first request's fetch; the third ticket is
+  // canceled and must not be called back
+  GDataServiceTicketBase *ticket1, *ticket2, *ticket3;
+  ticket1 = [service_ fetchPublicFeedWithURL:feedURL
+                                   feedClass:kGDataUseRegisteredClass
+                           completionHandler:handler];
+  ticket2 = [service_ fetchPublicFeedWithURL:feedURL
+                                   feedClass:kGDataUseRegisteredClass
+                           completionHandler:handler];
+  ticket3 = [service_ fetchPublicFeedWithURL:feedURL
+                                   feedClass:kGDataUseRegisteredClass
+                           completionHandler:handler];
+  [ticket3 cancelTicket];
+
+  XCTAssertTrue([service_ waitForTicket:ticket1
+                                timeout:10
+                          fetchedObject:NULL
+                                  error:NULL]);
+  XCTAssertTrue([ticket2 hasCalledCallback]);
+  XCTAssertFalse([ticket3 hasCalledCallback]);
+  XCTAssertEqual(callbackCounter, 2);
+  XCTAssertEqual(fetchStartedNotificationCount_, 1);
+
+  // each ticket gets its own copy of the feed
+  GDataObject *object1 = [ticket1 fetchedObject];
+  GDataObject *object2 = [ticket2 fetchedObject];
+  XCTAssertTrue(object1 != object2);
+  XCTAssertEqualObjects(object1, object2);
+
+  // canceling the first ticket leaves the fetch running for the second
+  callbackCounter = 0;
+  ticket1 = [service_ fetchPublicFeedWithURL:feedURL
+                                   feedClass:kGDataUseRegisteredClass
+                           completionHandler:handler];
+  ticket2 = [service_ fetchPublicFeedWithURL:feedURL
+                                   feedClass:kGDataUseRegisteredClass
+                           completionHandler:handler];
+  [ticket1 cancelTicket];
+
+  XCTAssertTrue([service_ waitForTicket:ticket2
+                                timeout:10
+                          fetchedObject:NULL
+                                  error:NULL]);
+  XCTAssertFalse([ticket1 hasCalledCallback]);
+  XCTAssertEqual(callbackCounter, 1);
+  XCTAssertEqual(fetchStartedNotificationCount_, 2);
+
+  // requests made after a fetch finishes start fetches of their own
+  callbackCounter = 0;
+  ticket1 = [service_ fetchPublicFeedWithURL:feedURL
+                                   feedClass:kGDataUseRegisteredClass
+                           completionHandler:handler];
+  XCTAssertTrue([service_ waitForTicket:ticket1
+                                timeout:10
+                          fetchedObject:NULL
+                                  error:NULL]);
+  XCTAssertEqual(callbackCounter, 1);
+  XCTAssertEqual(fetchStartedNotificationCount_, 3);
+
+  // a follower's callback that cancels the leader keeps the leader from
+  // being called back
+  callbackCounter = 0;
+  ticket1 = [service_ fetchPublicFeedWithURL:feedURL
+                                   feedClass:kGDataUseRegisteredClass
+                           completionHandler:handler];
+  GDataServiceTicketBase *leaderTicket = ticket1;
+  ticket2 = [service_ fetchPublicFeedWithURL:feedURL
+                                   feedClass:kGDataUseRegisteredClass
+                           completionHandler:^(GDataServiceTicketBase *ticket,
+                                               GDataFeedBase *feed,
+                                               NSError *error) {
+    handler(ticket, feed, error);
+    [leaderTicket cancelTicket];
+  }];
+
+  XCTAssertTrue([service_ waitForTicket:ticket2
+                                timeout:10
+                          fetchedObject:NULL
+                                  error:NULL]);
+  [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.1]];
+  XCTAssertFalse([ticket1 hasCalledCallback]);
+  XCTAssertEqual(callbackCounter, 1);
+  XCTAssertEqual(fetchStartedNotificationCount_, 4);
+
+  [service_ setServiceShouldCoalesceFetches:NO];
+}
+
+- (id)fetchKeyForURL:(NSURL *)feedURL authorizer:(id)authorizer {
+  GDataServiceTicketBase *ticket = [GDataServiceTicketBase ticketForService:service_];
+  [ticket setAuthorizer:authorizer];
+  return [service_ fetchKeyForURL:feedURL
+                      objectClass:kGDataUseRegisteredClass
+                     objectToPost:nil
+                             ETag:nil
+                       httpMethod:nil
+                           ticket:ticket];
+}
+
+- (void)testFetchKeys {
+
+  [service_ setUserCredentialsWithUsername:nil
+                                  password:nil];
+
+  NSURL *feedURL = [NSURL URLWithString:@"http://example.com/feed"];
+
+  // requests are coalesced and cached by account, not by authorizer object
+  MyGDataUserAuthorizer *auth1, *auth2, *auth3;
+  auth1 = [[[MyGDataUserAuthorizer alloc] initWithUserEmail:@"a@example.com"] autorelease];
+  auth2 = [[[MyGDataUserAuthorizer alloc] initWithUserEmail:@"a@example.com"] autorelease];
+  auth3 = [[[MyGDataUserAuthorizer alloc] initWithUserEmail:@"b@example.com"] autorelease];
+
+  id key1 = [self fetchKeyForURL:feedURL authorizer:auth1];
+  id key2 = [self fetchKeyForURL:feedURL authorizer:auth2];
+  id key3 = [self fetchKeyForURL:feedURL authorizer:auth3];
+  XCTAssertNotNil(key1);
+  XCTAssertEqualObjects(key1, key2);
+  XCTAssertEqual([key1 hash], [key2 hash]);
+  XCTAssertNotEqualObjects(key1, key3);
+
+  NSMutableDictionary *fetches = [NSMutableDictionary dictionary];
+  [fetches setObject:@"fetch1" forKey:key1];
+  XCTAssertEqualObjects([fetches objectForKey:key2], @"fetch1");
+  XCTAssertNil([fetches objectForKey:key3]);
+
+  // requests whose authorizer does not identify the account are not keyed
+  id anonymousAuth = [[[NSObject alloc] init] autorelease];
+  XCTAssertNil([self fetchKeyForURL:feedURL authorizer:anonymousAuth]);
+
+  // unauthorized requests are keyed, apart from authorized ones
+  id publicKey = [self fetchKeyForURL:feedURL authorizer:nil];
+  XCTAssertNotNil(publicKey);
+  XCTAssertNotEqualObjects(publicKey, key1);
+}
+
+- (void)testParsedObjectCache {
+
+  if (!isServerRunning_) return;
+
+  [service_ setParsedObjectCacheCapacity:1024 * 1024];
+
+  NSURL *feedURL = [self fileURLToTestFileName:@"FeedSpreadsheetTest1.xml"];
+
+  // the first fetch is parsed and cached
+  GDataServiceTicketBase *ticket;
+  GDataObject *fetchedObject = nil;
+  NSError *fetchError = nil;
+  ticket = [service_ fetchPublicFeedWithURL:feedURL
+                                  feedClass:kGDataUseRegisteredClass
+                                   delegate:nil
+                          didFinishSelector:NULL];
+  XCTAssertTrue([service_ waitForTicket:ticket
+                                timeout:10
+                          fetchedObject:&fetchedObject
+                                  error:&fetchError], @"%@", fetchError);
+  GDataObject *parsedObject = fetchedObject;
+  XCTAssertNotNil(parsedObject);
+  XCTAssertEqual([service_ parsedObjectCacheHitCount], (NSUInteger)0);
+  XCTAssertEqual([service_ parsedObjectCacheMissCount], (NSUInteger)1);
+
+  // the second fetch is revalidated and completes with a copy of the
+  // cached object
+  ticket = [service_ fetchPublicFeedWithURL:feedURL
+                                  feedClass:kGDataUseRegisteredClass
+                                   delegate:nil
+                          didFinishSelector:NULL];
+  XCTAssertTrue([service_ waitForTicket:ticket
+                                timeout:10
+                          fetchedObject:&fetchedObject
+                                  error:&fetchError], @"%@", fetchError);
+  XCTAssertEqual([[ticket objectFetcher] statusCode],
+                 (NSInteger)kGDataFetcherStatusNotModified);
+  XCTAssertEqualObjects(fetchedObject, parsedObject);
+  XCTAssertTrue(fetchedObject != parsedObject);
+  XCTAssertEqual([service_ parsedObjectCacheHitCount], (NSUInteger)1);
+  XCTAssertEqual([service_ parsedObjectCacheMissCount], (NSUInteger)1);
+  XCTAssertTrue([service_ parsedObjectCacheHitByteCount] > 0);
+  XCTAssertEqual(parseStartedCount_, parseStoppedCount_);
+
+  // clearing the cache makes the next fetch download the feed again
+  [service_ clearResponseDataCache];
+
+  ticket = [service_ fetchPublicFeedWithURL:feedURL
+                                  feedClass:kGDataUseRegisteredClass
+                                   delegate:nil
+                          didFinishSelector:NULL];
+  XCTAssertTrue([service_ waitForTicket:ticket
+                                timeout:10
+                          fetchedObject:&fetchedObject
+                                  error:&fetchError], @"%@", fetchError);
+  XCTAssertEqual([[ticket objectFetcher] statusCode], (NSInteger)200);
+  XCTAssertEqualObjects(fetchedObject, parsedObject);
+  XCTAssertEqual([service_ parsedObjectCacheMissCount], (NSUInteger)2);
+
+  [service_ setParsedObjectCacheCapacity:0];
+}
+
+- (void)testResponseDiskCache {
+
+  if (!isServerRunning_) return;
+
+  NSString *cacheDir = [NSTemporaryDirectory() stringByAppendingPathComponent:@"GDataResponseDiskCacheTest"];
+  NSFileManager *fileMgr = [NSFileManager defaultManager];
+  [fileMgr removeItemAtPath:cacheDir error:NULL];
+
+  [service_ setResponseDiskCacheDirectory:cacheDir];
+
+  NSURL *feedURL = [self fileURLToTestFileName:@"FeedSpreadsheetTest1.xml"];
+
+  // the first fetch downloads the feed and saves it
+  GDataServiceTicketBase *ticket;
+  GDataObject *fetchedObject = nil;
+  NSError *fetchError = nil;
+  ticket = [service_ fetchPublicFeedWithURL:feedURL
+                                  feedClass:kGDataUseRegisteredClass
+                                   delegate:nil
+                          didFinishSelector:NULL];
+  XCTAssertTrue([service_ waitForTicket:ticket
+                                timeout:10
+                          fetchedObject:&fetchedObject
+                                  error:&fetchError], @"%@", fetchError);
+  GDataObject *downloadedObject = [[fetchedObject retain] autorelease];
+  XCTAssertEqual([[ticket objectFetcher] statusCode], (NSInteger)200);
+
+  // a revalidation arriving before the response files are written uses the
+  // response kept in memory
+  ticket = [service_ fetchPublicFeedWithURL:feedURL
+                                  feedClass:kGDataUseRegisteredClass
+                                   delegate:nil
+                          didFinishSelector:NULL];
+  XCTAssertTrue([service_ waitForTicket:ticket
+                                timeout:10
+                          fetchedObject:&fetchedObject
+                                  error:&fetchError], @"%@", fetchError);
+  XCTAssertEqual([[ticket objectFetcher] statusCode],
+                 (NSInteger)kGDataFetcherStatusNotModified);
+  XCTAssertEqualObjects(fetchedObject, downloadedObject);
+
+  // wait for the response files to be written in the background
+  NSDate *giveUpDate = [NSDate dateWithTimeIntervalSinceNow:10.0];
+  NSArray *fileNames = nil;
+  do {
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+    fileNames = [fileMgr contentsOfDirectoryAtPath:cacheDir error:NULL];
+  } while ([[fileNames pathsMatchingExtensions:[NSArray arrayWithObject:@"plist"]] count] == 0
+           && [giveUpDate timeIntervalSinceNow] > 0);
+  XCTAssertEqual([fileNames count], (NSUInteger)2, @"%@", fileNames);
+
+  // a new service, as after a restart, revalidates the saved response, and
+  // discards a file left by an interrupted write
+  NSString *strayPath = [cacheDir stringByAppendingPathComponent:@"stray.data"];
+  [[NSData data] writeToFile:strayPath atomically:NO];
+
+  GDataServiceGoogleSpreadsheet *restartedService = [[[GDataServiceGoogleSpreadsheet alloc] init] autorelease];
+  [restartedService setUserAgent:[service_ userAgent]];
+  [[restartedService fetcherService] setAllowLocalhostRequest:YES];
+  [[restartedService fetcherService] setAllowedInsecureSchemes:@[ @"http" ]];
+  [restartedService setResponseDiskCacheDirectory:cacheDir];
+
+  XCTAssertFalse([fileMgr fileExistsAtPath:strayPath]);
+
+  ticket = [restartedService fetchPublicFeedWithURL:feedURL
+                                          feedClass:kGDataUseRegisteredClass
+                                           delegate:nil
+                                  didFinishSelector:NULL];
+  XCTAssertTrue([restartedService waitForTicket:ticket
+                                        timeout:10
+                                  fetchedObject:&fetchedObject
+                                          error:&fetchError], @"%@", fetchError);
+  XCTAssertEqual([[ticket objectFetcher] statusCode],
+                 (NSInteger)kGDataFetcherStatusNotModified);
+  XCTAssertEqualObjects(fetchedObject, downloadedObject);
+
+  // a response removed while its revalidation is in progress is fetched
+  // again without the validators
+  ticket = [restartedService fetchPublicFeedWithURL:feedURL
+                                          feedClass:kGDataUseRegisteredClass
+                                           delegate:nil
+                                  didFinishSelector:NULL];
+  XCTAssertNotNil([[[ticket objectFetcher] request] valueForHTTPHeaderField:@"If-None-Match"]);
+  [restartedService clearResponseDiskCache];
+  XCTAssertTrue([restartedService waitForTicket:ticket
+                                        timeout:10
+                                  fetchedObject:&fetchedObject
+                                          error:&fetchError], @"%@", fetchError);
+  XCTAssertEqual([[ticket objectFetcher] statusCode], (NSInteger)200);
+  XCTAssertNil([[[ticket objectFetcher] request] valueForHTTPHeaderField:@"If-None-Match"]);
+  XCTAssertEqualObjects(fetchedObject, downloadedObject);
+
+  // clearing the cache removes the files
+  [restartedService clearResponseDiskCache];
+  [service_ setResponseDiskCacheDirectory:nil];
+  [restartedService setResponseDiskCacheDirectory:nil];
+
+  giveUpDate = [NSDate dateWithTimeIntervalSinceNow:10.0];
+  do {
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+    fileNames = [fileMgr contentsOfDirectoryAtPath:cacheDir error:NULL];
+  } while ([fileNames count] > 0 && [giveUpDate timeIntervalSinceNow] > 0);
+  XCTAssertEqual([fileNames count], (NSUInteger)0, @"%@", fileNames);
+
+  [fileMgr removeItemAtPath:cacheDir error:NULL];
+}
+
 @end
 
 
@@ -1576,4 +2231,23 @@ authenticatedWithError:(NSError *)error {
 }
 @end
 
+@implementation MyGDataUserAuthorizer
+- (id)initWithUserEmail:(NSString *)userEmail {
+  self = [super init];
+  if (self) {
+    userEmail_ = [userEmail copy];
+  }
+  return self;
+}
+
+- (void)dealloc {
+  [userEmail_ release];
+  [super dealloc];
+}
+
+- (NSString *)userEmail {
+  return userEmail_;
+}
+@end
+
 #endif // !GDATA_SKIPSERVICETEST
@@ -85,11 +85,17 @@ class SimpleServer(BaseHTTPRequestHandler):
   
   Successful results have a Last-Modified header set; if that header's value
   ("thursday") is supplied in a request's "If-Modified-Since" header, the 
-  result is 304 (Not Modified).
+  result is 304 (Not Modified).  Likewise, successful results have an ETag
+  header set, and supplying its value in an "If-None-Match" header gives
+  a 304 result.
   
   Requests to /accounts/ClientLogin will fail if supplied with a body
   containing Passwd=bad. If they contain logintoken and logincaptcha values,
   those must be logintoken=CapToken&logincaptch=good to succeed.
+
+  Requests to /pagedfeed.xml?start-index=n&max-results=m&total=t return a
+  generated page of a feed of t entries, with a next link to the following
+  page.  Adding fail=n makes the page starting at entry n fail with status 500.
   """
 
   def do_GET(self):
@@ -127,6 +133,7 @@ class SimpleServer(BaseHTTPRequestHandler):
     headerType = "text/plain"
     postString = ""
     modifiedDate = "thursday" # clients should treat dates as opaque, generally
+    etag = "\"testETag\""
     
     # auth queries and some GData queries include post data
     postLength = int(self.headers.getheader("Content-Length", "0"));
@@ -134,6 +141,7 @@ class SimpleServer(BaseHTTPRequestHandler):
       postString = self.rfile.read(postLength)
       
     ifModifiedSince = self.headers.getheader("If-Modified-Since", "");
+    ifNoneMatch = self.headers.getheader("If-None-Match", "");
     
     # retrieve the auth header
     authorization = self.headers.getheader("Authorization", "")
@@ -269,6 +277,57 @@ class SimpleServer(BaseHTTPRequestHandler):
         resultStatus = 200
         headerType = "text/plain"
         
+      elif self.path.startswith("/pagedfeed.xml"):
+        #
+        # it's a fetch of a page of a generated feed; entries are numbered
+        # from 1, and every page but the last has max-results entries
+        #
+        query = ""
+        if "?" in self.path:
+          query = self.path.split("?", 1)[1]
+        params = cgi.parse_qs(query)
+        startIndex = int(params.get("start-index", ["1"])[0])
+        maxResults = int(params.get("max-results", ["2"])[0])
+        totalResults = int(params.get("total", ["5"])[0])
+        failIndex = int(params.get("fail", ["0"])[0])
+        
+        if startIndex == failIndex:
+          self.send_error(500, "Test HTTP server failed page: %s" % self.path)
+          return
+        
+        host = self.headers.getheader("Host", "")
+        endIndex = min(startIndex + maxResults, totalResults + 1)
+        
+        entries = ""
+        for index in range(startIndex, endIndex):
+          entries += ("<entry><id>http://%s/pagedfeed/%d</id>"
+            "<updated>2008-01-01T00:00:00Z</updated>"
+            "<title>Entry %d</title></entry>" % (host, index, index))
+        
+        nextLink = ""
+        if endIndex <= totalResults:
+          nextQuery = "start-index=%d&max-results=%d&total=%d" % (endIndex,
+            maxResults, totalResults)
+          if failIndex > 0:
+            nextQuery += "&fail=%d" % failIndex
+          nextLink = ("<link rel='next' type='application/atom+xml' "
+            "href='http://%s/pagedfeed.xml?%s'/>" % (host,
+            cgi.escape(nextQuery)))
+        
+        resultString = ("<?xml version='1.0' encoding='UTF-8'?>"
+          "<feed xmlns='http://www.w3.org/2005/Atom' "
+          "xmlns:openSearch='http://a9.com/-/spec/opensearch/1.1/'>"
+          "<id>http://%s/pagedfeed</id>"
+          "<updated>2008-01-01T00:00:00Z</updated>"
+          "<title>Paged feed</title>%s"
+          "<openSearch:totalResults>%d</openSearch:totalResults>"
+          "<openSearch:startIndex>%d</openSearch:startIndex>"
+          "<openSearch:itemsPerPage>%d</openSearch:itemsPerPage>%s"
+          "</feed>" % (host, nextLink, totalResults, startIndex, maxResults,
+                       entries))
+        resultStatus = 200
+        headerType = "application/atom+xml"
+        
       else:
         # queries that have something like "?status=456" should fail with the
         # status code
@@ -299,7 +358,7 @@ class SimpleServer(BaseHTTPRequestHandler):
           
         # if the client gave us back our modified date, then say there's no
         # change in the response
-        if ifModifiedSince == modifiedDate:
+        if ifModifiedSince == modifiedDate or ifNoneMatch == etag:
           self.send_response(304) # Not Modified
           return
           
@@ -317,6 +376,7 @@ class SimpleServer(BaseHTTPRequestHandler):
       self.send_response(resultStatus)
       self.send_header("Content-type", headerType)
       self.send_header("Last-Modified", modifiedDate)
+      self.send_header("ETag", etag)
       
       # set TestCookie to equal the file name requested
       cookieValue = os.path.basename("." + self.path)
@@ -307,5 +307,317 @@
   [self runXPathTestUsingShim:YES];
 }
 
+- (void)testXPathQuery {
+
+  NSString *xmlStr = @"<feed xmlns='http://www.w3.org/2005/Atom'>"
+    "<entry><link href='a'/><link href='b'/></entry>"
+    "<entry><link href='c'/></entry></feed>";
+
+  NSError *error = nil;
+  GDataXMLDocument *doc = [[[GDataXMLDocument alloc] initWithXMLString:xmlStr
+                                                               options:0
+                                                                 error:&error] autorelease];
+  XCTAssertNotNil(doc, @"%@", error);
+
+  NSDictionary *nsDict = [NSDictionary dictionaryWithObject:kGDataNamespaceAtom
+                                                     forKey:kGDataNamespaceAtomPrefix];
+  GDataXMLXPathQuery *query = [GDataXMLXPathQuery queryWithXPath:@"atom:link"
+                                                      namespaces:nsDict
+                                                           error:&error];
+  XCTAssertNotNil(query, @"%@", error);
+  XCTAssertEqualObjects([query XPath], @"atom:link");
+
+  // the same query evaluated relative to different nodes
+  NSArray *entries = [[doc rootElement] elementsForLocalName:@"entry"
+                                                         URI:kGDataNamespaceAtom];
+  NSArray *links = [[entries objectAtIndex:0] nodesForXPathQuery:query
+                                                           error:&error];
+  XCTAssertEqual([links count], (NSUInteger)2, @"%@", error);
+  links = [[entries objectAtIndex:1] nodesForXPathQuery:query error:&error];
+  XCTAssertEqual([links count], (NSUInteger)1, @"%@", error);
+  XCTAssertEqualObjects([[(GDataXMLElement *)[links objectAtIndex:0]
+                          attributeForName:@"href"] stringValue], @"c");
+
+  // evaluated against a document
+  GDataXMLXPathQuery *docQuery = [GDataXMLXPathQuery queryWithXPath:@"//atom:link"
+                                                         namespaces:nsDict
+                                                              error:&error];
+  XCTAssertEqual([[doc nodesForXPathQuery:docQuery error:&error] count],
+                 (NSUInteger)3, @"%@", error);
+
+  // evaluated on several threads at once
+  __block int numberOfFailures = 0;
+  dispatch_apply(32, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0),
+                 ^(size_t iteration) {
+    NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+    NSArray *nodes = [doc nodesForXPathQuery:docQuery error:NULL];
+    if ([nodes count] != 3) {
+      __sync_fetch_and_add(&numberOfFailures, 1);
+    }
+    [pool drain];
+  });
+  XCTAssertEqual(numberOfFailures, 0);
+
+  // an illegal expression fails to compile
+  error = nil;
+  GDataXMLXPathQuery *badQuery = [GDataXMLXPathQuery queryWithXPath:@"atom:link["
+                                                         namespaces:nsDict
+                                                              error:&error];
+  XCTAssertNil(badQuery);
+  XCTAssertNotNil(error);
+}
+
+- (void)testStringInterning {
+
+  NSString *xmlStr = @"<feed xmlns='http://www.w3.org/2005/Atom'>"
+    "<link rel='alternate' href='http://example.com/'/></feed>";
+
+  [GDataXMLNode resetStringInternStatistics];
+
+  NSError *error = nil;
+  GDataXMLDocument *doc1 = [[[GDataXMLDocument alloc] initWithXMLString:xmlStr
+                                                                options:0
+                                                                  error:&error] autorelease];
+  GDataXMLDocument *doc2 = [[[GDataXMLDocument alloc] initWithXMLString:xmlStr
+                                                                options:0
+                                                                  error:&error] autorelease];
+  XCTAssertNotNil(doc1, @"%@", error);
+  XCTAssertNotNil(doc2, @"%@", error);
+
+  // strings from separate documents are shared
+  NSString *uri1 = [[doc1 rootElement] URI];
+  NSString *uri2 = [[doc2 rootElement] URI];
+  XCTAssertEqualObjects(uri1, @"http://www.w3.org/2005/Atom");
+  XCTAssertTrue(uri1 == uri2, @"namespace URI not interned");
+
+  GDataXMLElement *link1 = [[[doc1 rootElement] children] objectAtIndex:0];
+  GDataXMLElement *link2 = [[[doc2 rootElement] children] objectAtIndex:0];
+  NSString *rel1 = [[link1 attributeForName:@"rel"] stringValue];
+  NSString *rel2 = [[link2 attributeForName:@"rel"] stringValue];
+  XCTAssertEqualObjects(rel1, @"alternate");
+  XCTAssertTrue(rel1 == rel2, @"attribute value not interned");
+
+  XCTAssertTrue([GDataXMLNode numberOfStringInternHits] > 0);
+  XCTAssertTrue([GDataXMLNode numberOfStringInternBytesSaved] > 0);
+
+  // after clearing the table, strings are allocated anew but are still valid
+  [GDataXMLNode clearStringInternTable];
+  XCTAssertEqualObjects([[doc2 rootElement] URI], uri1);
+}
+
+- (void)testIndexedLookups {
+
+  // an element with enough children that lookups use the index
+  NSMutableString *xmlStr = [NSMutableString stringWithString:
+    @"<feed xmlns='http://www.w3.org/2005/Atom'"
+     " xmlns:gd='http://schemas.google.com/g/2005' gd:etag='W/123'>"];
+  for (int idx = 0; idx < 20; idx++) {
+    [xmlStr appendFormat:@"<entry><id>%d</id></entry><gd:entry/>", idx];
+  }
+  [xmlStr appendString:@"<title>indexed</title></feed>"];
+
+  NSError *error = nil;
+  GDataXMLDocument *doc = [[[GDataXMLDocument alloc] initWithXMLString:xmlStr
+                                                               options:0
+                                                                 error:&error] autorelease];
+  XCTAssertNotNil(doc, @"%@", error);
+
+  NSString *const kAtom = @"http://www.w3.org/2005/Atom";
+  NSString *const kGD = @"http://schemas.google.com/g/2005";
+
+  GDataXMLElement *root = [doc rootElement];
+  NSArray *entries = [root elementsForLocalName:@"entry" URI:kAtom];
+  XCTAssertEqual([entries count], (NSUInteger)20);
+  XCTAssertEqualObjects([[entries objectAtIndex:3] stringValue], @"3");
+  XCTAssertEqual([[root elementsForLocalName:@"entry" URI:kGD] count],
+                 (NSUInteger)20);
+  XCTAssertEqual([[root elementsForLocalName:@"title" URI:kAtom] count],
+                 (NSUInteger)1);
+  XCTAssertEqual([[root elementsForLocalName:@"title" URI:kGD] count],
+                 (NSUInteger)0);
+  XCTAssertEqualObjects([[root attributeForLocalName:@"etag" URI:kGD] stringValue],
+                        @"W/123");
+
+  // changing the tree updates the lookups
+  GDataXMLElement *child = [GDataXMLNode elementWithName:@"title" URI:kAtom];
+  [root addChild:child];
+  NSArray *titles = [root elementsForLocalName:@"title" URI:kAtom];
+  XCTAssertEqual([titles count], (NSUInteger)2);
+
+  [root removeChild:[titles objectAtIndex:0]];
+  XCTAssertEqual([[root elementsForLocalName:@"title" URI:kAtom] count],
+                 (NSUInteger)1);
+
+  [root addAttribute:[GDataXMLNode attributeWithName:@"gd:kind"
+                                         stringValue:@"feed"]];
+  XCTAssertEqualObjects([[root attributeForLocalName:@"kind" URI:kGD] stringValue],
+                        @"feed");
+
+  [root setStringValue:@"gone"];
+  XCTAssertEqual([[root elementsForLocalName:@"entry" URI:kAtom] count],
+                 (NSUInteger)0);
+}
+
+- (void)testChildEnumeration {
+
+  NSString *xmlStr = @"<feed xmlns='http://www.w3.org/2005/Atom'"
+    " xmlns:gd='http://schemas.google.com/g/2005'>text<title>t</title>"
+    "<!-- note --><gd:entry/><entry/>more<entry/></feed>";
+
+  NSError *error = nil;
+  GDataXMLDocument *doc = [[[GDataXMLDocument alloc] initWithXMLString:xmlStr
+                                                               options:0
+                                                                 error:&error] autorelease];
+  XCTAssertNotNil(doc, @"%@", error);
+  GDataXMLElement *root = [doc rootElement];
+
+  NSString *const kAtom = @"http://www.w3.org/2005/Atom";
+  NSMutableArray *found = [NSMutableArray array];
+  GDataXMLNodeEnumerationBlock collector = ^(GDataXMLNode *node, BOOL *stop) {
+    [found addObject:node];
+  };
+
+  // elements only
+  [root enumerateChildrenOfKind:GDataXMLElementKind
+                            URI:nil
+                      localName:nil
+                     usingBlock:collector];
+  XCTAssertEqualObjects([found valueForKey:@"localName"],
+                        ([NSArray arrayWithObjects:@"title", @"entry",
+                          @"entry", @"entry", nil]));
+
+  // text only
+  [found removeAllObjects];
+  [root enumerateChildrenOfKind:GDataXMLTextKind
+                            URI:nil
+                      localName:nil
+                     usingBlock:collector];
+  XCTAssertEqualObjects([found valueForKey:@"stringValue"],
+                        ([NSArray arrayWithObjects:@"text", @"more", nil]));
+
+  // by namespace and name, stopping early
+  [found removeAllObjects];
+  [root enumerateChildrenOfKind:GDataXMLElementKind
+                            URI:kAtom
+                      localName:@"entry"
+                     usingBlock:^(GDataXMLNode *node, BOOL *stop) {
+    [found addObject:node];
+    *stop = YES;
+  }];
+  XCTAssertEqual([found count], (NSUInteger)1);
+  XCTAssertEqualObjects([[found objectAtIndex:0] URI], kAtom);
+
+  // once the children array exists, its nodes are passed
+  NSArray *children = [root children];
+  [found removeAllObjects];
+  [root enumerateChildrenOfKind:GDataXMLCommentKind
+                            URI:nil
+                      localName:nil
+                     usingBlock:collector];
+  XCTAssertEqual([found count], (NSUInteger)1);
+  XCTAssertTrue([found objectAtIndex:0] == [children objectAtIndex:2]);
+}
+
+- (void)testXMLWriter {
+
+  NSString *const kAtom = @"http://www.w3.org/2005/Atom";
+  NSString *const kGD = @"http://schemas.google.com/g/2005";
+
+  NSString *feedStr = @"<feed xmlns='http://www.w3.org/2005/Atom'"
+    " xmlns:gd='http://schemas.google.com/g/2005'><title>w</title></feed>";
+  NSString *entryStr = @"<entry xmlns='http://www.w3.org/2005/Atom'"
+    " xmlns:gd='http://schemas.google.com/g/2005' gd:etag='W/1'>"
+    "<id>1 &amp; 2</id><gd:when startTime='now'/></entry>";
+
+  NSError *error = nil;
+  GDataXMLElement *feed = [[[GDataXMLElement alloc] initWithXMLString:feedStr
+                                                                error:&error] autorelease];
+  GDataXMLElement *entry = [[[GDataXMLElement alloc] initWithXMLString:entryStr
+                                                                 error:&error] autorelease];
+  XCTAssertNotNil(feed, @"%@", error);
+  XCTAssertNotNil(entry, @"%@", error);
+
+  NSOutputStream *stream = [NSOutputStream outputStreamToMemory];
+  [stream open];
+
+  GDataXMLWriter *writer = [[[GDataXMLWriter alloc] initWithOutputStream:stream] autorelease];
+  XCTAssertTrue([writer writeStartOfElement:feed hoistingNamespaces:nil]);
+  XCTAssertTrue([writer writeElement:entry]);
+  XCTAssertTrue([writer writeElement:entry]);
+  XCTAssertTrue([writer writeEndOfElement]);
+  XCTAssertTrue([writer finishWritingWithError:&error], @"%@", error);
+
+  NSData *data = [stream propertyForKey:NSStreamDataWrittenToMemoryStreamKey];
+  [stream close];
+  XCTAssertEqual([writer numberOfBytesWritten], (unsigned long long)[data length]);
+
+  // the entries rely on the namespace declarations of the root
+  NSString *str = [[[NSString alloc] initWithData:data
+                                         encoding:NSUTF8StringEncoding] autorelease];
+  NSRange firstEntry = [str rangeOfString:@"<entry"];
+  XCTAssertTrue(firstEntry.location != NSNotFound);
+  XCTAssertEqual([[str substringFromIndex:firstEntry.location]
+                  rangeOfString:@"xmlns"].location, (NSUInteger)NSNotFound, @"%@", str);
+
+  GDataXMLDocument *doc = [[[GDataXMLDocument alloc] initWithData:data
+                                                          options:0
+                                                            error:&error] autorelease];
+  XCTAssertNotNil(doc, @"%@", error);
+  NSArray *entries = [[doc rootElement] elementsForLocalName:@"entry" URI:kAtom];
+  XCTAssertEqual([entries count], (NSUInteger)2);
+
+  GDataXMLElement *writtenEntry = [entries objectAtIndex:1];
+  XCTAssertEqualObjects([[writtenEntry attributeForLocalName:@"etag" URI:kGD] stringValue],
+                        @"W/1");
+  XCTAssertEqualObjects([[[writtenEntry elementsForLocalName:@"id" URI:kAtom]
+                          objectAtIndex:0] stringValue], @"1 & 2");
+  XCTAssertEqual([[writtenEntry elementsForLocalName:@"when" URI:kGD] count],
+                 (NSUInteger)1);
+
+  // nothing may be written after finishing
+  XCTAssertFalse([writer writeElement:entry]);
+}
+
+- (void)testPushParser {
+
+  NSString *xmlStr = @"<feed xmlns='http://www.w3.org/2005/Atom'>"
+    "<title>push</title><entry><id>1</id></entry><entry><id>2</id></entry>"
+    "</feed>";
+  NSData *data = [xmlStr dataUsingEncoding:NSUTF8StringEncoding];
+
+  // append the data a few bytes at a time
+  GDataXMLPushParser *parser = [[[GDataXMLPushParser alloc] init] autorelease];
+  const NSUInteger kChunkSize = 7;
+  for (NSUInteger offset = 0; offset < [data length]; offset += kChunkSize) {
+    NSRange range = NSMakeRange(offset, MIN(kChunkSize, [data length] - offset));
+    BOOL didAppend = [parser appendData:[data subdataWithRange:range]];
+    XCTAssertTrue(didAppend, @"push parser failed at offset %u",
+                  (unsigned int)offset);
+  }
+  XCTAssertEqual([parser numberOfBytesAppended],
+                 (unsigned long long)[data length]);
+
+  NSError *error = nil;
+  GDataXMLDocument *doc = [parser finishParsingWithError:&error];
+  XCTAssertNotNil(doc, @"push parser error %@", error);
+
+  GDataXMLElement *root = [doc rootElement];
+  XCTAssertEqualObjects([root localName], @"feed");
+  XCTAssertEqualObjects([root URI], @"http://www.w3.org/2005/Atom");
+  NSArray *entries = [root elementsForLocalName:@"entry"
+                                            URI:@"http://www.w3.org/2005/Atom"];
+  XCTAssertEqual([entries count], (NSUInteger)2);
+
+  // no data may follow the end of parsing
+  XCTAssertFalse([parser appendData:data]);
+
+  // malformed data fails
+  parser = [[[GDataXMLPushParser alloc] init] autorelease];
+  [parser appendData:[@"<feed><entry></feed>" dataUsingEncoding:NSUTF8StringEncoding]];
+  doc = [parser finishParsingWithError:&error];
+  XCTAssertNil(doc);
+  XCTAssertNotNil(error);
+}
+
 @end
 
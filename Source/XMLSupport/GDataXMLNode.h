@@ -44,6 +44,15 @@ typedef xmlNode* xmlNodePtr;
 struct _xmlDoc;
 typedef struct _xmlDoc xmlDoc;
 typedef xmlDoc *xmlDocPtr;
+struct _xmlParserCtxt;
+typedef struct _xmlParserCtxt xmlParserCtxt;
+typedef xmlParserCtxt *xmlParserCtxtPtr;
+struct _xmlXPathCompExpr;
+typedef struct _xmlXPathCompExpr xmlXPathCompExpr;
+typedef xmlXPathCompExpr *xmlXPathCompExprPtr;
+struct _xmlTextWriter;
+typedef struct _xmlTextWriter xmlTextWriter;
+typedef xmlTextWriter *xmlTextWriterPtr;
 #endif
 
 #ifdef GDATA_TARGET_NAMESPACE
@@ -77,8 +86,8 @@ _EXTERN const char* kGDataXMLXPathDefaultNamespacePrefix _INITIALIZE_AS("_def_ns
 // So, for example:
 //  + (id)nodeConsumingXMLNode:(xmlNodePtr)theXMLNode;
 
-@class NSArray, NSDictionary, NSError, NSString, NSURL;
-@class GDataXMLElement, GDataXMLDocument;
+@class NSArray, NSDictionary, NSError, NSOutputStream, NSString, NSURL;
+@class GDataXMLElement, GDataXMLDocument, GDataXMLXPathQuery;
 
 enum {
   GDataXMLInvalidKind = 0,
@@ -119,6 +128,10 @@ typedef NSUInteger GDataXMLNodeKind;
   NSString *cachedName_;
   NSArray *cachedChildren_;
   NSArray *cachedAttributes_;
+
+  // lookup tables built lazily from the cached children and attributes
+  CFMutableDictionaryRef cachedElementIndex_;   // (URI, name) -> child elements
+  CFMutableDictionaryRef cachedAttributeIndex_; // xmlAttrPtr -> attribute node
 }
 
 + (GDataXMLElement *)elementWithName:(NSString *)name;
@@ -161,6 +174,9 @@ typedef NSUInteger GDataXMLNodeKind;
 // be consistenly the same namespace in server responses.
 - (NSArray *)nodesForXPath:(NSString *)xpath error:(NSError **)error;
 
+// evaluate a compiled query with this node as the context node
+- (NSArray *)nodesForXPathQuery:(GDataXMLXPathQuery *)query error:(NSError **)error;
+
 // access to the underlying libxml node; be sure to release the cached values
 // if you change the underlying tree at all
 - (xmlNodePtr)XMLNode;
@@ -169,6 +185,24 @@ typedef NSUInteger GDataXMLNodeKind;
 @end
 
 
+// Strings of parsed nodes, such as names, namespace URIs, and short values,
+// are interned in a bounded table shared by all documents; these report how
+// well the table is working
+@interface GDataXMLNode (StringInternTable)
++ (unsigned long long)numberOfStringInternHits;
++ (unsigned long long)numberOfStringInternMisses;
++ (unsigned long long)numberOfStringInternBytesSaved; // UTF-8 bytes not reallocated
++ (void)resetStringInternStatistics;
+
+// empty the table, such as in response to a memory warning
++ (void)clearStringInternTable;
+@end
+
+
+#if NS_BLOCKS_AVAILABLE
+typedef void (^GDataXMLNodeEnumerationBlock)(GDataXMLNode *node, BOOL *stop);
+#endif
+
 @interface GDataXMLElement : GDataXMLNode
 
 - (id)initWithXMLString:(NSString *)str error:(NSError **)error;
@@ -184,6 +218,20 @@ typedef NSUInteger GDataXMLNodeKind;
 - (NSArray *)elementsForName:(NSString *)name;
 - (NSArray *)elementsForLocalName:(NSString *)localName URI:(NSString *)URI;
 
+#if NS_BLOCKS_AVAILABLE
+// Enumerate the children matching a node kind, namespace URI, and local name
+// without building the children array.  Pass GDataXMLInvalidKind for any kind
+// of node, and nil for any URI or any local name.
+//
+// Nodes are made only for the matching children.  If the children array has
+// already been built, its nodes are passed instead, so they may be compared
+// by identity with the array's.  The tree should not be changed by the block.
+- (void)enumerateChildrenOfKind:(GDataXMLNodeKind)kind
+                            URI:(NSString *)URI
+                      localName:(NSString *)localName
+                     usingBlock:(GDataXMLNodeEnumerationBlock)block;
+#endif
+
 - (NSArray *)attributes;
 - (GDataXMLNode *)attributeForName:(NSString *)name;
 - (GDataXMLNode *)attributeForLocalName:(NSString *)name URI:(NSString *)attributeURI;
@@ -193,6 +241,11 @@ typedef NSUInteger GDataXMLNodeKind;
 
 @end
 
+#if NS_BLOCKS_AVAILABLE
+// handler for streamed parsing; set *stop to YES to end the parse early
+typedef void (^GDataXMLDocumentStreamHandler)(GDataXMLDocument *childDocument, BOOL *stop);
+#endif
+
 @interface GDataXMLDocument : NSObject {
 @protected
   xmlDoc* xmlDoc_; // strong; always free'd in dealloc
@@ -201,9 +254,31 @@ typedef NSUInteger GDataXMLNodeKind;
 - (id)initWithXMLString:(NSString *)str options:(unsigned int)mask error:(NSError **)error;
 - (id)initWithData:(NSData *)data options:(unsigned int)mask error:(NSError **)error;
 
+// initWithContentsOfFile maps the file rather than reading it into memory
+- (id)initWithContentsOfFile:(NSString *)path options:(unsigned int)mask error:(NSError **)error;
+
 // initWithRootElement uses a copy of the argument as the new document's root
 - (id)initWithRootElement:(GDataXMLElement *)element;
 
+#if NS_BLOCKS_AVAILABLE
+// Streaming parse
+//
+// Rather than build a tree for the whole document, this walks the data
+// with libxml's xmlTextReader.  Each child of the root element with the
+// given local name and namespace URI is copied into a small document of
+// its own and passed to the handler as soon as its end tag has been read,
+// then the reader's nodes for it are freed.
+//
+// The returned document holds the root element and its remaining,
+// unstreamed children.  If the handler stops the parse, children following
+// the stopping point are not included.
++ (GDataXMLDocument *)documentWithStreamedData:(NSData *)data
+                        streamingChildrenNamed:(NSString *)localName
+                                           URI:(NSString *)URI
+                                       handler:(GDataXMLDocumentStreamHandler)handler
+                                         error:(NSError **)error;
+#endif
+
 - (GDataXMLElement *)rootElement;
 
 - (NSData *)XMLData;
@@ -221,5 +296,108 @@ typedef NSUInteger GDataXMLNodeKind;
 // be consistenly the same namespace in server responses.
 - (NSArray *)nodesForXPath:(NSString *)xpath error:(NSError **)error;
 
+- (NSArray *)nodesForXPathQuery:(GDataXMLXPathQuery *)query error:(NSError **)error;
+
 - (NSString *)description;
 @end
+
+// GDataXMLXPathQuery is an XPath expression compiled once, with its
+// namespace bindings, for evaluating repeatedly against any node or
+// document.  A query may be evaluated on several threads at once; each
+// evaluation uses a context of its own.
+//
+// Unlike nodesForXPath:error:, a query uses only the namespaces it was
+// created with, since it is not tied to a particular tree.
+@interface GDataXMLXPathQuery : NSObject {
+ @private
+  NSString *xpath_;
+  NSDictionary *namespaces_; // keys are prefixes, values are URIs
+  xmlXPathCompExprPtr compiledExpr_;
+  NSMutableArray *idleContexts_; // xmlXPathContextPtrs in NSValues
+}
+
+// returns nil, with an error, if the expression cannot be compiled
++ (GDataXMLXPathQuery *)queryWithXPath:(NSString *)xpath
+                            namespaces:(NSDictionary *)namespaces
+                                 error:(NSError **)error;
+
+- (id)initWithXPath:(NSString *)xpath
+         namespaces:(NSDictionary *)namespaces
+              error:(NSError **)error;
+
+- (NSString *)XPath;
+- (NSDictionary *)namespaces;
+@end
+
+// GDataXMLPushParser builds a document from data supplied in pieces, such as
+// the chunks of a response body as they arrive from the network, so parsing
+// can overlap the download.  A push parser is not thread-safe, but may be
+// handed from one thread to another between calls.
+@interface GDataXMLPushParser : NSObject {
+ @private
+  xmlParserCtxtPtr parserContext_; // created with the first data appended
+  unsigned long long numberOfBytesAppended_;
+  BOOL hasFailed_;
+  BOOL isFinished_;
+  BOOL allowsHugeDocument_;
+}
+
+// setAllowsHugeDocument: lifts libxml's limits on the sizes of documents and
+// text nodes, for data known to be huge; it must be set before any data is
+// appended
+- (void)setAllowsHugeDocument:(BOOL)flag;
+- (BOOL)allowsHugeDocument;
+
+// appendData: returns NO once the data is known to be malformed
+- (BOOL)appendData:(NSData *)data;
+
+// finishParsingWithError: returns the document, or nil if the data appended
+// was not well-formed; no data may be appended afterwards
+- (GDataXMLDocument *)finishParsingWithError:(NSError **)error;
+
+- (unsigned long long)numberOfBytesAppended;
+
+@end
+
+// GDataXMLWriter writes XML text for elements directly to an output stream
+// with libxml's xmlTextWriter, rather than adding the elements to a document
+// and dumping that.  Namespaces declared at the document's root element are
+// not declared again by the elements written inside it, so the elements
+// written need not be in the same tree, or in any tree.
+//
+// The stream should already be open; the writer does not close it.  Writes
+// to the stream block until they complete.
+@interface GDataXMLWriter : NSObject {
+ @private
+  NSOutputStream *outputStream_;
+  xmlTextWriterPtr textWriter_;
+  NSMutableArray *namespaceScopes_; // dictionaries of prefixes to URIs
+                                    // declared by each open element
+  NSUInteger numberOfGeneratedPrefixes_;
+  unsigned long long numberOfBytesWritten_;
+  NSError *streamError_;
+  BOOL hasStartedDocument_;
+  BOOL hasFailed_;
+  BOOL isFinished_;
+}
+
+- (id)initWithOutputStream:(NSOutputStream *)stream;
+
+// writeStartOfElement:hoistingNamespaces: writes the element's start tag,
+// declaring the given namespaces (keys are prefixes, values are URIs) as well
+// as the element's own, and then the element's current children.  The
+// element remains open so that more children may be written into it.
+//
+// These return NO once writing has failed.
+- (BOOL)writeStartOfElement:(GDataXMLElement *)element
+         hoistingNamespaces:(NSDictionary *)namespaces;
+- (BOOL)writeElement:(GDataXMLElement *)element;
+- (BOOL)writeEndOfElement;
+
+// finishWritingWithError: closes any open elements and flushes the text to
+// the stream; no more may be written afterwards
+- (BOOL)finishWritingWithError:(NSError **)error;
+
+- (unsigned long long)numberOfBytesWritten;
+
+@end
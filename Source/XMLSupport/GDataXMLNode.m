@@ -18,6 +18,9 @@
 #import <libxml/xmlstring.h>
 #import <libxml/xpath.h>
 #import <libxml/xpathInternals.h>
+#import <libxml/xmlreader.h>
+#import <libxml/xmlwriter.h>
+#import <pthread.h>
 
 #define GDATAXMLNODE_DEFINE_GLOBALS 1
 #import "GDataXMLNode.h"
@@ -28,12 +31,15 @@
 
 static const int kGDataXMLParseOptions = (XML_PARSE_NOCDATA | XML_PARSE_NOBLANKS);
 
-// dictionary key callbacks for string cache
-static const void *StringCacheKeyRetainCallBack(CFAllocatorRef allocator, const void *str);
-static void StringCacheKeyReleaseCallBack(CFAllocatorRef allocator, const void *str);
-static CFStringRef StringCacheKeyCopyDescriptionCallBack(const void *str);
-static Boolean StringCacheKeyEqualCallBack(const void *str1, const void *str2);
-static CFHashCode StringCacheKeyHashCallBack(const void *str);
+// the most data passed to the push parser at once
+static const NSUInteger kMaxPushParserChunkLength = 4 * 1024 * 1024;
+
+// elements with fewer children than this are searched without an index
+static const NSUInteger kMinChildCountForElementIndex = 8;
+
+// string intern table, shared by all documents
+static void InitStringInternTable(void);
+static NSString *InternedStringForXMLString(const xmlChar *chars);
 
 // isEqual: has the fatal flaw that it doesn't deal well with the received
 // being nil. We'll use this utility instead.
@@ -113,6 +119,198 @@ static xmlChar *SplitQNameReverse(const xmlChar *qname, xmlChar **prefix) {
   return qnameCopy;
 }
 
+// Keys for the child element index: a child's namespace URI (NULL if it has
+// no namespace) and name.  The pointers are into the tree, so the index is
+// released whenever the tree changes.
+typedef struct {
+  const xmlChar *href;
+  const xmlChar *name;
+} GDataXMLIndexKey;
+
+static const void *IndexKeyRetainCallBack(CFAllocatorRef allocator, const void *key) {
+  GDataXMLIndexKey *keyCopy = malloc(sizeof(GDataXMLIndexKey));
+  *keyCopy = *(const GDataXMLIndexKey *)key;
+  return keyCopy;
+}
+
+static void IndexKeyReleaseCallBack(CFAllocatorRef allocator, const void *key) {
+  free((void *)key);
+}
+
+static Boolean IndexKeyEqualCallBack(const void *key1, const void *key2) {
+  const GDataXMLIndexKey *indexKey1 = key1;
+  const GDataXMLIndexKey *indexKey2 = key2;
+  return xmlStrEqual(indexKey1->name, indexKey2->name)
+    && xmlStrEqual(indexKey1->href, indexKey2->href);
+}
+
+static CFHashCode IndexKeyHashCallBack(const void *key) {
+  // the name is more distinctive than the namespace, so hash just that
+  const GDataXMLIndexKey *indexKey = key;
+  CFHashCode hash = 5381;
+  unsigned int c;
+  const unsigned char *chars = (const unsigned char *)indexKey->name;
+  if (chars != NULL) {
+    while ((c = *chars++) != 0) {
+      hash = ((hash << 5) + hash) + c;
+    }
+  }
+  return hash;
+}
+
+// test if an element has the given local name and namespace URI
+static BOOL IsXMLNodeNamed(xmlNodePtr node, const xmlChar *localName,
+                           const xmlChar *href) {
+  if (node->type != XML_ELEMENT_NODE
+      || !xmlStrEqual(node->name, localName)) {
+    return NO;
+  }
+
+  const xmlChar *nodeHref = (node->ns != NULL ? node->ns->href : NULL);
+  return xmlStrEqual(nodeHref, href);
+}
+
+static GDataXMLNodeKind KindForXMLNodeType(xmlElementType nodeType) {
+  switch (nodeType) {
+    case XML_ELEMENT_NODE:         return GDataXMLElementKind;
+    case XML_ATTRIBUTE_NODE:       return GDataXMLAttributeKind;
+    case XML_TEXT_NODE:            return GDataXMLTextKind;
+    case XML_CDATA_SECTION_NODE:   return GDataXMLTextKind;
+    case XML_ENTITY_REF_NODE:      return GDataXMLEntityDeclarationKind;
+    case XML_ENTITY_NODE:          return GDataXMLEntityDeclarationKind;
+    case XML_PI_NODE:              return GDataXMLProcessingInstructionKind;
+    case XML_COMMENT_NODE:         return GDataXMLCommentKind;
+    case XML_DOCUMENT_NODE:        return GDataXMLDocumentKind;
+    case XML_DOCUMENT_TYPE_NODE:   return GDataXMLDocumentKind;
+    case XML_DOCUMENT_FRAG_NODE:   return GDataXMLDocumentKind;
+    case XML_NOTATION_NODE:        return GDataXMLNotationDeclarationKind;
+    case XML_HTML_DOCUMENT_NODE:   return GDataXMLDocumentKind;
+    case XML_DTD_NODE:             return GDataXMLDTDKind;
+    case XML_ELEMENT_DECL:         return GDataXMLElementDeclarationKind;
+    case XML_ATTRIBUTE_DECL:       return GDataXMLAttributeDeclarationKind;
+    case XML_ENTITY_DECL:          return GDataXMLEntityDeclarationKind;
+    case XML_NAMESPACE_DECL:       return GDataXMLNamespaceKind;
+    case XML_XINCLUDE_START:       return GDataXMLProcessingInstructionKind;
+    case XML_XINCLUDE_END:         return GDataXMLProcessingInstructionKind;
+    case XML_DOCB_DOCUMENT_NODE:   return GDataXMLDocumentKind;
+  }
+  return GDataXMLInvalidKind;
+}
+
+// test if a child node passes the filter of a child enumeration; a NULL
+// href or local name matches any, and fakeQNamePrefix is "{href}:", the
+// start of the names of elements whose namespace was left unresolved
+static BOOL IsXMLNodeMatchingFilter(xmlNodePtr node, GDataXMLNodeKind kind,
+                                    const xmlChar *href,
+                                    const xmlChar *localName,
+                                    const xmlChar *fakeQNamePrefix) {
+  if (kind != GDataXMLInvalidKind && KindForXMLNodeType(node->type) != kind) {
+    return NO;
+  }
+
+  const xmlChar *nodeLocalName = node->name;
+
+  if (href != NULL) {
+    if (node->ns != NULL) {
+      if (!xmlStrEqual(node->ns->href, href)) return NO;
+    } else {
+      int prefixLen = xmlStrlen(fakeQNamePrefix);
+      if (nodeLocalName == NULL
+          || xmlStrncmp(nodeLocalName, fakeQNamePrefix, prefixLen) != 0) {
+        return NO;
+      }
+      nodeLocalName += prefixLen;
+    }
+  }
+
+  return (localName == NULL || xmlStrEqual(nodeLocalName, localName));
+}
+
+// xmlXPathNewContext requires a doc for its context, but if our elements
+// are created from GDataXMLElement's initWithXMLString there may not be
+// a document. (We may later decide that we want to stuff the doc used
+// there into a GDataXMLDocument and retain it, but we don't do that now.)
+//
+// This makes a temporary document to use for the xpath context, with the
+// topmost node of the tree as its root, if the node has no document.
+static xmlDocPtr NewTemporaryDocForXPath(xmlNodePtr node, xmlNodePtr *topParent) {
+  xmlDocPtr tempDoc = NULL;
+  *topParent = NULL;
+
+  if (node != NULL && node->doc == NULL) {
+    tempDoc = xmlNewDoc(NULL);
+    if (tempDoc) {
+      // find the topmost node of the current tree to make the root of
+      // our temporary document
+      xmlNodePtr top = node;
+      while (top->parent != NULL) {
+        top = top->parent;
+      }
+      xmlDocSetRootElement(tempDoc, top);
+      *topParent = top;
+    }
+  }
+  return tempDoc;
+}
+
+static void FreeTemporaryDocForXPath(xmlDocPtr tempDoc, xmlNodePtr topParent) {
+  if (tempDoc != NULL) {
+    xmlUnlinkNode(topParent);
+    xmlSetTreeDoc(topParent, NULL);
+    xmlFreeDoc(tempDoc);
+  }
+}
+
+// returns the nodes of an xpath evaluation's result set
+static NSMutableArray *NodesForXPathObject(xmlXPathObjectPtr xpathObj) {
+  NSMutableArray *array = [NSMutableArray array];
+
+  xmlNodeSetPtr nodeSet = xpathObj->nodesetval;
+  if (nodeSet) {
+
+    // add each node in the result set to our array
+    for (int index = 0; index < nodeSet->nodeNr; index++) {
+
+      xmlNodePtr currNode = nodeSet->nodeTab[index];
+
+      GDataXMLNode *node = [GDataXMLNode nodeBorrowingXMLNode:currNode];
+      if (node) {
+        [array addObject:node];
+      }
+    }
+  }
+  return array;
+}
+
+// returns the error for a failed xpath compilation or evaluation
+static NSError *ErrorForXPathContext(xmlXPathContextPtr xpathCtx) {
+  NSInteger errorCode = -1;
+  NSDictionary *errorInfo = nil;
+
+  if (xpathCtx != NULL) {
+    const char *msg = xpathCtx->lastError.str1;
+    errorCode = xpathCtx->lastError.code;
+    if (msg) {
+      NSString *errStr = [NSString stringWithUTF8String:msg];
+      errorInfo = [NSDictionary dictionaryWithObject:errStr
+                                              forKey:@"error"];
+    }
+  } else {
+    // not a valid node for using XPath
+    errorInfo = [NSDictionary dictionaryWithObject:@"invalid node"
+                                            forKey:@"error"];
+  }
+  return [NSError errorWithDomain:@"com.google.GDataXML"
+                             code:errorCode
+                         userInfo:errorInfo];
+}
+
+@interface GDataXMLXPathQuery (PrivateMethods)
+- (NSArray *)nodesForXMLNode:(xmlNodePtr)theXMLNode error:(NSError **)error;
+- (xmlXPathContextPtr)makeContext;
+- (void)recycleContext:(xmlXPathContextPtr)xpathCtx;
+@end
+
 @interface GDataXMLNode (PrivateMethods)
 
 // consuming a node implies it will later be freed when the instance is
@@ -132,8 +330,7 @@ static xmlChar *SplitQNameReverse(const xmlChar *qname, xmlChar **prefix) {
 // search for an underlying attribute
 - (GDataXMLNode *)attributeForXMLNode:(xmlAttrPtr)theXMLNode;
 
-// return an NSString for an xmlChar*, using our strings cache in the
-// document
+// return an NSString for an xmlChar*, using the string intern table
 - (NSString *)stringFromXMLString:(const xmlChar *)chars;
 
 // setter/getter of the dealloc flag for the underlying node
@@ -152,6 +349,7 @@ static xmlChar *SplitQNameReverse(const xmlChar *qname, xmlChar **prefix) {
 
 + (void)load {
   xmlInitParser();
+  InitStringInternTable();
 }
 
 // Note on convenience methods for making stand-alone element and
@@ -324,13 +522,22 @@ static xmlChar *SplitQNameReverse(const xmlChar *qname, xmlChar **prefix) {
 
   [cachedAttributes_ release];
   cachedAttributes_ = nil;
+
+  if (cachedElementIndex_ != NULL) {
+    CFRelease(cachedElementIndex_);
+    cachedElementIndex_ = NULL;
+  }
+
+  if (cachedAttributeIndex_ != NULL) {
+    CFRelease(cachedAttributeIndex_);
+    cachedAttributeIndex_ = NULL;
+  }
 }
 
 
 // convert xmlChar* to NSString*
 //
-// returns an autoreleased NSString*, from the current node's document strings
-// cache if possible
+// returns an autoreleased NSString*, from the string intern table if possible
 - (NSString *)stringFromXMLString:(const xmlChar *)chars {
 
 #if DEBUG
@@ -338,45 +545,7 @@ static xmlChar *SplitQNameReverse(const xmlChar *qname, xmlChar **prefix) {
 #endif
   if (chars == NULL) return nil;
 
-  CFMutableDictionaryRef cacheDict = NULL;
-
-  NSString *result = nil;
-
-  if (xmlNode_ != NULL
-    && (xmlNode_->type == XML_ELEMENT_NODE
-        || xmlNode_->type == XML_ATTRIBUTE_NODE
-        || xmlNode_->type == XML_TEXT_NODE)) {
-    // there is no xmlDocPtr in XML_NAMESPACE_DECL nodes,
-    // so we can't cache the text of those
-
-    // look for a strings cache in the document
-    //
-    // the cache is in the document's user-defined _private field
-
-    if (xmlNode_->doc != NULL) {
-
-      cacheDict = xmlNode_->doc->_private;
-
-      if (cacheDict) {
-
-        // this document has a strings cache
-        result = (NSString *) CFDictionaryGetValue(cacheDict, chars);
-        if (result) {
-          // we found the xmlChar string in the cache; return the previously
-          // allocated NSString, rather than allocate a new one
-          return result;
-        }
-      }
-    }
-  }
-
-  // allocate a new NSString for this xmlChar*
-  result = [NSString stringWithUTF8String:(const char *) chars];
-  if (cacheDict) {
-    // save the string in the document's string cache
-    CFDictionarySetValue(cacheDict, chars, result);
-  }
-
+  NSString *result = InternedStringForXMLString(chars);
   return result;
 }
 
@@ -407,7 +576,8 @@ static xmlChar *SplitQNameReverse(const xmlChar *qname, xmlChar **prefix) {
 
     } else {
 
-      // attribute or element node
+      // attribute or element node; this replaces any children
+      [self releaseCachedValues];
 
       // do we need to call xmlEncodeSpecialChars?
       xmlNodeSetContent(xmlNode_, GDataGetXMLString(str));
@@ -660,30 +830,7 @@ static xmlChar *SplitQNameReverse(const xmlChar *qname, xmlChar **prefix) {
 
 - (GDataXMLNodeKind)kind {
   if (xmlNode_ != NULL) {
-    xmlElementType nodeType = xmlNode_->type;
-    switch (nodeType) {
-      case XML_ELEMENT_NODE:         return GDataXMLElementKind;
-      case XML_ATTRIBUTE_NODE:       return GDataXMLAttributeKind;
-      case XML_TEXT_NODE:            return GDataXMLTextKind;
-      case XML_CDATA_SECTION_NODE:   return GDataXMLTextKind;
-      case XML_ENTITY_REF_NODE:      return GDataXMLEntityDeclarationKind;
-      case XML_ENTITY_NODE:          return GDataXMLEntityDeclarationKind;
-      case XML_PI_NODE:              return GDataXMLProcessingInstructionKind;
-      case XML_COMMENT_NODE:         return GDataXMLCommentKind;
-      case XML_DOCUMENT_NODE:        return GDataXMLDocumentKind;
-      case XML_DOCUMENT_TYPE_NODE:   return GDataXMLDocumentKind;
-      case XML_DOCUMENT_FRAG_NODE:   return GDataXMLDocumentKind;
-      case XML_NOTATION_NODE:        return GDataXMLNotationDeclarationKind;
-      case XML_HTML_DOCUMENT_NODE:   return GDataXMLDocumentKind;
-      case XML_DTD_NODE:             return GDataXMLDTDKind;
-      case XML_ELEMENT_DECL:         return GDataXMLElementDeclarationKind;
-      case XML_ATTRIBUTE_DECL:       return GDataXMLAttributeDeclarationKind;
-      case XML_ENTITY_DECL:          return GDataXMLEntityDeclarationKind;
-      case XML_NAMESPACE_DECL:       return GDataXMLNamespaceKind;
-      case XML_XINCLUDE_START:       return GDataXMLProcessingInstructionKind;
-      case XML_XINCLUDE_END:         return GDataXMLProcessingInstructionKind;
-      case XML_DOCB_DOCUMENT_NODE:   return GDataXMLDocumentKind;
-    }
+    return KindForXMLNodeType(xmlNode_->type);
   }
   return GDataXMLInvalidKind;
 }
@@ -699,31 +846,10 @@ static xmlChar *SplitQNameReverse(const xmlChar *qname, xmlChar **prefix) {
                      error:(NSError **)error {
 
   NSMutableArray *array = nil;
-  NSInteger errorCode = -1;
-  NSDictionary *errorInfo = nil;
+  NSError *xpathError = nil;
 
-  // xmlXPathNewContext requires a doc for its context, but if our elements
-  // are created from GDataXMLElement's initWithXMLString there may not be
-  // a document. (We may later decide that we want to stuff the doc used
-  // there into a GDataXMLDocument and retain it, but we don't do that now.)
-  //
-  // We'll temporarily make a document to use for the xpath context.
-
-  xmlDocPtr tempDoc = NULL;
   xmlNodePtr topParent = NULL;
-
-  if (xmlNode_->doc == NULL) {
-    tempDoc = xmlNewDoc(NULL);
-    if (tempDoc) {
-      // find the topmost node of the current tree to make the root of
-      // our temporary document
-      topParent = xmlNode_;
-      while (topParent->parent != NULL) {
-        topParent = topParent->parent;
-      }
-      xmlDocSetRootElement(tempDoc, topParent);
-    }
-  }
+  xmlDocPtr tempDoc = NewTemporaryDocForXPath(xmlNode_, &topParent);
 
   if (xmlNode_ != NULL && xmlNode_->doc != NULL) {
 
@@ -788,56 +914,32 @@ static xmlChar *SplitQNameReverse(const xmlChar *qname, xmlChar **prefix) {
       if (xpathObj) {
 
         // we have some result from the search
-        array = [NSMutableArray array];
-
-        xmlNodeSetPtr nodeSet = xpathObj->nodesetval;
-        if (nodeSet) {
-
-          // add each node in the result set to our array
-          for (int index = 0; index < nodeSet->nodeNr; index++) {
-
-            xmlNodePtr currNode = nodeSet->nodeTab[index];
-
-            GDataXMLNode *node = [GDataXMLNode nodeBorrowingXMLNode:currNode];
-            if (node) {
-              [array addObject:node];
-            }
-          }
-        }
+        array = NodesForXPathObject(xpathObj);
         xmlXPathFreeObject(xpathObj);
       } else {
         // provide an error for failed evaluation
-        const char *msg = xpathCtx->lastError.str1;
-        errorCode = xpathCtx->lastError.code;
-        if (msg) {
-          NSString *errStr = [NSString stringWithUTF8String:msg];
-          errorInfo = [NSDictionary dictionaryWithObject:errStr
-                                                  forKey:@"error"];
-        }
+        xpathError = ErrorForXPathContext(xpathCtx);
       }
 
       xmlXPathFreeContext(xpathCtx);
     }
   } else {
-    // not a valid node for using XPath
-    errorInfo = [NSDictionary dictionaryWithObject:@"invalid node"
-                                            forKey:@"error"];
+    xpathError = ErrorForXPathContext(NULL);
   }
 
   if (array == nil && error != nil) {
-    *error = [NSError errorWithDomain:@"com.google.GDataXML"
-                                 code:errorCode
-                             userInfo:errorInfo];
+    *error = xpathError;
   }
 
-  if (tempDoc != NULL) {
-    xmlUnlinkNode(topParent);
-    xmlSetTreeDoc(topParent, NULL);
-    xmlFreeDoc(tempDoc);
-  }
+  FreeTemporaryDocForXPath(tempDoc, topParent);
   return array;
 }
 
+- (NSArray *)nodesForXPathQuery:(GDataXMLXPathQuery *)query
+                          error:(NSError **)error {
+  return [query nodesForXMLNode:xmlNode_ error:error];
+}
+
 - (NSString *)description {
   int nodeType = (xmlNode_ ? (int)xmlNode_->type : -1);
 
@@ -866,8 +968,12 @@ static xmlChar *SplitQNameReverse(const xmlChar *qname, xmlChar **prefix) {
 
 }
 
+// the hash covers what isEqual: compares, so equal nodes have equal hashes
 - (NSUInteger)hash {
-  return (NSUInteger) (void *) [GDataXMLNode class];
+  NSUInteger hash = [[self name] hash];
+  hash = hash * 31 + (NSUInteger) [self kind];
+  hash = hash * 31 + [self childCount];
+  return hash;
 }
 
 - (NSMethodSignature *)methodSignatureForSelector:(SEL)selector {
@@ -1067,6 +1173,56 @@ static xmlChar *SplitQNameReverse(const xmlChar *qname, xmlChar **prefix) {
   }
 }
 
+#if NS_BLOCKS_AVAILABLE
+- (void)enumerateChildrenOfKind:(GDataXMLNodeKind)kind
+                            URI:(NSString *)URI
+                      localName:(NSString *)localName
+                     usingBlock:(GDataXMLNodeEnumerationBlock)block {
+
+  if (xmlNode_ == NULL || xmlNode_->children == NULL) return;
+
+  const xmlChar *href = (URI != nil ? GDataGetXMLString(URI) : NULL);
+  const xmlChar *requestedLocalName =
+    (localName != nil ? GDataGetXMLString(localName) : NULL);
+  const xmlChar *fakeQNamePrefix = NULL;
+  if (URI != nil) {
+    NSString *prefixStr = [NSString stringWithFormat:@"{%@}:", URI];
+    fakeQNamePrefix = GDataGetXMLString(prefixStr);
+  }
+
+  BOOL shouldStop = NO;
+
+  if (cachedChildren_ != nil) {
+    // the children array has already been built, so pass its nodes rather
+    // than new ones, letting callers compare the nodes by identity; the
+    // array is retained in case the block changes the tree
+    NSArray *children = [cachedChildren_ retain];
+    for (GDataXMLNode *child in children) {
+      if (IsXMLNodeMatchingFilter([child XMLNode], kind, href,
+                                  requestedLocalName, fakeQNamePrefix)) {
+        block(child, &shouldStop);
+        if (shouldStop) break;
+      }
+    }
+    [children release];
+    return;
+  }
+
+  // walk the libxml children, making wrappers only for the matching nodes
+  xmlNodePtr currChild = xmlNode_->children;
+  while (currChild != NULL && !shouldStop) {
+    xmlNodePtr nextChild = currChild->next;
+
+    if (IsXMLNodeMatchingFilter(currChild, kind, href,
+                                requestedLocalName, fakeQNamePrefix)) {
+      GDataXMLNode *node = [GDataXMLNode nodeBorrowingXMLNode:currChild];
+      block(node, &shouldStop);
+    }
+    currChild = nextChild;
+  }
+}
+#endif
+
 - (NSArray *)elementsForName:(NSString *)name {
 
   NSString *desiredName = name;
@@ -1121,10 +1277,92 @@ static xmlChar *SplitQNameReverse(const xmlChar *qname, xmlChar **prefix) {
   return nil;
 }
 
+// elementIndex maps the namespace URI and name of each child element to an
+// array of the children having them, in document order
+- (CFDictionaryRef)elementIndex {
+
+  if (cachedElementIndex_ == NULL) {
+
+    CFDictionaryKeyCallBacks keyCallBacks = {
+      0, // version
+      IndexKeyRetainCallBack,
+      IndexKeyReleaseCallBack,
+      NULL, // copy description
+      IndexKeyEqualCallBack,
+      IndexKeyHashCallBack
+    };
+
+    cachedElementIndex_ = CFDictionaryCreateMutable(kCFAllocatorDefault, 0,
+      &keyCallBacks, &kCFTypeDictionaryValueCallBacks);
+
+    NSArray *children = [self children];
+
+    for (GDataXMLNode *child in children) {
+
+      xmlNodePtr currChildPtr = [child XMLNode];
+      if (currChildPtr->type == XML_ELEMENT_NODE && currChildPtr->name != NULL) {
+
+        GDataXMLIndexKey key;
+        key.href = (currChildPtr->ns != NULL ? currChildPtr->ns->href : NULL);
+        key.name = currChildPtr->name;
+
+        NSMutableArray *matches;
+        matches = (NSMutableArray *) CFDictionaryGetValue(cachedElementIndex_, &key);
+        if (matches == nil) {
+          matches = [[NSMutableArray alloc] initWithObjects:child, nil];
+          CFDictionarySetValue(cachedElementIndex_, &key, matches);
+          [matches release];
+        } else {
+          [matches addObject:child];
+        }
+      }
+    }
+  }
+  return cachedElementIndex_;
+}
+
+- (NSArray *)indexedElementsWithXMLHref:(const xmlChar *)href
+                                   name:(const xmlChar *)name {
+  GDataXMLIndexKey key;
+  key.href = href;
+  key.name = name;
+
+  NSArray *matches = (NSArray *) CFDictionaryGetValue([self elementIndex], &key);
+  return [[matches retain] autorelease];
+}
+
 - (NSArray *)elementsForLocalName:(NSString *)localName URI:(NSString *)URI {
 
   NSMutableArray *array = nil;
 
+  if (xmlNode_ != NULL && xmlNode_->children != NULL && URI != nil
+      && (cachedElementIndex_ != NULL
+          || [[self children] count] >= kMinChildCountForElementIndex)) {
+
+    // look up the children in the index by their namespace URI and name,
+    // or, if the namespace is not defined at this element, by the
+    // fake qualified name used for elements with a namespace left unresolved
+    xmlChar* desiredNSHref = GDataGetXMLString(URI);
+    xmlChar* requestedLocalName = GDataGetXMLString(localName);
+
+    NSArray *nsMatches = [self indexedElementsWithXMLHref:desiredNSHref
+                                                     name:requestedLocalName];
+
+    xmlNsPtr foundParentNS = xmlSearchNsByHref(xmlNode_->doc, xmlNode_, desiredNSHref);
+    if (foundParentNS != NULL) {
+      return nsMatches;
+    }
+
+    NSString *fakeQName = GDataFakeQNameForURIAndName(URI, localName);
+    NSArray *fakeMatches = [self indexedElementsWithXMLHref:NULL
+                                                       name:GDataGetXMLString(fakeQName)];
+    if (fakeMatches == nil) return nsMatches;
+    if (nsMatches == nil) return fakeMatches;
+
+    // both kinds are present, which is unusual; search the children directly
+    // to preserve document order
+  }
+
   if (xmlNode_ != NULL && xmlNode_->children != NULL) {
 
     xmlChar* desiredNSHref = GDataGetXMLString(URI);
@@ -1279,18 +1517,22 @@ static xmlChar *SplitQNameReverse(const xmlChar *qname, xmlChar **prefix) {
 }
 
 - (GDataXMLNode *)attributeForXMLNode:(xmlAttrPtr)theXMLNode {
-  // search the cached attributes list for the GDataXMLNode with
-  // the underlying xmlAttrPtr
-  NSArray *attributes = [self attributes];
+  // find the GDataXMLNode with the underlying xmlAttrPtr, using a table
+  // built from the cached attributes list
+  if (cachedAttributeIndex_ == NULL) {
 
-  for (GDataXMLNode *attr in attributes) {
+    cachedAttributeIndex_ = CFDictionaryCreateMutable(kCFAllocatorDefault, 0,
+      NULL, &kCFTypeDictionaryValueCallBacks);
 
-    if (theXMLNode == (xmlAttrPtr) [attr XMLNode]) {
-      return attr;
+    NSArray *attributes = [self attributes];
+    for (GDataXMLNode *attr in attributes) {
+      CFDictionarySetValue(cachedAttributeIndex_, [attr XMLNode], attr);
     }
   }
 
-  return nil;
+  GDataXMLNode *attr = (GDataXMLNode *) CFDictionaryGetValue(cachedAttributeIndex_,
+                                                            theXMLNode);
+  return [[attr retain] autorelease];
 }
 
 - (GDataXMLNode *)attributeForName:(NSString *)name {
@@ -1603,9 +1845,30 @@ static xmlChar *SplitQNameReverse(const xmlChar *qname, xmlChar **prefix) {
 
 
 @interface GDataXMLDocument (PrivateMethods)
-- (void)addStringsCacheToDoc;
+- (id)initConsumingXMLDoc:(xmlDocPtr)theXMLDoc;
 @end
 
+#if NS_BLOCKS_AVAILABLE
+// GDataXMLDataReadContext tracks the position of a reader reading huge data
+// through GDataXMLDataReadCallback
+typedef struct {
+  const char *bytes;
+  NSUInteger length;
+  NSUInteger offset;
+} GDataXMLDataReadContext;
+
+static int GDataXMLDataReadCallback(void *context, char *buffer, int len) {
+  GDataXMLDataReadContext *readContext = (GDataXMLDataReadContext *)context;
+
+  NSUInteger remaining = readContext->length - readContext->offset;
+  NSUInteger readLength = MIN(remaining, (NSUInteger)len);
+
+  memcpy(buffer, readContext->bytes + readContext->offset, readLength);
+  readContext->offset += readLength;
+  return (int)readLength;
+}
+#endif
+
 @implementation GDataXMLDocument
 
 - (id)initWithXMLString:(NSString *)str options:(unsigned int)mask error:(NSError **)error {
@@ -1623,9 +1886,24 @@ static xmlChar *SplitQNameReverse(const xmlChar *qname, xmlChar **prefix) {
     const char *baseURL = NULL;
     const char *encoding = NULL;
 
-    // NOTE: We are assuming [data length] fits into an int.
-    xmlDoc_ = xmlReadMemory((const char*)[data bytes], (int)[data length], baseURL, encoding,
-                            kGDataXMLParseOptions); // TODO(grobbins) map option values
+    if ([data length] <= (NSUInteger)INT_MAX) {
+      xmlDoc_ = xmlReadMemory((const char*)[data bytes], (int)[data length], baseURL, encoding,
+                              kGDataXMLParseOptions); // TODO(grobbins) map option values
+    } else {
+      // xmlReadMemory takes an int length, so huge data is passed in pieces
+      // to a push parser
+      GDataXMLPushParser *parser = [[[GDataXMLPushParser alloc] init] autorelease];
+      [parser setAllowsHugeDocument:YES];
+      [parser appendData:data];
+
+      GDataXMLDocument *pushedDocument = [parser finishParsingWithError:NULL];
+      if (pushedDocument != nil) {
+        // take the tree from the pushed document
+        xmlDoc_ = pushedDocument->xmlDoc_;
+        pushedDocument->xmlDoc_ = NULL;
+      }
+    }
+
     if (xmlDoc_ == NULL) {
       if (error) {
        *error = [NSError errorWithDomain:@"com.google.GDataXML"
@@ -1637,14 +1915,27 @@ static xmlChar *SplitQNameReverse(const xmlChar *qname, xmlChar **prefix) {
       return nil;
     } else {
       if (error) *error = NULL;
-
-      [self addStringsCacheToDoc];
     }
   }
 
   return self;
 }
 
+- (id)initWithContentsOfFile:(NSString *)path
+                     options:(unsigned int)mask
+                       error:(NSError **)error {
+  // mapping the file lets its pages be read in as the parser reaches them,
+  // and dropped without being written to swap
+  NSData *data = [NSData dataWithContentsOfFile:path
+                                        options:NSDataReadingMappedIfSafe
+                                          error:error];
+  if (data == nil) {
+    [self release];
+    return nil;
+  }
+  return [self initWithData:data options:mask error:error];
+}
+
 - (id)initWithRootElement:(GDataXMLElement *)element {
 
   self = [super init];
@@ -1653,43 +1944,135 @@ static xmlChar *SplitQNameReverse(const xmlChar *qname, xmlChar **prefix) {
     xmlDoc_ = xmlNewDoc(NULL);
 
     (void) xmlDocSetRootElement(xmlDoc_, [element XMLNodeCopy]);
-
-    [self addStringsCacheToDoc];
   }
 
   return self;
 }
 
-- (void)addStringsCacheToDoc {
-  // utility routine for init methods
+- (id)initConsumingXMLDoc:(xmlDocPtr)theXMLDoc {
 
-#if DEBUG
-  NSCAssert(xmlDoc_ != NULL && xmlDoc_->_private == NULL,
-            @"GDataXMLDocument cache creation problem");
-#endif
+  self = [super init];
+  if (self) {
+    xmlDoc_ = theXMLDoc;
+  }
+  return self;
+}
 
-  // add a strings cache as private data for the document
-  //
-  // we'll use plain C pointers (xmlChar*) as the keys, and NSStrings
-  // as the values
-  CFIndex capacity = 0; // no limit
-
-  CFDictionaryKeyCallBacks keyCallBacks = {
-    0, // version
-    StringCacheKeyRetainCallBack,
-    StringCacheKeyReleaseCallBack,
-    StringCacheKeyCopyDescriptionCallBack,
-    StringCacheKeyEqualCallBack,
-    StringCacheKeyHashCallBack
+#if NS_BLOCKS_AVAILABLE
++ (GDataXMLDocument *)documentWithStreamedData:(NSData *)data
+                        streamingChildrenNamed:(NSString *)localName
+                                           URI:(NSString *)URI
+                                       handler:(GDataXMLDocumentStreamHandler)handler
+                                         error:(NSError **)error {
+  if (error) *error = nil;
+
+  const char *baseURL = NULL;
+  const char *encoding = NULL;
+
+  xmlTextReaderPtr reader;
+  GDataXMLDataReadContext readContext = {
+    (const char *)[data bytes], [data length], 0
   };
 
-  CFMutableDictionaryRef dict = CFDictionaryCreateMutable(
-    kCFAllocatorDefault, capacity,
-    &keyCallBacks, &kCFTypeDictionaryValueCallBacks);
+  if ([data length] <= (NSUInteger)INT_MAX) {
+    reader = xmlReaderForMemory(readContext.bytes, (int)readContext.length,
+                                baseURL, encoding, kGDataXMLParseOptions);
+  } else {
+    // xmlReaderForMemory takes an int length, so huge data is read in pieces
+    // through a callback
+    reader = xmlReaderForIO(GDataXMLDataReadCallback, NULL, &readContext,
+                            baseURL, encoding,
+                            kGDataXMLParseOptions | XML_PARSE_HUGE);
+  }
+  if (reader == NULL) {
+    if (error) {
+      *error = [NSError errorWithDomain:@"com.google.GDataXML"
+                                   code:-1
+                               userInfo:nil];
+    }
+    return nil;
+  }
+
+  const xmlChar *streamedName = GDataGetXMLString(localName);
+  const xmlChar *streamedHref = GDataGetXMLString(URI);
+
+  // outerDoc accumulates the root element and the children not streamed to
+  // the handler
+  xmlDocPtr outerDoc = NULL;
+  xmlNodePtr outerRoot = NULL;
+  BOOL shouldStop = NO;
+
+  int readResult = xmlTextReaderRead(reader);
+  while (readResult == 1 && !shouldStop) {
+
+    int nodeType = xmlTextReaderNodeType(reader);
+    int depth = xmlTextReaderDepth(reader);
+
+    if (depth == 0 && nodeType == XML_READER_TYPE_ELEMENT) {
+      // copy the root element with its attributes and namespace declarations,
+      // but not its children
+      xmlNodePtr readerRoot = xmlTextReaderCurrentNode(reader);
+
+      outerDoc = xmlNewDoc((const xmlChar *)"1.0");
+      outerRoot = xmlDocCopyNode(readerRoot, outerDoc, 2);
+      (void) xmlDocSetRootElement(outerDoc, outerRoot);
+
+      readResult = xmlTextReaderRead(reader);
+
+    } else if (depth == 1 && outerRoot != NULL
+               && (nodeType == XML_READER_TYPE_ELEMENT
+                   || nodeType == XML_READER_TYPE_TEXT)) {
+      // a child of the root; expanding it makes the reader build just
+      // this subtree
+      xmlNodePtr child = xmlTextReaderExpand(reader);
+      if (child == NULL) {
+        readResult = -1;
+        break;
+      }
+
+      if (IsXMLNodeNamed(child, streamedName, streamedHref)) {
+        // copying the subtree declares on the copy any namespaces it uses
+        // from the ancestors
+        xmlDocPtr childDoc = xmlNewDoc((const xmlChar *)"1.0");
+        xmlNodePtr childCopy = xmlDocCopyNode(child, childDoc, 1);
+        (void) xmlDocSetRootElement(childDoc, childCopy);
+
+        GDataXMLDocument *childDocument = [[self alloc] initConsumingXMLDoc:childDoc];
+        handler(childDocument, &shouldStop);
+        [childDocument release];
+      } else {
+        xmlNodePtr childCopy = xmlDocCopyNode(child, outerDoc, 1);
+        if (childCopy) {
+          (void) xmlAddChild(outerRoot, childCopy);
+        }
+      }
+
+      // skip past the subtree, letting the reader free it
+      readResult = xmlTextReaderNext(reader);
+
+    } else {
+      readResult = xmlTextReaderRead(reader);
+    }
+  }
+
+  xmlFreeTextReader(reader);
+
+  if (readResult == -1 || outerDoc == NULL) {
+    // the data could not be parsed
+    if (outerDoc) xmlFreeDoc(outerDoc);
+
+    if (error) {
+      *error = [NSError errorWithDomain:@"com.google.GDataXML"
+                                   code:-1
+                               userInfo:nil];
+    }
+    return nil;
+  }
 
-  // we'll use the user-defined _private field for our cache
-  xmlDoc_->_private = dict;
+  GDataXMLDocument *doc = [[[self alloc] initConsumingXMLDoc:outerDoc] autorelease];
+  return doc;
 }
+#endif
 
 - (NSString *)description {
   return [NSString stringWithFormat:@"%@ %p", [self class], self];
@@ -1697,14 +2080,6 @@ static xmlChar *SplitQNameReverse(const xmlChar *qname, xmlChar **prefix) {
 
 - (void)dealloc {
   if (xmlDoc_ != NULL) {
-    // release the strings cache
-    //
-    // since it's a CF object, were anyone to use this in a GC environment,
-    // this would need to be released in a finalize method, too
-    if (xmlDoc_->_private != NULL) {
-      CFRelease(xmlDoc_->_private);
-    }
-
     xmlFreeDoc(xmlDoc_);
   }
   [super dealloc];
@@ -1789,48 +2164,823 @@ static xmlChar *SplitQNameReverse(const xmlChar *qname, xmlChar **prefix) {
   return nil;
 }
 
+- (NSArray *)nodesForXPathQuery:(GDataXMLXPathQuery *)query
+                          error:(NSError **)error {
+  return [query nodesForXMLNode:(xmlNodePtr)xmlDoc_ error:error];
+}
+
 @end
 
-//
-// Dictionary key callbacks for our C-string to NSString cache dictionary
-//
-static const void *StringCacheKeyRetainCallBack(CFAllocatorRef allocator, const void *str) {
-  // copy the key
-  xmlChar* key = xmlStrdup(str);
-  return key;
-}
+@implementation GDataXMLXPathQuery
 
-static void StringCacheKeyReleaseCallBack(CFAllocatorRef allocator, const void *str) {
-  // free the key
-  char *chars = (char *)str;
-  xmlFree((char *) chars);
++ (GDataXMLXPathQuery *)queryWithXPath:(NSString *)xpath
+                            namespaces:(NSDictionary *)namespaces
+                                 error:(NSError **)error {
+  return [[[self alloc] initWithXPath:xpath
+                           namespaces:namespaces
+                                error:error] autorelease];
 }
 
-static CFStringRef StringCacheKeyCopyDescriptionCallBack(const void *str) {
-  // make a CFString from the key
-  CFStringRef cfStr = CFStringCreateWithCString(kCFAllocatorDefault,
-                                                (const char *)str,
-                                                kCFStringEncodingUTF8);
-  return cfStr;
-}
+- (id)initWithXPath:(NSString *)xpath
+         namespaces:(NSDictionary *)namespaces
+              error:(NSError **)error {
+  self = [super init];
+  if (self) {
+    xpath_ = [xpath copy];
+    namespaces_ = [namespaces copy];
+    idleContexts_ = [[NSMutableArray alloc] init];
+
+    // compile with a context so a syntax error is reported in the context
+    xmlXPathContextPtr xpathCtx = [self makeContext];
+    if (xpathCtx != NULL) {
+      compiledExpr_ = xmlXPathCtxtCompile(xpathCtx, GDataGetXMLString(xpath));
+    }
 
-static Boolean StringCacheKeyEqualCallBack(const void *str1, const void *str2) {
-  // compare the key strings
-  if (str1 == str2) return true;
+    if (compiledExpr_ == NULL) {
+      if (error) *error = ErrorForXPathContext(xpathCtx);
+      if (xpathCtx != NULL) xmlXPathFreeContext(xpathCtx);
+      [self release];
+      return nil;
+    }
 
-  int result = xmlStrcmp(str1, str2);
-  return (result == 0);
+    [self recycleContext:xpathCtx];
+  }
+  return self;
 }
 
-static CFHashCode StringCacheKeyHashCallBack(const void *str) {
-
-  // dhb hash, per http://www.cse.yorku.ca/~oz/hash.html
-  CFHashCode hash = 5381;
-  unsigned int c;
-  const unsigned char *chars = (const unsigned char *)str;
+- (void)dealloc {
+  for (NSValue *value in idleContexts_) {
+    xmlXPathFreeContext((xmlXPathContextPtr) [value pointerValue]);
+  }
+  [idleContexts_ release];
 
-  while ((c = *chars++) != 0) {
-    hash = ((hash << 5) + hash) + c;
+  if (compiledExpr_ != NULL) {
+    xmlXPathFreeCompExpr(compiledExpr_);
   }
+
+  [xpath_ release];
+  [namespaces_ release];
+  [super dealloc];
+}
+
+- (NSString *)XPath {
+  return xpath_;
+}
+
+- (NSDictionary *)namespaces {
+  return namespaces_;
+}
+
+- (NSString *)description {
+  return [NSString stringWithFormat:@"%@ %p: {xpath:%@ namespaces:%@}",
+          [self class], self, xpath_, namespaces_];
+}
+
+// makeContext makes a context with the query's namespaces registered; it
+// is bound to a document only while an evaluation is using it
+- (xmlXPathContextPtr)makeContext {
+  xmlXPathContextPtr xpathCtx = xmlXPathNewContext(NULL);
+  if (xpathCtx) {
+    // the dictionary keys are prefixes; the values are URIs
+    for (NSString *prefix in namespaces_) {
+      NSString *uri = [namespaces_ objectForKey:prefix];
+
+      xmlChar *prefixChars = (xmlChar *) [prefix UTF8String];
+      xmlChar *uriChars = (xmlChar *) [uri UTF8String];
+      int result = xmlXPathRegisterNs(xpathCtx, prefixChars, uriChars);
+      if (result != 0) {
+#if DEBUG
+        NSCAssert1(result == 0, @"GDataXMLXPathQuery namespace %@ issue",
+                   prefix);
+#endif
+      }
+    }
+  }
+  return xpathCtx;
+}
+
+// A context holds the state of one evaluation, so each thread evaluating the
+// query takes a context of its own from the idle ones, or a new one, and
+// returns it when done.  The compiled expression is only read during
+// evaluation, and is shared.
+- (xmlXPathContextPtr)checkOutContext {
+  xmlXPathContextPtr xpathCtx = NULL;
+  @synchronized(idleContexts_) {
+    NSValue *value = [idleContexts_ lastObject];
+    if (value) {
+      xpathCtx = (xmlXPathContextPtr) [value pointerValue];
+      [idleContexts_ removeLastObject];
+    }
+  }
+  if (xpathCtx == NULL) {
+    xpathCtx = [self makeContext];
+  }
+  return xpathCtx;
+}
+
+- (void)recycleContext:(xmlXPathContextPtr)xpathCtx {
+  if (xpathCtx == NULL) return;
+
+  // don't keep pointers into the tree just evaluated
+  xpathCtx->doc = NULL;
+  xpathCtx->node = NULL;
+  xmlResetError(&xpathCtx->lastError);
+
+  @synchronized(idleContexts_) {
+    [idleContexts_ addObject:[NSValue valueWithPointer:xpathCtx]];
+  }
+}
+
+- (NSArray *)nodesForXMLNode:(xmlNodePtr)theXMLNode error:(NSError **)error {
+
+  NSMutableArray *array = nil;
+  NSError *xpathError = nil;
+
+  xmlNodePtr topParent = NULL;
+  xmlDocPtr tempDoc = NewTemporaryDocForXPath(theXMLNode, &topParent);
+
+  if (theXMLNode != NULL && theXMLNode->doc != NULL) {
+
+    xmlXPathContextPtr xpathCtx = [self checkOutContext];
+    if (xpathCtx) {
+      // anchor at the node being evaluated
+      xpathCtx->doc = theXMLNode->doc;
+      xpathCtx->node = theXMLNode;
+
+      xmlXPathObjectPtr xpathObj = xmlXPathCompiledEval(compiledExpr_, xpathCtx);
+      if (xpathObj) {
+        array = NodesForXPathObject(xpathObj);
+        xmlXPathFreeObject(xpathObj);
+      } else {
+        xpathError = ErrorForXPathContext(xpathCtx);
+      }
+
+      [self recycleContext:xpathCtx];
+    }
+  } else {
+    xpathError = ErrorForXPathContext(NULL);
+  }
+
+  if (array == nil && error != nil) {
+    *error = xpathError;
+  }
+
+  FreeTemporaryDocForXPath(tempDoc, topParent);
+  return array;
+}
+
+@end
+
+@implementation GDataXMLPushParser
+
+- (void)dealloc {
+  if (parserContext_ != NULL) {
+    if (parserContext_->myDoc != NULL) {
+      xmlFreeDoc(parserContext_->myDoc);
+      parserContext_->myDoc = NULL;
+    }
+    xmlFreeParserCtxt(parserContext_);
+  }
+  [super dealloc];
+}
+
+- (NSString *)description {
+  return [NSString stringWithFormat:@"%@ %p: {bytes:%llu failed:%@}",
+          [self class], self, numberOfBytesAppended_,
+          hasFailed_ ? @"YES" : @"NO"];
+}
+
+- (BOOL)appendData:(NSData *)data {
+
+  if (hasFailed_ || isFinished_) return NO;
+
+  const char *bytes = (const char *)[data bytes];
+  NSUInteger length = [data length];
+
+  if (parserContext_ == NULL) {
+    // libxml detects the encoding from the first bytes, so we'll pass in up to
+    // four of them when creating the context
+    int initialLength = (int) MIN(length, (NSUInteger)4);
+
+    parserContext_ = xmlCreatePushParserCtxt(NULL, NULL, bytes, initialLength,
+                                             NULL);
+    if (parserContext_ == NULL) {
+      hasFailed_ = YES;
+      return NO;
+    }
+    int options = kGDataXMLParseOptions;
+    if (allowsHugeDocument_) options |= XML_PARSE_HUGE;
+    (void) xmlCtxtUseOptions(parserContext_, options);
+
+    bytes += initialLength;
+    length -= (NSUInteger)initialLength;
+  }
+
+  // libxml copies each chunk into its input buffer and takes int lengths, so
+  // big buffers are parsed in pieces
+  while (length > 0) {
+    int chunkLength = (int) MIN(length, kMaxPushParserChunkLength);
+
+    int result = xmlParseChunk(parserContext_, bytes, chunkLength, 0);
+    if (result != 0) {
+      hasFailed_ = YES;
+      return NO;
+    }
+
+    bytes += chunkLength;
+    length -= (NSUInteger)chunkLength;
+  }
+
+  numberOfBytesAppended_ += [data length];
+  return YES;
+}
+
+- (GDataXMLDocument *)finishParsingWithError:(NSError **)error {
+
+  xmlDocPtr doc = NULL;
+
+  if (parserContext_ != NULL) {
+    if (!hasFailed_ && !isFinished_) {
+      int result = xmlParseChunk(parserContext_, NULL, 0, 1);
+      if (result == 0 && parserContext_->wellFormed) {
+        // take ownership of the document from the context
+        doc = parserContext_->myDoc;
+        parserContext_->myDoc = NULL;
+      }
+    }
+
+    if (parserContext_->myDoc != NULL) {
+      xmlFreeDoc(parserContext_->myDoc);
+      parserContext_->myDoc = NULL;
+    }
+    xmlFreeParserCtxt(parserContext_);
+    parserContext_ = NULL;
+  }
+
+  isFinished_ = YES;
+
+  if (doc == NULL) {
+    hasFailed_ = YES;
+
+    if (error) {
+      *error = [NSError errorWithDomain:@"com.google.GDataXML"
+                                   code:-1
+                               userInfo:nil];
+    }
+    return nil;
+  }
+
+  if (error) *error = nil;
+
+  GDataXMLDocument *xmlDocument = [[[GDataXMLDocument alloc] initConsumingXMLDoc:doc] autorelease];
+  return xmlDocument;
+}
+
+- (unsigned long long)numberOfBytesAppended {
+  return numberOfBytesAppended_;
+}
+
+- (void)setAllowsHugeDocument:(BOOL)flag {
+  allowsHugeDocument_ = flag;
+}
+
+- (BOOL)allowsHugeDocument {
+  return allowsHugeDocument_;
+}
+
+@end
+
+@interface GDataXMLWriter (PrivateMethods)
+- (int)writeBytes:(const char *)buffer length:(int)length;
+@end
+
+static int WriterOutputCallback(void *context, const char *buffer, int len) {
+  GDataXMLWriter *writer = (GDataXMLWriter *)context;
+  return [writer writeBytes:buffer length:len];
+}
+
+static NSString *StringForXMLString(const xmlChar *chars) {
+  if (chars == NULL) return nil;
+  return [NSString stringWithUTF8String:(const char *)chars];
+}
+
+@implementation GDataXMLWriter
+
+- (id)initWithOutputStream:(NSOutputStream *)stream {
+  self = [super init];
+  if (self) {
+    outputStream_ = [stream retain];
+    namespaceScopes_ = [[NSMutableArray alloc] init];
+
+    // the text writer owns the output buffer, and frees it when the writer
+    // is freed
+    xmlOutputBufferPtr outputBuffer = xmlOutputBufferCreateIO(WriterOutputCallback,
+                                                              NULL, self, NULL);
+    if (outputBuffer != NULL) {
+      textWriter_ = xmlNewTextWriter(outputBuffer);
+      if (textWriter_ == NULL) {
+        xmlOutputBufferClose(outputBuffer);
+      }
+    }
+
+    if (textWriter_ == NULL) {
+      [self release];
+      return nil;
+    }
+  }
+  return self;
+}
+
+- (void)dealloc {
+  if (textWriter_ != NULL) {
+    // nothing more should go to the stream
+    hasFailed_ = YES;
+    xmlFreeTextWriter(textWriter_);
+  }
+  [outputStream_ release];
+  [namespaceScopes_ release];
+  [streamError_ release];
+  [super dealloc];
+}
+
+- (unsigned long long)numberOfBytesWritten {
+  return numberOfBytesWritten_;
+}
+
+// called back by libxml with text to be written
+- (int)writeBytes:(const char *)buffer length:(int)length {
+  if (hasFailed_) return -1;
+
+  int totalWritten = 0;
+  while (totalWritten < length) {
+    NSInteger result = [outputStream_ write:(const uint8_t *)buffer + totalWritten
+                                  maxLength:(NSUInteger)(length - totalWritten)];
+    if (result <= 0) {
+      hasFailed_ = YES;
+      [streamError_ release];
+      streamError_ = [[outputStream_ streamError] retain];
+      return -1;
+    }
+    totalWritten += (int)result;
+  }
+  numberOfBytesWritten_ += (unsigned long long)length;
+  return length;
+}
+
+- (BOOL)checkResult:(int)result {
+  if (result < 0) {
+    hasFailed_ = YES;
+  }
+  return !hasFailed_;
+}
+
+- (BOOL)canWrite {
+  if (hasFailed_ || isFinished_) return NO;
+
+  if (!hasStartedDocument_) {
+    hasStartedDocument_ = YES;
+    [self checkResult:xmlTextWriterStartDocument(textWriter_, "1.0", "UTF-8", NULL)];
+  }
+  return !hasFailed_;
+}
+
+#pragma mark Namespace scopes
+
+// URIForPrefix: returns the URI the prefix is bound to by the declarations
+// about to be made, or else by the open elements.  The empty prefix is the
+// default namespace.
+- (NSString *)URIForPrefix:(NSString *)prefix
+       pendingDeclarations:(NSDictionary *)declarations {
+
+  NSString *uri = [declarations objectForKey:prefix];
+  if (uri != nil) return uri;
+
+  for (NSDictionary *scope in [namespaceScopes_ reverseObjectEnumerator]) {
+    uri = [scope objectForKey:prefix];
+    if (uri != nil) return uri;
+  }
+  return nil;
+}
+
+// prefixForURI: returns a prefix currently bound to the URI, or nil
+- (NSString *)prefixForURI:(NSString *)uri
+           allowingDefault:(BOOL)allowDefault
+       pendingDeclarations:(NSDictionary *)declarations {
+
+  NSMutableArray *scopes = [NSMutableArray arrayWithObject:declarations];
+  [scopes addObjectsFromArray:[[namespaceScopes_ reverseObjectEnumerator] allObjects]];
+
+  for (NSDictionary *scope in scopes) {
+    for (NSString *prefix in scope) {
+      if (([prefix length] > 0 || allowDefault)
+          && [[scope objectForKey:prefix] isEqual:uri]
+          && [[self URIForPrefix:prefix pendingDeclarations:declarations] isEqual:uri]) {
+        return prefix;
+      }
+    }
+  }
+  return nil;
+}
+
+- (NSString *)declareGeneratedPrefixForURI:(NSString *)uri
+                       pendingDeclarations:(NSMutableDictionary *)declarations {
+  NSString *prefix;
+  do {
+    prefix = [NSString stringWithFormat:@"ns%lu",
+              (unsigned long) ++numberOfGeneratedPrefixes_];
+  } while ([self URIForPrefix:prefix pendingDeclarations:declarations] != nil);
+
+  [declarations setObject:uri forKey:prefix];
+  return prefix;
+}
+
+// qualifiedNameForXMLNode: returns the name to write for an element or an
+// attribute, adding to the declarations any namespace binding the name needs.
+//
+// As when dumping a tree, an unprefixed name without a namespace, and a
+// prefixed name that was never resolved, are written as they are.
+- (NSString *)qualifiedNameForXMLNode:(xmlNodePtr)node
+                            namespace:(xmlNsPtr)ns
+                          isAttribute:(BOOL)isAttribute
+                  pendingDeclarations:(NSMutableDictionary *)declarations {
+
+  NSString *name = StringForXMLString(node->name);
+
+  if (ns != NULL && ns->href != NULL) {
+    NSString *uri = StringForXMLString(ns->href);
+    NSString *prefix = (ns->prefix != NULL ? StringForXMLString(ns->prefix) : @"");
+
+    if ([prefix isEqual:@"xml"]) {
+      // the xml prefix is never declared
+    } else if (isAttribute && [prefix length] == 0) {
+      // attributes cannot be in the default namespace
+      prefix = [self prefixForURI:uri
+                  allowingDefault:NO
+              pendingDeclarations:declarations];
+      if (prefix == nil) {
+        prefix = [self declareGeneratedPrefixForURI:uri
+                                pendingDeclarations:declarations];
+      }
+    } else if (![[self URIForPrefix:prefix
+                pendingDeclarations:declarations] isEqual:uri]) {
+      [declarations setObject:uri forKey:prefix];
+    }
+
+    if ([prefix length] == 0) return name;
+    return [NSString stringWithFormat:@"%@:%@", prefix, name];
+  }
+
+  if ([name hasPrefix:@"{"]) {
+    // a fake qualified name, {uri}:name, for a namespace left unresolved
+    NSRange closeRange = [name rangeOfString:@"}:"];
+    if (closeRange.location != NSNotFound) {
+      NSString *uri = [name substringWithRange:NSMakeRange(1, closeRange.location - 1)];
+      NSString *localName = [name substringFromIndex:NSMaxRange(closeRange)];
+
+      NSString *prefix = [self prefixForURI:uri
+                            allowingDefault:!isAttribute
+                        pendingDeclarations:declarations];
+      if (prefix == nil) {
+        prefix = [self declareGeneratedPrefixForURI:uri
+                                pendingDeclarations:declarations];
+      }
+
+      if ([prefix length] == 0) return localName;
+      return [NSString stringWithFormat:@"%@:%@", prefix, localName];
+    }
+  }
+  return name;
+}
+
+#pragma mark Writing nodes
+
+- (void)writeStartTagForXMLNode:(xmlNodePtr)node
+             hoistingNamespaces:(NSDictionary *)hoistedNamespaces {
+
+  // declare the element's own namespaces, unless the open elements already
+  // bind their prefixes the same way, and then any hoisted to this element
+  NSMutableDictionary *declarations = [NSMutableDictionary dictionary];
+
+  for (xmlNsPtr nsDef = node->nsDef; nsDef != NULL; nsDef = nsDef->next) {
+    NSString *prefix = (nsDef->prefix != NULL ? StringForXMLString(nsDef->prefix) : @"");
+    NSString *uri = StringForXMLString(nsDef->href);
+    if (uri != nil
+        && ![[self URIForPrefix:prefix pendingDeclarations:nil] isEqual:uri]) {
+      [declarations setObject:uri forKey:prefix];
+    }
+  }
+
+  for (NSString *prefix in hoistedNamespaces) {
+    NSString *uri = [hoistedNamespaces objectForKey:prefix];
+    if ([declarations objectForKey:prefix] == nil
+        && ![[self URIForPrefix:prefix pendingDeclarations:nil] isEqual:uri]) {
+      [declarations setObject:uri forKey:prefix];
+    }
+  }
+
+  // find the names before writing, since they may need more declarations
+  NSString *qName = [self qualifiedNameForXMLNode:node
+                                        namespace:node->ns
+                                      isAttribute:NO
+                              pendingDeclarations:declarations];
+
+  NSMutableArray *attrNames = [NSMutableArray array];
+  for (xmlAttrPtr attr = node->properties; attr != NULL; attr = attr->next) {
+    NSString *attrName = [self qualifiedNameForXMLNode:(xmlNodePtr)attr
+                                             namespace:attr->ns
+                                           isAttribute:YES
+                                   pendingDeclarations:declarations];
+    [attrNames addObject:attrName];
+  }
+
+  [self checkResult:xmlTextWriterStartElement(textWriter_, GDataGetXMLString(qName))];
+
+  for (NSString *prefix in declarations) {
+    NSString *attrName = ([prefix length] > 0 ?
+                          [@"xmlns:" stringByAppendingString:prefix] : @"xmlns");
+    NSString *uri = [declarations objectForKey:prefix];
+    [self checkResult:xmlTextWriterWriteAttribute(textWriter_,
+                                                  GDataGetXMLString(attrName),
+                                                  GDataGetXMLString(uri))];
+  }
+
+  NSUInteger attrIndex = 0;
+  for (xmlAttrPtr attr = node->properties; attr != NULL; attr = attr->next) {
+    NSString *attrName = [attrNames objectAtIndex:attrIndex++];
+    xmlChar *value = xmlNodeGetContent((xmlNodePtr)attr);
+    [self checkResult:xmlTextWriterWriteAttribute(textWriter_,
+                                                  GDataGetXMLString(attrName),
+                                                  value ? value : (const xmlChar *)"")];
+    if (value) xmlFree(value);
+  }
+
+  [namespaceScopes_ addObject:declarations];
+}
+
+- (void)writeXMLNode:(xmlNodePtr)node {
+  switch (node->type) {
+    case XML_ELEMENT_NODE:
+      [self writeStartTagForXMLNode:node hoistingNamespaces:nil];
+      [self writeChildrenOfXMLNode:node];
+      [self writeEndOfElement];
+      break;
+
+    case XML_TEXT_NODE:
+      if (node->content != NULL) {
+        [self checkResult:xmlTextWriterWriteString(textWriter_, node->content)];
+      }
+      break;
+
+    case XML_CDATA_SECTION_NODE:
+      if (node->content != NULL) {
+        [self checkResult:xmlTextWriterWriteCDATA(textWriter_, node->content)];
+      }
+      break;
+
+    case XML_COMMENT_NODE:
+      if (node->content != NULL) {
+        [self checkResult:xmlTextWriterWriteComment(textWriter_, node->content)];
+      }
+      break;
+
+    case XML_PI_NODE:
+      [self checkResult:xmlTextWriterWritePI(textWriter_, node->name, node->content)];
+      break;
+
+    case XML_ENTITY_REF_NODE:
+      [self checkResult:xmlTextWriterWriteFormatRaw(textWriter_, "&%s;",
+                                                    (const char *)node->name)];
+      break;
+
+    default:
+      break;
+  }
+}
+
+- (void)writeChildrenOfXMLNode:(xmlNodePtr)node {
+  for (xmlNodePtr child = node->children;
+       child != NULL && !hasFailed_;
+       child = child->next) {
+    [self writeXMLNode:child];
+  }
+}
+
+#pragma mark -
+
+- (BOOL)writeStartOfElement:(GDataXMLElement *)element
+         hoistingNamespaces:(NSDictionary *)namespaces {
+  xmlNodePtr node = [element XMLNode];
+  if (node == NULL || ![self canWrite]) return NO;
+
+  [self writeStartTagForXMLNode:node hoistingNamespaces:namespaces];
+  [self writeChildrenOfXMLNode:node];
+  return !hasFailed_;
+}
+
+- (BOOL)writeElement:(GDataXMLElement *)element {
+  xmlNodePtr node = [element XMLNode];
+  if (node == NULL || ![self canWrite]) return NO;
+
+  [self writeXMLNode:node];
+  return !hasFailed_;
+}
+
+- (BOOL)writeEndOfElement {
+  if ([namespaceScopes_ count] > 0 && !hasFailed_) {
+    [self checkResult:xmlTextWriterEndElement(textWriter_)];
+    [namespaceScopes_ removeLastObject];
+  }
+  return !hasFailed_;
+}
+
+- (BOOL)finishWritingWithError:(NSError **)error {
+  if (!isFinished_) {
+    isFinished_ = YES;
+
+    if (hasStartedDocument_ && !hasFailed_) {
+      // this closes any elements left open
+      [self checkResult:xmlTextWriterEndDocument(textWriter_)];
+    }
+    [namespaceScopes_ removeAllObjects];
+
+    if (!hasFailed_) {
+      [self checkResult:xmlTextWriterFlush(textWriter_)];
+    }
+  }
+
+  if (hasFailed_) {
+    if (error) {
+      *error = streamError_;
+      if (*error == nil) {
+        *error = [NSError errorWithDomain:@"com.google.GDataXML"
+                                     code:-1
+                                 userInfo:nil];
+      }
+    }
+    return NO;
+  }
+  return YES;
+}
+
+@end
+
+//
+// String intern table
+//
+// Element and attribute names, namespace URIs, rel values, and category
+// schemes repeat in every response, so rather than allocate their NSStrings
+// per document, we keep a bounded table of them shared by all documents.
+//
+// The table is direct-mapped: each string hashes to a single slot.  A slot's
+// string is marked as referenced when found; on a miss, a referenced string
+// gets a second chance (its mark is cleared and the new string is not
+// interned) while an unreferenced one is replaced.  This keeps the recurring
+// vocabulary in the table despite the stream of one-time strings.
+//
+// Slots are guarded by striped locks, held only for the compare and retain.
+//
+
+enum {
+  kInternTableSize = 4096,    // number of slots; must be a power of 2
+  kInternLockCount = 64,      // number of striped locks
+  kInternMaxLength = 128      // longest string interned, in UTF-8 bytes
+};
+
+typedef struct {
+  CFHashCode hash;
+  xmlChar *chars;             // owned copy of the UTF-8 string
+  NSString *string;           // retained
+  BOOL isReferenced;
+} InternSlot;
+
+static InternSlot gInternSlots[kInternTableSize];
+static pthread_mutex_t gInternLocks[kInternLockCount];
+
+static volatile int64_t gInternHits = 0;
+static volatile int64_t gInternMisses = 0;
+static volatile int64_t gInternBytesSaved = 0;
+
+static void InitStringInternTable(void) {
+  for (int idx = 0; idx < kInternLockCount; idx++) {
+    pthread_mutex_init(&gInternLocks[idx], NULL);
+  }
+}
+
+static CFHashCode StringInternHash(const xmlChar *str, size_t *outLength) {
+
+  // dhb hash, per http://www.cse.yorku.ca/~oz/hash.html
+  CFHashCode hash = 5381;
+  unsigned int c;
+  const unsigned char *chars = (const unsigned char *)str;
+
+  while ((c = *chars++) != 0) {
+    hash = ((hash << 5) + hash) + c;
+  }
+  *outLength = (size_t)(chars - (const unsigned char *)str - 1);
   return hash;
 }
+
+static NSString *InternedStringForXMLString(const xmlChar *chars) {
+
+  size_t length = 0;
+  CFHashCode hash = StringInternHash(chars, &length);
+
+  if (length > kInternMaxLength) {
+    // long strings are usually text content, which rarely repeats
+    return [NSString stringWithUTF8String:(const char *)chars];
+  }
+
+  NSUInteger slotIndex = hash & (kInternTableSize - 1);
+  InternSlot *slot = &gInternSlots[slotIndex];
+  pthread_mutex_t *lock = &gInternLocks[slotIndex % kInternLockCount];
+
+  NSString *result = nil;
+
+  pthread_mutex_lock(lock);
+  if (slot->string != nil
+      && slot->hash == hash
+      && xmlStrEqual(slot->chars, chars)) {
+    result = [[slot->string retain] autorelease];
+    slot->isReferenced = YES;
+  }
+  pthread_mutex_unlock(lock);
+
+  if (result) {
+    __sync_fetch_and_add(&gInternHits, 1);
+    __sync_fetch_and_add(&gInternBytesSaved, (int64_t)length);
+    return result;
+  }
+
+  __sync_fetch_and_add(&gInternMisses, 1);
+
+  // allocate outside of the lock
+  NSString *newString = [[NSString alloc] initWithUTF8String:(const char *)chars];
+  if (newString == nil) return nil;
+
+  xmlChar *newChars = xmlStrndup(chars, (int)length);
+
+  xmlChar *evictedChars = NULL;
+  NSString *evictedString = nil;
+
+  pthread_mutex_lock(lock);
+  if (slot->string != nil && slot->isReferenced) {
+    // give the current string a second chance
+    slot->isReferenced = NO;
+    evictedChars = newChars;
+  } else {
+    evictedChars = slot->chars;
+    evictedString = slot->string;
+
+    slot->hash = hash;
+    slot->chars = newChars;
+    slot->string = [newString retain];
+    slot->isReferenced = NO;
+  }
+  pthread_mutex_unlock(lock);
+
+  if (evictedChars) xmlFree(evictedChars);
+  [evictedString release];
+
+  return [newString autorelease];
+}
+
+@implementation GDataXMLNode (StringInternTable)
+
++ (unsigned long long)numberOfStringInternHits {
+  return (unsigned long long)__sync_fetch_and_add(&gInternHits, 0);
+}
+
++ (unsigned long long)numberOfStringInternMisses {
+  return (unsigned long long)__sync_fetch_and_add(&gInternMisses, 0);
+}
+
++ (unsigned long long)numberOfStringInternBytesSaved {
+  return (unsigned long long)__sync_fetch_and_add(&gInternBytesSaved, 0);
+}
+
++ (void)resetStringInternStatistics {
+  (void) __sync_lock_test_and_set(&gInternHits, 0);
+  (void) __sync_lock_test_and_set(&gInternMisses, 0);
+  (void) __sync_lock_test_and_set(&gInternBytesSaved, 0);
+}
+
++ (void)clearStringInternTable {
+  for (NSUInteger idx = 0; idx < kInternTableSize; idx++) {
+    InternSlot *slot = &gInternSlots[idx];
+    pthread_mutex_t *lock = &gInternLocks[idx % kInternLockCount];
+
+    pthread_mutex_lock(lock);
+    xmlChar *chars = slot->chars;
+    NSString *string = slot->string;
+    slot->hash = 0;
+    slot->chars = NULL;
+    slot->string = nil;
+    slot->isReferenced = NO;
+    pthread_mutex_unlock(lock);
+
+    if (chars) xmlFree(chars);
+    [string release];
+  }
+}
+
+@end